@@ -4,6 +4,10 @@
 #include "AsyncTCP.h"
 #include "AsyncTCPLogging.h"
 #include "AsyncTCPSimpleIntrusiveList.h"
+#include "AsyncTCPSlabPool.h"
+#include "AsyncTCPFairQueue.h"
+
+#include <atomic>
 
 /**
  * LibreTiny specific configurations
@@ -25,6 +29,7 @@
 #if defined(ARDUINO) && !defined(LIBRETINY)
 #include <Arduino.h>
 #include <esp_idf_version.h>
+#include <esp_timer.h>
 #if (ESP_IDF_VERSION_MAJOR >= 5)
 #include <NetworkInterface.h>
 #endif  // ESP_IDF_VERSION_MAJOR
@@ -150,8 +155,70 @@ struct lwip_tcp_event_packet_t {
   };
 
   inline lwip_tcp_event_packet_t(lwip_tcp_event_t _event, AsyncClient *_client) : next(nullptr), event(_event), client(_client){};
+
+  // Packets come from a static slab pool, falling back to the heap when it is exhausted
+  static void *operator new(size_t size, const std::nothrow_t &) noexcept;
+  static void operator delete(void *ptr) noexcept;
+  static void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    operator delete(ptr);
+  }
 };
 
+/*
+  Every lwIP callback allocates one packet and the async task frees it right after dispatch, so with a few busy
+  connections this used to be thousands of small malloc/free pairs per minute interleaved with String and JSON
+  allocations. The queue rarely holds more than CONFIG_ASYNC_TCP_QUEUE_SIZE packets (polls are throttled above that),
+  so a pool of that size serves nearly all of them; bursts of recv/sent beyond it still go to the heap.
+*/
+namespace {
+#if CONFIG_ASYNC_TCP_EVENT_POOL_SIZE > 0
+static SimpleSlabPool<sizeof(lwip_tcp_event_packet_t), alignof(lwip_tcp_event_packet_t), CONFIG_ASYNC_TCP_EVENT_POOL_SIZE> _event_pool;
+#endif
+// Bumped from the lwIP thread and the async task, which run on different cores
+static std::atomic<uint32_t> _event_heap_fallbacks{0};
+static std::atomic<uint32_t> _event_allocation_failures{0};
+}  // anonymous namespace
+
+void *lwip_tcp_event_packet_t::operator new(size_t size, const std::nothrow_t &) noexcept {
+#if CONFIG_ASYNC_TCP_EVENT_POOL_SIZE > 0
+  void *ptr = _event_pool.allocate();
+  if (ptr) {
+    return ptr;
+  }
+#endif
+  void *heap = ::operator new(size, std::nothrow);
+  if (heap) {
+    _event_heap_fallbacks.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    _event_allocation_failures.fetch_add(1, std::memory_order_relaxed);
+  }
+  return heap;
+}
+
+void lwip_tcp_event_packet_t::operator delete(void *ptr) noexcept {
+#if CONFIG_ASYNC_TCP_EVENT_POOL_SIZE > 0
+  if (_event_pool.owns(ptr)) {
+    _event_pool.release(ptr);
+    return;
+  }
+#endif
+  ::operator delete(ptr);
+}
+
+AsyncTCPEventPoolStats asyncTcpEventPoolStats() {
+  AsyncTCPEventPoolStats stats = {};
+#if CONFIG_ASYNC_TCP_EVENT_POOL_SIZE > 0
+  SimpleSlabPoolStats pool = _event_pool.stats();
+  stats.capacity = pool.capacity;
+  stats.in_use = pool.in_use;
+  stats.high_watermark = pool.high_watermark;
+  stats.pool_allocations = pool.allocations;
+#endif
+  stats.heap_fallbacks = _event_heap_fallbacks.load(std::memory_order_relaxed);
+  stats.allocation_failures = _event_allocation_failures.load(std::memory_order_relaxed);
+  return stats;
+}
+
 // Detail class for interacting with AsyncClient internals, but without exposing the API
 class AsyncTCP_detail {
 public:
@@ -187,9 +254,22 @@ public:
 };
 }  // anonymous namespace
 
-static SimpleIntrusiveList<lwip_tcp_event_packet_t> _async_queue;
+static FairEventQueue<lwip_tcp_event_packet_t, CONFIG_ASYNC_TCP_MAX_CLIENT_QUEUES> _async_queue({
+  CONFIG_ASYNC_TCP_HOG_WINDOW_MS * 1000UL,
+  CONFIG_ASYNC_TCP_HOG_BUDGET_MS * 1000UL,
+  CONFIG_ASYNC_TCP_HOG_SKIP_ROUNDS,
+  CONFIG_ASYNC_TCP_HOG_RESET_WINDOWS,
+});
 static TaskHandle_t _async_service_task_handle = NULL;
 
+static inline uint32_t _async_now_us() {
+#if defined(LIBRETINY)
+  return micros();
+#else
+  return (uint32_t)esp_timer_get_time();
+#endif
+}
+
 static void _free_event(lwip_tcp_event_packet_t *evpkt) {
   if ((evpkt->event == LWIP_TCP_RECV) && (evpkt->recv.pb != nullptr)) {
     pbuf_free(evpkt->recv.pb);
@@ -201,7 +281,11 @@ static inline void _send_async_event(lwip_tcp_event_packet_t *e) {
   if (e == nullptr) {
     return;
   }
-  _async_queue.push_back(e);
+  if (!_async_queue.push(e, e->event == LWIP_TCP_POLL)) {
+    // a poll for this connection is already pending
+    _free_event(e);
+    return;
+  }
   xTaskNotifyGive(_async_service_task_handle);
 }
 
@@ -209,60 +293,46 @@ static inline void _prepend_async_event(lwip_tcp_event_packet_t *e) {
   if (e == nullptr) {
     return;
   }
-  _async_queue.push_front(e);
+  _async_queue.push(e, false, true);
   xTaskNotifyGive(_async_service_task_handle);
 }
 
+/*
+  Events are queued per connection and dispatched round-robin (see AsyncTCPFairQueue.h), replacing the single FIFO
+  that coalesced only adjacent polls and dropped polls at random once the queue was 3/4 full. A connection has at most
+  one poll pending, and connections whose callbacks hog the task are throttled instead of starving the others.
+*/
 static inline lwip_tcp_event_packet_t *_get_async_event() {
-  queue_mutex_guard guard;
-  while (1) {
-    lwip_tcp_event_packet_t *e = _async_queue.pop_front();
-
-    if ((!e) || (e->event != LWIP_TCP_POLL)) {
-      return e;
-    }
-
-    /*
-      Let's try to coalesce two (or more) consecutive poll events into one
-      this usually happens with poor implemented user-callbacks that are runs too long and makes poll events to stack in the queue
-      if consecutive user callback for a same connection runs longer that poll time then it will fill the queue with events until it deadlocks.
-      This is a workaround to mitigate such poor designs and won't let other events/connections to starve the task time.
-      It won't be effective if user would run multiple simultaneous long running callbacks due to message interleaving.
-      todo: implement some kind of fair dequeuing or (better) simply punish user for a bad designed callbacks by resetting hog connections
-    */
-    for (lwip_tcp_event_packet_t *next_pkt = _async_queue.begin(); next_pkt && (next_pkt->client == e->client) && (next_pkt->event == LWIP_TCP_POLL);
-         next_pkt = _async_queue.begin()) {
-      // if the next event that will come is a poll event for the same connection, we can discard it and continue
-      _free_event(_async_queue.pop_front());
-      async_tcp_log_d("coalescing polls, network congestion or async callbacks might be too slow!");
-    }
-
-    /*
-      now we have to decide if to proceed with poll callback handler or discard it?
-      poor designed apps using asynctcp without proper dataflow control could flood the queue with interleaved pool/ack events.
-      I.e. on each poll app would try to generate more data to send, which in turn results in additional ack event triggering chain effect
-      for long connections. Or poll callback could take long time starving other connections. Anyway our goal is to keep the queue length
-      grows under control (if possible) and poll events are the safest to discard.
-      Let's discard poll events processing using linear-increasing probability curve when queue size grows over 3/4
-      Poll events are periodic and connection could get another chance next time
-    */
-    if (_async_queue.size() > (rand() % CONFIG_ASYNC_TCP_QUEUE_SIZE / 4 + CONFIG_ASYNC_TCP_QUEUE_SIZE * 3 / 4)) {
-      _free_event(e);
-      async_tcp_log_d("discarding poll due to queue congestion");
-      continue;
+  lwip_tcp_event_packet_t *e;
+  lwip_tcp_event_packet_t *stale = nullptr;
+  {
+    queue_mutex_guard guard;
+    e = _async_queue.pop();
+    // An error is the last event of a connection: lwIP has freed the pcb and the error callback usually deletes the
+    // client. Release its slot now, while the pointer is still valid, so that the queue never hands a freed client to
+    // complete() and a new client allocated at the same address starts with clean throttle and hog counters.
+    if (e && e->event == LWIP_TCP_ERROR && e->client) {
+      stale = _async_queue.remove_client(e->client);
     }
-
-    return e;
   }
+  while (stale) {
+    auto t = stale;
+    stale = t->next;
+    _free_event(t);
+  }
+  return e;
+}
+
+static AsyncClient *_complete_async_event(uint32_t busy_us, uint32_t now_us) {
+  queue_mutex_guard guard;
+  return _async_queue.complete(busy_us, now_us);
 }
 
 static size_t _remove_events_for_client(AsyncClient *client) {
   lwip_tcp_event_packet_t *removed_event_chain;
   {
     queue_mutex_guard guard;
-    removed_event_chain = _async_queue.remove_if([=](lwip_tcp_event_packet_t &pkt) {
-      return pkt.client == client;
-    });
+    removed_event_chain = _async_queue.remove_client(client);
   }
 
   size_t count = 0;
@@ -275,6 +345,25 @@ static size_t _remove_events_for_client(AsyncClient *client) {
   return count;
 };
 
+AsyncTCPQueueStats asyncTcpQueueStats() {
+  FairEventQueueStats q;
+  {
+    queue_mutex_guard guard;
+    q = _async_queue.stats();
+  }
+  return {q.queued, q.high_watermark, q.active_clients, q.polls_coalesced, q.shared_fallbacks, q.hog_throttles, q.hog_resets};
+}
+
+static volatile AsyncTCPEventTimeHook _event_time_hook = NULL;
+
+void asyncTcpSetEventTimeHook(AsyncTCPEventTimeHook hook) {
+  _event_time_hook = hook;
+}
+
+TaskHandle_t asyncTcpTaskHandle() {
+  return _async_service_task_handle;
+}
+
 void AsyncTCP_detail::handle_async_event(lwip_tcp_event_packet_t *e) {
   if (e->client == NULL) {
     // do nothing when arg is NULL
@@ -316,7 +405,18 @@ static void _async_service_task(void *pvParameters) {
 #endif
   for (;;) {
     while (auto packet = _get_async_event()) {
+      uint32_t started = _async_now_us();
       AsyncTCP_detail::handle_async_event(packet);
+      uint32_t finished = _async_now_us();
+      AsyncTCPEventTimeHook hook = _event_time_hook;
+      if (hook) {
+        hook(finished - started);
+      }
+      AsyncClient *hog = _complete_async_event(finished - started, finished);
+      if (hog) {
+        async_tcp_log_w("resetting connection that keeps hogging the async task");
+        hog->abort();
+      }
 #if CONFIG_ASYNC_TCP_USE_WDT
       esp_task_wdt_reset();
 #endif
@@ -418,18 +518,17 @@ static int8_t _tcp_connected(void *arg, tcp_pcb *pcb, int8_t err) {
 }
 
 int8_t AsyncTCP_detail::tcp_poll(void *arg, struct tcp_pcb *pcb) {
-  // throttle polling events queueing when event queue is getting filled up, let it handle _onack's
+  // ets_printf("+P: 0x%08x\n", pcb);
+  AsyncClient *client = reinterpret_cast<AsyncClient *>(arg);
+
+  // don't allocate a poll that would be coalesced: one is already pending, or the connection is throttled
   {
     queue_mutex_guard guard;
-    // async_tcp_log_d("qs:%u", _async_queue.size());
-    if (_async_queue.size() > (rand() % CONFIG_ASYNC_TCP_QUEUE_SIZE / 2 + CONFIG_ASYNC_TCP_QUEUE_SIZE / 4)) {
-      async_tcp_log_d("throttling");
+    if (!_async_queue.accepts_poll(client)) {
       return ERR_OK;
     }
   }
 
-  // ets_printf("+P: 0x%08x\n", pcb);
-  AsyncClient *client = reinterpret_cast<AsyncClient *>(arg);
   lwip_tcp_event_packet_t *e = new (std::nothrow) lwip_tcp_event_packet_t{LWIP_TCP_POLL, client};
   if (!e) {
     async_tcp_log_e("Failed to allocate event packet");
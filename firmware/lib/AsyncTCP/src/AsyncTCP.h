@@ -54,12 +54,79 @@ extern "C" {
 #define CONFIG_ASYNC_TCP_QUEUE_SIZE 64
 #endif
 
+// event packets preallocated in a static slab pool (0 = always use the heap); the slack covers the packet being
+// dispatched and packets still being filled in lwIP callbacks while the queue is at its nominal size
+#ifndef CONFIG_ASYNC_TCP_EVENT_POOL_SIZE
+#define CONFIG_ASYNC_TCP_EVENT_POOL_SIZE (CONFIG_ASYNC_TCP_QUEUE_SIZE + 4)
+#endif
+
+// per-connection event queues served round-robin; connections beyond this share one FIFO
+#ifndef CONFIG_ASYNC_TCP_MAX_CLIENT_QUEUES
+#ifdef CONFIG_LWIP_MAX_ACTIVE_TCP
+#define CONFIG_ASYNC_TCP_MAX_CLIENT_QUEUES CONFIG_LWIP_MAX_ACTIVE_TCP
+#else
+#define CONFIG_ASYNC_TCP_MAX_CLIENT_QUEUES 16
+#endif
+#endif
+
+// a connection whose callbacks take more than BUDGET ms of the async task per WINDOW ms is throttled for the next
+// window (polls dropped, served once every SKIP_ROUNDS + 1 rounds); RESET_WINDOWS consecutive throttled windows
+// abort the connection (0 = never)
+#ifndef CONFIG_ASYNC_TCP_HOG_WINDOW_MS
+#define CONFIG_ASYNC_TCP_HOG_WINDOW_MS 1000
+#endif
+
+#ifndef CONFIG_ASYNC_TCP_HOG_BUDGET_MS
+#define CONFIG_ASYNC_TCP_HOG_BUDGET_MS 250
+#endif
+
+#ifndef CONFIG_ASYNC_TCP_HOG_SKIP_ROUNDS
+#define CONFIG_ASYNC_TCP_HOG_SKIP_ROUNDS 3
+#endif
+
+#ifndef CONFIG_ASYNC_TCP_HOG_RESET_WINDOWS
+#define CONFIG_ASYNC_TCP_HOG_RESET_WINDOWS 0
+#endif
+
 #ifndef CONFIG_ASYNC_TCP_MAX_ACK_TIME
 #define CONFIG_ASYNC_TCP_MAX_ACK_TIME 5000
 #endif
 
 class AsyncClient;
 
+// Event packet pool usage; heap_fallbacks counts packets allocated while the pool was exhausted
+struct AsyncTCPEventPoolStats {
+  size_t capacity;
+  size_t in_use;
+  size_t high_watermark;
+  uint32_t pool_allocations;
+  uint32_t heap_fallbacks;
+  uint32_t allocation_failures;
+};
+
+AsyncTCPEventPoolStats asyncTcpEventPoolStats();
+
+// Async task queue: events waiting, poll coalescing and hog detection
+struct AsyncTCPQueueStats {
+  size_t queued;
+  size_t high_watermark;
+  size_t active_clients;
+  uint32_t polls_coalesced;
+  uint32_t shared_fallbacks;
+  uint32_t hog_throttles;
+  uint32_t hog_resets;
+};
+
+AsyncTCPQueueStats asyncTcpQueueStats();
+
+// Optional observer for event dispatch time, called from the async task after every event.
+// Reuses the timestamps taken for hog detection; pass NULL to remove.
+typedef void (*AsyncTCPEventTimeHook)(uint32_t busy_us);
+void asyncTcpSetEventTimeHook(AsyncTCPEventTimeHook hook);
+
+// Handle of the async service task (NULL until the first server or client starts it), e.g. for stack high-water marks
+TaskHandle_t asyncTcpTaskHandle();
+
 #define ASYNC_WRITE_FLAG_COPY 0x01  // will allocate new buffer to hold the data while sending (else will hold reference to the data given)
 #define ASYNC_WRITE_FLAG_MORE 0x02  // will not send PSH flag, meaning that there should be more data to be sent before the application should react.
 
@@ -0,0 +1,371 @@
+// Per-connection event queues with round-robin dispatch
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include <utility>
+
+#include "AsyncTCPSimpleIntrusiveList.h"
+
+// Statistics snapshot, see FairEventQueue::stats()
+struct FairEventQueueStats {
+  size_t queued;            // events waiting, all connections
+  size_t high_watermark;
+  size_t active_clients;    // connections with events waiting
+  uint32_t polls_coalesced; // polls dropped because one was already pending (or the connection is throttled)
+  uint32_t shared_fallbacks;// events queued on the shared FIFO because every slot was busy
+  uint32_t hog_throttles;   // windows in which a connection was throttled for hogging the task
+  uint32_t hog_resets;      // connections reported for reset
+};
+
+/*
+  Each connection gets its own FIFO and the connections with pending events are
+  served round-robin, one event per turn, so a dashboard that is slow to
+  consume (or whose callbacks are slow) cannot delay the others by more than
+  one of its own events per round. Polls are coalesced deterministically: a
+  connection has at most one poll pending, wherever it sits in the queue.
+
+  The caller reports how long each callback ran (complete()). A connection
+  whose callbacks use more than HogBudgetUs of the task in a HogWindowUs window
+  is throttled for the next window: its polls are dropped and it is served
+  once every HogSkipRounds + 1 rounds while others are waiting. After
+  HogResetWindows consecutive throttled windows (0 = never) complete()
+  returns it so the caller can reset the connection.
+
+  Events with a null client, and events arriving while all MaxClients slots
+  hold pending events, go to a shared FIFO that takes one turn per round like
+  any connection. A connection with events in the shared FIFO keeps using it
+  until they are dispatched, so its events stay in order, and the shared FIFO
+  tracks pending polls per connection (up to MaxSharedPolls connections; past
+  that, polls are queued without coalescing rather than dropped). Not
+  thread-safe: the caller holds the queue lock. Meant for static storage
+  (SimpleIntrusiveList relies on zero-initialization).
+*/
+template<typename T, size_t MaxClients, size_t MaxSharedPolls = MaxClients> class FairEventQueue {
+  static_assert(std::is_same<decltype(std::declval<T>().next), T *>::value, "Template type must have public 'T* next' member");
+
+public:
+  typedef typename std::remove_reference<decltype(std::declval<T>().client)>::type client_type;
+
+  struct Config {
+    uint32_t hog_window_us;
+    uint32_t hog_budget_us;
+    uint8_t hog_skip_rounds;
+    uint8_t hog_reset_windows;
+  };
+
+  explicit FairEventQueue(const Config &config)
+    : _config(config), _shared_polls(), _active_head(nullptr), _active_tail(nullptr), _current(nullptr), _current_client(nullptr), _size(0), _window_start(0),
+      _window_started(false), _stats() {}
+
+  // Noncopyable, nonmovable
+  FairEventQueue(const FairEventQueue &) = delete;
+  FairEventQueue &operator=(const FairEventQueue &) = delete;
+
+  // Returns false if the event was not queued (coalesced poll); the caller frees it
+  bool push(T *e, bool poll, bool front = false) {
+    Queue *q = queue_for(e->client);
+    if (poll) {
+      T **pending = poll_entry(q, e->client, true);
+      if ((pending && *pending) || q->throttled) {
+        ++_stats.polls_coalesced;
+        return false;
+      }
+      if (pending) {
+        *pending = e;
+      }
+    }
+    if (front) {
+      q->events.push_front(e);
+    } else {
+      q->events.push_back(e);
+    }
+    activate(q);
+    if (++_size > _stats.high_watermark) {
+      _stats.high_watermark = _size;
+    }
+    return true;
+  }
+
+  // True if a poll for this connection would be queued
+  bool accepts_poll(client_type client) const {
+    FairEventQueue *self = const_cast<FairEventQueue *>(this);
+    Queue *q = self->find(client);
+    if (!q && self->in_shared(client)) {
+      q = &self->_shared;
+    }
+    if (!q) {
+      return true;
+    }
+    T **pending = self->poll_entry(q, client, false);
+    return !(pending && *pending) && !q->throttled;
+  }
+
+  T *pop() {
+    // Terminates: a throttled queue yields at most hog_skip_rounds turns in a row
+    while (_active_head) {
+      Queue *q = _active_head;
+      _active_head = q->next_active;
+      if (!_active_head) {
+        _active_tail = nullptr;
+      }
+      q->next_active = nullptr;
+
+      // A throttled connection yields its turn while someone else is waiting
+      if (q->throttled && _active_head && q->skipped < _config.hog_skip_rounds) {
+        ++q->skipped;
+        append_active(q);
+        continue;
+      }
+      q->skipped = 0;
+
+      T *e = q->events.pop_front();
+      T **pending = poll_entry(q, e->client, false);
+      if (pending && *pending == e) {
+        *pending = nullptr;
+      }
+      if (q->events.size()) {
+        append_active(q);
+      } else {
+        q->active = false;
+      }
+      --_size;
+      _current = q;
+      _current_client = e->client;
+      return e;
+    }
+    return nullptr;
+  }
+
+  // Report how long the callback for the last popped event ran. Returns a connection to reset, or nullptr: only
+  // connections that still hold a slot are returned, so the caller must remove_client() a connection before it is
+  // freed (AsyncTCP does it when the connection's final event, the error, is popped or when it is closed).
+  client_type complete(uint32_t busy_us, uint32_t now_us) {
+    client_type reset = nullptr;
+    if (_current && _current != &_shared && _current->client == _current_client) {
+      _current->busy_us += busy_us;
+    }
+    _current = nullptr;
+
+    if (!_window_started) {
+      _window_started = true;
+      _window_start = now_us;
+    } else if (now_us - _window_start >= _config.hog_window_us) {
+      _window_start = now_us;
+      for (Queue &q : _slots) {
+        if (!q.client) {
+          continue;
+        }
+        q.throttled = q.busy_us > _config.hog_budget_us;
+        q.busy_us = 0;
+        if (!q.throttled) {
+          q.hog_windows = 0;
+          continue;
+        }
+        ++_stats.hog_throttles;
+        if (_config.hog_reset_windows && ++q.hog_windows >= _config.hog_reset_windows && !reset) {
+          q.hog_windows = 0;
+          ++_stats.hog_resets;
+          reset = q.client;
+        }
+      }
+    }
+    return reset;
+  }
+
+  // Detaches every event of a connection (and its slot); returns them as a chain linked through 'next'
+  T *remove_client(client_type client) {
+    T *removed = _shared.events.remove_if([=](T &e) {
+      return e.client == client;
+    });
+    size_t count = SimpleIntrusiveList<T>::list_size(removed);
+    T **shared_poll = poll_entry(&_shared, client, false);
+    if (shared_poll) {
+      *shared_poll = nullptr;
+    }
+    if (!_shared.events.size()) {
+      deactivate(&_shared);
+    }
+
+    Queue *q = find(client);
+    if (q) {
+      T *chain = q->events.remove_if([](T &) {
+        return true;
+      });
+      count += SimpleIntrusiveList<T>::list_size(chain);
+      // Both chains are already reversed by remove_if; splice them
+      while (chain) {
+        T *next = chain->next;
+        chain->next = removed;
+        removed = chain;
+        chain = next;
+      }
+      deactivate(q);
+      if (_current == q) {
+        _current = nullptr;
+      }
+      q->reset();
+    }
+    _size -= count;
+    return removed;
+  }
+
+  size_t size() const {
+    return _size;
+  }
+
+  FairEventQueueStats stats() const {
+    FairEventQueueStats s = _stats;
+    s.queued = _size;
+    s.active_clients = 0;
+    for (const Queue *q = _active_head; q; q = q->next_active) {
+      ++s.active_clients;
+    }
+    return s;
+  }
+
+private:
+  struct Queue {
+    Queue() : client(nullptr), next_active(nullptr), pending_poll(nullptr), busy_us(0), active(false), throttled(false), skipped(0), hog_windows(0) {}
+
+    void reset() {
+      client = nullptr;
+      pending_poll = nullptr;
+      busy_us = 0;
+      throttled = false;
+      skipped = 0;
+      hog_windows = 0;
+    }
+
+    client_type client;
+    Queue *next_active;
+    T *pending_poll;
+    SimpleIntrusiveList<T> events;
+    uint32_t busy_us;  // callback time in the current window
+    bool active;       // linked in the round-robin list
+    bool throttled;
+    uint8_t skipped;
+    uint8_t hog_windows;
+  };
+
+  Queue *find(client_type client) {
+    if (client) {
+      for (Queue &q : _slots) {
+        if (q.client == client) {
+          return &q;
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  // Where the pending poll of a connection is recorded: the slot's own field, or the connection's entry in the shared
+  // table (a free entry is claimed if asked; nullptr when there is none)
+  T **poll_entry(Queue *q, client_type client, bool claim) {
+    if (q != &_shared) {
+      return &q->pending_poll;
+    }
+    T **free_entry = nullptr;
+    for (T *&entry : _shared_polls) {
+      if (entry && entry->client == client) {
+        return &entry;
+      }
+      if (!entry && !free_entry) {
+        free_entry = &entry;
+      }
+    }
+    return claim ? free_entry : nullptr;
+  }
+
+  bool in_shared(client_type client) {
+    for (T *e = _shared.events.begin(); e; e = e->next) {
+      if (e->client == client) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  Queue *queue_for(client_type client) {
+    if (!client) {
+      return &_shared;
+    }
+    Queue *q = find(client);
+    if (q) {
+      return q;
+    }
+    // Events already waiting in the shared FIFO go out first
+    if (in_shared(client)) {
+      return &_shared;
+    }
+    // Free slot first, then an idle one (its connection has nothing pending and is not throttled)
+    Queue *idle = nullptr;
+    for (Queue &slot : _slots) {
+      if (!slot.client) {
+        slot.client = client;
+        return &slot;
+      }
+      if (!idle && !slot.active && !slot.throttled) {
+        idle = &slot;
+      }
+    }
+    if (idle) {
+      idle->reset();
+      idle->client = client;
+      return idle;
+    }
+    ++_stats.shared_fallbacks;
+    return &_shared;
+  }
+
+  void append_active(Queue *q) {
+    q->next_active = nullptr;
+    if (_active_tail) {
+      _active_tail->next_active = q;
+    } else {
+      _active_head = q;
+    }
+    _active_tail = q;
+  }
+
+  void activate(Queue *q) {
+    if (!q->active) {
+      q->active = true;
+      append_active(q);
+    }
+  }
+
+  void deactivate(Queue *q) {
+    if (!q->active) {
+      return;
+    }
+    Queue **link = &_active_head;
+    Queue *prev = nullptr;
+    while (*link && *link != q) {
+      prev = *link;
+      link = &(*link)->next_active;
+    }
+    if (*link) {
+      *link = q->next_active;
+      if (_active_tail == q) {
+        _active_tail = prev;
+      }
+    }
+    q->next_active = nullptr;
+    q->active = false;
+  }
+
+  Config _config;
+  Queue _slots[MaxClients];
+  Queue _shared;
+  T *_shared_polls[MaxSharedPolls];
+  Queue *_active_head;
+  Queue *_active_tail;
+  Queue *_current;
+  client_type _current_client;
+  size_t _size;
+  uint32_t _window_start;
+  bool _window_started;
+  FairEventQueueStats _stats;
+};
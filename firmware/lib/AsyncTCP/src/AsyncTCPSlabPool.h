@@ -0,0 +1,112 @@
+// Fixed-capacity slab pool for small, fixed-size objects
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+
+#if defined(LIBRETINY)
+extern "C" {
+#include <FreeRTOS.h>
+#include <task.h>
+}
+#else
+#include "freertos/FreeRTOS.h"
+#endif
+
+// Statistics snapshot, see SimpleSlabPool::stats()
+struct SimpleSlabPoolStats {
+  size_t capacity;
+  size_t in_use;          // slots currently handed out
+  size_t high_watermark;  // highest in_use seen
+  uint32_t allocations;   // served from the pool
+  uint32_t exhausted;     // requests that found the pool empty (caller falls back to the heap)
+};
+
+/*
+  Slots live in one static array and free slots are chained through their own
+  storage, so allocate()/release() are O(1) and never touch the heap. The free
+  list is guarded by a spinlock critical section (a handful of instructions),
+  which makes it safe to use from the lwIP thread, the async task and user tasks
+  on either core. When the pool is empty allocate() returns nullptr; callers keep
+  a heap fallback and release() tells the two apart with owns().
+*/
+template<size_t ObjectSize, size_t ObjectAlign, size_t Capacity> class SimpleSlabPool {
+  union Slot {
+    Slot *next;
+    alignas(ObjectAlign) uint8_t storage[ObjectSize];
+  };
+
+public:
+  SimpleSlabPool() : _free(nullptr), _in_use(0), _high_watermark(0), _allocations(0), _exhausted(0) {
+    for (size_t i = Capacity; i > 0; --i) {
+      _slots[i - 1].next = _free;
+      _free = &_slots[i - 1];
+    }
+  }
+
+  // Noncopyable, nonmovable
+  SimpleSlabPool(const SimpleSlabPool &) = delete;
+  SimpleSlabPool &operator=(const SimpleSlabPool &) = delete;
+
+  void *allocate() {
+    lock();
+    Slot *slot = _free;
+    if (slot) {
+      _free = slot->next;
+      ++_allocations;
+      if (++_in_use > _high_watermark) {
+        _high_watermark = _in_use;
+      }
+    } else {
+      ++_exhausted;
+    }
+    unlock();
+    return slot;
+  }
+
+  void release(void *ptr) {
+    Slot *slot = static_cast<Slot *>(ptr);
+    lock();
+    slot->next = _free;
+    _free = slot;
+    --_in_use;
+    unlock();
+  }
+
+  inline bool owns(const void *ptr) const {
+    return ptr >= static_cast<const void *>(&_slots[0]) && ptr < static_cast<const void *>(&_slots[Capacity]);
+  }
+
+  SimpleSlabPoolStats stats() {
+    lock();
+    SimpleSlabPoolStats s = {Capacity, _in_use, _high_watermark, _allocations, _exhausted};
+    unlock();
+    return s;
+  }
+
+private:
+#if defined(LIBRETINY)
+  inline void lock() {
+    taskENTER_CRITICAL();
+  }
+  inline void unlock() {
+    taskEXIT_CRITICAL();
+  }
+#else
+  inline void lock() {
+    portENTER_CRITICAL(&_lock);
+  }
+  inline void unlock() {
+    portEXIT_CRITICAL(&_lock);
+  }
+  portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+  Slot _slots[Capacity];
+  Slot *_free;
+  size_t _in_use;
+  size_t _high_watermark;
+  uint32_t _allocations;
+  uint32_t _exhausted;
+};
@@ -0,0 +1,170 @@
+#include "DallasTemperature.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "Arduino.h"
+#include "NativeSim.h"
+
+// --- Custos de barramento (µs), derivados dos tempos do protocolo 1-Wire ---
+namespace {
+
+using sim::ONEWIRE_RESET_US;
+using sim::ONEWIRE_SLOT_US;
+using sim::settleConversion;
+using sim::startConversion;
+
+const uint32_t SEARCH_PASS_US = ONEWIRE_RESET_US + (8 + 64 * 3) * ONEWIRE_SLOT_US;      // uma passada de SEARCH ROM
+const uint32_t SKIP_ROM_CMD_US = ONEWIRE_RESET_US + (8 + 8) * ONEWIRE_SLOT_US;          // SKIP ROM + CONVERT T
+const uint32_t MATCH_ROM_CMD_US = ONEWIRE_RESET_US + (8 + 64 + 8) * ONEWIRE_SLOT_US;    // MATCH ROM + comando
+const uint32_t READ_SCRATCHPAD_US = MATCH_ROM_CMD_US + 72 * ONEWIRE_SLOT_US;            // + 9 bytes de scratchpad
+
+void busTime(uint32_t us) {
+    sim::oneWireBusTime(us);
+}
+
+sim::TemperatureProbe* findProbe(const uint8_t* deviceAddress) {
+    for (auto& probe : sim::probes()) {
+        if (probe.connected && memcmp(probe.address, deviceAddress, 8) == 0) return &probe;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+void DallasTemperature::begin() {
+    _devices = 0;
+    _bitResolution = 9;
+    for (auto& probe : sim::probes()) {
+        busTime(SEARCH_PASS_US + READ_SCRATCHPAD_US);
+        if (!probe.connected) continue;
+        _devices++;
+        if (probe.resolution > _bitResolution) _bitResolution = probe.resolution;
+    }
+    busTime(SEARCH_PASS_US); // passada final que encerra a busca
+}
+
+bool DallasTemperature::validAddress(const uint8_t* deviceAddress) {
+    return OneWire::crc8(deviceAddress, 7) == deviceAddress[7];
+}
+
+bool DallasTemperature::getAddress(uint8_t* deviceAddress, uint8_t index) {
+    // Como na biblioteca real: refaz o SEARCH ROM desde o início até chegar ao índice
+    uint8_t depth = 0;
+    for (auto& probe : sim::probes()) {
+        if (!probe.connected) continue;
+        busTime(SEARCH_PASS_US);
+        if (depth == index) {
+            memcpy(deviceAddress, probe.address, 8);
+            return true;
+        }
+        depth++;
+    }
+    busTime(SEARCH_PASS_US);
+    return false;
+}
+
+bool DallasTemperature::isConnected(const uint8_t* deviceAddress) {
+    busTime(READ_SCRATCHPAD_US);
+    return findProbe(deviceAddress) != nullptr;
+}
+
+void DallasTemperature::setResolution(uint8_t newResolution) {
+    _bitResolution = newResolution < 9 ? 9 : (newResolution > 12 ? 12 : newResolution);
+    for (auto& probe : sim::probes()) {
+        if (probe.connected) setResolution(probe.address, _bitResolution, true);
+    }
+}
+
+uint8_t DallasTemperature::getResolution(const uint8_t* deviceAddress) {
+    busTime(READ_SCRATCHPAD_US);
+    sim::TemperatureProbe* probe = findProbe(deviceAddress);
+    return probe ? probe->resolution : 0;
+}
+
+bool DallasTemperature::setResolution(const uint8_t* deviceAddress, uint8_t newResolution,
+                                      bool skipGlobalBitResolutionCalculation) {
+    busTime(READ_SCRATCHPAD_US + MATCH_ROM_CMD_US + 24 * ONEWIRE_SLOT_US);
+    sim::TemperatureProbe* probe = findProbe(deviceAddress);
+    if (!probe) return false;
+    probe->resolution = newResolution < 9 ? 9 : (newResolution > 12 ? 12 : newResolution);
+    if (!skipGlobalBitResolutionCalculation && probe->resolution > _bitResolution) {
+        _bitResolution = probe->resolution;
+    }
+    return true;
+}
+
+DallasTemperature::request_t DallasTemperature::requestTemperatures() {
+    request_t req = {true, millis()};
+    busTime(SKIP_ROM_CMD_US);
+    for (auto& probe : sim::probes()) {
+        if (probe.connected) startConversion(probe);
+    }
+    if (_waitForConversion) blockTillConversionComplete(_bitResolution, req.timestamp);
+    return req;
+}
+
+DallasTemperature::request_t DallasTemperature::requestTemperaturesByAddress(const uint8_t* deviceAddress) {
+    request_t req = {false, millis()};
+    busTime(MATCH_ROM_CMD_US);
+    sim::TemperatureProbe* probe = findProbe(deviceAddress);
+    if (!probe) return req;
+    startConversion(*probe);
+    req.result = true;
+    if (_waitForConversion) blockTillConversionComplete(probe->resolution, req.timestamp);
+    return req;
+}
+
+DallasTemperature::request_t DallasTemperature::requestTemperaturesByIndex(uint8_t index) {
+    DeviceAddress deviceAddress;
+    if (!getAddress(deviceAddress, index)) return {false, millis()};
+    return requestTemperaturesByAddress(deviceAddress);
+}
+
+int32_t DallasTemperature::getTemp(const uint8_t* deviceAddress) {
+    busTime(READ_SCRATCHPAD_US);
+    sim::TemperatureProbe* probe = findProbe(deviceAddress);
+    if (!probe) return DEVICE_DISCONNECTED_RAW;
+    settleConversion(*probe);
+    return static_cast<int32_t>(std::lround(probe->latchedC * 128.0f));
+}
+
+float DallasTemperature::getTempC(const uint8_t* deviceAddress) {
+    int32_t raw = getTemp(deviceAddress);
+    return raw <= DEVICE_DISCONNECTED_RAW ? DEVICE_DISCONNECTED_C : static_cast<float>(raw) * 0.0078125f;
+}
+
+float DallasTemperature::getTempCByIndex(uint8_t index) {
+    DeviceAddress deviceAddress;
+    if (!getAddress(deviceAddress, index)) return DEVICE_DISCONNECTED_C;
+    return getTempC(deviceAddress);
+}
+
+bool DallasTemperature::isConversionComplete() {
+    // Leitura de um único slot: o barramento fica em 0 enquanto algum sensor converte
+    busTime(ONEWIRE_SLOT_US);
+    bool complete = true;
+    for (auto& probe : sim::probes()) {
+        settleConversion(probe);
+        complete &= !probe.converting;
+    }
+    return complete;
+}
+
+uint16_t DallasTemperature::millisToWaitForConversion(uint8_t bitResolution) {
+    switch (bitResolution) {
+    case 9: return 94;
+    case 10: return 188;
+    case 11: return 375;
+    default: return 750;
+    }
+}
+
+void DallasTemperature::blockTillConversionComplete(uint8_t bitResolution, unsigned long start) {
+    if (_checkForConversion) {
+        while (!isConversionComplete() && millis() - start < millisToWaitForConversion(12)) yield();
+    } else {
+        unsigned long wait = millisToWaitForConversion(bitResolution);
+        while (millis() - start < wait) yield();
+    }
+}
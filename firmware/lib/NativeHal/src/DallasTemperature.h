@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+
+#include "OneWire.h"
+
+#define DEVICE_DISCONNECTED_C -127
+#define DEVICE_DISCONNECTED_F -196.6
+#define DEVICE_DISCONNECTED_RAW -7040
+
+typedef uint8_t DeviceAddress[8];
+
+// Mesma API pública da DallasTemperature 3.11 (subconjunto usado pelo firmware).
+// Os DS18B20 vivem em sim::probes(); cada transação no barramento consome o
+// tempo que levaria no hardware real.
+class DallasTemperature {
+public:
+    struct request_t {
+        bool result;
+        unsigned long timestamp;
+
+        operator bool() { return result; }
+    };
+
+    DallasTemperature() = default;
+    explicit DallasTemperature(OneWire* wire) : _wire(wire) {}
+
+    void setOneWire(OneWire* wire) { _wire = wire; }
+
+    void begin();
+    uint8_t getDeviceCount() const { return _devices; }
+    uint8_t getDS18Count() const { return _devices; }
+    bool validAddress(const uint8_t* deviceAddress);
+    bool getAddress(uint8_t* deviceAddress, uint8_t index);
+    bool isConnected(const uint8_t* deviceAddress);
+
+    uint8_t getResolution() const { return _bitResolution; }
+    void setResolution(uint8_t newResolution);
+    uint8_t getResolution(const uint8_t* deviceAddress);
+    bool setResolution(const uint8_t* deviceAddress, uint8_t newResolution,
+                       bool skipGlobalBitResolutionCalculation = false);
+
+    void setWaitForConversion(bool flag) { _waitForConversion = flag; }
+    bool getWaitForConversion() const { return _waitForConversion; }
+    void setCheckForConversion(bool flag) { _checkForConversion = flag; }
+    bool getCheckForConversion() const { return _checkForConversion; }
+
+    request_t requestTemperatures();
+    request_t requestTemperaturesByAddress(const uint8_t* deviceAddress);
+    request_t requestTemperaturesByIndex(uint8_t index);
+
+    int32_t getTemp(const uint8_t* deviceAddress);
+    float getTempC(const uint8_t* deviceAddress);
+    float getTempCByIndex(uint8_t index);
+
+    bool isParasitePowerMode() const { return false; }
+    bool isConversionComplete();
+
+    static uint16_t millisToWaitForConversion(uint8_t bitResolution);
+    uint16_t millisToWaitForConversion() const { return millisToWaitForConversion(_bitResolution); }
+
+private:
+    void blockTillConversionComplete(uint8_t bitResolution, unsigned long start);
+
+    OneWire* _wire = nullptr;
+    uint8_t _devices = 0;
+    uint8_t _bitResolution = 9;
+    bool _waitForConversion = true;
+    bool _checkForConversion = true;
+};
@@ -0,0 +1,586 @@
+#include "ESPAsyncWebServer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <new>
+#include <regex>
+
+#include "NativeSim.h"
+
+namespace {
+
+std::vector<AsyncWebServer*>& servers() {
+    static std::vector<AsyncWebServer*> list;
+    return list;
+}
+
+std::vector<AsyncWebSocket*>& sockets() {
+    static std::vector<AsyncWebSocket*> list;
+    return list;
+}
+
+const String emptyString;
+
+bool equalsIgnoreCase(const String& a, const String& b) {
+    if (a.length() != b.length()) return false;
+    for (unsigned i = 0; i < a.length(); i++) {
+        if (tolower(static_cast<unsigned char>(a[i])) != tolower(static_cast<unsigned char>(b[i]))) return false;
+    }
+    return true;
+}
+
+std::string urlDecode(const std::string& in) {
+    std::string out;
+    for (size_t i = 0; i < in.size(); i++) {
+        if (in[i] == '+') {
+            out += ' ';
+        } else if (in[i] == '%' && i + 2 < in.size()) {
+            out += static_cast<char>(strtol(in.substr(i + 1, 2).c_str(), nullptr, 16));
+            i += 2;
+        } else {
+            out += in[i];
+        }
+    }
+    return out;
+}
+
+void parseParams(const std::string& query, bool form, std::vector<AsyncWebParameter>& params) {
+    size_t start = 0;
+    while (start < query.size()) {
+        size_t end = query.find('&', start);
+        if (end == std::string::npos) end = query.size();
+        std::string pair = query.substr(start, end - start);
+        size_t eq = pair.find('=');
+        std::string name = urlDecode(pair.substr(0, eq));
+        std::string value = eq == std::string::npos ? std::string() : urlDecode(pair.substr(eq + 1));
+        if (!name.empty()) params.emplace_back(String(name), String(value), form);
+        start = end + 1;
+    }
+}
+
+size_t approxHeaderBytes(const AsyncWebServerResponse& response) {
+    // Linha de status + Content-Type/Length + cabeçalhos extras, como o servidor real os serializa
+    size_t bytes = 64 + response.contentType().length();
+    for (const auto& h : response.headers()) bytes += h.name().length() + h.value().length() + 4;
+    return bytes;
+}
+
+} // namespace
+
+// --- AsyncWebServerRequest ---
+
+const char* AsyncWebServerRequest::methodToString() const {
+    switch (_method) {
+    case HTTP_GET: return "GET";
+    case HTTP_POST: return "POST";
+    case HTTP_DELETE: return "DELETE";
+    case HTTP_PUT: return "PUT";
+    case HTTP_PATCH: return "PATCH";
+    case HTTP_HEAD: return "HEAD";
+    case HTTP_OPTIONS: return "OPTIONS";
+    default: return "UNKNOWN";
+    }
+}
+
+bool AsyncWebServerRequest::hasParam(const String& name, bool post, bool file) const {
+    return getParam(name, post, file) != nullptr;
+}
+
+const AsyncWebParameter* AsyncWebServerRequest::getParam(const String& name, bool post, bool file) const {
+    (void)file;
+    for (const auto& p : _params) {
+        if (p.name() == name && p.isPost() == post) return &p;
+    }
+    return nullptr;
+}
+
+bool AsyncWebServerRequest::hasArg(const char* name) const {
+    for (const auto& p : _params) {
+        if (p.name() == name) return true;
+    }
+    return false;
+}
+
+const String& AsyncWebServerRequest::arg(const String& name) const {
+    for (const auto& p : _params) {
+        if (p.name() == name) return p.value();
+    }
+    return emptyString;
+}
+
+const String& AsyncWebServerRequest::pathArg(size_t i) const {
+    return i < _pathParams.size() ? _pathParams[i] : emptyString;
+}
+
+bool AsyncWebServerRequest::hasHeader(const String& name) const {
+    return getHeader(name) != nullptr;
+}
+
+const AsyncWebHeader* AsyncWebServerRequest::getHeader(const String& name) const {
+    for (const auto& h : _headers) {
+        if (equalsIgnoreCase(h.name(), name)) return &h;
+    }
+    return nullptr;
+}
+
+const String& AsyncWebServerRequest::header(const char* name) const {
+    const AsyncWebHeader* h = getHeader(name);
+    return h ? h->value() : emptyString;
+}
+
+void AsyncWebServerRequest::send(int code, const String& contentType, const String& content) {
+    send(beginResponse(code, contentType, content));
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse* response) {
+    if (_response) {
+        delete response; // o servidor real também ignora um segundo send()
+        return;
+    }
+    _response.reset(response);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(int code, const String& contentType,
+                                                             const String& content) {
+    return new AsyncWebServerResponse(code, contentType, content.str());
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse_P(int code, const String& contentType,
+                                                               const uint8_t* content, size_t len) {
+    return new AsyncWebServerResponse(code, contentType, content, len);
+}
+
+void AsyncWebServerRequest::redirect(const String& url) {
+    AsyncWebServerResponse* response = beginResponse(302);
+    response->addHeader("Location", url);
+    send(response);
+}
+
+// --- AsyncCallbackWebHandler ---
+
+bool AsyncCallbackWebHandler::canHandle(AsyncWebServerRequest* request) {
+    if (!_onRequest || !(_method & request->method())) return false;
+    const std::string& uri = _uri.str();
+    const std::string& url = request->url().str();
+    if (!uri.empty() && uri[0] == '^') {
+        std::smatch match;
+        std::regex pattern(uri);
+        if (!std::regex_search(url, match, pattern)) return false;
+        request->_pathParams.clear();
+        for (size_t i = 1; i < match.size(); i++) request->_pathParams.emplace_back(String(match[i].str()));
+        return true;
+    }
+    if (!uri.empty() && uri.back() == '*') {
+        return url.compare(0, uri.size() - 1, uri, 0, uri.size() - 1) == 0;
+    }
+    return url == uri || url.compare(0, uri.size() + 1, uri + "/") == 0;
+}
+
+void AsyncCallbackWebHandler::handleRequest(AsyncWebServerRequest* request) {
+    if (_onRequest) _onRequest(request);
+}
+
+void AsyncCallbackWebHandler::handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index,
+                                         size_t total) {
+    if (_onBody) _onBody(request, data, len, index, total);
+}
+
+// --- AsyncWebServer ---
+
+AsyncWebServer::AsyncWebServer(uint16_t port) : _port(port) {
+    servers().push_back(this);
+}
+
+AsyncWebServer::~AsyncWebServer() {
+    auto& list = servers();
+    list.erase(std::remove(list.begin(), list.end(), this), list.end());
+}
+
+void AsyncWebServer::reset() {
+    _handlers.clear();
+    _ownedHandlers.clear();
+    _notFound = nullptr;
+}
+
+AsyncWebHandler& AsyncWebServer::addHandler(AsyncWebHandler* handler) {
+    _handlers.push_back(handler);
+    if (auto* ws = dynamic_cast<AsyncWebSocket*>(handler)) sockets().push_back(ws);
+    return *handler;
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, ArRequestHandlerFunction onRequest) {
+    return on(uri, HTTP_ANY, std::move(onRequest), nullptr, nullptr);
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method,
+                                            ArRequestHandlerFunction onRequest) {
+    return on(uri, method, std::move(onRequest), nullptr, nullptr);
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method,
+                                            ArRequestHandlerFunction onRequest, ArUploadHandlerFunction onUpload) {
+    return on(uri, method, std::move(onRequest), std::move(onUpload), nullptr);
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method,
+                                            ArRequestHandlerFunction onRequest, ArUploadHandlerFunction onUpload,
+                                            ArBodyHandlerFunction onBody) {
+    auto handler = std::make_unique<AsyncCallbackWebHandler>();
+    handler->setUri(uri);
+    handler->setMethod(method);
+    handler->onRequest(std::move(onRequest));
+    handler->onUpload(std::move(onUpload));
+    handler->onBody(std::move(onBody));
+    AsyncCallbackWebHandler& ref = *handler;
+    _ownedHandlers.push_back(std::move(handler));
+    addHandler(&ref);
+    return ref;
+}
+
+// --- WebSocket ---
+
+AsyncWebSocketPayload* AsyncWebSocketPayload::create(size_t length) {
+    void* block = ::operator new(sizeof(AsyncWebSocketPayload) + length + 1);
+    sim::stats().wsHeapBlocks++;
+    AsyncWebSocketPayload* payload = new (block) AsyncWebSocketPayload(length);
+    payload->data()[length] = 0;
+    return payload;
+}
+
+void AsyncWebSocketPayload::release() {
+    if (_refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+    this->~AsyncWebSocketPayload();
+    ::operator delete(this);
+}
+
+bool AsyncWebSocketClient::enqueue(AwsFrameType opcode, AsyncWebSocketPayload* payload) {
+    Frame frame(opcode, payload);
+    size_t len = payload->length();
+    std::lock_guard<std::recursive_mutex> guard(_server->_lock);
+    if (!_open) return false;
+    if (_outbox.size() >= WS_MAX_QUEUED_MESSAGES) {
+        sim::stats().wsMessagesDropped++;
+        return false;
+    }
+    _outbox.push_back(std::move(frame));
+    if (_outbox.size() > _outboxPeak) _outboxPeak = _outbox.size();
+    sim::stats().wsMessagesSent++;
+    sim::stats().wsBytesSent += len + (len < 126 ? 2 : 4); // payload + cabeçalho do frame
+    return true;
+}
+
+// Mensagem avulsa: cópia própria, como a biblioteca faz
+static AsyncWebSocketPayload* copyPayload(const void* data, size_t len) {
+    AsyncWebSocketPayload* payload = AsyncWebSocketPayload::create(len);
+    memcpy(payload->data(), data, len);
+    return payload;
+}
+
+bool AsyncWebSocketClient::text(const char* message, size_t len) {
+    return enqueue(WS_TEXT, copyPayload(message, len));
+}
+
+bool AsyncWebSocketClient::binary(const uint8_t* message, size_t len) {
+    return enqueue(WS_BINARY, copyPayload(message, len));
+}
+
+bool AsyncWebSocketClient::text(AsyncWebSocketMessageBuffer* buffer) {
+    if (!buffer) return false;
+    buffer->_payload->retain();
+    bool queued = enqueue(WS_TEXT, buffer->_payload);
+    delete buffer;
+    return queued;
+}
+
+bool AsyncWebSocketClient::binary(AsyncWebSocketMessageBuffer* buffer) {
+    if (!buffer) return false;
+    buffer->_payload->retain();
+    bool queued = enqueue(WS_BINARY, buffer->_payload);
+    delete buffer;
+    return queued;
+}
+
+void AsyncWebSocketClient::close(uint16_t code, const char* message) {
+    (void)code;
+    (void)message;
+    std::lock_guard<std::recursive_mutex> guard(_server->_lock);
+    _open = false;
+}
+
+size_t AsyncWebSocketClient::queueLen() const {
+    std::lock_guard<std::recursive_mutex> guard(_server->_lock);
+    return _outbox.size();
+}
+
+size_t AsyncWebSocket::count() const {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    return static_cast<size_t>(std::count_if(_clients.begin(), _clients.end(),
+                                             [](const std::unique_ptr<AsyncWebSocketClient>& c) { return c->_open; }));
+}
+
+AsyncWebSocketClient* AsyncWebSocket::client(uint32_t id) {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    for (auto& c : _clients) {
+        if (c->_id == id && c->_open) return c.get();
+    }
+    return nullptr;
+}
+
+void AsyncWebSocket::cleanupClients(uint16_t maxClients) {
+    std::vector<std::unique_ptr<AsyncWebSocketClient>> closed;
+    {
+        std::lock_guard<std::recursive_mutex> guard(_lock);
+        // Fecha os clientes mais antigos acima do limite e descarta os já fechados
+        size_t open = count();
+        for (auto& c : _clients) {
+            if (open <= maxClients) break;
+            if (c->_open) {
+                c->_open = false;
+                open--;
+            }
+        }
+        for (auto it = _clients.begin(); it != _clients.end();) {
+            if (!(*it)->_open) {
+                closed.push_back(std::move(*it));
+                it = _clients.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (auto& c : closed) emit(c.get(), WS_EVT_DISCONNECT, nullptr, nullptr, 0);
+}
+
+void AsyncWebSocket::closeAll(uint16_t code, const char* message) {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    for (auto& c : _clients) c->close(code, message);
+}
+
+bool AsyncWebSocket::text(uint32_t id, const char* message, size_t len) {
+    AsyncWebSocketClient* c = client(id);
+    return c && c->text(message, len);
+}
+
+bool AsyncWebSocket::binary(uint32_t id, const uint8_t* message, size_t len) {
+    AsyncWebSocketClient* c = client(id);
+    return c && c->binary(message, len);
+}
+
+void AsyncWebSocket::textAll(const char* message, size_t len) {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    // Assim como na biblioteca, cada cliente recebe sua própria cópia do payload
+    for (auto& c : _clients) {
+        if (c->_open) c->text(message, len);
+    }
+}
+
+AsyncWebSocketMessageBuffer* AsyncWebSocket::makeBuffer(size_t size) {
+    sim::stats().wsHeapBlocks++;
+    return new AsyncWebSocketMessageBuffer(size);
+}
+
+void AsyncWebSocket::enqueueAll(AwsFrameType opcode, AsyncWebSocketMessageBuffer* buffer) {
+    if (!buffer) return;
+    {
+        std::lock_guard<std::recursive_mutex> guard(_lock);
+        // Todas as filas apontam para o mesmo payload (sem cópia por cliente)
+        for (auto& c : _clients) {
+            if (!c->_open) continue;
+            buffer->_payload->retain();
+            c->enqueue(opcode, buffer->_payload);
+        }
+    }
+    delete buffer;
+}
+
+void AsyncWebSocket::textAll(AsyncWebSocketMessageBuffer* buffer) {
+    enqueueAll(WS_TEXT, buffer);
+}
+
+void AsyncWebSocket::binaryAll(AsyncWebSocketMessageBuffer* buffer) {
+    enqueueAll(WS_BINARY, buffer);
+}
+
+void AsyncWebSocket::binaryAll(const uint8_t* message, size_t len) {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    for (auto& c : _clients) {
+        if (c->_open) c->binary(message, len);
+    }
+}
+
+void AsyncWebSocket::emit(AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len) {
+    if (_eventHandler) _eventHandler(this, client, type, arg, data, len);
+}
+
+// --- Injeção de tráfego ---
+
+struct SimHttpExchange {
+    static sim::HttpResponse run(WebRequestMethod method, const std::string& url, const std::string& body,
+                                 const std::vector<std::pair<std::string, std::string>>& headers) {
+        AsyncWebServerRequest request;
+        request._method = method;
+        size_t q = url.find('?');
+        request._url = String(url.substr(0, q));
+        if (q != std::string::npos) parseParams(url.substr(q + 1), false, request._params);
+
+        bool form = false;
+        for (const auto& h : headers) {
+            request._headers.emplace_back(String(h.first), String(h.second));
+            String name(h.first);
+            if (equalsIgnoreCase(name, "Content-Type") &&
+                h.second.find("application/x-www-form-urlencoded") != std::string::npos) {
+                form = true;
+            }
+        }
+        if (form) parseParams(body, true, request._params);
+
+        AsyncWebHandler* target = nullptr;
+        for (AsyncWebServer* server : servers()) {
+            if (!server->_running) continue;
+            for (AsyncWebHandler* handler : server->_handlers) {
+                if (handler->filter(&request) && handler->canHandle(&request)) {
+                    target = handler;
+                    break;
+                }
+            }
+            if (target) break;
+        }
+
+        if (target) {
+            if (!body.empty() && !form) {
+                std::string copy = body;
+                target->handleBody(&request, reinterpret_cast<uint8_t*>(&copy[0]), copy.size(), 0, copy.size());
+            }
+            target->handleRequest(&request);
+        } else {
+            for (AsyncWebServer* server : servers()) {
+                if (server->_running && server->_notFound) {
+                    server->_notFound(&request);
+                    break;
+                }
+            }
+        }
+
+        sim::HttpResponse out;
+        if (request._response) {
+            const AsyncWebServerResponse& r = *request._response;
+            out.code = r.code();
+            out.contentType = r.contentType().str();
+            out.body = r.body();
+            for (const auto& h : r.headers()) out.headers.emplace_back(h.name().str(), h.value().str());
+            sim::stats().httpRequests++;
+            sim::stats().httpBytesSent += approxHeaderBytes(r) + r.bodySize();
+        } else if (!target) {
+            out.code = 404;
+        }
+        // O servidor real dispara onDisconnect depois que a resposta foi entregue e o socket fechou
+        if (request._onDisconnect) request._onDisconnect();
+        return out;
+    }
+};
+
+struct SimWebSocketPeer {
+    // Na biblioteca a numeração é por endpoint; aqui é única entre todos, porque
+    // as funções sim:: identificam o cliente só pelo id
+    static uint32_t nextId() {
+        static std::atomic<uint32_t> next{1};
+        return next++;
+    }
+
+    static AsyncWebSocket* owner(uint32_t clientId, AsyncWebSocketClient** out) {
+        for (AsyncWebSocket* ws : sockets()) {
+            if (AsyncWebSocketClient* c = ws->client(clientId)) {
+                *out = c;
+                return ws;
+            }
+        }
+        return nullptr;
+    }
+
+    static uint32_t connect(const std::string& path, const std::vector<std::pair<std::string, std::string>>& headers) {
+        AsyncWebServerRequest request;
+        request._method = HTTP_GET;
+        request._url = String(path);
+        for (const auto& h : headers) request._headers.emplace_back(String(h.first), String(h.second));
+
+        for (AsyncWebSocket* ws : sockets()) {
+            if (path != ws->url() || !ws->filter(&request)) continue;
+            AsyncWebSocketClient* client;
+            {
+                std::lock_guard<std::recursive_mutex> guard(ws->_lock);
+                ws->_clients.push_back(std::make_unique<AsyncWebSocketClient>(ws, nextId()));
+                client = ws->_clients.back().get();
+            }
+            ws->emit(client, WS_EVT_CONNECT, &request, nullptr, 0);
+            return client->id();
+        }
+        return 0;
+    }
+
+    static void send(uint32_t clientId, const std::string& payload, bool binary) {
+        AsyncWebSocketClient* client;
+        AsyncWebSocket* ws = owner(clientId, &client);
+        if (!ws) return;
+        AwsFrameInfo info = {};
+        info.message_opcode = info.opcode = binary ? WS_BINARY : WS_TEXT;
+        info.final = 1;
+        info.len = payload.size();
+        std::string copy = payload;
+        ws->emit(client, WS_EVT_DATA, &info, reinterpret_cast<uint8_t*>(&copy[0]), copy.size());
+    }
+
+    static std::vector<std::string> receive(uint32_t clientId) {
+        std::vector<std::string> messages;
+        for (AsyncWebSocket* ws : sockets()) {
+            std::lock_guard<std::recursive_mutex> guard(ws->_lock);
+            for (auto& c : ws->_clients) {
+                if (c->_id != clientId) continue;
+                for (auto& m : c->_outbox) {
+                    messages.emplace_back(reinterpret_cast<const char*>(m.payload->data()), m.payload->length());
+                }
+                c->_outbox.clear();
+            }
+        }
+        return messages;
+    }
+
+    static size_t outboxPeak(uint32_t clientId) {
+        AsyncWebSocketClient* client;
+        AsyncWebSocket* ws = owner(clientId, &client);
+        if (!ws) return 0;
+        std::lock_guard<std::recursive_mutex> guard(ws->_lock);
+        return client->_outboxPeak;
+    }
+
+    static void disconnect(uint32_t clientId) {
+        AsyncWebSocketClient* client;
+        if (owner(clientId, &client)) client->close();
+    }
+};
+
+namespace sim {
+
+std::string HttpResponse::header(const std::string& name) const {
+    for (const auto& h : headers) {
+        if (equalsIgnoreCase(String(h.first), String(name))) return h.second;
+    }
+    return std::string();
+}
+
+HttpResponse http(WebRequestMethod method, const std::string& url, const std::string& body,
+                  const std::vector<std::pair<std::string, std::string>>& headers) {
+    return SimHttpExchange::run(method, url, body, headers);
+}
+
+uint32_t wsConnect(const std::string& path, const std::vector<std::pair<std::string, std::string>>& headers) {
+    return SimWebSocketPeer::connect(path, headers);
+}
+void wsSend(uint32_t clientId, const std::string& payload, bool binary) {
+    SimWebSocketPeer::send(clientId, payload, binary);
+}
+std::vector<std::string> wsReceive(uint32_t clientId) { return SimWebSocketPeer::receive(clientId); }
+size_t wsOutboxPeak(uint32_t clientId) { return SimWebSocketPeer::outboxPeak(clientId); }
+void wsDisconnect(uint32_t clientId) { SimWebSocketPeer::disconnect(clientId); }
+
+} // namespace sim
@@ -0,0 +1,396 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Arduino.h"
+
+// Servidor HTTP/WebSocket simulado com a mesma superfície da ESPAsyncWebServer.
+// Não abre sockets: as requisições e os clientes WebSocket são injetados pelas
+// funções do namespace sim declaradas no final deste arquivo.
+
+#ifndef DEFAULT_MAX_WS_CLIENTS
+#define DEFAULT_MAX_WS_CLIENTS 8
+#endif
+#ifndef WS_MAX_QUEUED_MESSAGES
+#define WS_MAX_QUEUED_MESSAGES 32
+#endif
+
+typedef enum {
+    HTTP_GET = 0b00000001,
+    HTTP_POST = 0b00000010,
+    HTTP_DELETE = 0b00000100,
+    HTTP_PUT = 0b00001000,
+    HTTP_PATCH = 0b00010000,
+    HTTP_HEAD = 0b00100000,
+    HTTP_OPTIONS = 0b01000000,
+    HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebServerRequest;
+class AsyncWebSocket;
+class AsyncWebSocketClient;
+
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+typedef std::function<bool(AsyncWebServerRequest* request)> ArRequestFilterFunction;
+typedef std::function<void(AsyncWebServerRequest* request, const String& filename, size_t index, uint8_t* data,
+                           size_t len, bool final)>
+    ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total)>
+    ArBodyHandlerFunction;
+typedef std::function<void()> ArDisconnectHandler;
+
+class AsyncWebParameter {
+public:
+    AsyncWebParameter(const String& name, const String& value, bool form = false)
+        : _name(name), _value(value), _isForm(form) {}
+
+    const String& name() const { return _name; }
+    const String& value() const { return _value; }
+    bool isPost() const { return _isForm; }
+
+private:
+    String _name;
+    String _value;
+    bool _isForm;
+};
+
+class AsyncWebHeader {
+public:
+    AsyncWebHeader(const String& name, const String& value) : _name(name), _value(value) {}
+
+    const String& name() const { return _name; }
+    const String& value() const { return _value; }
+
+private:
+    String _name;
+    String _value;
+};
+
+class AsyncWebServerResponse {
+public:
+    AsyncWebServerResponse(int code, const String& contentType, std::string body)
+        : _code(code), _contentType(contentType), _body(std::move(body)) {}
+    // Corpo na flash (beginResponse_P): o servidor real envia direto de lá, sem cópia no heap
+    AsyncWebServerResponse(int code, const String& contentType, const uint8_t* flash, size_t len)
+        : _code(code), _contentType(contentType), _flash(flash), _flashLen(len) {}
+    virtual ~AsyncWebServerResponse() = default;
+
+    void addHeader(const String& name, const String& value) { _headers.emplace_back(name, value); }
+    void setCode(int code) { _code = code; }
+    void setContentType(const String& type) { _contentType = type; }
+
+    int code() const { return _code; }
+    const String& contentType() const { return _contentType; }
+    std::string body() const {
+        return _flash ? std::string(reinterpret_cast<const char*>(_flash), _flashLen) : _body;
+    }
+    size_t bodySize() const { return _flash ? _flashLen : _body.size(); }
+    const std::vector<AsyncWebHeader>& headers() const { return _headers; }
+
+private:
+    int _code;
+    String _contentType;
+    std::string _body;
+    const uint8_t* _flash = nullptr;
+    size_t _flashLen = 0;
+    std::vector<AsyncWebHeader> _headers;
+};
+
+class AsyncWebServerRequest {
+public:
+    WebRequestMethodComposite method() const { return _method; }
+    const String& url() const { return _url; }
+    const char* methodToString() const;
+
+    size_t params() const { return _params.size(); }
+    const AsyncWebParameter* getParam(size_t index) const { return index < _params.size() ? &_params[index] : nullptr; }
+    bool hasParam(const String& name, bool post = false, bool file = false) const;
+    const AsyncWebParameter* getParam(const String& name, bool post = false, bool file = false) const;
+    bool hasArg(const char* name) const;
+    const String& arg(const String& name) const;
+    const String& pathArg(size_t i) const;
+
+    bool hasHeader(const String& name) const;
+    const AsyncWebHeader* getHeader(const String& name) const;
+    const String& header(const char* name) const;
+
+    void send(int code, const String& contentType = String(), const String& content = String());
+    void send(AsyncWebServerResponse* response);
+    AsyncWebServerResponse* beginResponse(int code, const String& contentType = String(),
+                                          const String& content = String());
+    AsyncWebServerResponse* beginResponse_P(int code, const String& contentType, const uint8_t* content,
+                                            size_t len);
+    void redirect(const String& url);
+    void onDisconnect(ArDisconnectHandler fn) { _onDisconnect = std::move(fn); }
+
+private:
+    friend class AsyncCallbackWebHandler;
+    friend struct SimHttpExchange;
+    friend struct SimWebSocketPeer;
+
+    WebRequestMethodComposite _method = HTTP_GET;
+    String _url;
+    std::vector<AsyncWebParameter> _params;
+    std::vector<AsyncWebHeader> _headers;
+    std::vector<String> _pathParams;
+    std::unique_ptr<AsyncWebServerResponse> _response;
+    ArDisconnectHandler _onDisconnect;
+};
+
+class AsyncWebHandler {
+public:
+    virtual ~AsyncWebHandler() = default;
+
+    // Como na biblioteca: o servidor só consulta canHandle() se o filtro aceitar
+    AsyncWebHandler& setFilter(ArRequestFilterFunction fn) {
+        _filter = std::move(fn);
+        return *this;
+    }
+    bool filter(AsyncWebServerRequest* request) { return !_filter || _filter(request); }
+
+    virtual bool canHandle(AsyncWebServerRequest* request) { (void)request; return false; }
+    virtual void handleRequest(AsyncWebServerRequest* request) { (void)request; }
+    virtual void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+        (void)request; (void)data; (void)len; (void)index; (void)total;
+    }
+
+protected:
+    ArRequestFilterFunction _filter;
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+public:
+    void setUri(const String& uri) { _uri = uri; }
+    void setMethod(WebRequestMethodComposite method) { _method = method; }
+    void onRequest(ArRequestHandlerFunction fn) { _onRequest = std::move(fn); }
+    void onUpload(ArUploadHandlerFunction fn) { _onUpload = std::move(fn); }
+    void onBody(ArBodyHandlerFunction fn) { _onBody = std::move(fn); }
+
+    bool canHandle(AsyncWebServerRequest* request) override;
+    void handleRequest(AsyncWebServerRequest* request) override;
+    void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) override;
+
+private:
+    String _uri;
+    WebRequestMethodComposite _method = HTTP_ANY;
+    ArRequestHandlerFunction _onRequest;
+    ArUploadHandlerFunction _onUpload;
+    ArBodyHandlerFunction _onBody;
+};
+
+class AsyncWebServer {
+public:
+    explicit AsyncWebServer(uint16_t port);
+    ~AsyncWebServer();
+
+    void begin() { _running = true; }
+    void end() { _running = false; }
+    void reset();
+
+    AsyncWebHandler& addHandler(AsyncWebHandler* handler);
+    AsyncCallbackWebHandler& on(const char* uri, ArRequestHandlerFunction onRequest);
+    AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest);
+    AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                                ArUploadHandlerFunction onUpload);
+    AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                                ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody);
+    void onNotFound(ArRequestHandlerFunction fn) { _notFound = std::move(fn); }
+
+private:
+    friend struct SimHttpExchange;
+
+    uint16_t _port;
+    bool _running = false;
+    std::vector<AsyncWebHandler*> _handlers;
+    std::vector<std::unique_ptr<AsyncCallbackWebHandler>> _ownedHandlers;
+    ArRequestHandlerFunction _notFound;
+};
+
+// --- WebSocket ---
+
+typedef enum { WS_EVT_CONNECT, WS_EVT_DISCONNECT, WS_EVT_PONG, WS_EVT_ERROR, WS_EVT_DATA } AwsEventType;
+typedef enum { WS_CONTINUATION, WS_TEXT, WS_BINARY, WS_DISCONNECT = 0x08, WS_PING, WS_PONG } AwsFrameType;
+
+typedef struct {
+    uint8_t message_opcode;
+    uint32_t num;
+    uint8_t final;
+    uint8_t masked;
+    uint8_t opcode;
+    uint64_t len;
+    uint8_t mask[4];
+    uint64_t index;
+} AwsFrameInfo;
+
+typedef std::function<void(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg,
+                           uint8_t* data, size_t len)>
+    AwsEventHandler;
+
+// Payload de um frame num único bloco do heap: contador de referências,
+// tamanho e os bytes (mais um terminador). Cada fila de cliente que o contém
+// segura uma referência; o bloco é liberado quando o último frame sai da fila.
+class AsyncWebSocketPayload {
+public:
+    static AsyncWebSocketPayload* create(size_t length);
+
+    void retain() { _refs.fetch_add(1, std::memory_order_relaxed); }
+    void release();
+
+    uint8_t* data() { return reinterpret_cast<uint8_t*>(this + 1); }
+    size_t length() const { return _length; }
+
+private:
+    explicit AsyncWebSocketPayload(size_t length) : _length(length) {}
+
+    std::atomic<uint32_t> _refs{1};
+    size_t _length;
+};
+
+// Buffer de makeBuffer(): serializado uma vez e entregue a textAll(), que
+// enfileira o mesmo payload em todos os clientes em vez de copiá-lo
+class AsyncWebSocketMessageBuffer {
+public:
+    explicit AsyncWebSocketMessageBuffer(size_t size) : _payload(AsyncWebSocketPayload::create(size)) {}
+    ~AsyncWebSocketMessageBuffer() { _payload->release(); }
+    AsyncWebSocketMessageBuffer(const AsyncWebSocketMessageBuffer&) = delete;
+    AsyncWebSocketMessageBuffer& operator=(const AsyncWebSocketMessageBuffer&) = delete;
+
+    uint8_t* get() { return _payload->data(); }
+    size_t length() const { return _payload->length(); }
+
+private:
+    friend class AsyncWebSocket;
+    friend class AsyncWebSocketClient;
+
+    AsyncWebSocketPayload* _payload;
+};
+
+class AsyncWebSocketClient {
+public:
+    AsyncWebSocketClient(AsyncWebSocket* server, uint32_t id) : _server(server), _id(id) {}
+
+    uint32_t id() const { return _id; }
+    AsyncWebSocket* server() const { return _server; }
+    IPAddress remoteIP() const { return IPAddress(192, 168, 4, static_cast<uint8_t>(2 + _id % 250)); }
+
+    bool text(const char* message, size_t len);
+    bool text(const char* message) { return text(message, strlen(message)); }
+    bool text(const String& message) { return text(message.c_str(), message.length()); }
+    bool binary(const uint8_t* message, size_t len);
+    bool text(AsyncWebSocketMessageBuffer* buffer);
+    bool binary(AsyncWebSocketMessageBuffer* buffer);
+    void close(uint16_t code = 0, const char* message = nullptr);
+
+    size_t queueLen() const;
+    bool canSend() const { return queueLen() < WS_MAX_QUEUED_MESSAGES; }
+
+private:
+    friend class AsyncWebSocket;
+    friend struct SimWebSocketPeer;
+
+    // Frame na fila: segura uma referência do payload enquanto não é enviado
+    struct Frame {
+        Frame(AwsFrameType type, AsyncWebSocketPayload* data) : opcode(type), payload(data) {}
+        Frame(Frame&& other) noexcept : opcode(other.opcode), payload(other.payload) { other.payload = nullptr; }
+        Frame& operator=(Frame&& other) noexcept {
+            std::swap(opcode, other.opcode);
+            std::swap(payload, other.payload);
+            return *this;
+        }
+        ~Frame() {
+            if (payload) payload->release();
+        }
+
+        AwsFrameType opcode;
+        AsyncWebSocketPayload* payload;
+    };
+
+    // Assume uma referência de payload (liberada também quando o frame é descartado)
+    bool enqueue(AwsFrameType opcode, AsyncWebSocketPayload* payload);
+
+    AsyncWebSocket* _server;
+    uint32_t _id;
+    bool _open = true;
+    std::deque<Frame> _outbox;
+    size_t _outboxPeak = 0;   // maior fila desde a conexão (sim::wsOutboxPeak())
+};
+
+class AsyncWebSocket : public AsyncWebHandler {
+public:
+    explicit AsyncWebSocket(const String& url) : _url(url) {}
+
+    const char* url() const { return _url.c_str(); }
+    void onEvent(AwsEventHandler handler) { _eventHandler = std::move(handler); }
+
+    size_t count() const;
+    AsyncWebSocketClient* client(uint32_t id);
+    bool hasClient(uint32_t id) { return client(id) != nullptr; }
+    void cleanupClients(uint16_t maxClients = DEFAULT_MAX_WS_CLIENTS);
+    void closeAll(uint16_t code = 0, const char* message = nullptr);
+
+    bool text(uint32_t id, const char* message, size_t len);
+    bool text(uint32_t id, const String& message) { return text(id, message.c_str(), message.length()); }
+    bool binary(uint32_t id, const uint8_t* message, size_t len);
+
+    void textAll(const char* message, size_t len);
+    void textAll(const char* message) { textAll(message, strlen(message)); }
+    void textAll(const String& message) { textAll(message.c_str(), message.length()); }
+    void binaryAll(const uint8_t* message, size_t len);
+
+    // Um único payload para todos os clientes; textAll()/binaryAll() assumem a posse do buffer
+    AsyncWebSocketMessageBuffer* makeBuffer(size_t size = 0);
+    void textAll(AsyncWebSocketMessageBuffer* buffer);
+    void binaryAll(AsyncWebSocketMessageBuffer* buffer);
+
+private:
+    friend class AsyncWebSocketClient;
+    friend struct SimWebSocketPeer;
+
+    void emit(AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len);
+    void enqueueAll(AwsFrameType opcode, AsyncWebSocketMessageBuffer* buffer);
+
+    String _url;
+    AwsEventHandler _eventHandler;
+    mutable std::recursive_mutex _lock;
+    std::vector<std::unique_ptr<AsyncWebSocketClient>> _clients;
+};
+
+// --- Injeção de tráfego pela simulação ---
+namespace sim {
+
+struct HttpResponse {
+    int code = 0;
+    std::string contentType;
+    std::string body;
+    std::vector<std::pair<std::string, std::string>> headers;
+
+    std::string header(const std::string& name) const;
+};
+
+// Executa uma requisição HTTP contra todos os AsyncWebServer ativos
+HttpResponse http(WebRequestMethod method, const std::string& url, const std::string& body = std::string(),
+                  const std::vector<std::pair<std::string, std::string>>& headers = {});
+
+// Conecta um cliente WebSocket simulado ao endpoint `path`; retorna o id do cliente (0 se não existe).
+// Os cabeçalhos do handshake (ex.: Sec-WebSocket-Protocol) passam pelos filtros dos handlers
+// e chegam ao WS_EVT_CONNECT como o AsyncWebServerRequest* em `arg`, como na biblioteca.
+uint32_t wsConnect(const std::string& path = "/ws",
+                   const std::vector<std::pair<std::string, std::string>>& headers = {});
+void wsSend(uint32_t clientId, const std::string& payload, bool binary = false);
+// Retira as mensagens que o firmware enfileirou para o cliente
+std::vector<std::string> wsReceive(uint32_t clientId);
+// Maior fila de saída do cliente desde a conexão (limitada a WS_MAX_QUEUED_MESSAGES)
+size_t wsOutboxPeak(uint32_t clientId);
+void wsDisconnect(uint32_t clientId);
+
+} // namespace sim
@@ -0,0 +1,178 @@
+#include "FS.h"
+#include "SPIFFS.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "NativeSim.h"
+
+fs::SPIFFSFS SPIFFS;
+
+namespace fs {
+
+struct FileImpl {
+    FILE* fp = nullptr;
+    std::string path;
+    std::string name;
+    bool writable = false;
+    FS* fs = nullptr;
+
+    ~FileImpl() {
+        if (fp) fclose(fp);
+    }
+};
+
+size_t File::write(uint8_t c) { return write(&c, 1); }
+
+size_t File::write(const uint8_t* buf, size_t size) {
+    if (!_impl || !_impl->fp || !_impl->writable) return 0;
+    fflush(_impl->fp);
+    size_t room = _impl->fs->writableBytes();
+    if (size > room) size = room;
+    size_t n = fwrite(buf, 1, size, _impl->fp);
+    sim::stats().flashBytesWritten += n;
+    return n;
+}
+
+int File::available() {
+    if (!_impl || !_impl->fp) return 0;
+    return static_cast<int>(size() - position());
+}
+
+int File::read() {
+    if (!_impl || !_impl->fp) return -1;
+    int c = fgetc(_impl->fp);
+    return c == EOF ? -1 : c;
+}
+
+int File::peek() {
+    if (!_impl || !_impl->fp) return -1;
+    int c = fgetc(_impl->fp);
+    if (c == EOF) return -1;
+    ungetc(c, _impl->fp);
+    return c;
+}
+
+size_t File::readBytes(char* buffer, size_t length) {
+    if (!_impl || !_impl->fp) return 0;
+    return fread(buffer, 1, length, _impl->fp);
+}
+
+void File::flush() {
+    if (_impl && _impl->fp) fflush(_impl->fp);
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    if (!_impl || !_impl->fp) return false;
+    int whence = mode == SeekSet ? SEEK_SET : (mode == SeekCur ? SEEK_CUR : SEEK_END);
+    return fseek(_impl->fp, static_cast<long>(pos), whence) == 0;
+}
+
+size_t File::position() const {
+    if (!_impl || !_impl->fp) return 0;
+    long pos = ftell(_impl->fp);
+    return pos < 0 ? 0 : static_cast<size_t>(pos);
+}
+
+size_t File::size() const {
+    if (!_impl || !_impl->fp) return 0;
+    fflush(_impl->fp);
+    struct stat st;
+    return fstat(fileno(_impl->fp), &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+}
+
+void File::close() {
+    if (_impl && _impl->fp) {
+        fclose(_impl->fp);
+        _impl->fp = nullptr;
+    }
+}
+
+const char* File::path() const { return _impl ? _impl->path.c_str() : nullptr; }
+const char* File::name() const { return _impl ? _impl->name.c_str() : nullptr; }
+
+File::operator bool() const { return _impl && _impl->fp; }
+
+std::string FS::hostRoot() const { return sim::rootPath(_subdir.c_str()); }
+
+std::string FS::hostPath(const char* path) const {
+    std::string p = path ? path : "";
+    if (p.empty() || p[0] != '/') p = "/" + p;
+    return hostRoot() + p;
+}
+
+File FS::open(const char* path, const char* mode, bool create) {
+    (void)create;
+    std::string host = hostPath(path);
+    std::string m = mode ? mode : "r";
+    const char* hostMode = m == "w" ? "wb" : (m == "a" ? "ab" : (m == "r+" ? "r+b" : (m == "w+" ? "w+b" : "rb")));
+    FILE* fp = fopen(host.c_str(), hostMode);
+    if (!fp) return File();
+    auto impl = std::make_shared<FileImpl>();
+    impl->fp = fp;
+    impl->path = path;
+    impl->name = impl->path.substr(impl->path.find_last_of('/') + 1);
+    impl->writable = m != "r";
+    impl->fs = this;
+    return File(impl);
+}
+
+bool FS::exists(const char* path) {
+    struct stat st;
+    return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char* path) {
+    return ::remove(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* pathFrom, const char* pathTo) {
+    // Como no SPIFFS: renomear sobre um arquivo existente falha em vez de substituí-lo
+    if (exists(pathTo)) return false;
+    return ::rename(hostPath(pathFrom).c_str(), hostPath(pathTo).c_str()) == 0;
+}
+
+bool SPIFFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+    (void)formatOnFail;
+    (void)basePath;
+    (void)maxOpenFiles;
+    (void)partitionLabel;
+    _mounted = true;
+    return true;
+}
+
+bool SPIFFSFS::format() {
+    DIR* dir = opendir(hostRoot().c_str());
+    if (!dir) return false;
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') continue;
+        ::remove((hostRoot() + "/" + entry->d_name).c_str());
+    }
+    closedir(dir);
+    return true;
+}
+
+size_t SPIFFSFS::totalBytes() {
+    return sim::config().spiffsBytes;
+}
+
+size_t SPIFFSFS::writableBytes() {
+    size_t used = usedBytes();
+    return used < totalBytes() ? totalBytes() - used : 0;
+}
+
+size_t SPIFFSFS::usedBytes() {
+    size_t used = 0;
+    DIR* dir = opendir(hostRoot().c_str());
+    if (!dir) return 0;
+    while (struct dirent* entry = readdir(dir)) {
+        struct stat st;
+        if (entry->d_name[0] != '.' && stat((hostRoot() + "/" + entry->d_name).c_str(), &st) == 0) {
+            used += static_cast<size_t>(st.st_size);
+        }
+    }
+    closedir(dir);
+    return used;
+}
+
+} // namespace fs
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "Arduino.h"
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+struct FileImpl;
+
+// Arquivo simulado sobre FILE*; cópias compartilham o mesmo descritor, como no core ESP32
+class File : public Stream {
+public:
+    File() = default;
+    explicit File(std::shared_ptr<FileImpl> impl) : _impl(std::move(impl)) {}
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t readBytes(char* buffer, size_t length) override;
+    size_t read(uint8_t* buf, size_t size) { return readBytes(reinterpret_cast<char*>(buf), size); }
+    void flush() override;
+
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    void close();
+    const char* path() const;
+    const char* name() const;
+    bool isDirectory() const { return false; }
+
+    explicit operator bool() const;
+
+private:
+    std::shared_ptr<FileImpl> _impl;
+};
+
+class FS {
+public:
+    explicit FS(const char* subdir) : _subdir(subdir) {}
+    virtual ~FS() = default;
+
+    File open(const char* path, const char* mode = FILE_READ, bool create = false);
+    File open(const String& path, const char* mode = FILE_READ, bool create = false) {
+        return open(path.c_str(), mode, create);
+    }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* pathFrom, const char* pathTo);
+    bool rename(const String& pathFrom, const String& pathTo) { return rename(pathFrom.c_str(), pathTo.c_str()); }
+
+    // Espaço livre que limita as escritas (partição simulada); sem limite por padrão
+    virtual size_t writableBytes() { return SIZE_MAX; }
+
+protected:
+    std::string hostPath(const char* path) const;
+    std::string hostRoot() const;
+
+    std::string _subdir;
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
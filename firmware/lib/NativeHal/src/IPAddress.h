@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+#include "Print.h"
+
+class IPAddress : public Printable {
+public:
+    IPAddress() : IPAddress(0, 0, 0, 0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _octets{a, b, c, d} {}
+
+    uint8_t operator[](int i) const { return _octets[i]; }
+    bool operator==(const IPAddress& o) const {
+        return _octets[0] == o._octets[0] && _octets[1] == o._octets[1] &&
+               _octets[2] == o._octets[2] && _octets[3] == o._octets[3];
+    }
+
+    String toString() const {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _octets[0], _octets[1], _octets[2], _octets[3]);
+        return String(buf);
+    }
+
+    size_t printTo(Print& p) const override { return p.print(toString()); }
+
+private:
+    uint8_t _octets[4];
+};
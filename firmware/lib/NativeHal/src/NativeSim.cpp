@@ -0,0 +1,510 @@
+#include "NativeSim.h"
+
+#include <malloc.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "Arduino.h"
+#include "OneWire.h"
+#include "WiFi.h"
+#include "esp_system.h"
+
+void setup();
+void loop();
+
+namespace sim {
+bool parkTasks(unsigned long timeoutMs);   // task.cpp
+void stopTimers();                         // esp_timer.cpp
+}
+
+HardwareSerial Serial;
+EspClass ESP;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const Clock::time_point bootTime = Clock::now();
+thread_local uint64_t delayedMicros = 0;   // pedidos a delay()/delayMicroseconds() (sim::threadMicros())
+char** savedArgv = nullptr;
+
+struct PinState {
+    uint8_t mode = INPUT;
+    int level = LOW;
+    uint16_t analog = 0;
+    int ledcChannel = -1;
+    void (*isr)(void*) = nullptr;
+    void* isrArg = nullptr;
+    int isrMode = 0;
+};
+
+struct LedcChannel {
+    uint32_t freq = 0;
+    uint8_t resolution = 8;
+    uint32_t duty = 0;
+};
+
+std::mutex pinLock;
+std::map<uint8_t, PinState> pins;
+LedcChannel ledcChannels[16];
+
+// Linha 1-Wire vista pelos pinos (sim::attachOneWire), sob pinLock
+struct OneWireLine {
+    OneWire* wire = nullptr;
+    bool low = false;               // o ESP32 segura a linha em 0
+    unsigned long lowSince = 0;     // micros()
+    // Fim do último pulso de reset no sim::threadMicros() de quem soltou a
+    // linha: no ESP32 a amostra vem logo depois, com as interrupções desligadas,
+    // e uma pausa do host entre as duas não pode tirar a presença da janela
+    uint64_t releasedAt = 0;
+    std::thread::id releasedBy;
+    bool presence = false;
+};
+
+// Presença do DS18B20: espera 15-60 µs após a soltura e segura a linha por 60-240 µs
+const unsigned long PRESENCE_FROM_US = 15;
+const unsigned long PRESENCE_UNTIL_US = 300;
+
+// Registrado por OneWire::begin(), possivelmente antes de main(): nunca destruído
+std::map<uint8_t, OneWireLine>& oneWireLines() {
+    static std::map<uint8_t, OneWireLine>* lines = new std::map<uint8_t, OneWireLine>();
+    return *lines;
+}
+
+const size_t SIM_HEAP_SIZE = 327680; // heap interno típico de um ESP32 sem PSRAM
+size_t heapBaseline = 0;
+size_t minFreeHeap = SIM_HEAP_SIZE;
+
+void makeDirs(const std::string& path) {
+    for (size_t pos = 1; pos <= path.size(); pos++) {
+        if (pos == path.size() || path[pos] == '/') mkdir(path.substr(0, pos).c_str(), 0755);
+    }
+}
+
+size_t heapInUse() {
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks;
+}
+
+} // namespace
+
+// --- GPIO / ADC / LEDC ---
+
+// Acompanha a linha 1-Wire do pino depois de pinMode()/digitalWrite(); sob pinLock
+static void trackOneWireLine(uint8_t pin, const PinState& p) {
+    auto it = oneWireLines().find(pin);
+    if (it == oneWireLines().end()) return;
+    OneWireLine& line = it->second;
+    bool low = p.mode == OUTPUT && p.level == LOW;
+    if (low == line.low) return;
+    line.low = low;
+    unsigned long now = micros();
+    if (low) {
+        line.lowSince = now;
+    } else if (now - line.lowSince >= sim::ONEWIRE_RESET_LOW_US) {
+        line.presence = line.wire->resetPulse() != 0;
+        line.releasedAt = sim::threadMicros();
+        line.releasedBy = std::this_thread::get_id();
+    }
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    std::lock_guard<std::mutex> guard(pinLock);
+    PinState& p = pins[pin];
+    p.mode = mode;
+    if (mode == INPUT_PULLUP) p.level = HIGH;
+    trackOneWireLine(pin, p);
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    std::lock_guard<std::mutex> guard(pinLock);
+    PinState& p = pins[pin];
+    p.level = val ? HIGH : LOW;
+    trackOneWireLine(pin, p);
+}
+
+int digitalRead(uint8_t pin) {
+    std::lock_guard<std::mutex> guard(pinLock);
+    auto it = oneWireLines().find(pin);
+    if (it != oneWireLines().end() && pins[pin].mode != OUTPUT) {
+        // Solta, a linha fica em 1 pelo pull-up, salvo durante o pulso de presença
+        const OneWireLine& line = it->second;
+        uint64_t sinceRelease = sim::threadMicros() - line.releasedAt;
+        bool presencePulse = line.presence && line.releasedBy == std::this_thread::get_id() &&
+                             sinceRelease >= PRESENCE_FROM_US && sinceRelease <= PRESENCE_UNTIL_US;
+        return presencePulse ? LOW : HIGH;
+    }
+    return pins[pin].level;
+}
+
+static void callPlainIsr(void* isr) {
+    reinterpret_cast<void (*)()>(isr)();
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode) {
+    attachInterruptArg(pin, callPlainIsr, reinterpret_cast<void*>(isr), mode);
+}
+
+void attachInterruptArg(uint8_t pin, void (*isr)(void*), void* arg, int mode) {
+    std::lock_guard<std::mutex> guard(pinLock);
+    PinState& p = pins[pin];
+    p.isr = isr;
+    p.isrArg = arg;
+    p.isrMode = mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+    std::lock_guard<std::mutex> guard(pinLock);
+    pins[pin].isr = nullptr;
+}
+
+uint16_t analogRead(uint8_t pin) {
+    // Uma conversão do ADC1 do ESP32 leva alguns microssegundos
+    delayMicroseconds(10);
+    std::lock_guard<std::mutex> guard(pinLock);
+    return pins[pin].analog;
+}
+
+uint32_t ledcSetup(uint8_t channel, uint32_t freq, uint8_t resolutionBits) {
+    if (channel >= 16 || resolutionBits < 1 || resolutionBits > 20) return 0;
+    std::lock_guard<std::mutex> guard(pinLock);
+    ledcChannels[channel].freq = freq;
+    ledcChannels[channel].resolution = resolutionBits;
+    return freq;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel) {
+    if (channel >= 16) return;
+    std::lock_guard<std::mutex> guard(pinLock);
+    pins[pin].ledcChannel = channel;
+}
+
+void ledcWrite(uint8_t channel, uint32_t duty) {
+    if (channel >= 16) return;
+    std::lock_guard<std::mutex> guard(pinLock);
+    ledcChannels[channel].duty = duty;
+    sim::stats().ledcWrites++;
+}
+
+// --- Tempo ---
+
+unsigned long millis() {
+    return static_cast<unsigned long>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - bootTime).count());
+}
+
+unsigned long micros() {
+    return static_cast<unsigned long>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - bootTime).count());
+}
+
+void delay(uint32_t ms) {
+    delayedMicros += ms * 1000ULL;
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+    delayedMicros += us;
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1, const char* server2,
+                const char* server3) {
+    (void)server1;
+    (void)server2;
+    (void)server3;
+    // Mesmo formato POSIX que o core monta ("UTC-3" = 3 h a leste)
+    char tz[32];
+    long offset = -(gmtOffsetSec + daylightOffsetSec);
+    snprintf(tz, sizeof(tz), "UTC%+ld:%02ld", offset / 3600, labs(offset % 3600) / 60);
+    configTzTime(tz, nullptr);
+}
+
+void configTzTime(const char* tz, const char* server1, const char* server2, const char* server3) {
+    (void)server1;
+    (void)server2;
+    (void)server3;
+    setenv("TZ", tz, 1);
+    tzset();
+}
+
+bool getLocalTime(struct tm* info, uint32_t ms) {
+    (void)ms;
+    time_t now = time(nullptr);
+    localtime_r(&now, info);
+    return info->tm_year > (2016 - 1900);
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    const long dividend = outMax - outMin;
+    const long divisor = inMax - inMin;
+    const long delta = x - inMin;
+    if (divisor == 0) return -1;
+    return (delta * dividend + (divisor / 2)) / divisor + outMin;
+}
+
+long random(long max) {
+    return max > 0 ? ::random() % max : 0;
+}
+
+long random(long min, long max) {
+    return min >= max ? min : min + random(max - min);
+}
+
+// --- Serial / ESP ---
+
+size_t HardwareSerial::write(uint8_t c) {
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    return fwrite(buffer, 1, size, stdout);
+}
+
+// Mesmo limite do ESP-IDF (SHUTDOWN_HANDLERS_NO)
+static shutdown_handler_t shutdownHandlers[5] = {nullptr};
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler) {
+    for (auto& slot : shutdownHandlers) {
+        if (slot == handler) return ESP_ERR_INVALID_STATE;
+        if (!slot) {
+            slot = handler;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_unregister_shutdown_handler(shutdown_handler_t handler) {
+    for (auto& slot : shutdownHandlers) {
+        if (slot == handler) {
+            slot = nullptr;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_INVALID_STATE;
+}
+
+void EspClass::restart() {
+    // O ESP-IDF chama os handlers em ordem reversa de registro
+    for (int i = sizeof(shutdownHandlers) / sizeof(shutdownHandlers[0]) - 1; i >= 0; i--) {
+        if (shutdownHandlers[i]) shutdownHandlers[i]();
+    }
+    // Reinício simulado: reexecuta o próprio binário, preservando NVS e SPIFFS em disco
+    printf("\n[sim] ESP.restart()\n");
+    fflush(stdout);
+    if (savedArgv) execv("/proc/self/exe", savedArgv);
+    exit(0);
+}
+
+uint32_t EspClass::getHeapSize() { return SIM_HEAP_SIZE; }
+
+uint32_t EspClass::getFreeHeap() {
+    size_t used = heapInUse() > heapBaseline ? heapInUse() - heapBaseline : 0;
+    size_t freeHeap = used < SIM_HEAP_SIZE ? SIM_HEAP_SIZE - used : 0;
+    if (freeHeap < minFreeHeap) minFreeHeap = freeHeap;
+    return static_cast<uint32_t>(freeHeap);
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    getFreeHeap();
+    return static_cast<uint32_t>(minFreeHeap);
+}
+
+uint32_t EspClass::getMaxAllocHeap() {
+    // Sem fragmentação modelada: o maior bloco é o próprio heap livre
+    return getFreeHeap();
+}
+
+uint32_t EspClass::getCycleCount() {
+    // Contador de ciclos a 240 MHz derivado do relógio monotônico
+    return static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - bootTime).count() * 240 / 1000);
+}
+
+// --- Controle da simulação ---
+
+namespace sim {
+
+Config& config() {
+    static Config cfg;
+    return cfg;
+}
+
+Stats& stats() {
+    static Stats s;
+    return s;
+}
+
+uint64_t threadMicros() {
+    timespec cpu;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+    return static_cast<uint64_t>(cpu.tv_sec) * 1000000ULL + cpu.tv_nsec / 1000 + delayedMicros;
+}
+
+std::string rootPath(const char* sub) {
+    std::string path = config().root;
+    if (sub && *sub) path += std::string("/") + sub;
+    makeDirs(path);
+    return path;
+}
+
+void begin(int argc, char** argv) {
+    (void)argc;
+    savedArgv = argv;
+    if (const char* root = getenv("QP_SIM_ROOT")) config().root = root;
+    if (const char* run = getenv("QP_SIM_RUN_MS")) config().runMillis = atol(run);
+    if (const char* sleep = getenv("QP_SIM_LOOP_SLEEP_US")) config().loopSleepMicros = atoi(sleep);
+    rootPath("nvs");
+    rootPath("spiffs");
+    if (const char* list = getenv("QP_SIM_PROBES")) {
+        // Lista de temperaturas separadas por vírgula, uma sonda por valor
+        for (const char* p = list; *p;) {
+            char* end = nullptr;
+            float value = strtof(p, &end);
+            if (end == p) break;
+            addTemperatureProbe(value);
+            p = *end == ',' ? end + 1 : end;
+        }
+    }
+    if (probes().empty()) addTemperatureProbe(26.5f);
+    if (accessPoints().empty()) {
+        accessPoints().push_back({"Quinta-Casa", "senha-da-casa", -58, 6, true, {0x24, 0x6f, 0x28, 0x10, 0x20, 0x30}});
+        accessPoints().push_back({"Vizinho-2G", "", -81, 11, true, {0x9c, 0x53, 0x22, 0x41, 0x07, 0xe2}});
+    }
+    setAnalog(34, 1800);
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+    heapBaseline = heapInUse();
+}
+
+int end(int status) {
+    static const unsigned long PARK_TIMEOUT_MS = 2000;
+    fflush(nullptr);
+    if (!parkTasks(PARK_TIMEOUT_MS)) {
+        fprintf(stderr, "sim: tarefas não pararam em %lu ms, saindo sem destrutores\n", PARK_TIMEOUT_MS);
+        fflush(nullptr);
+        _exit(status);
+    }
+    WiFi.stopEvents();
+    stopTimers();
+    return status;
+}
+
+int pinLevel(uint8_t pin) {
+    std::lock_guard<std::mutex> guard(pinLock);
+    return pins[pin].level;
+}
+
+uint32_t pinDuty(uint8_t pin) {
+    std::lock_guard<std::mutex> guard(pinLock);
+    int ch = pins[pin].ledcChannel;
+    return ch < 0 ? 0 : ledcChannels[ch].duty;
+}
+
+uint8_t pinDutyResolution(uint8_t pin) {
+    std::lock_guard<std::mutex> guard(pinLock);
+    int ch = pins[pin].ledcChannel;
+    return ch < 0 ? 0 : ledcChannels[ch].resolution;
+}
+
+void setAnalog(uint8_t pin, uint16_t raw) {
+    std::lock_guard<std::mutex> guard(pinLock);
+    pins[pin].analog = raw > 4095 ? 4095 : raw;
+}
+
+void setDigitalInput(uint8_t pin, int level) {
+    void (*isr)(void*) = nullptr;
+    void* arg = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(pinLock);
+        PinState& p = pins[pin];
+        int previous = p.level;
+        p.level = level ? HIGH : LOW;
+        bool rising = previous == LOW && p.level == HIGH;
+        bool falling = previous == HIGH && p.level == LOW;
+        if (p.isr && ((rising && (p.isrMode & RISING)) || (falling && (p.isrMode & FALLING)))) {
+            isr = p.isr;
+            arg = p.isrArg;
+        }
+    }
+    // Fora da trava: a ISR pode ler pinos
+    if (isr) isr(arg);
+}
+
+std::vector<TemperatureProbe>& probes() {
+    static std::vector<TemperatureProbe> list;
+    return list;
+}
+
+size_t addTemperatureProbe(float temperatureC, uint8_t resolution) {
+    TemperatureProbe probe;
+    size_t index = probes().size();
+    // Endereço ROM determinístico: família 0x28 (DS18B20), serial derivado do índice, CRC válido
+    uint8_t serial[6] = {0x5A, 0x1C, static_cast<uint8_t>(0x40 + index), 0x0B, 0x00, 0x00};
+    probe.address[0] = 0x28;
+    memcpy(&probe.address[1], serial, sizeof(serial));
+    probe.address[7] = OneWire::crc8(probe.address, 7);
+    probe.temperatureC = temperatureC;
+    probe.resolution = resolution;
+    probes().push_back(probe);
+    return index;
+}
+
+void attachOneWire(uint8_t pin, OneWire* wire) {
+    std::lock_guard<std::mutex> guard(pinLock);
+    oneWireLines()[pin].wire = wire;
+}
+
+void oneWireBusTime(uint32_t us) {
+    stats().oneWireBusMicros += us;
+    delayMicroseconds(us);
+}
+
+void startConversion(TemperatureProbe& probe) {
+    probe.converting = true;
+    probe.conversionStart = millis();
+}
+
+void settleConversion(TemperatureProbe& probe) {
+    static const uint16_t conversionMillis[4] = {94, 188, 375, 750};
+    if (!probe.converting) return;
+    if (millis() - probe.conversionStart < conversionMillis[probe.resolution - 9]) return;
+    float step = 1.0f / static_cast<float>(1 << (probe.resolution - 8));
+    probe.latchedC = std::floor(probe.temperatureC / step) * step;
+    probe.converting = false;
+}
+
+std::vector<AccessPoint>& accessPoints() {
+    static std::vector<AccessPoint> list;
+    return list;
+}
+
+} // namespace sim
+
+// Nos testes (pio test) o main() é o do Unity, em cada test/test_*/
+#if !defined(NATIVE_SIM_NO_MAIN) && !defined(PIO_UNIT_TESTING)
+int main(int argc, char** argv) {
+    sim::begin(argc, argv);
+    setup();
+    const long runMillis = sim::config().runMillis;
+    while (runMillis < 0 || static_cast<long>(millis()) < runMillis) {
+        loop();
+        if (sim::config().loopSleepMicros) delayMicroseconds(sim::config().loopSleepMicros);
+    }
+    return sim::end(0);
+}
+#endif
@@ -0,0 +1,109 @@
+#pragma once
+
+// Controle da simulação do ambiente [env:native]: pinos, sensores, rádio,
+// diretórios de flash e contadores. Os harnesses de medição usam esta API;
+// o firmware em si só enxerga as APIs Arduino/ESP32 habituais.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class OneWire;
+
+namespace sim {
+
+struct Config {
+    std::string root = ".sim";          // diretório base (nvs/, spiffs/)
+    long runMillis = -1;                // tempo de execução do processo (-1 = infinito)
+    unsigned loopSleepMicros = 1000;    // pausa entre iterações de loop() para não queimar CPU
+    size_t spiffsBytes = 1378241;       // tamanho útil da partição SPIFFS padrão
+    unsigned long wifiConnectMillis = 1500;      // scan de todos os canais + associação
+    unsigned long wifiFastConnectMillis = 300;   // begin() com canal e BSSID conhecidos
+    unsigned long wifiFailMillis = 4000;
+    unsigned long wifiScanMillis = 2200;
+};
+
+struct Stats {
+    std::atomic<uint64_t> nvsWrites{0};
+    std::atomic<uint64_t> nvsCommits{0};
+    std::atomic<uint64_t> flashBytesWritten{0};
+    std::atomic<uint64_t> oneWireBusMicros{0};
+    std::atomic<uint64_t> ledcWrites{0};
+    std::atomic<uint64_t> httpRequests{0};
+    std::atomic<uint64_t> httpBytesSent{0};
+    std::atomic<uint64_t> wsMessagesSent{0};
+    std::atomic<uint64_t> wsMessagesDropped{0};
+    std::atomic<uint64_t> wsBytesSent{0};
+    std::atomic<uint64_t> wsHeapBlocks{0};      // alocações da própria camada WS (payloads e makeBuffer())
+};
+
+struct TemperatureProbe {
+    uint8_t address[8];
+    float temperatureC = 25.0f;   // temperatura "física" da água/ambiente
+    float latchedC = 85.0f;       // valor no scratchpad (85 °C = power-on reset do DS18B20)
+    uint8_t resolution = 12;
+    bool connected = true;
+    bool converting = false;
+    unsigned long conversionStart = 0;
+};
+
+struct AccessPoint {
+    std::string ssid;
+    std::string password;
+    int32_t rssi = -60;
+    uint8_t channel = 6;
+    bool reachable = true;
+    uint8_t bssid[6] = {0x24, 0x6f, 0x28, 0x10, 0x20, 0x30};
+};
+
+Config& config();
+Stats& stats();
+
+// Relógio da thread que chama: CPU da thread mais as esperas pedidas a delay()
+// e delayMicroseconds(). Não anda quando o host tira a thread da CPU
+// (preempção, pausa da máquina virtual), então mede um trecho como no ESP32
+uint64_t threadMicros();
+
+// Caminho absoluto de <root>/<sub>, criado sob demanda
+std::string rootPath(const char* sub);
+
+// Lê QP_SIM_* do ambiente e prepara os diretórios; chamado pelo main() nativo
+void begin(int argc, char** argv);
+// Para as threads da simulação antes de main() retornar: cada tarefa no seu
+// próximo ponto de espera, depois a tarefa de eventos do WiFi e os timers
+// (juntadas). Devolve `status`, para `return sim::end(UNITY_END());`; se
+// alguma tarefa não parar a tempo, sai já com _exit(status)
+int end(int status);
+
+// --- Pinos ---
+int pinLevel(uint8_t pin);
+uint32_t pinDuty(uint8_t pin);          // duty LEDC atual do pino (0 se não anexado)
+uint8_t pinDutyResolution(uint8_t pin);
+void setAnalog(uint8_t pin, uint16_t raw);
+// Muda o nível de uma entrada e dispara a interrupção anexada, na thread de quem chama
+void setDigitalInput(uint8_t pin, int level);
+
+// --- 1-Wire ---
+const uint32_t ONEWIRE_RESET_US = 960;  // pulso de reset + janela de presença
+const uint32_t ONEWIRE_SLOT_US = 70;    // um time slot de bit
+
+// Liga o barramento ao pino: linha em 0 por ONEWIRE_RESET_LOW_US ou mais e
+// solta (pinMode/digitalWrite) é um pulso de reset, e digitalRead() mostra o
+// pulso de presença das sondas na janela do DS18B20, contada em threadMicros()
+// da thread que soltou a linha. Chamado por OneWire::begin()
+const uint32_t ONEWIRE_RESET_LOW_US = 480;
+void attachOneWire(uint8_t pin, OneWire* wire);
+
+std::vector<TemperatureProbe>& probes();
+size_t addTemperatureProbe(float temperatureC, uint8_t resolution = 12);
+void oneWireBusTime(uint32_t us);
+void startConversion(TemperatureProbe& probe);
+// Fecha a conversão (atualiza o scratchpad) se o tempo da resolução já passou
+void settleConversion(TemperatureProbe& probe);
+
+// --- Rádio ---
+std::vector<AccessPoint>& accessPoints();
+
+} // namespace sim
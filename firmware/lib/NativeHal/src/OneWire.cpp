@@ -0,0 +1,178 @@
+#include "OneWire.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "NativeSim.h"
+
+namespace {
+
+const uint8_t CMD_MATCH_ROM = 0x55;
+const uint8_t CMD_SKIP_ROM = 0xCC;
+const uint8_t CMD_CONVERT_T = 0x44;
+const uint8_t CMD_READ_SCRATCHPAD = 0xBE;
+const uint8_t CMD_WRITE_SCRATCHPAD = 0x4E;
+
+bool anyConnected() {
+    for (const auto& probe : sim::probes()) {
+        if (probe.connected) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+uint8_t OneWire::crc8(const uint8_t* addr, uint8_t len) {
+    uint8_t crc = 0;
+    while (len--) {
+        uint8_t inbyte = *addr++;
+        for (uint8_t i = 8; i; i--) {
+            uint8_t mix = (crc ^ inbyte) & 0x01;
+            crc >>= 1;
+            if (mix) crc ^= 0x8C;
+            inbyte >>= 1;
+        }
+    }
+    return crc;
+}
+
+void OneWire::begin(uint8_t pin) {
+    _pin = pin;
+    sim::attachOneWire(pin, this);
+}
+
+uint8_t OneWire::reset() {
+    sim::oneWireBusTime(sim::ONEWIRE_RESET_US);
+    return resetPulse();
+}
+
+uint8_t OneWire::resetPulse() {
+    _phase = Phase::RomCommand;
+    _selected = -1;
+    _romPos = 0;
+    return anyConnected() ? 1 : 0;
+}
+
+void OneWire::select(const uint8_t rom[8]) {
+    write(CMD_MATCH_ROM);
+    for (int i = 0; i < 8; i++) write(rom[i]);
+}
+
+void OneWire::skip() {
+    write(CMD_SKIP_ROM);
+}
+
+void OneWire::write(uint8_t v, uint8_t power) {
+    (void)power;
+    sim::oneWireBusTime(8 * sim::ONEWIRE_SLOT_US);
+    onByte(v);
+}
+
+void OneWire::write_bytes(const uint8_t* buf, uint16_t count, bool power) {
+    for (uint16_t i = 0; i < count; i++) write(buf[i], power);
+}
+
+uint8_t OneWire::read() {
+    sim::oneWireBusTime(8 * sim::ONEWIRE_SLOT_US);
+    if (_phase != Phase::ReadScratchpad || _scratchPos >= sizeof(_scratch)) return 0xFF;
+    return _scratch[_scratchPos++];
+}
+
+void OneWire::read_bytes(uint8_t* buf, uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) buf[i] = read();
+}
+
+void OneWire::write_bit(uint8_t v) {
+    (void)v;
+    sim::oneWireBusTime(sim::ONEWIRE_SLOT_US);
+}
+
+uint8_t OneWire::read_bit() {
+    sim::oneWireBusTime(sim::ONEWIRE_SLOT_US);
+    // Durante CONVERT T o sensor segura a linha em 0 até terminar (wired-AND)
+    for (auto& probe : sim::probes()) {
+        sim::settleConversion(probe);
+        if (probe.connected && probe.converting) return 0;
+    }
+    return 1;
+}
+
+bool OneWire::search(uint8_t* newAddr, bool searchMode) {
+    (void)searchMode;
+    sim::oneWireBusTime(sim::ONEWIRE_RESET_US + (8 + 64 * 3) * sim::ONEWIRE_SLOT_US);
+    auto& probes = sim::probes();
+    while (_searchIndex < probes.size() && !probes[_searchIndex].connected) _searchIndex++;
+    if (_searchIndex >= probes.size()) return false;
+    memcpy(newAddr, probes[_searchIndex++].address, 8);
+    return true;
+}
+
+void OneWire::onByte(uint8_t v) {
+    auto& probes = sim::probes();
+    switch (_phase) {
+    case Phase::RomCommand:
+        if (v == CMD_MATCH_ROM) {
+            _phase = Phase::MatchRom;
+            _romPos = 0;
+        } else if (v == CMD_SKIP_ROM) {
+            _selected = -2;
+            _phase = Phase::Function;
+        } else {
+            _phase = Phase::Idle;
+        }
+        break;
+    case Phase::MatchRom:
+        _romBuf[_romPos++] = v;
+        if (_romPos == 8) {
+            _selected = -1;
+            for (size_t i = 0; i < probes.size(); i++) {
+                if (probes[i].connected && memcmp(probes[i].address, _romBuf, 8) == 0) _selected = static_cast<int>(i);
+            }
+            _phase = _selected >= 0 ? Phase::Function : Phase::Idle;
+        }
+        break;
+    case Phase::Function:
+        if (v == CMD_CONVERT_T) {
+            for (size_t i = 0; i < probes.size(); i++) {
+                if (probes[i].connected && (_selected == -2 || _selected == static_cast<int>(i))) {
+                    sim::startConversion(probes[i]);
+                }
+            }
+            _phase = Phase::Idle;
+        } else if (v == CMD_READ_SCRATCHPAD && _selected >= 0) {
+            sim::TemperatureProbe& probe = probes[_selected];
+            sim::settleConversion(probe);
+            int16_t raw = static_cast<int16_t>(std::lround(probe.latchedC * 16.0f));
+            _scratch[0] = static_cast<uint8_t>(raw & 0xFF);
+            _scratch[1] = static_cast<uint8_t>((raw >> 8) & 0xFF);
+            _scratch[2] = 0x4B;
+            _scratch[3] = 0x46;
+            _scratch[4] = static_cast<uint8_t>(((probe.resolution - 9) << 5) | 0x1F);
+            _scratch[5] = 0xFF;
+            _scratch[6] = 0x0C;
+            _scratch[7] = 0x10;
+            _scratch[8] = crc8(_scratch, 8);
+            _scratchPos = 0;
+            _phase = Phase::ReadScratchpad;
+        } else if (v == CMD_WRITE_SCRATCHPAD) {
+            _scratchPos = 0;
+            _phase = Phase::WriteScratchpad;
+        } else {
+            _phase = Phase::Idle;
+        }
+        break;
+    case Phase::WriteScratchpad:
+        // TH, TL e o registrador de configuração (bits 5-6 = resolução)
+        if (++_scratchPos == 3) {
+            for (size_t i = 0; i < probes.size(); i++) {
+                if (probes[i].connected && (_selected == -2 || _selected == static_cast<int>(i))) {
+                    probes[i].resolution = static_cast<uint8_t>(9 + ((v >> 5) & 0x03));
+                }
+            }
+            _phase = Phase::Idle;
+        }
+        break;
+    default:
+        break;
+    }
+}
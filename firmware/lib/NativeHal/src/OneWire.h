@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+// Barramento 1-Wire simulado, no nível de bytes/bits como a OneWire real.
+// Cada operação consome o tempo que o bit-banging (CRIT_TIMING com
+// interrupções desligadas) levaria no ESP32; os dispositivos são os DS18B20
+// de sim::probes(), que entendem MATCH/SKIP ROM, CONVERT T, READ e WRITE SCRATCHPAD.
+class OneWire {
+public:
+    OneWire() = default;
+    explicit OneWire(uint8_t pin) { begin(pin); }
+
+    void begin(uint8_t pin);
+    uint8_t pin() const { return _pin; }
+
+    uint8_t reset();
+    // Pulso de reset dado direto no pino (sim::attachOneWire); 1 se há presença
+    uint8_t resetPulse();
+    void select(const uint8_t rom[8]);
+    void skip();
+    void write(uint8_t v, uint8_t power = 0);
+    void write_bytes(const uint8_t* buf, uint16_t count, bool power = 0);
+    uint8_t read();
+    void read_bytes(uint8_t* buf, uint16_t count);
+    void write_bit(uint8_t v);
+    uint8_t read_bit();
+    void depower() {}
+
+    void reset_search() { _searchIndex = 0; }
+    bool search(uint8_t* newAddr, bool searchMode = true);
+
+    static uint8_t crc8(const uint8_t* addr, uint8_t len);
+
+private:
+    enum class Phase : uint8_t { Idle, RomCommand, MatchRom, Function, WriteScratchpad, ReadScratchpad };
+
+    void onByte(uint8_t v);
+
+    uint8_t _pin = 0;
+    Phase _phase = Phase::Idle;
+    int _selected = -1;          // índice em sim::probes(); -2 = SKIP ROM (todos)
+    uint8_t _romBuf[8] = {0};
+    uint8_t _romPos = 0;
+    uint8_t _scratch[9] = {0};
+    uint8_t _scratchPos = 0;
+    uint8_t _searchIndex = 0;
+};
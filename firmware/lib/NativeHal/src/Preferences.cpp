@@ -0,0 +1,116 @@
+#include "Preferences.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "NativeSim.h"
+
+namespace {
+
+std::string namespacePath(const std::string& ns) {
+    return sim::rootPath("nvs") + "/" + ns + ".bin";
+}
+
+} // namespace
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partitionLabel) {
+    (void)partitionLabel;
+    if (_open || !name || strlen(name) > 15) return false; // limite real da NVS
+    _namespace = name;
+    _readOnly = readOnly;
+    _dirty = false;
+    _open = true;
+    load();
+    return true;
+}
+
+void Preferences::end() {
+    if (!_open) return;
+    if (_dirty) commit();
+    _entries.clear();
+    _open = false;
+}
+
+bool Preferences::clear() {
+    if (!_open || _readOnly) return false;
+    _entries.clear();
+    _dirty = true;
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    if (!_open || _readOnly) return false;
+    _dirty |= _entries.erase(key) > 0;
+    return true;
+}
+
+bool Preferences::isKey(const char* key) {
+    return _open && _entries.count(key) > 0;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+    if (!_open || _readOnly || !key || strlen(key) > 15) return 0;
+    const uint8_t* bytes = static_cast<const uint8_t*>(value);
+    _entries[key].assign(bytes, bytes + len);
+    _dirty = true;
+    sim::stats().nvsWrites++;
+    return len;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+    auto it = _open ? _entries.find(key) : _entries.end();
+    if (it == _entries.end() || it->second.size() > maxLen) return 0;
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    auto it = _open ? _entries.find(key) : _entries.end();
+    return it == _entries.end() ? 0 : it->second.size();
+}
+
+size_t Preferences::putString(const char* key, const String& value) {
+    return putString(key, value.c_str());
+}
+
+size_t Preferences::putString(const char* key, const char* value) {
+    return putBytes(key, value, strlen(value) + 1) ? strlen(value) : 0;
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+    auto it = _open ? _entries.find(key) : _entries.end();
+    if (it == _entries.end() || it->second.empty()) return defaultValue;
+    return String(reinterpret_cast<const char*>(it->second.data()));
+}
+
+void Preferences::load() {
+    _entries.clear();
+    FILE* f = fopen(namespacePath(_namespace).c_str(), "rb");
+    if (!f) return;
+    uint16_t keyLen;
+    while (fread(&keyLen, sizeof(keyLen), 1, f) == 1) {
+        std::string key(keyLen, '\0');
+        uint32_t valueLen;
+        if (fread(&key[0], 1, keyLen, f) != keyLen || fread(&valueLen, sizeof(valueLen), 1, f) != 1) break;
+        std::vector<uint8_t> value(valueLen);
+        if (valueLen && fread(value.data(), 1, valueLen, f) != valueLen) break;
+        _entries[key] = std::move(value);
+    }
+    fclose(f);
+}
+
+void Preferences::commit() {
+    FILE* f = fopen(namespacePath(_namespace).c_str(), "wb");
+    if (!f) return;
+    for (const auto& entry : _entries) {
+        uint16_t keyLen = static_cast<uint16_t>(entry.first.size());
+        uint32_t valueLen = static_cast<uint32_t>(entry.second.size());
+        fwrite(&keyLen, sizeof(keyLen), 1, f);
+        fwrite(entry.first.data(), 1, keyLen, f);
+        fwrite(&valueLen, sizeof(valueLen), 1, f);
+        fwrite(entry.second.data(), 1, valueLen, f);
+    }
+    fclose(f);
+    sim::stats().nvsCommits++;
+    _dirty = false;
+}
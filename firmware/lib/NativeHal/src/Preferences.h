@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "WString.h"
+
+// NVS simulada: cada namespace vira um arquivo em <raiz da simulação>/nvs/,
+// então o estado sobrevive a um ESP.restart() do processo simulado.
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+    void end();
+
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putBytes(const char* key, const void* value, size_t len);
+    size_t getBytes(const char* key, void* buf, size_t maxLen);
+    size_t getBytesLength(const char* key);
+
+    size_t putString(const char* key, const String& value);
+    size_t putString(const char* key, const char* value);
+    String getString(const char* key, const String& defaultValue = String());
+
+    size_t putUChar(const char* key, uint8_t value) { return putScalar(key, value); }
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0) { return getScalar(key, defaultValue); }
+    size_t putBool(const char* key, bool value) { return putScalar<uint8_t>(key, value ? 1 : 0); }
+    bool getBool(const char* key, bool defaultValue = false) { return getScalar<uint8_t>(key, defaultValue ? 1 : 0) != 0; }
+    size_t putUShort(const char* key, uint16_t value) { return putScalar(key, value); }
+    uint16_t getUShort(const char* key, uint16_t defaultValue = 0) { return getScalar(key, defaultValue); }
+    size_t putInt(const char* key, int32_t value) { return putScalar(key, value); }
+    int32_t getInt(const char* key, int32_t defaultValue = 0) { return getScalar(key, defaultValue); }
+    size_t putUInt(const char* key, uint32_t value) { return putScalar(key, value); }
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) { return getScalar(key, defaultValue); }
+    size_t putULong64(const char* key, uint64_t value) { return putScalar(key, value); }
+    uint64_t getULong64(const char* key, uint64_t defaultValue = 0) { return getScalar(key, defaultValue); }
+
+private:
+    template <typename T>
+    size_t putScalar(const char* key, T value) { return putBytes(key, &value, sizeof(T)); }
+    template <typename T>
+    T getScalar(const char* key, T defaultValue) {
+        T value;
+        return getBytes(key, &value, sizeof(T)) == sizeof(T) ? value : defaultValue;
+    }
+
+    void load();
+    void commit();
+
+    std::string _namespace;
+    bool _open = false;
+    bool _readOnly = true;
+    bool _dirty = false;
+    std::map<std::string, std::vector<uint8_t>> _entries;
+};
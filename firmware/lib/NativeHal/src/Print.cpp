@@ -0,0 +1,44 @@
+#include "Print.h"
+
+#include <cstdio>
+#include <vector>
+
+size_t Print::printf(const char* format, ...) {
+    char stackBuf[256];
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    int len = vsnprintf(stackBuf, sizeof(stackBuf), format, copy);
+    va_end(copy);
+    if (len < 0) {
+        va_end(args);
+        return 0;
+    }
+    if (static_cast<size_t>(len) < sizeof(stackBuf)) {
+        va_end(args);
+        return write(reinterpret_cast<const uint8_t*>(stackBuf), len);
+    }
+    std::vector<char> heapBuf(len + 1);
+    vsnprintf(heapBuf.data(), heapBuf.size(), format, args);
+    va_end(args);
+    return write(reinterpret_cast<const uint8_t*>(heapBuf.data()), len);
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+    // Os streams simulados nunca ficam "esperando" bytes: fim de dados é fim de stream
+    size_t count = 0;
+    while (count < length) {
+        int c = read();
+        if (c < 0) break;
+        buffer[count++] = static_cast<char>(c);
+    }
+    return count;
+}
+
+String Stream::readString() {
+    String out;
+    int c;
+    while ((c = read()) >= 0) out += static_cast<char>(c);
+    return out;
+}
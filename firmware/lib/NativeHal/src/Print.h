@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "WString.h"
+
+class Print;
+
+class Printable {
+public:
+    virtual ~Printable() = default;
+    virtual size_t printTo(Print& p) const = 0;
+};
+
+// --- Print / Stream (mesma hierarquia do core Arduino) ---
+class Print {
+public:
+    virtual ~Print() = default;
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (size--) {
+            if (!write(*buffer++)) break;
+            n++;
+        }
+        return n;
+    }
+    size_t write(const char* s) { return s ? write(reinterpret_cast<const uint8_t*>(s), strlen(s)) : 0; }
+    virtual void flush() {}
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    size_t print(const char* s) { return write(s); }
+    size_t print(const String& s) { return write(reinterpret_cast<const uint8_t*>(s.c_str()), s.length()); }
+    size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+    size_t print(int v, int base = 10) { return print(String(v, static_cast<unsigned char>(base))); }
+    size_t print(unsigned int v, int base = 10) { return print(String(v, static_cast<unsigned char>(base))); }
+    size_t print(long v, int base = 10) { return print(String(v, static_cast<unsigned char>(base))); }
+    size_t print(unsigned long v, int base = 10) { return print(String(v, static_cast<unsigned char>(base))); }
+    size_t print(double v, int decimals = 2) { return print(String(v, static_cast<unsigned int>(decimals))); }
+    size_t print(const Printable& p) { return p.printTo(*this); }
+
+    size_t println() { return print("\r\n"); }
+    template <typename T>
+    size_t println(const T& v) { size_t n = print(v); return n + println(); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeoutMs) { _timeout = timeoutMs; }
+    virtual size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes(reinterpret_cast<char*>(buffer), length); }
+    String readString();
+
+protected:
+    unsigned long _timeout = 1000;
+};
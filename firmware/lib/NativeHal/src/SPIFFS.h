@@ -0,0 +1,27 @@
+#pragma once
+
+#include "FS.h"
+
+namespace fs {
+
+// SPIFFS simulado: um diretório em <raiz da simulação>/spiffs
+class SPIFFSFS : public FS {
+public:
+    SPIFFSFS() : FS("spiffs") {}
+
+    bool begin(bool formatOnFail = false, const char* basePath = "/spiffs", uint8_t maxOpenFiles = 10,
+               const char* partitionLabel = nullptr);
+    void end() { _mounted = false; }
+    bool format();
+    size_t totalBytes();
+    size_t usedBytes();
+    // Escrita além da partição é cortada, como no SPIFFS cheio
+    size_t writableBytes() override;
+
+private:
+    bool _mounted = false;
+};
+
+} // namespace fs
+
+extern fs::SPIFFSFS SPIFFS;
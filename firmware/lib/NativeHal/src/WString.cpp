@@ -0,0 +1,88 @@
+#include "WString.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+template <typename T>
+std::string formatUnsigned(T value, unsigned char base) {
+    if (base < 2 || base > 36) base = 10;
+    if (value == 0) return "0";
+    std::string out;
+    while (value > 0) {
+        unsigned digit = static_cast<unsigned>(value % base);
+        out += static_cast<char>(digit < 10 ? '0' + digit : 'a' + digit - 10);
+        value /= base;
+    }
+    std::reverse(out.begin(), out.end());
+    return out;
+}
+
+template <typename T>
+std::string formatSigned(T value, unsigned char base) {
+    if (base == 10 && value < 0) {
+        return "-" + formatUnsigned(static_cast<unsigned long long>(-(value + 1)) + 1, base);
+    }
+    return formatUnsigned(static_cast<unsigned long long>(value), base);
+}
+
+std::string formatFloat(double value, unsigned int decimals) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", static_cast<int>(decimals), value);
+    return buf;
+}
+
+} // namespace
+
+String::String(unsigned char value, unsigned char base) : _s(formatUnsigned(value, base)) {}
+String::String(int value, unsigned char base) : _s(formatSigned(value, base)) {}
+String::String(unsigned int value, unsigned char base) : _s(formatUnsigned(value, base)) {}
+String::String(long value, unsigned char base) : _s(formatSigned(value, base)) {}
+String::String(unsigned long value, unsigned char base) : _s(formatUnsigned(value, base)) {}
+String::String(long long value, unsigned char base) : _s(formatSigned(value, base)) {}
+String::String(unsigned long long value, unsigned char base) : _s(formatUnsigned(value, base)) {}
+String::String(float value, unsigned int decimals) : _s(formatFloat(value, decimals)) {}
+String::String(double value, unsigned int decimals) : _s(formatFloat(value, decimals)) {}
+
+int String::indexOf(char c, unsigned int from) const {
+    size_t pos = _s.find(c, from);
+    return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+int String::indexOf(const String& s, unsigned int from) const {
+    size_t pos = _s.find(s._s, from);
+    return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= _s.size()) return String();
+    return String(_s.substr(from, std::min<size_t>(to, _s.size()) - from));
+}
+
+void String::trim() {
+    size_t begin = 0;
+    while (begin < _s.size() && isspace(static_cast<unsigned char>(_s[begin]))) begin++;
+    size_t end = _s.size();
+    while (end > begin && isspace(static_cast<unsigned char>(_s[end - 1]))) end--;
+    _s = _s.substr(begin, end - begin);
+}
+
+void String::toLowerCase() {
+    for (auto& c : _s) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+}
+
+void String::toUpperCase() {
+    for (auto& c : _s) c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+}
+
+long String::toInt() const { return strtol(_s.c_str(), nullptr, 10); }
+float String::toFloat() const { return strtof(_s.c_str(), nullptr); }
+
+String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+String operator+(const String& a, char b) { String r(a); r += b; return r; }
@@ -0,0 +1,297 @@
+#include "WiFi.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include "NativeSim.h"
+
+WiFiClass WiFi;
+
+namespace {
+
+// Resultado do último scan (cópia da lista simulada no momento da varredura)
+std::vector<sim::AccessPoint> scanResults;
+unsigned long scanStartedAt = 0;
+bool scanInProgress = false;
+
+const sim::AccessPoint* findAccessPoint(const std::string& ssid, const uint8_t* bssid = nullptr) {
+    for (const auto& ap : sim::accessPoints()) {
+        if (ap.ssid != ssid || !ap.reachable) continue;
+        if (bssid && memcmp(ap.bssid, bssid, sizeof(ap.bssid)) != 0) continue;
+        return &ap;
+    }
+    return nullptr;
+}
+
+const unsigned long EVENT_POLL_MS = 5;
+
+} // namespace
+
+WiFiClass::~WiFiClass() {
+    stopEvents();
+}
+
+void WiFiClass::stopEvents() {
+    {
+        std::lock_guard<std::recursive_mutex> guard(_lock);
+        _stopEvents = true;
+    }
+    if (_eventThread.joinable() && _eventThread.get_id() != std::this_thread::get_id()) _eventThread.join();
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventFuncCb cbEvent, arduino_event_id_t event) {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    _handlers.push_back(Handler{std::move(cbEvent), event});
+    if (!_eventThread.joinable() && !_stopEvents) _eventThread = std::thread(&WiFiClass::eventTask, this);
+    return _handlers.size();
+}
+
+void WiFiClass::post(arduino_event_id_t event, const WiFiEventInfo_t& info) {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    _pending.push_back(PendingEvent{event, info});
+}
+
+// Acompanha o enlace como o driver: conexão e IP, falha de uma tentativa
+// (AP ausente ou senha errada) e queda de um enlace que estava de pé
+void WiFiClass::eventTask() {
+    for (;;) {
+        std::vector<PendingEvent> events;
+        std::vector<Handler> handlers;
+        {
+            std::lock_guard<std::recursive_mutex> guard(_lock);
+            if (_stopEvents) return;
+
+            wl_status_t current = statusLocked();
+            WiFiEventInfo_t info;
+            memset(&info, 0, sizeof(info));
+            if (current == WL_CONNECTED && !_linkUp) {
+                _linkUp = true;
+                wifi_event_sta_connected_t& c = info.wifi_sta_connected;
+                c.ssid_len = static_cast<uint8_t>(std::min<size_t>(_targetSsid.size(), 32));
+                memcpy(c.ssid, _targetSsid.data(), c.ssid_len);
+                memcpy(c.bssid, _bssid, sizeof(c.bssid));
+                c.channel = static_cast<uint8_t>(channel());
+                c.authmode = _targetPass.empty() ? WIFI_AUTH_OPEN : WIFI_AUTH_WPA2_PSK;
+                _pending.push_back(PendingEvent{ARDUINO_EVENT_WIFI_STA_CONNECTED, info});
+                _pending.push_back(PendingEvent{ARDUINO_EVENT_WIFI_STA_GOT_IP, info});
+            } else if (current != WL_CONNECTED && _linkUp) {
+                _linkUp = false;
+                wifi_event_sta_disconnected_t& d = info.wifi_sta_disconnected;
+                d.ssid_len = static_cast<uint8_t>(std::min<size_t>(_targetSsid.size(), 32));
+                memcpy(d.ssid, _targetSsid.data(), d.ssid_len);
+                memcpy(d.bssid, _bssid, sizeof(d.bssid));
+                d.reason = _connecting ? WIFI_REASON_BEACON_TIMEOUT : WIFI_REASON_ASSOC_LEAVE;
+                _pending.push_back(PendingEvent{ARDUINO_EVENT_WIFI_STA_LOST_IP, info});
+                _pending.push_back(PendingEvent{ARDUINO_EVENT_WIFI_STA_DISCONNECTED, info});
+                _reportedAttempt = _attempt;
+                // Como o arduino-esp32: com autoReconnect o próprio driver tenta de novo
+                if (_connecting && _autoReconnect) reconnect();
+            } else if ((current == WL_NO_SSID_AVAIL || current == WL_CONNECT_FAILED) && _reportedAttempt != _attempt) {
+                _reportedAttempt = _attempt;
+                wifi_event_sta_disconnected_t& d = info.wifi_sta_disconnected;
+                d.ssid_len = static_cast<uint8_t>(std::min<size_t>(_targetSsid.size(), 32));
+                memcpy(d.ssid, _targetSsid.data(), d.ssid_len);
+                d.reason = current == WL_NO_SSID_AVAIL ? WIFI_REASON_NO_AP_FOUND : WIFI_REASON_AUTH_FAIL;
+                _pending.push_back(PendingEvent{ARDUINO_EVENT_WIFI_STA_DISCONNECTED, info});
+            }
+
+            events.assign(_pending.begin(), _pending.end());
+            _pending.clear();
+            if (!events.empty()) handlers = _handlers;
+        }
+        // Callbacks fora da trava: podem chamar a própria API WiFi
+        for (const PendingEvent& e : events) {
+            for (const Handler& h : handlers) {
+                if (h.event == ARDUINO_EVENT_MAX || h.event == e.event) h.callback(e.event, e.info);
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(EVENT_POLL_MS));
+    }
+}
+
+bool WiFiClass::mode(wifi_mode_t m) {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    _mode = m;
+    if (!(m & WIFI_MODE_STA)) _connecting = false;
+    if (!(m & WIFI_MODE_AP)) _apUp = false;
+    return true;
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* passphrase, int32_t channel, const uint8_t* bssid,
+                             bool connect) {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    if (!(_mode & WIFI_MODE_STA)) mode(static_cast<wifi_mode_t>(_mode | WIFI_MODE_STA));
+    _targetSsid = ssid ? ssid : "";
+    _targetPass = passphrase ? passphrase : "";
+    _targetChannel = channel;
+    _hasTargetBssid = bssid != nullptr;
+    if (bssid) memcpy(_targetBssid, bssid, sizeof(_targetBssid));
+    _beginAt = millis();
+    _connecting = connect;
+    _attempt++;
+    return WL_DISCONNECTED;
+}
+
+// Como o driver: sair de um enlace (ou de uma tentativa) gera na hora o
+// STA_DISCONNECTED com ASSOC_LEAVE, entregue depois pela tarefa de eventos
+bool WiFiClass::disconnect(bool wifiOff, bool eraseAp) {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    if (_linkUp || (_connecting && _reportedAttempt != _attempt)) {
+        WiFiEventInfo_t info;
+        memset(&info, 0, sizeof(info));
+        wifi_event_sta_disconnected_t& d = info.wifi_sta_disconnected;
+        d.ssid_len = static_cast<uint8_t>(std::min<size_t>(_targetSsid.size(), 32));
+        memcpy(d.ssid, _targetSsid.data(), d.ssid_len);
+        if (_linkUp) memcpy(d.bssid, _bssid, sizeof(d.bssid));
+        d.reason = WIFI_REASON_ASSOC_LEAVE;
+        if (_linkUp) _pending.push_back(PendingEvent{ARDUINO_EVENT_WIFI_STA_LOST_IP, info});
+        _pending.push_back(PendingEvent{ARDUINO_EVENT_WIFI_STA_DISCONNECTED, info});
+        _linkUp = false;
+        _reportedAttempt = _attempt;
+    }
+    _connecting = false;
+    if (eraseAp) _targetSsid.clear();
+    if (wifiOff) mode(WIFI_MODE_NULL);
+    return true;
+}
+
+bool WiFiClass::reconnect() {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    if (_targetSsid.empty()) return false;
+    _beginAt = millis();
+    _connecting = true;
+    _attempt++;
+    return true;
+}
+
+bool WiFiClass::setAutoReconnect(bool autoReconnect) {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    _autoReconnect = autoReconnect;
+    return true;
+}
+
+wl_status_t WiFiClass::status() {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    return statusLocked();
+}
+
+// Com canal+BSSID a associação vai direto ao AP (sem scan), mas só se ele
+// ainda estiver naquele BSSID e canal; senão a tentativa falha como AP ausente
+wl_status_t WiFiClass::statusLocked() {
+    if (!_connecting || !(_mode & WIFI_MODE_STA)) return WL_DISCONNECTED;
+    unsigned long elapsed = millis() - _beginAt;
+    const sim::AccessPoint* ap = findAccessPoint(_targetSsid, _hasTargetBssid ? _targetBssid : nullptr);
+    if (ap && _targetChannel > 0 && ap->channel != _targetChannel) ap = nullptr;
+    if (ap && ap->password == _targetPass) {
+        unsigned long connectMs = _hasTargetBssid && _targetChannel > 0 ? sim::config().wifiFastConnectMillis
+                                                                        : sim::config().wifiConnectMillis;
+        if (elapsed < connectMs) return WL_DISCONNECTED;
+        memcpy(_bssid, ap->bssid, sizeof(_bssid));
+        return WL_CONNECTED;
+    }
+    if (elapsed < sim::config().wifiFailMillis) return WL_DISCONNECTED;
+    return ap ? WL_CONNECT_FAILED : WL_NO_SSID_AVAIL;
+}
+
+IPAddress WiFiClass::localIP() {
+    return status() == WL_CONNECTED ? IPAddress(192, 168, 1, 50) : IPAddress();
+}
+
+IPAddress WiFiClass::gatewayIP() {
+    return status() == WL_CONNECTED ? IPAddress(192, 168, 1, 1) : IPAddress();
+}
+
+int8_t WiFiClass::RSSI() {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    const sim::AccessPoint* ap = findAccessPoint(_targetSsid, _bssid);
+    return statusLocked() == WL_CONNECTED && ap ? static_cast<int8_t>(ap->rssi) : 0;
+}
+
+uint8_t* WiFiClass::BSSID() {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    return statusLocked() == WL_CONNECTED ? _bssid : nullptr;
+}
+
+int32_t WiFiClass::channel() {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    const sim::AccessPoint* ap = findAccessPoint(_targetSsid, _bssid);
+    return statusLocked() == WL_CONNECTED && ap ? ap->channel : 0;
+}
+
+bool WiFiClass::softAP(const char* ssid, const char* passphrase, int channel, int ssidHidden, int maxConnection) {
+    (void)ssid;
+    (void)passphrase;
+    (void)channel;
+    (void)ssidHidden;
+    (void)maxConnection;
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    mode(static_cast<wifi_mode_t>(_mode | WIFI_MODE_AP));
+    if (!_apUp) {
+        WiFiEventInfo_t info;
+        memset(&info, 0, sizeof(info));
+        post(ARDUINO_EVENT_WIFI_AP_START, info);
+    }
+    _apUp = true;
+    return true;
+}
+
+bool WiFiClass::softAPdisconnect(bool wifiOff) {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    if (_apUp) {
+        WiFiEventInfo_t info;
+        memset(&info, 0, sizeof(info));
+        post(ARDUINO_EVENT_WIFI_AP_STOP, info);
+    }
+    _apUp = false;
+    mode(static_cast<wifi_mode_t>(wifiOff ? WIFI_MODE_NULL : (_mode & ~WIFI_MODE_AP)));
+    return true;
+}
+
+IPAddress WiFiClass::softAPIP() {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    return _apUp ? IPAddress(192, 168, 4, 1) : IPAddress();
+}
+
+int16_t WiFiClass::scanNetworks(bool async, bool showHidden) {
+    (void)showHidden;
+    if (scanInProgress) return WIFI_SCAN_RUNNING;
+    scanStartedAt = millis();
+    scanInProgress = true;
+    if (async) return WIFI_SCAN_RUNNING;
+    // O scan síncrono bloqueia o chamador pelo tempo de varredura de todos os canais
+    delay(sim::config().wifiScanMillis);
+    return scanComplete();
+}
+
+int16_t WiFiClass::scanComplete() {
+    if (scanInProgress) {
+        if (millis() - scanStartedAt < sim::config().wifiScanMillis) return WIFI_SCAN_RUNNING;
+        scanResults.clear();
+        for (const auto& ap : sim::accessPoints()) {
+            if (ap.reachable) scanResults.push_back(ap);
+        }
+        scanInProgress = false;
+        _scanCount = static_cast<int16_t>(scanResults.size());
+    }
+    return _scanCount;
+}
+
+void WiFiClass::scanDelete() {
+    scanResults.clear();
+    _scanCount = WIFI_SCAN_FAILED;
+}
+
+String WiFiClass::SSID(uint8_t i) {
+    return i < scanResults.size() ? String(scanResults[i].ssid.c_str()) : String();
+}
+
+int32_t WiFiClass::RSSI(uint8_t i) {
+    return i < scanResults.size() ? scanResults[i].rssi : 0;
+}
+
+wifi_auth_mode_t WiFiClass::encryptionType(uint8_t i) {
+    if (i >= scanResults.size()) return WIFI_AUTH_OPEN;
+    return scanResults[i].password.empty() ? WIFI_AUTH_OPEN : WIFI_AUTH_WPA2_PSK;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Arduino.h"
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum {
+    WIFI_MODE_NULL = 0,
+    WIFI_MODE_STA = 1,
+    WIFI_MODE_AP = 2,
+    WIFI_MODE_APSTA = 3
+} wifi_mode_t;
+
+#define WIFI_OFF WIFI_MODE_NULL
+#define WIFI_STA WIFI_MODE_STA
+#define WIFI_AP WIFI_MODE_AP
+#define WIFI_AP_STA WIFI_MODE_APSTA
+
+typedef enum {
+    WIFI_AUTH_OPEN = 0,
+    WIFI_AUTH_WEP,
+    WIFI_AUTH_WPA_PSK,
+    WIFI_AUTH_WPA2_PSK,
+    WIFI_AUTH_WPA_WPA2_PSK,
+    WIFI_AUTH_WPA2_ENTERPRISE,
+    WIFI_AUTH_WPA3_PSK
+} wifi_auth_mode_t;
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+// Eventos do driver (mesma ordem do arduino-esp32 2.x; só os usados pela simulação)
+typedef enum {
+    ARDUINO_EVENT_WIFI_READY = 0,
+    ARDUINO_EVENT_WIFI_SCAN_DONE,
+    ARDUINO_EVENT_WIFI_STA_START,
+    ARDUINO_EVENT_WIFI_STA_STOP,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+    ARDUINO_EVENT_WIFI_STA_AUTHMODE_CHANGE,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP6,
+    ARDUINO_EVENT_WIFI_STA_LOST_IP,
+    ARDUINO_EVENT_WIFI_AP_START,
+    ARDUINO_EVENT_WIFI_AP_STOP,
+    ARDUINO_EVENT_MAX
+} arduino_event_id_t;
+
+typedef enum {
+    WIFI_REASON_ASSOC_LEAVE = 8,
+    WIFI_REASON_BEACON_TIMEOUT = 200,
+    WIFI_REASON_NO_AP_FOUND = 201,
+    WIFI_REASON_AUTH_FAIL = 202,
+    WIFI_REASON_CONNECTION_FAIL = 205,
+} wifi_err_reason_t;
+
+typedef struct {
+    uint8_t ssid[33];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t channel;
+    wifi_auth_mode_t authmode;
+} wifi_event_sta_connected_t;
+
+typedef struct {
+    uint8_t ssid[33];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t reason;
+} wifi_event_sta_disconnected_t;
+
+typedef union {
+    wifi_event_sta_connected_t wifi_sta_connected;
+    wifi_event_sta_disconnected_t wifi_sta_disconnected;
+} arduino_event_info_t;
+
+typedef arduino_event_id_t WiFiEvent_t;
+typedef arduino_event_info_t WiFiEventInfo_t;
+typedef std::function<void(WiFiEvent_t event, WiFiEventInfo_t info)> WiFiEventFuncCb;
+typedef size_t wifi_event_id_t;
+
+// Rádio WiFi simulado: a lista de redes "no ar" vem de sim::accessPoints().
+// Como no ESP32, os eventos (onEvent) chegam de outra thread, a "tarefa de
+// eventos", que acompanha o enlace e avisa conexão, IP e quedas.
+class WiFiClass {
+public:
+    ~WiFiClass();
+    // Só da simulação (sim::end()): encerra e junta a tarefa de eventos
+    void stopEvents();
+
+    bool mode(wifi_mode_t m);
+    wifi_mode_t getMode() const { return _mode; }
+
+    wl_status_t begin(const char* ssid, const char* passphrase = nullptr, int32_t channel = 0,
+                      const uint8_t* bssid = nullptr, bool connect = true);
+    bool disconnect(bool wifiOff = false, bool eraseAp = false);
+    bool reconnect();
+    wl_status_t status();
+    bool isConnected() { return status() == WL_CONNECTED; }
+    bool setAutoReconnect(bool autoReconnect);
+    bool getAutoReconnect() const { return _autoReconnect; }
+    void persistent(bool persistent) { (void)persistent; }
+
+    wifi_event_id_t onEvent(WiFiEventFuncCb cbEvent, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+
+    IPAddress localIP();
+    IPAddress gatewayIP();
+    String SSID() const { return String(_targetSsid.c_str()); }
+    int8_t RSSI();
+    uint8_t* BSSID();
+    int32_t channel();
+
+    bool softAP(const char* ssid, const char* passphrase = nullptr, int channel = 1, int ssidHidden = 0,
+                int maxConnection = 4);
+    bool softAPdisconnect(bool wifiOff = false);
+    IPAddress softAPIP();
+
+    int16_t scanNetworks(bool async = false, bool showHidden = false);
+    int16_t scanComplete();
+    void scanDelete();
+    String SSID(uint8_t i);
+    int32_t RSSI(uint8_t i);
+    wifi_auth_mode_t encryptionType(uint8_t i);
+
+private:
+    struct Handler {
+        WiFiEventFuncCb callback;
+        arduino_event_id_t event;
+    };
+    struct PendingEvent {
+        arduino_event_id_t event;
+        WiFiEventInfo_t info;
+    };
+
+    wl_status_t statusLocked();
+    void post(arduino_event_id_t event, const WiFiEventInfo_t& info);
+    void eventTask();
+
+    std::recursive_mutex _lock;
+    wifi_mode_t _mode = WIFI_MODE_NULL;
+    std::string _targetSsid;
+    std::string _targetPass;
+    int32_t _targetChannel = 0;        // begin() com canal+BSSID: conexão direta, sem scan
+    uint8_t _targetBssid[6] = {0};
+    bool _hasTargetBssid = false;
+    uint8_t _bssid[6] = {0};           // AP da conexão atual
+    unsigned long _beginAt = 0;
+    bool _connecting = false;
+    bool _autoReconnect = true;
+    bool _apUp = false;
+    int16_t _scanCount = WIFI_SCAN_FAILED;
+
+    // Tarefa de eventos
+    std::vector<Handler> _handlers;
+    std::deque<PendingEvent> _pending;
+    std::thread _eventThread;
+    bool _stopEvents = false;
+    uint32_t _attempt = 0;             // incrementa a cada begin()/reconnect()
+    uint32_t _reportedAttempt = 0;     // tentativa cuja falha já foi avisada
+    bool _linkUp = false;
+};
+
+extern WiFiClass WiFi;
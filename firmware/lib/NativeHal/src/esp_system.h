@@ -0,0 +1,11 @@
+#pragma once
+
+// Subconjunto de esp_system.h: handlers executados por ESP.restart()/esp_restart()
+// antes do reinício, na task que pediu o reinício.
+
+#include "esp_timer.h"
+
+typedef void (*shutdown_handler_t)(void);
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler);
+esp_err_t esp_unregister_shutdown_handler(shutdown_handler_t handler);
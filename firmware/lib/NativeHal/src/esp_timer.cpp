@@ -0,0 +1,144 @@
+#include "esp_timer.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "Arduino.h"
+
+struct esp_timer {
+    esp_timer_create_args_t args;
+    std::thread thread;
+    std::mutex lock;
+    std::condition_variable wake;
+    bool running = false;
+};
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Timers vivos, para sim::end(). Nunca destruídos: uma thread de timer que
+// ainda rode durante os destrutores estáticos não encontra a trava desfeita
+std::mutex& registryLock() {
+    static std::mutex* lock = new std::mutex();
+    return *lock;
+}
+
+std::set<esp_timer*>& registry() {
+    static std::set<esp_timer*>* timers = new std::set<esp_timer*>();
+    return *timers;
+}
+
+bool timersStopped = false;   // sob registryLock(): depois de sim::end(), nada mais arma
+
+void run(esp_timer* timer, uint64_t periodUs, bool periodic) {
+    auto next = Clock::now() + std::chrono::microseconds(periodUs);
+    std::unique_lock<std::mutex> guard(timer->lock);
+    while (timer->running) {
+        if (timer->wake.wait_until(guard, next, [timer] { return !timer->running; })) break;
+        guard.unlock();
+        timer->args.callback(timer->args.arg);
+        guard.lock();
+        if (!periodic) {
+            timer->running = false;
+            break;
+        }
+        next += std::chrono::microseconds(periodUs);
+        // Como com skip_unhandled_events: disparos atrasados não se acumulam
+        if (timer->args.skip_unhandled_events && next < Clock::now()) {
+            next = Clock::now() + std::chrono::microseconds(periodUs);
+        }
+    }
+}
+
+esp_err_t start(esp_timer_handle_t timer, uint64_t us, bool periodic) {
+    if (!timer || us == 0) return ESP_ERR_INVALID_ARG;
+    {
+        std::lock_guard<std::mutex> guard(registryLock());
+        if (timersStopped) return ESP_ERR_INVALID_STATE;
+    }
+    {
+        std::lock_guard<std::mutex> guard(timer->lock);
+        if (timer->running) return ESP_ERR_INVALID_STATE;
+        timer->running = true;
+    }
+    if (timer->thread.joinable()) timer->thread.join();
+    timer->thread = std::thread(run, timer, us, periodic);
+    return ESP_OK;
+}
+
+} // namespace
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* outHandle) {
+    if (!args || !args->callback || !outHandle) return ESP_ERR_INVALID_ARG;
+    esp_timer* timer = new esp_timer();
+    timer->args = *args;
+    {
+        std::lock_guard<std::mutex> guard(registryLock());
+        registry().insert(timer);
+    }
+    *outHandle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutUs) {
+    return start(timer, timeoutUs, false);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t periodUs) {
+    return start(timer, periodUs, true);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    {
+        std::lock_guard<std::mutex> guard(timer->lock);
+        if (!timer->running) return ESP_ERR_INVALID_STATE;
+        timer->running = false;
+    }
+    timer->wake.notify_all();
+    // Parado de dentro do próprio callback: a thread termina sozinha
+    if (timer->thread.get_id() != std::this_thread::get_id()) timer->thread.join();
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    if (timer->running) return ESP_ERR_INVALID_STATE;
+    if (timer->thread.joinable()) timer->thread.join();
+    {
+        std::lock_guard<std::mutex> guard(registryLock());
+        registry().erase(timer);
+    }
+    delete timer;
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time() {
+    return static_cast<int64_t>(micros());
+}
+
+namespace sim {
+
+// Para todos os timers e junta as threads deles; chamado por sim::end()
+void stopTimers() {
+    std::set<esp_timer*> timers;
+    {
+        std::lock_guard<std::mutex> guard(registryLock());
+        timersStopped = true;
+        timers = registry();
+    }
+    for (esp_timer* timer : timers) {
+        {
+            std::lock_guard<std::mutex> guard(timer->lock);
+            timer->running = false;
+        }
+        timer->wake.notify_all();
+        if (timer->thread.joinable()) timer->thread.join();
+    }
+}
+
+} // namespace sim
@@ -0,0 +1,36 @@
+#pragma once
+
+// Tarefas do FreeRTOS para o ambiente [env:native]: cada tarefa é uma thread.
+// A prioridade vira SCHED_FIFO quando o processo tem permissão (root ou
+// CAP_SYS_NICE); sem ela a thread roda na política normal do Linux. O núcleo
+// pedido é só registrado. Notificações de tarefa são um contador com espera.
+// A pilha da thread é alocada aqui, com pelo menos HOST_MIN_STACK_BYTES (o
+// código de 64 bits e a libc do host usam mais pilha que o ESP32), e pintada
+// para que uxTaskGetStackHighWaterMark() meça o mínimo livre, como no IDF.
+// Em sim::end() cada tarefa para no próximo vTaskDelay/ulTaskNotifyTake.
+
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+typedef struct NativeTask* TaskHandle_t;
+
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameter,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core);
+inline BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameter,
+                              UBaseType_t priority, TaskHandle_t* handle) {
+    return xTaskCreatePinnedToCore(function, name, stackDepth, parameter, priority, handle, tskNO_AFFINITY);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle();
+// Menor sobra da pilha, em bytes; 0 para a thread principal (loop())
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken);
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait);
+
+// No host a "ISR" roda na thread de quem mudou o pino: não há troca a pedir
+#define portYIELD_FROM_ISR(woken) ((void)(woken))
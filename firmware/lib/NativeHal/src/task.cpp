@@ -0,0 +1,190 @@
+#include "freertos/task.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct NativeTask {
+    std::string name;
+    UBaseType_t priority;
+    BaseType_t core;
+    TaskFunction_t function;
+    void* parameter;
+    uint8_t* stack;
+    size_t stackBytes;
+    std::mutex lock;
+    std::condition_variable wake;
+    uint32_t notifications = 0;
+};
+
+namespace {
+
+const size_t HOST_MIN_STACK_BYTES = 64 * 1024;
+const uint8_t STACK_PAINT = 0xA5;
+
+thread_local NativeTask* currentTask = nullptr;
+
+// Encerramento (sim::end()): as tarefas do FreeRTOS nunca retornam, então cada
+// uma para no próximo ponto de espera (vTaskDelay/ulTaskNotifyTake) e fica lá,
+// presa só a estado no heap, enquanto main() retorna e roda os destrutores
+std::atomic<bool> stopping{false};
+std::atomic<size_t> parked{0};
+
+// Tarefas criadas; como elas, nunca destruído
+std::mutex& registryLock() {
+    static std::mutex* lock = new std::mutex();
+    return *lock;
+}
+
+std::vector<NativeTask*>& registry() {
+    static std::vector<NativeTask*>* tasks = new std::vector<NativeTask*>();
+    return *tasks;
+}
+
+[[noreturn]] void park(NativeTask* task) {
+    parked.fetch_add(1);
+    std::unique_lock<std::mutex> guard(task->lock);
+    for (;;) task->wake.wait(guard);
+}
+
+void* taskMain(void* arg) {
+    NativeTask* task = static_cast<NativeTask*>(arg);
+    currentTask = task;
+    pthread_setname_np(pthread_self(), task->name.substr(0, 15).c_str());
+    // Prioridade real só se o processo puder; senão segue como thread comum
+    sched_param param = {};
+    param.sched_priority = task->priority < 1 ? 1 : static_cast<int>(task->priority);
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    task->function(task->parameter);
+    parked.fetch_add(1);   // retornou (fora do padrão do FreeRTOS): também já parou
+    return nullptr;
+}
+
+void give(NativeTask* task) {
+    {
+        std::lock_guard<std::mutex> guard(task->lock);
+        task->notifications++;
+    }
+    task->wake.notify_one();
+}
+
+} // namespace
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameter,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    NativeTask* task = new NativeTask();
+    task->name = name ? name : "";
+    task->priority = priority;
+    task->core = core;
+    task->function = function;
+    task->parameter = parameter;
+    // Pilha cresce para baixo: o que sobrar da pintura no começo do bloco nunca foi usado
+    task->stackBytes = (std::max<size_t>(stackDepth, HOST_MIN_STACK_BYTES) + 4095) & ~size_t(4095);
+    task->stack = static_cast<uint8_t*>(std::aligned_alloc(4096, task->stackBytes));
+    memset(task->stack, STACK_PAINT, task->stackBytes);
+    if (handle) *handle = task;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, task->stack, task->stackBytes);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_t thread;
+    int err = pthread_create(&thread, &attr, taskMain, task);
+    pthread_attr_destroy(&attr);
+    if (err != 0) return pdFAIL;
+    std::lock_guard<std::mutex> guard(registryLock());
+    registry().push_back(task);
+    return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return currentTask;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    if (!task) task = currentTask;
+    if (!task) return 0;
+    size_t untouched = 0;
+    while (untouched < task->stackBytes && task->stack[untouched] == STACK_PAINT) untouched++;
+    return static_cast<UBaseType_t>(untouched);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    NativeTask* task = currentTask;
+    if (!task) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ticks * portTICK_PERIOD_MS));
+        return;
+    }
+    // Numa tarefa, a espera é interrompível pelo encerramento
+    std::unique_lock<std::mutex> guard(task->lock);
+    task->wake.wait_for(guard, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS), [] { return stopping.load(); });
+    guard.unlock();
+    if (stopping) park(task);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    if (task) give(task);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken) {
+    if (task) give(task);
+    if (higherPriorityTaskWoken) *higherPriorityTaskWoken = pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait) {
+    NativeTask* task = currentTask;
+    if (!task) {
+        vTaskDelay(ticksToWait == portMAX_DELAY ? 1 : ticksToWait);
+        return 0;
+    }
+    std::unique_lock<std::mutex> guard(task->lock);
+    auto ready = [task] { return task->notifications > 0 || stopping; };
+    if (ticksToWait == portMAX_DELAY) {
+        task->wake.wait(guard, ready);
+    } else {
+        task->wake.wait_for(guard, std::chrono::milliseconds(ticksToWait * portTICK_PERIOD_MS), ready);
+    }
+    if (stopping) {
+        guard.unlock();
+        park(task);
+    }
+    uint32_t count = task->notifications;
+    if (count > 0) task->notifications = clearCountOnExit ? 0 : count - 1;
+    return count;
+}
+
+namespace sim {
+
+// Acorda as tarefas e espera cada uma parar no seu ponto de espera; false se
+// alguma não chegar lá a tempo. Chamado por sim::end()
+bool parkTasks(unsigned long timeoutMs) {
+    stopping = true;
+    size_t tasks;
+    {
+        std::lock_guard<std::mutex> guard(registryLock());
+        tasks = registry().size();
+        for (NativeTask* task : registry()) {
+            // Com a trava da tarefa: quem está entre o predicado e a espera não perde o aviso
+            { std::lock_guard<std::mutex> taskGuard(task->lock); }
+            task->wake.notify_all();
+        }
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (parked.load() < tasks) {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+} // namespace sim
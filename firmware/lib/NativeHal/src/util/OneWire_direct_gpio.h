@@ -0,0 +1,16 @@
+#pragma once
+
+// Subconjunto de util/OneWire_direct_gpio.h (OneWire): no ESP32 são escritas
+// diretas nos registradores de GPIO, seguras em seção crítica. No simulador
+// passam pelo pino simulado, que acompanha a linha 1-Wire (sim::attachOneWire)
+
+#include "Arduino.h"
+
+#define IO_REG_TYPE uint32_t
+#define PIN_TO_BASEREG(pin) (0)
+#define PIN_TO_BITMASK(pin) (pin)
+#define DIRECT_READ(base, pin) digitalRead(pin)
+#define DIRECT_WRITE_LOW(base, pin) digitalWrite(pin, LOW)
+#define DIRECT_WRITE_HIGH(base, pin) digitalWrite(pin, HIGH)
+#define DIRECT_MODE_INPUT(base, pin) pinMode(pin, INPUT)
+#define DIRECT_MODE_OUTPUT(base, pin) pinMode(pin, OUTPUT)
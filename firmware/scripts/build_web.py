@@ -0,0 +1,128 @@
+# Gera src/WebAssets.h a partir de web/: páginas com o CSS do Tailwind embutido
+# e podado, minificadas e comprimidas em gzip, como arrays PROGMEM com ETag.
+#
+# Roda antes de cada build pelo PlatformIO (extra_scripts = pre:...) e também
+# avulso: python3 scripts/build_web.py
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+try:
+    Import("env")  # noqa: F821 - definido pelo SCons do PlatformIO
+    PROJECT_DIR = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(sys.argv[0])))
+
+WEB_DIR = os.path.join(PROJECT_DIR, "web")
+OUTPUT = os.path.join(PROJECT_DIR, "src", "WebAssets.h")
+
+# (arquivo, prefixo dos símbolos C++)
+PAGES = [
+    ("index.html", "INDEX_HTML"),
+    ("config.html", "CONFIG_HTML"),
+]
+
+INLINE_MARKER = re.compile(r"/\* @inline ([\w.-]+) \*/")
+CLASS_ATTR = re.compile(r'class="([^"]*)"')
+CLASS_LIST_CALL = re.compile(r"classList\.\w+\(\s*'([\w-]+)'")
+CSS_CLASS = re.compile(r"\.((?:\\.|[\w-])+)")
+
+
+def used_classes(html):
+    classes = set()
+    for attr in CLASS_ATTR.findall(html):
+        classes.update(attr.split())
+    classes.update(CLASS_LIST_CALL.findall(html))
+    return classes
+
+
+def purge_css(css, classes):
+    kept = []
+    defined = set()
+    css = re.sub(r"/\*.*?\*/", "", css, flags=re.S)
+    for line in css.splitlines():
+        line = line.strip()
+        if not line:
+            continue
+        # Classes do seletor: tira os blocos de declarações (e o que há dentro deles)
+        selectors = {c.replace("\\", "") for c in CSS_CLASS.findall(re.sub(r"\{[^{}]*\}", "", line))}
+        # Seletores sem classe (preflight) ficam sempre
+        if not selectors or selectors & classes:
+            kept.append(line)
+            defined.update(selectors)
+    return "".join(kept), defined
+
+
+def own_classes(html):
+    # Classes definidas no <style> da própria página (ex.: pump-card, toggle-checkbox)
+    styles = "".join(re.findall(r"<style>(.*?)</style>", html, re.S))
+    return {c for c in CSS_CLASS.findall(INLINE_MARKER.sub("", styles)) if not c[0].isdigit()}
+
+
+def render(name):
+    with open(os.path.join(WEB_DIR, name), encoding="utf-8") as f:
+        html = f.read()
+    classes = used_classes(html)
+    defined = own_classes(html)
+
+    def inline(match):
+        with open(os.path.join(WEB_DIR, match.group(1)), encoding="utf-8") as f:
+            css, purged_defined = purge_css(f.read(), classes)
+        defined.update(purged_defined)
+        return css
+
+    html = INLINE_MARKER.sub(inline, html)
+    missing = sorted(classes - defined)
+    if missing:
+        print("build_web: %s usa classes sem regra CSS: %s" % (name, " ".join(missing)))
+
+    # Minificação conservadora: só indentação e linhas vazias (JS e CSS seguem válidos)
+    lines = [line.strip() for line in html.splitlines()]
+    return "\n".join(line for line in lines if line).encode("utf-8")
+
+
+def c_array(data):
+    rows = []
+    for i in range(0, len(data), 16):
+        rows.append("    " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return "\n".join(rows)
+
+
+def generate():
+    out = [
+        "// Gerado por scripts/build_web.py a partir de web/ - não editar",
+        "#pragma once",
+        "",
+        "#include <Arduino.h>",
+        "",
+    ]
+    for name, symbol in PAGES:
+        raw = render(name)
+        packed = gzip.compress(raw, compresslevel=9, mtime=0)  # mtime fixo: build reprodutível
+        etag = hashlib.sha1(packed).hexdigest()[:16]
+        out += [
+            "// %s: %d B -> %d B gzip" % (name, len(raw), len(packed)),
+            'const char %s_ETAG[] = "\\"%s\\"";' % (symbol, etag),
+            "const size_t %s_GZ_LEN = %d;" % (symbol, len(packed)),
+            "const uint8_t %s_GZ[] PROGMEM = {" % symbol,
+            c_array(packed),
+            "};",
+            "",
+        ]
+    content = "\n".join(out)
+
+    # Só reescreve se mudou, para não recompilar o main.cpp à toa
+    try:
+        with open(OUTPUT, encoding="utf-8") as f:
+            if f.read() == content:
+                return
+    except FileNotFoundError:
+        pass
+    with open(OUTPUT, "w", encoding="utf-8") as f:
+        f.write(content)
+    print("build_web: %s atualizado" % os.path.relpath(OUTPUT, PROJECT_DIR))
+
+
+generate()
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Arduino.h>
+#include "RgbEffects.h"
+#include "TemperatureSensor.h"
+
+// --- Estado publicado do controlador ---
+// Tudo que o full_state, os deltas e a API mostram. O loop() é o único que
+// escreve na sua cópia de trabalho e a publica num SeqLock a cada delta; as
+// outras tarefas leem essa cópia inteira, nunca um campo solto no meio de uma
+// atualização. Mudanças vindas de fora do loop() chegam como ControlCommand,
+// e cada delta segue para a tarefa de rede como StateDelta.
+
+struct ProbeState {
+    float celsius = DEVICE_DISCONNECTED_C;
+    bool valid = false;
+    bool present = false;
+};
+
+struct ControllerState {
+    uint32_t seq = 0;                     // número do último delta
+    bool pumps[4] = {false, false, false, false};
+    float temperature = -127.0;
+    int luminosity = 0;
+    uint8_t color[3] = {255, 0, 255};     // R, G, B - Roxo padrão
+    RgbEffectType effect = RgbEffectType::Static;
+    uint32_t effectPeriod = 0;            // ms (ciclo/pulso)
+    ProbeState probes[TemperatureSensorBus::MAX_PROBES];
+};
+
+// Um delta a enviar: campos marcados (bits DIRTY_*) e o estado daquele seq
+struct StateDelta {
+    uint32_t fields;
+    ControllerState state;
+};
+
+enum class ControlCommandType : uint8_t { SetPump, SetEffect };
+
+struct ControlCommand {
+    ControlCommandType type;
+    uint8_t target;   // bomba ou RgbEffectType
+    uint32_t value;   // estado da bomba ou período do efeito (ms)
+};
@@ -0,0 +1,61 @@
+#include "DeferredActions.h"
+
+bool DeferredActionQueue::schedule(AsyncWebServerRequest* request, DeferredAction action, unsigned long delayMs) {
+    uint32_t id = 0;
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        Entry* free = nullptr;
+        for (Entry& entry : _entries) {
+            if (entry.id != 0 && entry.action == action) {
+                id = entry.id;
+                break;
+            }
+            if (entry.id == 0 && !free) free = &entry;
+        }
+        if (id == 0) {
+            if (!free) return false;
+            if (++_nextId == 0) ++_nextId;   // 0 marca entrada livre
+            id = _nextId;
+            *free = Entry{id, action, false, millis(), 0, delayMs};
+        }
+    }
+    request->onDisconnect([this, id]() { release(id); });
+    return true;
+}
+
+void DeferredActionQueue::release(uint32_t id) {
+    std::lock_guard<std::mutex> guard(_lock);
+    for (Entry& entry : _entries) {
+        if (entry.id == id && !entry.released) {
+            entry.released = true;
+            entry.releasedAt = millis();
+        }
+    }
+}
+
+void DeferredActionQueue::poll(unsigned long now) {
+    DeferredAction action;
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        Entry* ready = nullptr;
+        for (Entry& entry : _entries) {
+            if (entry.id == 0) continue;
+            // Com sinal: o AsyncTCP carimba com millis() depois de o loop() ler `now`,
+            // e a diferença sem sinal daria ~4·10⁹ (tempo esgotado na hora)
+            bool released = entry.released && (long)(now - entry.releasedAt) >= (long)entry.delayMs;
+            bool expired =
+                !entry.released && (long)(now - entry.scheduledAt) >= (long)(RELEASE_TIMEOUT_MS + entry.delayMs);
+            if (released || expired) {
+                if (expired) _timedOut++;
+                ready = &entry;
+                break;
+            }
+        }
+        if (!ready) return;
+        action = ready->action;
+        ready->id = 0;
+        _executed++;
+    }
+    // Fora da trava: a ação pode reiniciar o chip ou mexer no WiFi
+    if (_runner) _runner(action);
+}
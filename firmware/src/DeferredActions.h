@@ -0,0 +1,59 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <mutex>
+
+// --- Ações adiadas para depois da resposta HTTP ---
+// Um handler não pode reiniciar o ESP32 (nem derrubar o WiFi) de dentro da
+// tarefa do AsyncTCP: a resposta ainda está na fila de envio e nunca chega ao
+// cliente. schedule() só registra a ação e a amarra ao onDisconnect da
+// requisição, que o servidor dispara depois que a resposta foi entregue e a
+// conexão fechou. O loop() chama poll() e executa a ação liberada, passado o
+// atraso pedido. Se o onDisconnect não vier, a ação roda mesmo assim depois
+// de RELEASE_TIMEOUT_MS.
+
+enum class DeferredAction : uint8_t {
+    Restart,
+    ApplyWifi,       // aplica as credenciais recebidas sem reiniciar
+    FactoryReset,    // apaga NVS e SPIFFS e reinicia
+};
+
+class DeferredActionQueue {
+public:
+    static constexpr uint8_t CAPACITY = 4;
+    static constexpr unsigned long RELEASE_TIMEOUT_MS = 5000;
+
+    typedef void (*Runner)(DeferredAction action);
+
+    // `runner` executa as ações, sempre na tarefa do loop()
+    void begin(Runner runner) { _runner = runner; }
+
+    // Chamado pelo handler; false se a fila estiver cheia. A mesma ação já
+    // pendente não é duplicada (ex.: dois cliques em "Salvar")
+    bool schedule(AsyncWebServerRequest* request, DeferredAction action, unsigned long delayMs = 0);
+
+    void poll(unsigned long now);
+
+    uint32_t executed() const { return _executed; }
+    uint32_t timedOut() const { return _timedOut; }
+
+private:
+    struct Entry {
+        uint32_t id;               // 0 = livre
+        DeferredAction action;
+        bool released;             // resposta entregue
+        unsigned long scheduledAt;
+        unsigned long releasedAt;
+        unsigned long delayMs;
+    };
+
+    void release(uint32_t id);
+
+    std::mutex _lock;
+    Entry _entries[CAPACITY] = {};
+    uint32_t _nextId = 0;
+    Runner _runner = nullptr;
+    uint32_t _executed = 0;
+    uint32_t _timedOut = 0;        // executadas sem o onDisconnect
+};
@@ -0,0 +1,59 @@
+#include "JsonArena.h"
+
+void* JsonArena::allocate(size_t size) {
+    size_t block = blockSize(size);
+    if (block > _capacity - _top) {
+        _overflows++;
+        return malloc(size);
+    }
+    BlockHeader* header = reinterpret_cast<BlockHeader*>(_buffer + _top);
+    header->size = size;
+    _last = _top;
+    _top += block;
+    _live++;
+    if (_top > _highWater) _highWater = _top;
+    return header + 1;
+}
+
+void JsonArena::deallocate(void* ptr) {
+    if (!ptr) return;
+    if (!owns(ptr)) {
+        free(ptr);
+        return;
+    }
+    // Só o bloco mais recente devolve espaço; os demais esperam a arena esvaziar
+    if (reinterpret_cast<uint8_t*>(headerOf(ptr)) == _buffer + _last) {
+        _top = _last;
+        _last = NO_BLOCK;
+    }
+    if (--_live == 0) {
+        _top = 0;
+        _last = NO_BLOCK;
+    }
+}
+
+void* JsonArena::reallocate(void* ptr, size_t newSize) {
+    if (!ptr) return allocate(newSize);
+    if (!owns(ptr)) return realloc(ptr, newSize);
+
+    BlockHeader* header = headerOf(ptr);
+    size_t offset = reinterpret_cast<uint8_t*>(header) - _buffer;
+
+    // Bloco do topo: cresce ou encolhe no lugar
+    if (offset == _last && blockSize(newSize) <= _capacity - offset) {
+        header->size = newSize;
+        _top = offset + blockSize(newSize);
+        if (_top > _highWater) _highWater = _top;
+        return ptr;
+    }
+    if (newSize <= header->size) {
+        header->size = newSize;
+        return ptr;
+    }
+
+    void* moved = allocate(newSize);
+    if (!moved) return nullptr;
+    memcpy(moved, ptr, header->size);
+    deallocate(ptr);
+    return moved;
+}
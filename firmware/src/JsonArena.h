@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// --- Arena de memória para os JsonDocument dos caminhos quentes ---
+// Por padrão cada JsonDocument faz malloc/free dos seus pools e strings. Com
+// uma arena, os blocos saem de um buffer estático por alocação sequencial
+// (bump); liberar o bloco mais recente devolve o espaço na hora e, quando o
+// último documento vivo é destruído, a arena volta ao início. Assim cada
+// mensagem reaproveita o mesmo buffer sem tocar no heap global.
+// Uma arena pertence a uma única tarefa (sem trava): uma para o loop() e outra
+// para a tarefa do AsyncTCP. Se o buffer acabar, o bloco vai para o heap e
+// conta em overflows().
+
+// Um pool de variantes do ArduinoJson: ARDUINOJSON_POOL_CAPACITY slots de dois
+// ponteiros (1 KB no ESP32). As arenas são dimensionadas em pools + strings.
+constexpr size_t JSON_POOL_BYTES = ARDUINOJSON_POOL_CAPACITY * 2 * sizeof(void*);
+
+class JsonArena : public ArduinoJson::Allocator {
+public:
+    JsonArena(uint8_t* buffer, size_t capacity) : _buffer(buffer), _capacity(capacity) {}
+
+    void* allocate(size_t size) override;
+    void deallocate(void* ptr) override;
+    void* reallocate(void* ptr, size_t newSize) override;
+
+    size_t capacity() const { return _capacity; }
+    size_t used() const { return _top; }
+    size_t highWater() const { return _highWater; }   // maior ocupação já vista
+    uint32_t overflows() const { return _overflows; } // blocos que foram para o heap
+
+private:
+    // Cabeçalho de cada bloco: tamanho pedido (para reallocate copiar o conteúdo)
+    struct alignas(8) BlockHeader {
+        size_t size;
+    };
+
+    static constexpr size_t NO_BLOCK = SIZE_MAX;
+
+    bool owns(const void* ptr) const {
+        const uint8_t* p = static_cast<const uint8_t*>(ptr);
+        return p >= _buffer && p < _buffer + _capacity;
+    }
+    static BlockHeader* headerOf(void* ptr) { return static_cast<BlockHeader*>(ptr) - 1; }
+    static size_t blockSize(size_t size) { return (sizeof(BlockHeader) + size + 7) & ~size_t(7); }
+
+    uint8_t* _buffer;
+    size_t _capacity;
+    size_t _top = 0;            // próximo byte livre
+    size_t _last = NO_BLOCK;    // início do bloco mais recente (liberação/crescimento no lugar)
+    uint32_t _live = 0;         // blocos ainda não liberados
+    size_t _highWater = 0;
+    uint32_t _overflows = 0;
+};
+
+template <size_t Capacity>
+class StaticJsonArena : public JsonArena {
+public:
+    StaticJsonArena() : JsonArena(_storage, Capacity) {}
+
+private:
+    alignas(8) uint8_t _storage[Capacity];
+};
@@ -0,0 +1,232 @@
+#include "Metrics.h"
+
+#ifndef NATIVE_SIM
+#include <AsyncTCP.h>
+#endif
+
+// Baldes 0..3 são exatos (0-3 µs); a partir daí cada oitava 2^o tem 4 baldes
+uint8_t LatencyHistogram::bucketFor(uint32_t micros) {
+    if (micros < SUB_BUCKETS) return micros;
+    uint8_t octave = 31 - __builtin_clz(micros);
+    if (octave > MAX_OCTAVE) return BUCKETS - 1;
+    uint8_t sub = (micros >> (octave - 2)) & (SUB_BUCKETS - 1);
+    return SUB_BUCKETS + (octave - 2) * SUB_BUCKETS + sub;
+}
+
+uint32_t LatencyHistogram::bucketUpperBound(uint8_t bucket) {
+    if (bucket < SUB_BUCKETS) return bucket;
+    uint8_t octave = (bucket - SUB_BUCKETS) / SUB_BUCKETS + 2;
+    uint8_t sub = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+    uint32_t width = 1UL << (octave - 2);
+    return ((SUB_BUCKETS + sub) << (octave - 2)) + width - 1;
+}
+
+void LatencyHistogram::record(uint32_t micros) {
+    // Escritor único: load+store em vez de read-modify-write atômico
+    std::atomic<uint32_t>& bucket = _buckets[bucketFor(micros)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    _count.store(_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    _sum.store(_sum.load(std::memory_order_relaxed) + micros, std::memory_order_relaxed);
+    if (micros > _max.load(std::memory_order_relaxed)) _max.store(micros, std::memory_order_relaxed);
+}
+
+uint32_t LatencyHistogram::quantileMicros(float q) const {
+    uint32_t total = count();
+    if (total == 0) return 0;
+    uint32_t rank = static_cast<uint32_t>(q * total + 0.5f);
+    if (rank == 0) rank = 1;
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < BUCKETS; i++) {
+        seen += _buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            uint32_t bound = bucketUpperBound(i);
+            uint32_t max = maxMicros();
+            return bound < max ? bound : max;
+        }
+    }
+    return maxMicros();
+}
+
+namespace metrics {
+
+static LatencyHistogram sections[static_cast<size_t>(MetricSection::Count)];
+static const char* SECTION_NAMES[] = {"loop", "update_sensors", "broadcast_delta", "send_full_state", "ws_event",
+                                      "async_tcp_event", "emergency_stop"};
+static_assert(sizeof(SECTION_NAMES) / sizeof(SECTION_NAMES[0]) == static_cast<size_t>(MetricSection::Count),
+              "Um nome por seção");
+
+struct TaskStats {
+    std::atomic<TaskHandle_t> handle{nullptr};
+    std::atomic<uint64_t> busyMicros{0};   // escritor único: a própria tarefa
+    uint64_t busyAtSample = 0;             // sampleTasks()
+    std::atomic<float> ratio{0};
+};
+
+static TaskStats tasks[static_cast<size_t>(TaskId::Count)];
+static uint32_t lastSampleMicros = 0;
+
+void begin() {
+#if QP_METRICS && !defined(NATIVE_SIM)
+    asyncTcpSetEventTimeHook([](uint32_t busyMicros) { recordMicros(MetricSection::AsyncTcpEvent, busyMicros); });
+#endif
+}
+
+void registerTask(TaskId task, TaskHandle_t handle) {
+    tasks[static_cast<size_t>(task)].handle.store(handle, std::memory_order_release);
+}
+
+void addTaskBusy(TaskId task, uint32_t micros) {
+    std::atomic<uint64_t>& busy = tasks[static_cast<size_t>(task)].busyMicros;
+    busy.store(busy.load(std::memory_order_relaxed) + micros, std::memory_order_relaxed);
+}
+
+void sampleTasks(uint32_t nowMicros) {
+    uint32_t elapsed = nowMicros - lastSampleMicros;
+    lastSampleMicros = nowMicros;
+    for (TaskStats& stats : tasks) {
+        uint64_t busy = stats.busyMicros.load(std::memory_order_relaxed);
+        float ratio = elapsed ? static_cast<float>(busy - stats.busyAtSample) / elapsed : 0;
+        stats.busyAtSample = busy;
+        stats.ratio.store(ratio > 1 ? 1 : ratio, std::memory_order_relaxed);
+    }
+}
+
+void recordCycles(MetricSection section, uint32_t cycles) {
+    recordMicros(section, cycles / ESP.getCpuFreqMHz());
+}
+
+void recordMicros(MetricSection section, uint32_t micros) {
+    sections[static_cast<size_t>(section)].record(micros);
+    if (section == MetricSection::Loop) {
+        addTaskBusy(TaskId::Loop, micros);
+    } else if (section == MetricSection::AsyncTcpEvent) {
+        addTaskBusy(TaskId::AsyncTcp, micros);
+    }
+}
+
+const LatencyHistogram& histogram(MetricSection section) {
+    return sections[static_cast<size_t>(section)];
+}
+
+const char* sectionName(MetricSection section) {
+    return SECTION_NAMES[static_cast<size_t>(section)];
+}
+
+// # HELP, # TYPE e a amostra de uma série sem rótulos
+static void writeSeries(String& out, const char* name, const char* help, const char* type, const char* number) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+    out += name;
+    out += number;
+}
+
+void writeGauge(String& out, const char* name, const char* help, double value) {
+    char number[24];
+    snprintf(number, sizeof(number), " %.10g\n", value);
+    writeSeries(out, name, help, "gauge", number);
+}
+
+void writeCounter(String& out, const char* name, const char* help, uint64_t value) {
+    char number[24];
+    snprintf(number, sizeof(number), " %llu\n", (unsigned long long)value);
+    writeSeries(out, name, help, "counter", number);
+}
+
+// Utilização e pilha por tarefa, com o núcleo da tabela como rótulo
+static void writeTasks(String& out) {
+#ifndef NATIVE_SIM
+    registerTask(TaskId::AsyncTcp, asyncTcpTaskHandle()); // criada pela biblioteca no server.begin()
+#endif
+    char line[128];
+    out += "# HELP qp_task_cpu_ratio Fração de um núcleo ocupada pela tarefa no último segundo\n"
+           "# TYPE qp_task_cpu_ratio gauge\n";
+    for (size_t i = 0; i < static_cast<size_t>(TaskId::Count); i++) {
+        snprintf(line, sizeof(line), "qp_task_cpu_ratio{task=\"%s\",core=\"%d\"} %.4f\n", TASKS[i].name,
+                 (int)TASKS[i].core, tasks[i].ratio.load(std::memory_order_relaxed));
+        out += line;
+    }
+    out += "# HELP qp_task_busy_seconds_total Tempo ocupado por tarefa desde o boot\n"
+           "# TYPE qp_task_busy_seconds_total counter\n";
+    for (size_t i = 0; i < static_cast<size_t>(TaskId::Count); i++) {
+        snprintf(line, sizeof(line), "qp_task_busy_seconds_total{task=\"%s\"} %.6f\n", TASKS[i].name,
+                 tasks[i].busyMicros.load(std::memory_order_relaxed) / 1e6);
+        out += line;
+    }
+    out += "# HELP qp_task_stack_bytes Pilha reservada por tarefa\n"
+           "# TYPE qp_task_stack_bytes gauge\n";
+    for (size_t i = 0; i < static_cast<size_t>(TaskId::Count); i++) {
+        snprintf(line, sizeof(line), "qp_task_stack_bytes{task=\"%s\"} %lu\n", TASKS[i].name,
+                 (unsigned long)TASKS[i].stackBytes);
+        out += line;
+    }
+    out += "# HELP qp_task_stack_free_min_bytes Menor sobra de pilha desde o boot\n"
+           "# TYPE qp_task_stack_free_min_bytes gauge\n";
+    for (size_t i = 0; i < static_cast<size_t>(TaskId::Count); i++) {
+        TaskHandle_t handle = tasks[i].handle.load(std::memory_order_acquire);
+        if (!handle) continue;
+        snprintf(line, sizeof(line), "qp_task_stack_free_min_bytes{task=\"%s\"} %lu\n", TASKS[i].name,
+                 (unsigned long)uxTaskGetStackHighWaterMark(handle));
+        out += line;
+    }
+}
+
+void writePrometheus(String& out) {
+    char line[128];
+    out += "# HELP qp_section_duration_seconds Duração das seções instrumentadas\n"
+           "# TYPE qp_section_duration_seconds summary\n";
+    for (size_t i = 0; i < static_cast<size_t>(MetricSection::Count); i++) {
+        const LatencyHistogram& h = sections[i];
+        if (h.count() == 0) continue;
+        const char* name = SECTION_NAMES[i];
+        snprintf(line, sizeof(line), "qp_section_duration_seconds{section=\"%s\",quantile=\"0.5\"} %.6f\n", name,
+                 h.quantileMicros(0.5f) / 1e6);
+        out += line;
+        snprintf(line, sizeof(line), "qp_section_duration_seconds{section=\"%s\",quantile=\"0.99\"} %.6f\n", name,
+                 h.quantileMicros(0.99f) / 1e6);
+        out += line;
+        snprintf(line, sizeof(line), "qp_section_duration_seconds_sum{section=\"%s\"} %.6f\n", name,
+                 h.sumMicros() / 1e6);
+        out += line;
+        snprintf(line, sizeof(line), "qp_section_duration_seconds_count{section=\"%s\"} %lu\n", name,
+                 (unsigned long)h.count());
+        out += line;
+    }
+    out += "# HELP qp_section_duration_max_seconds Maior duração observada por seção\n"
+           "# TYPE qp_section_duration_max_seconds gauge\n";
+    for (size_t i = 0; i < static_cast<size_t>(MetricSection::Count); i++) {
+        const LatencyHistogram& h = sections[i];
+        if (h.count() == 0) continue;
+        snprintf(line, sizeof(line), "qp_section_duration_max_seconds{section=\"%s\"} %.6f\n", SECTION_NAMES[i],
+                 h.maxMicros() / 1e6);
+        out += line;
+    }
+
+    writeTasks(out);
+
+    writeGauge(out, "qp_uptime_seconds", "Tempo desde o boot", millis() / 1000.0);
+    writeGauge(out, "qp_heap_free_bytes", "Heap livre", ESP.getFreeHeap());
+    writeGauge(out, "qp_heap_min_free_bytes", "Menor heap livre desde o boot", ESP.getMinFreeHeap());
+    writeGauge(out, "qp_heap_largest_free_block_bytes", "Maior bloco alocável", ESP.getMaxAllocHeap());
+
+#ifndef NATIVE_SIM
+    AsyncTCPQueueStats queue = asyncTcpQueueStats();
+    writeGauge(out, "qp_async_tcp_queue_depth", "Eventos na fila do AsyncTCP", queue.queued);
+    writeGauge(out, "qp_async_tcp_queue_high_watermark", "Maior profundidade da fila do AsyncTCP",
+               queue.high_watermark);
+    writeCounter(out, "qp_async_tcp_hog_throttles_total", "Conexões adiadas por monopolizar a tarefa",
+                 queue.hog_throttles);
+    AsyncTCPEventPoolStats pool = asyncTcpEventPoolStats();
+    writeGauge(out, "qp_async_tcp_event_pool_in_use", "Pacotes de evento em uso", pool.in_use);
+    writeCounter(out, "qp_async_tcp_event_pool_heap_fallbacks_total", "Pacotes alocados no heap (pool cheio)",
+                 pool.heap_fallbacks);
+#endif
+}
+
+} // namespace metrics
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "TaskTable.h"
+
+// --- Instrumentação: tempos por seção, heap e fila do AsyncTCP ---
+// METRICS_SCOPE(seção) mede o bloco com o contador de ciclos da CPU e soma a
+// duração num histograma de baldes fixos (4 por oitava, de 1 µs a ~16 s):
+// nada é alocado e o registro custa alguns ciclos. GET /api/metrics exporta
+// p50/p99/máximo de cada seção e os medidores no formato texto do Prometheus.
+// Por tarefa da TaskTable: tempo ocupado (a fração de núcleo do último segundo
+// sai de sampleTasks()) e a menor sobra de pilha desde o boot.
+// Com -DQP_METRICS=0 as macros somem e a rota não é registrada.
+
+#ifndef QP_METRICS
+#define QP_METRICS 1
+#endif
+
+enum class MetricSection : uint8_t {
+    Loop,             // uma iteração do loop()
+    UpdateSensors,
+    BroadcastDelta,
+    SendFullState,
+    WsEvent,          // onWebSocketEvent (tarefa do AsyncTCP)
+    AsyncTcpEvent,    // um evento despachado pela tarefa do AsyncTCP (só no ESP32)
+    EmergencyStop,    // do pedido de parada ao último relé desligado
+    Count
+};
+
+// Cada seção tem um único escritor (a tarefa que a executa); a API só lê
+class LatencyHistogram {
+public:
+    static constexpr uint8_t SUB_BUCKETS = 4;     // por oitava: erro de até 25%
+    static constexpr uint8_t MAX_OCTAVE = 23;     // 2^24 µs ~ 16,7 s
+    static constexpr uint8_t BUCKETS = SUB_BUCKETS + (MAX_OCTAVE - 1) * SUB_BUCKETS;
+
+    void record(uint32_t micros);
+
+    uint32_t count() const { return _count.load(std::memory_order_relaxed); }
+    uint32_t maxMicros() const { return _max.load(std::memory_order_relaxed); }
+    uint64_t sumMicros() const { return _sum.load(std::memory_order_relaxed); }
+    // Limite superior do balde que contém o quantil `q` (0..1), limitado ao máximo
+    uint32_t quantileMicros(float q) const;
+
+    static uint8_t bucketFor(uint32_t micros);
+    static uint32_t bucketUpperBound(uint8_t bucket);
+
+private:
+    std::atomic<uint32_t> _buckets[BUCKETS] = {};
+    std::atomic<uint32_t> _count{0};
+    std::atomic<uint32_t> _max{0};
+    std::atomic<uint64_t> _sum{0};
+};
+
+namespace metrics {
+
+// Liga as fontes externas (tempo de cada evento do AsyncTCP, no ESP32)
+void begin();
+
+// Tarefas com handle registrado também exportam a sobra de pilha
+void registerTask(TaskId task, TaskHandle_t handle);
+// Tempo de trabalho da tarefa (cada tarefa soma só o seu). Loop e AsyncTcpEvent
+// já contam para as tarefas "loop" e "async_tcp"
+void addTaskBusy(TaskId task, uint32_t micros);
+// Fecha a janela de utilização; chamado uma vez por segundo pela tarefa de rede
+void sampleTasks(uint32_t nowMicros);
+
+void recordCycles(MetricSection section, uint32_t cycles);
+void recordMicros(MetricSection section, uint32_t micros);
+const LatencyHistogram& histogram(MetricSection section);
+const char* sectionName(MetricSection section);
+
+// Seções e medidores do sistema (heap, AsyncTCP) em texto do Prometheus
+void writePrometheus(String& out);
+// Uma linha de medidor avulso (# HELP/# TYPE incluídos)
+void writeGauge(String& out, const char* name, const char* help, double value);
+// Contador avulso, só cresce desde o boot: o nome termina em _total
+void writeCounter(String& out, const char* name, const char* help, uint64_t value);
+
+} // namespace metrics
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(MetricSection section) : _section(section), _start(ESP.getCycleCount()) {}
+    ~ScopedTimer() { metrics::recordCycles(_section, ESP.getCycleCount() - _start); }
+
+private:
+    MetricSection _section;
+    uint32_t _start;
+};
+
+#if QP_METRICS
+#define METRICS_CONCAT_(a, b) a##b
+#define METRICS_CONCAT(a, b) METRICS_CONCAT_(a, b)
+#define METRICS_SCOPE(section) ScopedTimer METRICS_CONCAT(metricsScope_, __LINE__)(section)
+#else
+#define METRICS_SCOPE(section) \
+    do {                       \
+    } while (0)
+#endif
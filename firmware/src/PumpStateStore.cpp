@@ -0,0 +1,59 @@
+#include "PumpStateStore.h"
+
+static const char* NVS_NAMESPACE = "pump-states";
+static const char* NVS_STATES_KEY = "states";
+
+bool PumpStateStore::begin(bool* states) {
+    std::lock_guard<std::mutex> guard(_lock);
+    _states = states;
+    _prefs.begin(NVS_NAMESPACE, true);
+    bool found = _prefs.isKey(NVS_STATES_KEY) &&
+                 _prefs.getBytes(NVS_STATES_KEY, _stored, sizeof(_stored)) == sizeof(_stored);
+    _prefs.end();
+    if (!found) memset(_stored, 0, sizeof(_stored));
+    for (uint8_t i = 0; i < PUMP_COUNT; i++) {
+        _states[i] = _stored[i] != 0;
+    }
+    return found;
+}
+
+void PumpStateStore::markDirty(unsigned long now) {
+    _changes++;
+    if (!_dirty) {
+        _firstDirty = now;
+        _dirty = true;
+    }
+}
+
+void PumpStateStore::poll(unsigned long now) {
+    if (!_dirty || now - _firstDirty < _windowMs) return;
+    flush();
+}
+
+void PumpStateStore::flush() {
+    std::lock_guard<std::mutex> guard(_lock);
+    if (!_states || !_dirty) return;
+    _dirty = false;
+
+    uint8_t current[PUMP_COUNT];
+    for (uint8_t i = 0; i < PUMP_COUNT; i++) {
+        current[i] = _states[i] ? 1 : 0;
+    }
+    if (memcmp(current, _stored, sizeof(current)) == 0) {
+        _skipped++;
+        return;
+    }
+
+    _prefs.begin(NVS_NAMESPACE, false);
+    bool ok = _prefs.putBytes(NVS_STATES_KEY, current, sizeof(current)) == sizeof(current);
+    _prefs.end();
+    if (!ok) {
+        _firstDirty = millis(); // tenta de novo na próxima janela
+        _dirty = true;
+        Serial.println("❌ Falha ao salvar estados das bombas na NVS");
+        return;
+    }
+    memcpy(_stored, current, sizeof(current));
+    _commits++;
+    Serial.println("💾 Estados das bombas salvos na NVS");
+}
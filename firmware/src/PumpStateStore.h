@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <atomic>
+#include <mutex>
+
+// --- Persistência write-behind dos estados das bombas ---
+// setPumpState() só marca o estado como sujo; o loop() chama poll() e a NVS
+// recebe no máximo um commit por janela, contada a partir da primeira mudança
+// pendente. Antes de gravar, o blob é comparado com o último valor salvo:
+// ligar e desligar dentro da mesma janela não gasta ciclo de apagamento.
+// flush() força a gravação (reinício via esp_register_shutdown_handler).
+
+class PumpStateStore {
+public:
+    static constexpr uint8_t PUMP_COUNT = 4;
+    static constexpr unsigned long DEFAULT_WINDOW_MS = 5000;
+
+    explicit PumpStateStore(unsigned long windowMs = DEFAULT_WINDOW_MS) : _windowMs(windowMs) {}
+
+    // Lê os estados salvos para `states`, que passa a ser o estado vivo observado
+    // (false se não havia nada na NVS)
+    bool begin(bool* states);
+
+    void markDirty(unsigned long now);
+    void poll(unsigned long now);
+    void flush();
+
+    bool pending() const { return _dirty; }
+    uint32_t changes() const { return _changes; }
+    uint32_t commits() const { return _commits; }
+    uint32_t skipped() const { return _skipped; }
+
+private:
+    Preferences _prefs;   // instância própria: flush() pode rodar fora do loop()
+    std::mutex _lock;
+    bool* _states = nullptr;
+    uint8_t _stored[PUMP_COUNT] = {0};
+    unsigned long _windowMs;
+    std::atomic<bool> _dirty{false};
+    std::atomic<unsigned long> _firstDirty{0};
+
+    std::atomic<uint32_t> _changes{0};   // markDirty()
+    std::atomic<uint32_t> _commits{0};   // gravações efetivas na NVS
+    std::atomic<uint32_t> _skipped{0};   // janelas que terminaram com o valor já salvo
+};
@@ -0,0 +1,154 @@
+#include "RgbEffects.h"
+
+using namespace rgbfx;
+
+static const char* EFFECT_NAMES[] = {"static", "fade", "cycle", "pulse"};
+
+const char* rgbEffectName(RgbEffectType type) {
+    return EFFECT_NAMES[static_cast<uint8_t>(type)];
+}
+
+bool parseRgbEffectName(const char* name, RgbEffectType& type) {
+    if (!name) return false;
+    for (uint8_t i = 0; i < sizeof(EFFECT_NAMES) / sizeof(EFFECT_NAMES[0]); i++) {
+        if (strcmp(name, EFFECT_NAMES[i]) == 0) {
+            type = static_cast<RgbEffectType>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void RgbEffectEngine::begin(const int pins[3], const int channels[3]) {
+    for (int i = 0; i < 3; i++) {
+        _channels[i] = channels[i];
+        ledcSetup(channels[i], LEDC_FREQUENCY, DUTY_BITS);
+        ledcAttachPin(pins[i], channels[i]);
+        ledcWrite(channels[i], _duty[i]);
+    }
+
+    esp_timer_create_args_t args = {};
+    args.callback = &RgbEffectEngine::onTimer;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "rgbfx";
+    args.skip_unhandled_events = true;
+    if (esp_timer_create(&args, &_timer) != ESP_OK || esp_timer_start_periodic(_timer, FRAME_PERIOD_US) != ESP_OK) {
+        Serial.println("❌ Erro ao iniciar timer dos efeitos RGB");
+    }
+}
+
+void RgbEffectEngine::showColor(uint8_t r, uint8_t g, uint8_t b, uint32_t transitionMs) {
+    RgbEffect effect;
+    effect.type = transitionMs ? RgbEffectType::Fade : RgbEffectType::Static;
+    effect.color[0] = r;
+    effect.color[1] = g;
+    effect.color[2] = b;
+    effect.durationMs = transitionMs;
+    setEffect(effect, transitionMs != 0);
+}
+
+void RgbEffectEngine::startCycle(uint8_t brightness, uint32_t periodMs) {
+    RgbEffect effect;
+    effect.type = RgbEffectType::Cycle;
+    effect.color[0] = effect.color[1] = effect.color[2] = brightness;
+    effect.durationMs = periodMs ? periodMs : 1;
+    setEffect(effect, false);
+}
+
+void RgbEffectEngine::startPulse(uint8_t r, uint8_t g, uint8_t b, uint32_t periodMs) {
+    RgbEffect effect;
+    effect.type = RgbEffectType::Pulse;
+    effect.color[0] = r;
+    effect.color[1] = g;
+    effect.color[2] = b;
+    effect.durationMs = periodMs ? periodMs : 1;
+    setEffect(effect, false);
+}
+
+RgbEffectType RgbEffectEngine::effect() {
+    portENTER_CRITICAL(&_lock);
+    RgbEffectType type = _effect.type;
+    portEXIT_CRITICAL(&_lock);
+    return type;
+}
+
+void RgbEffectEngine::setEffect(RgbEffect& effect, bool fadeFromOutput) {
+    effect.startMs = millis();
+    portENTER_CRITICAL(&_lock);
+    if (fadeFromOutput) memcpy(effect.from, _duty, sizeof(effect.from));
+    _effect = effect;
+    portEXIT_CRITICAL(&_lock);
+}
+
+void RgbEffectEngine::render(const RgbEffect& effect, uint32_t nowMs, uint16_t duty[3]) {
+    uint32_t elapsed = nowMs - effect.startMs;
+
+    switch (effect.type) {
+    case RgbEffectType::Static:
+        for (int i = 0; i < 3; i++) duty[i] = GAMMA_TABLE.duty[effect.color[i]];
+        return;
+
+    case RgbEffectType::Fade: {
+        if (elapsed >= effect.durationMs) {
+            for (int i = 0; i < 3; i++) duty[i] = GAMMA_TABLE.duty[effect.color[i]];
+            return;
+        }
+        // Interpola no espaço do duty (luz linear): degraus finos mesmo no brilho baixo
+        uint32_t progress = (uint32_t)(((uint64_t)elapsed << 16) / effect.durationMs);
+        for (int i = 0; i < 3; i++) {
+            int32_t from = effect.from[i];
+            int32_t to = GAMMA_TABLE.duty[effect.color[i]];
+            duty[i] = (uint16_t)(from + (((to - from) * (int32_t)progress) >> 16));
+        }
+        return;
+    }
+
+    case RgbEffectType::Cycle: {
+        uint32_t phase = (uint32_t)(((uint64_t)(elapsed % effect.durationMs) << 16) / effect.durationMs);
+        uint8_t index = phase >> 8;
+        uint8_t frac = phase & 0xFF;
+        uint8_t next = index + 1;
+        uint32_t brightness = effect.color[0] + 1;
+        for (int i = 0; i < 3; i++) {
+            uint32_t value88 = HUE_WHEEL.rgb[index][i] * (256 - frac) + HUE_WHEEL.rgb[next][i] * frac;
+            duty[i] = gammaDuty((uint16_t)((value88 * brightness) >> 8));
+        }
+        return;
+    }
+
+    case RgbEffectType::Pulse: {
+        uint32_t phase = (uint32_t)(((uint64_t)(elapsed % effect.durationMs) << 16) / effect.durationMs);
+        uint8_t index = phase >> 8;
+        uint8_t frac = phase & 0xFF;
+        uint8_t next = index + 1;
+        uint32_t level = WAVE_TABLE.level[index] * (256 - frac) + WAVE_TABLE.level[next] * frac; // 8.8
+        for (int i = 0; i < 3; i++) {
+            duty[i] = gammaDuty((uint16_t)((effect.color[i] * level) >> 8));
+        }
+        return;
+    }
+    }
+}
+
+void RgbEffectEngine::onTimer(void* arg) {
+    static_cast<RgbEffectEngine*>(arg)->tick();
+}
+
+void RgbEffectEngine::tick() {
+    uint32_t now = millis();
+    portENTER_CRITICAL(&_lock);
+    RgbEffect effect = _effect;
+    portEXIT_CRITICAL(&_lock);
+
+    uint16_t duty[3];
+    render(effect, now, duty);
+
+    for (int i = 0; i < 3; i++) {
+        if (duty[i] != _duty[i]) ledcWrite(_channels[i], duty[i]);
+    }
+    portENTER_CRITICAL(&_lock);
+    memcpy(_duty, duty, sizeof(_duty));
+    portEXIT_CRITICAL(&_lock);
+    _frames = _frames + 1;
+}
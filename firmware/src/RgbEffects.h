@@ -0,0 +1,184 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+// --- Motor de efeitos RGB ---
+// Um esp_timer periódico (100 Hz) calcula o quadro e escreve o LEDC em 12 bits;
+// o loop() só troca o efeito ativo. Todas as contas são em ponto fixo sobre
+// tabelas geradas em tempo de compilação (gama e roda de matiz), então o
+// resultado é o mesmo, bit a bit, no ESP32 e no ambiente nativo.
+
+namespace rgbfx {
+
+constexpr uint8_t DUTY_BITS = 12;
+constexpr uint16_t DUTY_MAX = (1 << DUTY_BITS) - 1;
+constexpr double GAMMA = 2.2;
+
+// --- Matemática constexpr (std::pow/std::cos não são constexpr) ---
+constexpr double cexp(double x) {
+    int halvings = 0;
+    while (x > 0.5 || x < -0.5) {
+        x /= 2;
+        halvings++;
+    }
+    double term = 1, sum = 1;
+    for (int n = 1; n < 20; n++) {
+        term *= x / n;
+        sum += term;
+    }
+    while (halvings-- > 0) sum *= sum;
+    return sum;
+}
+
+constexpr double clog(double x) {
+    int exponent = 0;
+    while (x > 2) {
+        x /= 2;
+        exponent++;
+    }
+    while (x < 0.5) {
+        x *= 2;
+        exponent--;
+    }
+    // ln(x) = 2 atanh((x - 1) / (x + 1))
+    double y = (x - 1) / (x + 1), y2 = y * y, term = y, sum = 0;
+    for (int n = 1; n < 60; n += 2) {
+        sum += term / n;
+        term *= y2;
+    }
+    return 2 * sum + exponent * 0.6931471805599453;
+}
+
+constexpr double cpow(double base, double exponent) {
+    return base <= 0 ? 0 : cexp(exponent * clog(base));
+}
+
+constexpr double ccos(double x) {
+    const double pi = 3.14159265358979323846;
+    while (x > pi) x -= 2 * pi;
+    while (x < -pi) x += 2 * pi;
+    double term = 1, sum = 1;
+    for (int n = 2; n < 30; n += 2) {
+        term *= -x * x / ((n - 1) * n);
+        sum += term;
+    }
+    return sum;
+}
+
+// --- Tabelas ---
+struct GammaTable {
+    uint16_t duty[256];   // valor 8 bits -> duty de 12 bits, gama 2.2
+};
+
+struct HueWheel {
+    uint8_t rgb[256][3];  // matiz 0..255 (volta completa) com S = V = 1
+};
+
+struct WaveTable {
+    uint8_t level[256];   // cosseno elevado 0..255..0, uma volta
+};
+
+constexpr GammaTable makeGammaTable() {
+    GammaTable table = {};
+    for (int i = 0; i < 256; i++) {
+        table.duty[i] = static_cast<uint16_t>(cpow(i / 255.0, GAMMA) * DUTY_MAX + 0.5);
+    }
+    return table;
+}
+
+constexpr HueWheel makeHueWheel() {
+    HueWheel wheel = {};
+    for (int h = 0; h < 256; h++) {
+        int scaled = h * 6;            // 6 setores de 256 passos
+        int sector = scaled / 256;
+        uint8_t rising = static_cast<uint8_t>(scaled % 256);
+        uint8_t falling = static_cast<uint8_t>(255 - rising);
+        uint8_t* c = wheel.rgb[h];
+        switch (sector) {
+        case 0: c[0] = 255; c[1] = rising; c[2] = 0; break;
+        case 1: c[0] = falling; c[1] = 255; c[2] = 0; break;
+        case 2: c[0] = 0; c[1] = 255; c[2] = rising; break;
+        case 3: c[0] = 0; c[1] = falling; c[2] = 255; break;
+        case 4: c[0] = rising; c[1] = 0; c[2] = 255; break;
+        default: c[0] = 255; c[1] = 0; c[2] = falling; break;
+        }
+    }
+    return wheel;
+}
+
+constexpr WaveTable makeWaveTable() {
+    WaveTable table = {};
+    for (int i = 0; i < 256; i++) {
+        table.level[i] = static_cast<uint8_t>((1 - ccos(i * 2 * 3.14159265358979323846 / 256)) / 2 * 255 + 0.5);
+    }
+    return table;
+}
+
+constexpr GammaTable GAMMA_TABLE = makeGammaTable();
+constexpr HueWheel HUE_WHEEL = makeHueWheel();
+constexpr WaveTable WAVE_TABLE = makeWaveTable();
+
+static_assert(GAMMA_TABLE.duty[0] == 0 && GAMMA_TABLE.duty[255] == DUTY_MAX, "gama deve cobrir 0..DUTY_MAX");
+static_assert(WAVE_TABLE.level[0] == 0 && WAVE_TABLE.level[128] == 255, "onda deve ir de 0 a 255");
+
+// Cor em 8.8 (0..65280) -> duty de 12 bits, interpolando entre entradas da tabela de gama
+inline uint16_t gammaDuty(uint16_t value88) {
+    uint8_t index = value88 >> 8;
+    uint8_t frac = value88 & 0xFF;
+    uint16_t low = GAMMA_TABLE.duty[index];
+    if (index == 255 || frac == 0) return low;
+    uint16_t high = GAMMA_TABLE.duty[index + 1];
+    return low + (((uint32_t)(high - low) * frac) >> 8);
+}
+
+} // namespace rgbfx
+
+enum class RgbEffectType : uint8_t {
+    Static,  // cor fixa
+    Fade,    // transição da saída atual até `color` em `durationMs`
+    Cycle,   // volta completa na roda de matiz a cada `durationMs`, brilho = max(color)
+    Pulse,   // `color` respirando de 0 ao máximo a cada `durationMs`
+};
+
+struct RgbEffect {
+    RgbEffectType type = RgbEffectType::Static;
+    uint8_t color[3] = {0, 0, 0};
+    uint16_t from[3] = {0, 0, 0};   // duty inicial do Fade
+    uint32_t startMs = 0;
+    uint32_t durationMs = 0;
+};
+
+const char* rgbEffectName(RgbEffectType type);
+bool parseRgbEffectName(const char* name, RgbEffectType& type);
+
+class RgbEffectEngine {
+public:
+    static constexpr uint32_t LEDC_FREQUENCY = 5000;
+    static constexpr uint32_t FRAME_PERIOD_US = 10000; // 100 Hz
+
+    // Configura os canais LEDC em 12 bits e inicia o timer de quadros
+    void begin(const int pins[3], const int channels[3]);
+
+    void showColor(uint8_t r, uint8_t g, uint8_t b, uint32_t transitionMs = 0);
+    void startCycle(uint8_t brightness, uint32_t periodMs);
+    void startPulse(uint8_t r, uint8_t g, uint8_t b, uint32_t periodMs);
+
+    RgbEffectType effect();
+    uint32_t frames() const { return _frames; }
+
+    // Núcleo de interpolação: função pura do efeito e do instante, sem alocação
+    static void render(const RgbEffect& effect, uint32_t nowMs, uint16_t duty[3]);
+
+private:
+    static void onTimer(void* arg);
+    void tick();
+    void setEffect(RgbEffect& effect, bool fadeFromOutput);
+
+    portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED;
+    RgbEffect _effect;
+    uint16_t _duty[3] = {0, 0, 0};  // última saída escrita no LEDC
+    int _channels[3] = {0, 1, 2};
+    esp_timer_handle_t _timer = nullptr;
+    volatile uint32_t _frames = 0;
+};
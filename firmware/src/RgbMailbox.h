@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// --- Caixa de correio de cor RGB ---
+// O handler do WebSocket (task do AsyncTCP) só deposita a cor mais recente;
+// o loop() retira no máximo uma por quadro. Cores intermediárias de um arraste
+// no seletor são sobrescritas em vez de enfileiradas.
+class RgbMailbox {
+public:
+    void post(uint8_t r, uint8_t g, uint8_t b) {
+        uint32_t packed = PENDING | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+        if (_slot.exchange(packed, std::memory_order_acq_rel) & PENDING) _overwritten++;
+        _posted++;
+    }
+
+    // Retira a cor pendente, se houver
+    bool take(uint8_t& r, uint8_t& g, uint8_t& b) {
+        uint32_t packed = _slot.exchange(0, std::memory_order_acq_rel);
+        if (!(packed & PENDING)) return false;
+        r = (packed >> 16) & 0xFF;
+        g = (packed >> 8) & 0xFF;
+        b = packed & 0xFF;
+        return true;
+    }
+
+    // Há cor esperando o loop(): a caixa nunca guarda mais de uma
+    bool pending() const { return _slot.load(std::memory_order_acquire) & PENDING; }
+
+    uint32_t posted() const { return _posted; }
+    uint32_t overwritten() const { return _overwritten; }
+
+private:
+    static const uint32_t PENDING = 1UL << 24;
+
+    std::atomic<uint32_t> _slot{0};
+    std::atomic<uint32_t> _posted{0};
+    std::atomic<uint32_t> _overwritten{0};
+};
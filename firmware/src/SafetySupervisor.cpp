@@ -0,0 +1,153 @@
+#include "SafetySupervisor.h"
+#include "Metrics.h"
+
+static const char* SOURCE_NAMES[] = {"none", "button", "command", "api"};
+
+void SafetySupervisor::begin(const int (&relayPins)[PUMP_COUNT], uint8_t stopPin, uint8_t initialMask) {
+    uint32_t now = nowMillis();
+    for (uint8_t i = 0; i < PUMP_COUNT; i++) {
+        _relayPins[i] = relayPins[i];
+        pinMode(_relayPins[i], OUTPUT);
+        digitalWrite(_relayPins[i], (initialMask >> i) & 1 ? HIGH : LOW);
+        _onSince[i].store(now, std::memory_order_relaxed);
+    }
+    _requested.store(initialMask, std::memory_order_release);
+    _applied.store(initialMask, std::memory_order_release);
+
+    _stopPin = stopPin;
+    pinMode(_stopPin, INPUT_PULLUP);
+    const TaskConfig& task = taskConfig(TaskId::Safety);
+    xTaskCreatePinnedToCore(taskEntry, task.name, task.stackBytes, this, task.priority, &_task, task.core);
+    metrics::registerTask(TaskId::Safety, _task);
+    attachInterruptArg(digitalPinToInterrupt(_stopPin), onStopButton, this, FALLING);
+}
+
+bool SafetySupervisor::requestPump(uint8_t pump, bool on) {
+    if (pump >= PUMP_COUNT) return false;
+    uint8_t bit = 1 << pump;
+    if (on) {
+        if (emergencyActive()) return false;
+        _requested.fetch_or(bit, std::memory_order_acq_rel);
+    } else {
+        _requested.fetch_and(~bit, std::memory_order_acq_rel);
+    }
+    xTaskNotifyGive(_task);
+    return true;
+}
+
+void SafetySupervisor::emergencyStop(EmergencySource source) {
+    uint32_t now = micros() | 1;   // 0 marca "nenhum pedido"
+    uint32_t none = 0;
+    // Com um pedido já pendente vale o mais antigo: a latência conta dele
+    if (_stopRequestedAt.compare_exchange_strong(none, now, std::memory_order_acq_rel)) {
+        _stopSource.store(static_cast<uint8_t>(source), std::memory_order_release);
+    }
+    xTaskNotifyGive(_task);
+}
+
+void IRAM_ATTR SafetySupervisor::onStopButton(void* self) {
+    SafetySupervisor* supervisor = static_cast<SafetySupervisor*>(self);
+    uint32_t now = micros() | 1;
+    uint32_t none = 0;
+    if (supervisor->_stopRequestedAt.compare_exchange_strong(none, now, std::memory_order_acq_rel)) {
+        supervisor->_stopSource.store(static_cast<uint8_t>(EmergencySource::Button), std::memory_order_release);
+    }
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(supervisor->_task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+void SafetySupervisor::clearEmergency() {
+    _clearRequested.store(true, std::memory_order_release);
+    xTaskNotifyGive(_task);
+}
+
+void SafetySupervisor::taskEntry(void* self) {
+    static_cast<SafetySupervisor*>(self)->run();
+}
+
+void SafetySupervisor::stopAll(uint32_t requestedAt, EmergencySource source) {
+    // Relés primeiro; contabilidade e log depois
+    for (uint8_t i = 0; i < PUMP_COUNT; i++) digitalWrite(_relayPins[i], LOW);
+    uint32_t latency = micros() - requestedAt;
+
+    _applied.store(0, std::memory_order_release);
+    _requested.store(0, std::memory_order_release);
+    _latched.store(true, std::memory_order_release);
+    _latchedSource.store(static_cast<uint8_t>(source), std::memory_order_relaxed);
+    _stops.fetch_add(1, std::memory_order_relaxed);
+    _lastLatency.store(latency, std::memory_order_relaxed);
+    if (latency > _maxLatency.load(std::memory_order_relaxed)) _maxLatency.store(latency, std::memory_order_relaxed);
+    metrics::recordMicros(MetricSection::EmergencyStop, latency);
+    Serial.printf("🛑 Parada de emergência (%s): bombas desligadas em %lu µs\n",
+                  SOURCE_NAMES[static_cast<uint8_t>(source)], (unsigned long)latency);
+}
+
+void SafetySupervisor::run() {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TICK_MS));
+        uint32_t started = micros();
+
+        uint32_t stopAt = _stopRequestedAt.exchange(0, std::memory_order_acq_rel);
+        if (stopAt != 0) {
+            stopAll(stopAt, static_cast<EmergencySource>(_stopSource.load(std::memory_order_acquire)));
+        } else if (!_latched.load(std::memory_order_relaxed) && digitalRead(_stopPin) == LOW) {
+            // Botão pressionado sem a interrupção ter chegado
+            stopAll(micros(), EmergencySource::Button);
+        }
+
+        if (_clearRequested.exchange(false, std::memory_order_acq_rel) && _latched.load(std::memory_order_relaxed)) {
+            if (digitalRead(_stopPin) == LOW) {
+                Serial.println("🛑 Botão de emergência ainda pressionado: parada mantida");
+            } else {
+                _requested.store(0, std::memory_order_release);   // nada religa sozinho
+                _latched.store(false, std::memory_order_release);
+                _latchedSource.store(0, std::memory_order_relaxed);
+                Serial.println("✅ Parada de emergência liberada");
+            }
+        }
+
+        uint8_t desired = _latched.load(std::memory_order_relaxed) ? 0 : _requested.load(std::memory_order_acquire);
+        uint8_t applied = _applied.load(std::memory_order_relaxed);
+        uint32_t now = nowMillis();
+        for (uint8_t i = 0; i < PUMP_COUNT; i++) {
+            uint8_t bit = 1 << i;
+            if ((desired & bit) && !(applied & bit)) {
+                digitalWrite(_relayPins[i], HIGH);
+                _onSince[i].store(now, std::memory_order_relaxed);
+                applied |= bit;
+            } else if (!(desired & bit) && (applied & bit)) {
+                digitalWrite(_relayPins[i], LOW);
+                applied &= ~bit;
+            } else if ((applied & bit) && now - _onSince[i].load(std::memory_order_relaxed) >= MAX_RUNTIME_MS) {
+                digitalWrite(_relayPins[i], LOW);
+                applied &= ~bit;
+                _requested.fetch_and(~bit, std::memory_order_acq_rel);
+                _runtimeTrips.fetch_add(1, std::memory_order_relaxed);
+                Serial.printf("⏱️ Bomba %u desligada: tempo máximo de %lu min atingido\n", i,
+                              (unsigned long)(MAX_RUNTIME_MS / 60000));
+            }
+        }
+        _applied.store(applied, std::memory_order_release);
+        metrics::addTaskBusy(TaskId::Safety, micros() - started);
+    }
+}
+
+void SafetySupervisor::toJson(JsonObject json) const {
+    json["emergency"] = emergencyActive();
+    json["source"] = SOURCE_NAMES[_latchedSource.load(std::memory_order_relaxed)];
+    json["stops"] = stops();
+    json["last_stop_latency_us"] = lastStopLatencyMicros();
+    json["max_stop_latency_us"] = maxStopLatencyMicros();
+    json["runtime_trips"] = runtimeTrips();
+    json["max_runtime_s"] = MAX_RUNTIME_MS / 1000;
+    JsonArray pumps = json["pumps"].to<JsonArray>();
+    uint8_t applied = appliedMask();
+    uint32_t now = nowMillis();
+    for (uint8_t i = 0; i < PUMP_COUNT; i++) {
+        JsonObject pump = pumps.add<JsonObject>();
+        bool on = (applied >> i) & 1;
+        pump["on"] = on;
+        pump["runtime_s"] = on ? (now - _onSince[i].load(std::memory_order_relaxed)) / 1000 : 0;
+    }
+}
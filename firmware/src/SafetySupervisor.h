@@ -0,0 +1,85 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <atomic>
+#include <esp_timer.h>
+#include "TaskTable.h"
+
+// --- Supervisor de segurança das bombas ---
+// Uma tarefa própria (linha "safety" da TaskTable), no núcleo do loop() e
+// acima da prioridade dele, é a única que escreve nos relés. Os pedidos chegam por caixas
+// de correio atômicas (sem trava, seguras em ISR) e acordam a tarefa por
+// notificação, então um loop() preso em sensores ou rede não atrasa nada:
+//   - requestPump(): estado desejado de uma bomba (loop, AsyncTCP, agendador)
+//   - emergencyStop(): desliga todas as bombas e trava até clearEmergency()
+//     (também pela interrupção do botão de emergência)
+// A tarefa acorda ainda a cada TICK_MS para impor MAX_RUNTIME_MS por bomba,
+// pelo relógio monotônico do esp_timer, e conferir o nível do botão caso a
+// interrupção se perca. Cada parada mede a latência do pedido até o último
+// relé desligado.
+
+// Tempo máximo ligado por bomba, em minutos (-DQP_PUMP_MAX_RUNTIME_MIN=...)
+#ifndef QP_PUMP_MAX_RUNTIME_MIN
+#define QP_PUMP_MAX_RUNTIME_MIN 240
+#endif
+
+enum class EmergencySource : uint8_t { None, Button, Command, Api };
+
+class SafetySupervisor {
+public:
+    static constexpr uint8_t PUMP_COUNT = 4;
+    static constexpr uint32_t MAX_RUNTIME_MS = QP_PUMP_MAX_RUNTIME_MIN * 60UL * 1000;
+    static constexpr uint32_t TICK_MS = 20;
+
+    // Relés começam em `initialMask` (estados restaurados da NVS); o botão é
+    // ativo em LOW, com pull-up interno
+    void begin(const int (&relayPins)[PUMP_COUNT], uint8_t stopPin, uint8_t initialMask);
+
+    // Qualquer tarefa; false (e nada muda) se for para ligar com a parada ativa
+    bool requestPump(uint8_t pump, bool on);
+    void emergencyStop(EmergencySource source);
+    // Libera a trava se o botão não estiver pressionado; as bombas continuam
+    // desligadas até um novo pedido
+    void clearEmergency();
+
+    // Bombas pedidas: o supervisor apaga o bit ao desligar por tempo ou emergência
+    uint8_t requestedMask() const { return _requested.load(std::memory_order_acquire); }
+    // Relés realmente ligados
+    uint8_t appliedMask() const { return _applied.load(std::memory_order_acquire); }
+    bool emergencyActive() const { return _latched.load(std::memory_order_acquire); }
+
+    uint32_t stops() const { return _stops.load(std::memory_order_relaxed); }
+    uint32_t lastStopLatencyMicros() const { return _lastLatency.load(std::memory_order_relaxed); }
+    uint32_t maxStopLatencyMicros() const { return _maxLatency.load(std::memory_order_relaxed); }
+    uint32_t runtimeTrips() const { return _runtimeTrips.load(std::memory_order_relaxed); }
+
+    void toJson(JsonObject json) const;
+
+private:
+    static void taskEntry(void* self);
+    static void onStopButton(void* self);
+    void run();
+    void stopAll(uint32_t requestedAt, EmergencySource source);
+    uint32_t nowMillis() const { return static_cast<uint32_t>(esp_timer_get_time() / 1000); }
+
+    int _relayPins[PUMP_COUNT] = {};
+    uint8_t _stopPin = 0;
+    TaskHandle_t _task = nullptr;
+
+    // Caixas de correio (escritas por qualquer tarefa ou ISR)
+    std::atomic<uint8_t> _requested{0};
+    std::atomic<uint32_t> _stopRequestedAt{0};   // micros() do pedido pendente; 0 = nenhum
+    std::atomic<uint8_t> _stopSource{0};
+    std::atomic<bool> _clearRequested{false};
+
+    // Estado (escrito só pela tarefa)
+    std::atomic<uint8_t> _applied{0};
+    std::atomic<bool> _latched{false};
+    std::atomic<uint8_t> _latchedSource{0};
+    std::atomic<uint32_t> _onSince[PUMP_COUNT] = {};
+    std::atomic<uint32_t> _stops{0};
+    std::atomic<uint32_t> _lastLatency{0};
+    std::atomic<uint32_t> _maxLatency{0};
+    std::atomic<uint32_t> _runtimeTrips{0};
+};
@@ -0,0 +1,154 @@
+#include "ScheduleEngine.h"
+
+#include <algorithm>
+
+void ScheduleEngine::begin(ScheduleStore& store, PumpAction action) {
+    std::lock_guard<std::mutex> guard(_lock);
+    _action = action;
+    _entries.clear();
+    _entries.reserve(store.count());
+    store.forEach([&](const ScheduleRecord& record) {
+        Entry entry = {record.id, record.duration, record.pumpId, record.hour,
+                       record.minute, record.days, record.enabled != 0, false, false};
+        _entries.push_back(entry); // forEach percorre em ordem de id
+    });
+    _heap.clear();
+    _lastTick = 0; // o heap é montado no primeiro tick com relógio válido
+    Serial.printf("⏰ %u agendamentos no motor\n", (unsigned)_entries.size());
+}
+
+ScheduleEngine::Entry* ScheduleEngine::find(uint32_t id) {
+    auto it = std::lower_bound(_entries.begin(), _entries.end(), id,
+                               [](const Entry& entry, uint32_t key) { return entry.id < key; });
+    return it != _entries.end() && it->id == id ? &*it : nullptr;
+}
+
+void ScheduleEngine::pushEvent(time_t when, uint32_t id, EventType type) {
+    _heap.push_back(Event{when, id, type});
+    std::push_heap(_heap.begin(), _heap.end(), Later());
+}
+
+// Primeiro início depois de `after` num dia da semana habilitado (hora local, com DST)
+time_t ScheduleEngine::nextOccurrence(const Entry& entry, time_t after) {
+    if (!(entry.days & 0x7F)) return 0;
+    struct tm base;
+    localtime_r(&after, &base);
+    for (int day = 0; day <= 7; day++) {
+        struct tm candidate = base;
+        candidate.tm_mday += day;
+        candidate.tm_hour = entry.hour;
+        candidate.tm_min = entry.minute;
+        candidate.tm_sec = 0;
+        candidate.tm_isdst = -1;
+        time_t when = mktime(&candidate); // normaliza a data e preenche tm_wday
+        if (when > after && (entry.days & (1 << candidate.tm_wday))) return when;
+    }
+    return 0;
+}
+
+void ScheduleEngine::scheduleNextStart(const Entry& entry, time_t after) {
+    if (!entry.enabled || entry.removed) return;
+    time_t when = nextOccurrence(entry, after);
+    if (when) pushEvent(when, entry.id, EVENT_START);
+}
+
+void ScheduleEngine::rebuild(time_t now) {
+    _heap.clear();
+    for (Entry& entry : _entries) {
+        // Começa pela janela que ainda não terminou: um boot no meio dela liga a bomba
+        time_t windowStart = now - (time_t)entry.duration * 60;
+        if (entry.active) {
+            // Janela em andamento, conferida contra o relógio novo: se ainda
+            // cobre `now` a bomba segue ligada até o fim dela; senão desliga já.
+            // Nos dois casos o próximo início volta ao heap
+            time_t start = entry.enabled && !entry.removed ? nextOccurrence(entry, windowStart) : 0;
+            if (start && start <= now) {
+                pushEvent(start + (time_t)entry.duration * 60, entry.id, EVENT_STOP);
+                scheduleNextStart(entry, start);
+                continue;
+            }
+            pushEvent(now, entry.id, EVENT_STOP);
+        }
+        scheduleNextStart(entry, windowStart);
+    }
+}
+
+void ScheduleEngine::onCreated(const ScheduleRecord& record) {
+    std::lock_guard<std::mutex> guard(_lock);
+    Entry entry = {record.id, record.duration, record.pumpId, record.hour,
+                   record.minute, record.days, record.enabled != 0, false, false};
+    auto it = std::lower_bound(_entries.begin(), _entries.end(), record.id,
+                               [](const Entry& e, uint32_t key) { return e.id < key; });
+    it = _entries.insert(it, entry);
+    if (_lastTick) scheduleNextStart(*it, _lastTick);
+}
+
+void ScheduleEngine::onRemoved(uint32_t id) {
+    std::lock_guard<std::mutex> guard(_lock);
+    Entry* entry = find(id);
+    if (!entry) return;
+    if (entry->active) {
+        // A bomba é desligada pelo loop(), no próximo tick
+        entry->removed = true;
+        pushEvent(0, id, EVENT_STOP);
+    } else {
+        _entries.erase(_entries.begin() + (entry - _entries.data()));
+    }
+}
+
+void ScheduleEngine::tick(time_t now) {
+    // Ações coletadas sob o lock e executadas depois: setPumpState grava NVS e faz log
+    struct Action {
+        int pumpId;
+        bool on;
+    };
+    Action actions[8];
+    size_t actionCount = 0;
+
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        if (_lastTick == 0 || now < _lastTick - 60 || now > _lastTick + CLOCK_JUMP_SECONDS) {
+            rebuild(now);
+        }
+        _lastTick = now;
+
+        while (!_heap.empty() && _heap.front().when <= now && actionCount < sizeof(actions) / sizeof(actions[0])) {
+            std::pop_heap(_heap.begin(), _heap.end(), Later());
+            Event event = _heap.back();
+            _heap.pop_back();
+
+            Entry* entry = find(event.id);
+            if (!entry) continue; // agendamento removido: evento obsoleto
+
+            if (event.type == EVENT_START) {
+                if (entry->removed || !entry->enabled) continue;
+                if (!entry->active) {
+                    entry->active = true;
+                    if (_pumpHolds[entry->pumpId]++ == 0) actions[actionCount++] = {entry->pumpId, true};
+                    pushEvent(event.when + (time_t)entry->duration * 60, entry->id, EVENT_STOP);
+                }
+                scheduleNextStart(*entry, event.when);
+            } else if (entry->active) {
+                entry->active = false;
+                // Com janelas sobrepostas na mesma bomba, só a última desliga
+                if (--_pumpHolds[entry->pumpId] == 0) actions[actionCount++] = {entry->pumpId, false};
+                if (entry->removed) _entries.erase(_entries.begin() + (entry - _entries.data()));
+            }
+        }
+    }
+
+    for (size_t i = 0; i < actionCount; i++) {
+        Serial.printf("⏰ Agendamento -> Bomba %d %s\n", actions[i].pumpId, actions[i].on ? "ON" : "OFF");
+        _action(actions[i].pumpId, actions[i].on);
+    }
+}
+
+size_t ScheduleEngine::size() {
+    std::lock_guard<std::mutex> guard(_lock);
+    return _entries.size();
+}
+
+time_t ScheduleEngine::nextEventTime() {
+    std::lock_guard<std::mutex> guard(_lock);
+    return _heap.empty() ? 0 : _heap.front().when;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Arduino.h>
+#include <mutex>
+#include <vector>
+
+#include "ScheduleStore.h"
+
+// --- Motor de agendamentos ---
+// Tabela compacta dos agendamentos em RAM (carregada uma vez do ScheduleStore)
+// e um min-heap com o próximo evento de cada um (ligar ou desligar a bomba).
+// A cada tick o loop() só olha o topo do heap: O(1) enquanto nada vence,
+// O(log n) por evento disparado, independente do número de agendamentos.
+// A API REST atualiza a tabela incrementalmente via onCreated()/onRemoved();
+// eventos de agendamentos removidos são descartados quando chegam ao topo.
+
+class ScheduleEngine {
+public:
+    typedef void (*PumpAction)(int pumpId, bool on);
+
+    // Carrega os agendamentos do store; `action` liga/desliga as bombas no loop()
+    void begin(ScheduleStore& store, PumpAction action);
+
+    // Chamados pelos handlers HTTP (task do AsyncTCP)
+    void onCreated(const ScheduleRecord& record);
+    void onRemoved(uint32_t id);
+
+    // Chamado pelo loop() com o relógio de parede já sincronizado
+    void tick(time_t now);
+
+    size_t size();
+    time_t nextEventTime();   // 0 se não há eventos
+
+private:
+    enum EventType : uint8_t { EVENT_START, EVENT_STOP };
+
+    struct Entry {
+        uint32_t id;
+        uint16_t duration;   // minutos
+        uint8_t pumpId;
+        uint8_t hour;
+        uint8_t minute;
+        uint8_t days;
+        bool enabled;
+        bool active;         // janela em andamento (bomba ligada por este agendamento)
+        bool removed;        // apagado durante a janela: aguarda o STOP para sair da tabela
+    };
+
+    struct Event {
+        time_t when;
+        uint32_t id;
+        EventType type;
+    };
+
+    struct Later {
+        bool operator()(const Event& a, const Event& b) const { return a.when > b.when; }
+    };
+
+    // Salto de relógio acima disso (SNTP, ajuste manual) reconstrói o heap
+    static constexpr time_t CLOCK_JUMP_SECONDS = 3600;
+
+    Entry* find(uint32_t id);
+    void pushEvent(time_t when, uint32_t id, EventType type);
+    void scheduleNextStart(const Entry& entry, time_t after);
+    void rebuild(time_t now);
+    static time_t nextOccurrence(const Entry& entry, time_t after);
+
+    PumpAction _action = nullptr;
+    std::mutex _lock;
+    std::vector<Entry> _entries;   // ordenado por id
+    std::vector<Event> _heap;
+    uint8_t _pumpHolds[4] = {0};   // janelas ativas por bomba
+    time_t _lastTick = 0;
+};
@@ -0,0 +1,353 @@
+#include "ScheduleStore.h"
+#include "Crc32.h"
+
+#include <algorithm>
+
+static const char* SNAPSHOT_PATH = "/sched.dat";
+static const char* SNAPSHOT_TMP_PATH = "/sched.tmp";
+static const char* JOURNAL_PATH = "/sched.log";
+static const char* LEGACY_JSON_PATH = "/schedules.json";
+static const char* LEGACY_BACKUP_PATH = "/schedules.json.bak";
+
+static const uint32_t SNAPSHOT_MAGIC = 0x31535051; // "QPS1"
+static const uint16_t FORMAT_VERSION = 1;
+
+static const uint8_t OP_PUT = 1;
+static const uint8_t OP_DELETE = 2;
+
+struct SnapshotHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t count;
+    uint32_t nextId;
+};
+// Depois dos registros: CRC32 de cabeçalho + registros
+
+struct JournalEntry {
+    uint8_t op;
+    uint8_t reserved[3];
+    ScheduleRecord record;
+    uint32_t crc;        // CRC32 de op..record
+};
+
+static_assert(sizeof(SnapshotHeader) == 16, "SnapshotHeader faz parte do formato em flash");
+static_assert(sizeof(JournalEntry) == 48, "JournalEntry faz parte do formato em flash");
+
+static uint32_t journalCrc(const JournalEntry& entry) {
+    return crc32Update(0, reinterpret_cast<const uint8_t*>(&entry), offsetof(JournalEntry, crc));
+}
+
+// --- JSON ---
+
+bool scheduleFromJson(JsonVariantConst json, ScheduleRecord& record, const char*& error) {
+    memset(&record, 0, sizeof(record));
+    if (!json.is<JsonObjectConst>()) {
+        error = "Schedule must be an object";
+        return false;
+    }
+    int pumpId = json["pump_id"] | 0;
+    int hour = json["hour"] | -1;
+    int minute = json["minute"] | -1;
+    int duration = json["duration"] | 0;
+    if (pumpId < 0 || pumpId >= 4) {
+        error = "Invalid pump_id";
+        return false;
+    }
+    if (hour < 0 || hour > 23 || minute < 0 || minute > 59) {
+        error = "Invalid hour/minute";
+        return false;
+    }
+    if (duration <= 0 || duration > 24 * 60) {
+        error = "Invalid duration";
+        return false;
+    }
+    record.pumpId = pumpId;
+    record.hour = hour;
+    record.minute = minute;
+    record.duration = duration;
+    record.enabled = (json["enabled"] | true) ? 1 : 0;
+    record.id = json["id"] | 0UL;
+    record.created = json["created"] | 0UL;
+
+    // Dias da semana: lista [0..6] (0 = domingo); ausente = todos os dias
+    JsonArrayConst days = json["days"];
+    if (days.isNull()) {
+        record.days = 0x7F;
+    } else {
+        for (JsonVariantConst day : days) {
+            int d = day | -1;
+            if (d < 0 || d > 6) {
+                error = "Invalid days";
+                return false;
+            }
+            record.days |= 1 << d;
+        }
+    }
+
+    const char* name = json["name"] | "";
+    strncpy(record.name, name, sizeof(record.name) - 1);
+    return true;
+}
+
+void scheduleToJson(const ScheduleRecord& record, JsonObject json) {
+    json["id"] = record.id;
+    json["created"] = record.created;
+    json["name"] = String(record.name); // const char* seria guardado por referência
+    json["pump_id"] = record.pumpId;
+    json["hour"] = record.hour;
+    json["minute"] = record.minute;
+    json["duration"] = record.duration;
+    JsonArray days = json["days"].to<JsonArray>();
+    for (int d = 0; d < 7; d++) {
+        if (record.days & (1 << d)) days.add(d);
+    }
+    json["enabled"] = record.enabled != 0;
+}
+
+// --- Índice ---
+
+int ScheduleStore::find(uint32_t id) const {
+    auto it = std::lower_bound(_index.begin(), _index.end(), id,
+                               [](const IndexEntry& entry, uint32_t key) { return entry.id < key; });
+    return it != _index.end() && it->id == id ? static_cast<int>(it - _index.begin()) : -1;
+}
+
+void ScheduleStore::indexPut(uint32_t id, uint32_t location) {
+    auto it = std::lower_bound(_index.begin(), _index.end(), id,
+                               [](const IndexEntry& entry, uint32_t key) { return entry.id < key; });
+    if (it != _index.end() && it->id == id) {
+        it->location = location;
+    } else {
+        _index.insert(it, IndexEntry{id, location});
+    }
+    if (id >= _nextId) _nextId = id + 1;
+}
+
+void ScheduleStore::indexErase(uint32_t id) {
+    int pos = find(id);
+    if (pos >= 0) _index.erase(_index.begin() + pos);
+}
+
+// --- Carga ---
+
+bool ScheduleStore::begin(fs::FS& fs) {
+    _fs = &fs;
+    _index.clear();
+    _nextId = 1;
+    _journalEntries = 0;
+
+    // Compactação interrompida entre remover o snapshot antigo e renomear o novo
+    if (!fs.exists(SNAPSHOT_PATH) && fs.exists(SNAPSHOT_TMP_PATH)) {
+        fs.rename(SNAPSHOT_TMP_PATH, SNAPSHOT_PATH);
+    }
+    fs.remove(SNAPSHOT_TMP_PATH);
+
+    if (!fs.exists(SNAPSHOT_PATH) && !fs.exists(JOURNAL_PATH) && fs.exists(LEGACY_JSON_PATH)) {
+        return migrateJson();
+    }
+
+    if (!loadSnapshot()) {
+        Serial.println("❌ Snapshot de agendamentos inválido, ignorando");
+        _index.clear();
+    }
+    bool tornTail = false;
+    replayJournal(tornTail);
+    Serial.printf("📄 %u agendamentos carregados (%u entradas no diário)\n",
+                  (unsigned)_index.size(), (unsigned)_journalEntries);
+
+    // Entrada incompleta no fim do diário (queda de energia): reescreve sem ela
+    if (tornTail) {
+        Serial.println("⚠️ Diário de agendamentos truncado, compactando");
+        return compact();
+    }
+    return true;
+}
+
+bool ScheduleStore::loadSnapshot() {
+    File file = _fs->open(SNAPSHOT_PATH, FILE_READ);
+    if (!file) return true; // sem snapshot: só o diário
+
+    SnapshotHeader header;
+    if (file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) != sizeof(header) ||
+        header.magic != SNAPSHOT_MAGIC || header.version != FORMAT_VERSION ||
+        header.recordSize != sizeof(ScheduleRecord)) {
+        return false;
+    }
+
+    uint32_t crc = crc32Update(0, reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+    ScheduleRecord record;
+    _index.reserve(header.count);
+    for (uint32_t i = 0; i < header.count; i++) {
+        uint32_t offset = sizeof(SnapshotHeader) + i * sizeof(ScheduleRecord);
+        if (file.read(reinterpret_cast<uint8_t*>(&record), sizeof(record)) != sizeof(record)) return false;
+        crc = crc32Update(crc, reinterpret_cast<const uint8_t*>(&record), sizeof(record));
+        // Snapshot é gravado em ordem de id: inserção no fim do índice
+        _index.push_back(IndexEntry{record.id, offset});
+    }
+    uint32_t storedCrc = 0;
+    if (file.read(reinterpret_cast<uint8_t*>(&storedCrc), sizeof(storedCrc)) != sizeof(storedCrc) || crc != storedCrc) {
+        return false;
+    }
+    _nextId = std::max(header.nextId, _index.empty() ? 1 : _index.back().id + 1);
+    return true;
+}
+
+bool ScheduleStore::replayJournal(bool& tornTail) {
+    File file = _fs->open(JOURNAL_PATH, FILE_READ);
+    if (!file) return true;
+
+    JournalEntry entry;
+    uint32_t offset = 0;
+    while (file.read(reinterpret_cast<uint8_t*>(&entry), sizeof(entry)) == sizeof(entry)) {
+        if (entry.crc != journalCrc(entry)) {
+            tornTail = true;
+            return false;
+        }
+        if (entry.op == OP_PUT) {
+            indexPut(entry.record.id, IN_JOURNAL | (offset + offsetof(JournalEntry, record)));
+        } else if (entry.op == OP_DELETE) {
+            indexErase(entry.record.id);
+            if (entry.record.id >= _nextId) _nextId = entry.record.id + 1;
+        }
+        offset += sizeof(entry);
+        _journalEntries++;
+    }
+    tornTail = offset != file.size();
+    return true;
+}
+
+bool ScheduleStore::migrateJson() {
+    File file = _fs->open(LEGACY_JSON_PATH, FILE_READ);
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+    if (error) {
+        Serial.printf("❌ Erro ao migrar agendamentos: %s\n", error.c_str());
+        return false;
+    }
+
+    // Monta o índice com os registros migrados no diário e compacta de uma vez
+    size_t skipped = 0;
+    std::vector<ScheduleRecord> records;
+    for (JsonVariantConst item : doc.as<JsonArrayConst>()) {
+        ScheduleRecord record;
+        const char* reason = nullptr;
+        if (!scheduleFromJson(item, record, reason) || record.id == 0 || contains(record.id)) {
+            skipped++;
+            continue;
+        }
+        records.push_back(record);
+        indexPut(record.id, 0);
+    }
+    for (const ScheduleRecord& record : records) {
+        if (!append(OP_PUT, record)) return false;
+    }
+    if (!compact()) return false;
+
+    _fs->rename(LEGACY_JSON_PATH, LEGACY_BACKUP_PATH);
+    Serial.printf("🔄 %u agendamentos migrados de %s (%u ignorados)\n",
+                  (unsigned)records.size(), LEGACY_JSON_PATH, (unsigned)skipped);
+    return true;
+}
+
+// --- Escrita ---
+
+bool ScheduleStore::append(uint8_t op, const ScheduleRecord& record) {
+    File file = _fs->open(JOURNAL_PATH, FILE_APPEND);
+    if (!file) {
+        Serial.println("❌ Erro ao abrir diário de agendamentos");
+        return false;
+    }
+    JournalEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.op = op;
+    entry.record = record;
+    entry.crc = journalCrc(entry);
+
+    uint32_t offset = file.size();
+    bool ok = file.write(reinterpret_cast<const uint8_t*>(&entry), sizeof(entry)) == sizeof(entry);
+    file.close();
+    if (!ok) return false;
+
+    if (op == OP_PUT) {
+        indexPut(record.id, IN_JOURNAL | (offset + offsetof(JournalEntry, record)));
+    } else {
+        indexErase(record.id);
+    }
+    _journalEntries++;
+    return true;
+}
+
+bool ScheduleStore::create(ScheduleRecord& record) {
+    record.id = _nextId;
+    record.created = millis();
+    if (!append(OP_PUT, record)) return false;
+    if (journalNeedsCompaction()) compact();
+    return true;
+}
+
+bool ScheduleStore::remove(uint32_t id) {
+    if (!contains(id)) return false;
+    ScheduleRecord record;
+    memset(&record, 0, sizeof(record));
+    record.id = id;
+    if (!append(OP_DELETE, record)) return false;
+    if (journalNeedsCompaction()) compact();
+    return true;
+}
+
+bool ScheduleStore::get(uint32_t id, ScheduleRecord& record) {
+    int pos = find(id);
+    if (pos < 0) return false;
+    File snapshot, journal;
+    return readAt(_index[pos].location, record, snapshot, journal);
+}
+
+bool ScheduleStore::readAt(uint32_t location, ScheduleRecord& record, File& snapshot, File& journal) {
+    bool inJournal = location & IN_JOURNAL;
+    File& file = inJournal ? journal : snapshot;
+    if (!file) file = _fs->open(inJournal ? JOURNAL_PATH : SNAPSHOT_PATH, FILE_READ);
+    if (!file || !file.seek(location & ~IN_JOURNAL)) return false;
+    return file.read(reinterpret_cast<uint8_t*>(&record), sizeof(record)) == sizeof(record);
+}
+
+// Reescreve os registros vivos num snapshot novo: tmp -> remove antigo -> rename.
+// Uma queda entre os passos é resolvida no begin() (tmp órfão é promovido);
+// reaplicar o diário sobre o snapshot novo é idempotente.
+bool ScheduleStore::compact() {
+    File out = _fs->open(SNAPSHOT_TMP_PATH, FILE_WRITE);
+    if (!out) {
+        Serial.println("❌ Erro ao criar snapshot de agendamentos");
+        return false;
+    }
+
+    SnapshotHeader header = {SNAPSHOT_MAGIC, FORMAT_VERSION, sizeof(ScheduleRecord),
+                             static_cast<uint32_t>(_index.size()), _nextId};
+    bool written = out.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header)) == sizeof(header);
+    uint32_t crc = crc32Update(0, reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+
+    std::vector<IndexEntry> compacted;
+    compacted.reserve(_index.size());
+    uint32_t offset = sizeof(header);
+    bool ok = forEach([&](const ScheduleRecord& record) {
+        crc = crc32Update(crc, reinterpret_cast<const uint8_t*>(&record), sizeof(record));
+        compacted.push_back(IndexEntry{record.id, offset});
+        offset += sizeof(record);
+        written = written && out.write(reinterpret_cast<const uint8_t*>(&record), sizeof(record)) == sizeof(record);
+    });
+    ok = ok && written && out.write(reinterpret_cast<const uint8_t*>(&crc), sizeof(crc)) == sizeof(crc);
+    out.close();
+    if (!ok) {
+        _fs->remove(SNAPSHOT_TMP_PATH);
+        Serial.println("❌ Erro ao gravar snapshot de agendamentos");
+        return false;
+    }
+
+    _fs->remove(SNAPSHOT_PATH);
+    if (!_fs->rename(SNAPSHOT_TMP_PATH, SNAPSHOT_PATH)) return false;
+    _fs->remove(JOURNAL_PATH);
+    _index.swap(compacted);
+    _journalEntries = 0;
+    return true;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <FS.h>
+#include <vector>
+
+// --- Armazenamento de agendamentos ---
+// Registros binários de tamanho fixo em dois arquivos:
+//   /sched.dat  snapshot compactado (cabeçalho + registros, com CRC)
+//   /sched.log  diário só de acréscimo (uma entrada por criação/remoção, com CRC)
+// Um índice id -> posição em RAM evita reler os arquivos para localizar um
+// registro. Criar ou remover grava só uma entrada no diário; quando ele cresce
+// demais, os registros vivos são reescritos em /sched.tmp e promovidos a
+// snapshot. Na primeira execução o antigo /schedules.json é migrado.
+
+struct ScheduleRecord {
+    uint32_t id;
+    uint32_t created;
+    char name[24];
+    uint16_t duration;   // minutos
+    uint8_t pumpId;
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t days;        // bit 0 = domingo ... bit 6 = sábado
+    uint8_t enabled;
+    uint8_t reserved;
+};
+
+static_assert(sizeof(ScheduleRecord) == 40, "ScheduleRecord faz parte do formato em flash");
+
+// Conversão de/para a representação JSON da API
+bool scheduleFromJson(JsonVariantConst json, ScheduleRecord& record, const char*& error);
+void scheduleToJson(const ScheduleRecord& record, JsonObject json);
+
+class ScheduleStore {
+public:
+    bool begin(fs::FS& fs);
+
+    size_t count() const { return _index.size(); }
+    bool contains(uint32_t id) const { return find(id) >= 0; }
+
+    // Atribui id e data de criação e grava o registro
+    bool create(ScheduleRecord& record);
+    bool remove(uint32_t id);
+    bool get(uint32_t id, ScheduleRecord& record);
+
+    // Percorre todos os registros em ordem de id; fn(const ScheduleRecord&)
+    template <typename Fn>
+    bool forEach(Fn fn) {
+        File snapshot, journal;
+        ScheduleRecord record;
+        for (const IndexEntry& entry : _index) {
+            if (!readAt(entry.location, record, snapshot, journal)) return false;
+            fn(record);
+        }
+        return true;
+    }
+
+    bool compact();
+
+    uint32_t journalEntries() const { return _journalEntries; }
+
+private:
+    struct IndexEntry {
+        uint32_t id;
+        uint32_t location;   // offset no arquivo; bit 31 = diário
+    };
+
+    static constexpr uint32_t IN_JOURNAL = 0x80000000UL;
+    // Compacta quando o diário passa de 32 entradas além do dobro dos registros
+    // vivos: o custo da reescrita fica amortizado em O(1) por operação
+    static constexpr uint32_t COMPACT_SLACK_ENTRIES = 32;
+
+    bool journalNeedsCompaction() const {
+        return _journalEntries > COMPACT_SLACK_ENTRIES + 2 * _index.size();
+    }
+
+    int find(uint32_t id) const;
+    void indexPut(uint32_t id, uint32_t location);
+    void indexErase(uint32_t id);
+
+    bool loadSnapshot();
+    bool replayJournal(bool& tornTail);
+    bool append(uint8_t op, const ScheduleRecord& record);
+    bool readAt(uint32_t location, ScheduleRecord& record, File& snapshot, File& journal);
+    bool migrateJson();
+
+    fs::FS* _fs = nullptr;
+    std::vector<IndexEntry> _index;   // ordenado por id
+    uint32_t _nextId = 1;
+    uint32_t _journalEntries = 0;
+};
@@ -0,0 +1,141 @@
+#include "SensorHistory.h"
+
+#include <math.h>
+#include <string.h>
+
+constexpr uint32_t SensorHistory::TIER_PERIOD_S[];
+constexpr uint16_t SensorHistory::TIER_CAPACITY[];
+
+static_assert(SensorHistory::TIER_TOTAL ==
+                  SensorHistory::TIER_CAPACITY[0] + SensorHistory::TIER_CAPACITY[1] + SensorHistory::TIER_CAPACITY[2],
+              "TIER_TOTAL deve somar as capacidades");
+
+static const char* RESOLUTION_NAMES[] = {"raw", "1m", "15m", "1h"};
+
+SensorHistory::SensorHistory(float scale) : _scale(scale) {
+    uint16_t offset = 0;
+    for (uint8_t i = 0; i < TIER_COUNT; i++) {
+        _tiers[i].offset = offset;
+        _tiers[i].capacity = TIER_CAPACITY[i];
+        _tiers[i].period = TIER_PERIOD_S[i];
+        offset += TIER_CAPACITY[i];
+    }
+}
+
+void SensorHistory::add(uint32_t t, float value) {
+    if (isnan(value)) return;
+    float scaled = roundf(value * _scale);
+    // EMPTY fica reservado para "período sem amostras"
+    int16_t fixed = scaled >= INT16_MAX   ? INT16_MAX
+                    : scaled <= EMPTY + 1 ? EMPTY + 1
+                                          : static_cast<int16_t>(scaled);
+
+    std::lock_guard<std::mutex> guard(_lock);
+    // Amostra fora de ordem (não deveria acontecer com tempo monotônico)
+    if (_rawSize > 0 && t < _rawTime[(_rawHead + RAW_CAPACITY - 1) % RAW_CAPACITY]) return;
+
+    _rawTime[_rawHead] = t;
+    _rawValue[_rawHead] = fixed;
+    _rawHead = (_rawHead + 1) % RAW_CAPACITY;
+    if (_rawSize < RAW_CAPACITY) _rawSize++;
+
+    for (uint8_t i = 0; i < TIER_COUNT; i++) addToTier(i, t, fixed);
+    _samples++;
+}
+
+void SensorHistory::addToTier(uint8_t index, uint32_t t, int16_t value) {
+    Tier& tier = _tiers[index];
+    Accumulator& open = tier.open;
+    uint32_t start = t - t % tier.period;
+
+    if (open.count > 0 && start != open.start) {
+        // Fecha o período anterior; períodos sem amostra no meio ficam vazios
+        if (tier.size > 0) {
+            uint32_t gaps = (open.start - tier.newestStart) / tier.period - 1;
+            if (gaps > tier.capacity) gaps = tier.capacity;
+            for (uint32_t g = 0; g < gaps; g++) push(tier, EMPTY, EMPTY, EMPTY);
+        }
+        push(tier, open.min, open.max, static_cast<int16_t>(open.sum / open.count));
+        tier.newestStart = open.start;
+        open.count = 0;
+    }
+    if (open.count == 0) {
+        open.start = start;
+        open.sum = 0;
+        open.min = value;
+        open.max = value;
+    }
+    open.sum += value;
+    open.count++;
+    if (value < open.min) open.min = value;
+    if (value > open.max) open.max = value;
+}
+
+void SensorHistory::push(Tier& tier, int16_t min, int16_t max, int16_t avg) {
+    uint16_t slot = tier.offset + tier.head;
+    _min[slot] = min;
+    _max[slot] = max;
+    _avg[slot] = avg;
+    tier.head = (tier.head + 1) % tier.capacity;
+    if (tier.size < tier.capacity) tier.size++;
+}
+
+uint16_t SensorHistory::rawLowerBound(uint32_t from) const {
+    // Busca binária no anel: os instantes são crescentes do mais antigo ao mais novo
+    uint16_t lo = 0, hi = _rawSize;
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        uint16_t slot = (_rawHead + RAW_CAPACITY - _rawSize + mid) % RAW_CAPACITY;
+        if (_rawTime[slot] < from) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+uint32_t SensorHistory::oldest(HistoryResolution res) const {
+    if (res == HistoryResolution::Raw) {
+        // Anel ainda não cheio: nada foi descartado, cobre desde o boot
+        if (_rawSize < RAW_CAPACITY) return 0;
+        return _rawTime[_rawHead];
+    }
+    const Tier& tier = _tiers[static_cast<uint8_t>(res) - 1];
+    if (tier.size < tier.capacity) return 0;
+    return tier.newestStart - (tier.size - 1) * tier.period;
+}
+
+HistoryResolution SensorHistory::pick(uint32_t from, uint32_t to, size_t maxPoints) {
+    std::lock_guard<std::mutex> guard(_lock);
+    if (to < from) return HistoryResolution::Raw;
+
+    if (oldest(HistoryResolution::Raw) <= from) {
+        uint16_t first = rawLowerBound(from);
+        uint16_t last = to == UINT32_MAX ? _rawSize : rawLowerBound(to + 1);
+        if (static_cast<size_t>(last - first) <= maxPoints) return HistoryResolution::Raw;
+    }
+    for (uint8_t i = 0; i < TIER_COUNT; i++) {
+        HistoryResolution res = static_cast<HistoryResolution>(i + 1);
+        if (oldest(res) > from) continue;
+        // Estimativa pelo tamanho do intervalo, sem olhar as entradas
+        size_t points = (to - from) / _tiers[i].period + 1;
+        if (points <= maxPoints) return res;
+    }
+    return HistoryResolution::Hour;
+}
+
+uint32_t SensorHistory::period(HistoryResolution res) {
+    return res == HistoryResolution::Raw ? 0 : TIER_PERIOD_S[static_cast<uint8_t>(res) - 1];
+}
+
+const char* SensorHistory::name(HistoryResolution res) {
+    return RESOLUTION_NAMES[static_cast<uint8_t>(res)];
+}
+
+bool SensorHistory::parse(const char* text, HistoryResolution& res) {
+    for (uint8_t i = 0; i < sizeof(RESOLUTION_NAMES) / sizeof(RESOLUTION_NAMES[0]); i++) {
+        if (strcmp(text, RESOLUTION_NAMES[i]) == 0) {
+            res = static_cast<HistoryResolution>(i);
+            return true;
+        }
+    }
+    return false;
+}
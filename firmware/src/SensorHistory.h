@@ -0,0 +1,146 @@
+#pragma once
+
+#include <Arduino.h>
+#include <mutex>
+
+// --- Histórico dos sensores em RAM, em várias resoluções ---
+// Cada série guarda as amostras brutas mais recentes e três níveis agregados
+// (1 min, 15 min, 1 h) com mínimo, máximo e média por período. Cada amostra
+// entra no acumulador aberto de cada nível; quando o período vira, o
+// acumulador fecha numa entrada do anel. Todos os anéis têm capacidade fixa
+// (memória conhecida em tempo de compilação) e os valores ficam em
+// ponto fixo int16. Consultas a um nível agregado calculam o índice pelo
+// tempo, sem percorrer as amostras brutas.
+// Tempo em segundos desde o boot (monotônico); a conversão para o relógio de
+// parede fica com quem chama.
+
+enum class HistoryResolution : uint8_t { Raw, Minute, QuarterHour, Hour };
+
+struct HistoryPoint {
+    uint32_t t;      // início do período (ou instante da amostra bruta)
+    float min;
+    float max;
+    float avg;
+    bool partial;    // período ainda aberto
+};
+
+class SensorHistory {
+public:
+    static constexpr uint16_t RAW_CAPACITY = 180;   // 15 min a cada 5 s
+    static constexpr uint8_t TIER_COUNT = 3;
+    static constexpr uint32_t TIER_PERIOD_S[TIER_COUNT] = {60, 900, 3600};
+    static constexpr uint16_t TIER_CAPACITY[TIER_COUNT] = {240, 288, 720};   // 4 h, 3 dias, 30 dias
+    static constexpr uint16_t TIER_TOTAL = 240 + 288 + 720;
+
+    // Valor guardado = round(valor * scale) em int16 (100 = centésimos)
+    explicit SensorHistory(float scale = 100.0f);
+
+    void add(uint32_t t, float value);
+
+    // fn(const HistoryPoint&) para cada ponto que toca [from, to], do mais
+    // antigo ao mais novo; passando de `maxPoints`, ficam os mais recentes.
+    // Retorna quantos foram emitidos
+    template <typename Fn>
+    size_t query(HistoryResolution res, uint32_t from, uint32_t to, size_t maxPoints, Fn fn);
+
+    // A resolução mais fina que ainda cobre `from` com até `maxPoints` pontos
+    // (as mais finas guardam menos tempo); se nenhuma cobre, a de 1 h
+    HistoryResolution pick(uint32_t from, uint32_t to, size_t maxPoints);
+
+    static uint32_t period(HistoryResolution res);
+    static const char* name(HistoryResolution res);
+    static bool parse(const char* text, HistoryResolution& res);
+
+    uint32_t samples() const { return _samples; }
+
+private:
+    static constexpr int16_t EMPTY = INT16_MIN;   // período sem amostras
+
+    struct Accumulator {
+        uint32_t start;
+        int32_t sum;
+        uint16_t count;
+        int16_t min;
+        int16_t max;
+    };
+
+    struct Tier {
+        uint16_t offset;        // início do anel em _min/_max/_avg
+        uint16_t capacity;
+        uint32_t period;
+        uint16_t head = 0;      // próxima escrita
+        uint16_t size = 0;
+        uint32_t newestStart = 0;
+        Accumulator open = {};
+    };
+
+    void addToTier(uint8_t tier, uint32_t t, int16_t value);
+    void push(Tier& tier, int16_t min, int16_t max, int16_t avg);
+    // Índice do anel bruto da primeira amostra com t >= from
+    uint16_t rawLowerBound(uint32_t from) const;
+    uint32_t oldest(HistoryResolution res) const;
+    float toFloat(int16_t value) const { return value / _scale; }
+
+    std::mutex _lock;   // add() no loop(), consultas na tarefa do AsyncTCP
+    float _scale;
+    uint32_t _samples = 0;
+
+    uint32_t _rawTime[RAW_CAPACITY];
+    int16_t _rawValue[RAW_CAPACITY];
+    uint16_t _rawHead = 0;
+    uint16_t _rawSize = 0;
+
+    Tier _tiers[TIER_COUNT];
+    int16_t _min[TIER_TOTAL];
+    int16_t _max[TIER_TOTAL];
+    int16_t _avg[TIER_TOTAL];
+};
+
+template <typename Fn>
+size_t SensorHistory::query(HistoryResolution res, uint32_t from, uint32_t to, size_t maxPoints, Fn fn) {
+    std::lock_guard<std::mutex> guard(_lock);
+    size_t emitted = 0;
+    if (to < from || maxPoints == 0) return 0;
+
+    if (res == HistoryResolution::Raw) {
+        uint16_t first = rawLowerBound(from);
+        uint16_t end = to == UINT32_MAX ? _rawSize : rawLowerBound(to + 1);
+        if (end > first + maxPoints) first = end - maxPoints;
+        for (uint16_t i = first; i < end; i++) {
+            uint16_t slot = (_rawHead + RAW_CAPACITY - _rawSize + i) % RAW_CAPACITY;
+            float value = toFloat(_rawValue[slot]);
+            fn(HistoryPoint{_rawTime[slot], value, value, value, false});
+            emitted++;
+        }
+        return emitted;
+    }
+
+    const Tier& tier = _tiers[static_cast<uint8_t>(res) - 1];
+    const Accumulator& open = tier.open;
+    bool withOpen = open.count > 0 && open.start <= to && open.start + tier.period > from;
+    if (withOpen) maxPoints--;
+    if (tier.size > 0 && maxPoints > 0) {
+        uint32_t oldestStart = tier.newestStart - (tier.size - 1) * tier.period;
+        // Períodos [s, s + period) que tocam [from, to]: índice direto pelo tempo
+        uint32_t first = from > oldestStart ? (from - oldestStart) / tier.period : 0;
+        uint32_t last = to >= tier.newestStart ? tier.size - 1
+                        : to >= oldestStart    ? (to - oldestStart) / tier.period
+                                               : UINT32_MAX;
+        if (last != UINT32_MAX && first <= last) {
+            if (last - first + 1 > maxPoints) first = last + 1 - maxPoints;
+            for (uint32_t j = first; j <= last; j++) {
+                uint16_t slot = tier.offset + (tier.head + tier.capacity - tier.size + j) % tier.capacity;
+                if (_min[slot] == EMPTY) continue;
+                fn(HistoryPoint{oldestStart + j * tier.period, toFloat(_min[slot]), toFloat(_max[slot]),
+                                toFloat(_avg[slot]), false});
+                emitted++;
+            }
+        }
+    }
+    if (withOpen) {
+        fn(HistoryPoint{open.start, toFloat(open.min), toFloat(open.max),
+                        toFloat(static_cast<int16_t>(open.sum / open.count)), true});
+        emitted++;
+    }
+    return emitted;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include <string.h>
+#include <type_traits>
+
+// --- Seqlock de um escritor ---
+// Publica uma cópia de T sem trava: o escritor incrementa o contador (ímpar =
+// escrita em andamento), grava os dados e incrementa de novo; o leitor copia
+// os dados e só aceita a cópia se o contador era par e não mudou no meio. Os
+// dados ficam em palavras atômicas relaxadas, então uma leitura concorrente
+// nunca é uma corrida de dados, só uma cópia descartada e refeita.
+// write() só pode ser chamado por uma tarefa; read() por qualquer uma (não em ISR).
+
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock copia T palavra por palavra");
+
+public:
+    // Tentativas seguidas antes de ceder a CPU: se o leitor tiver prioridade
+    // maior e interromper o escritor no mesmo núcleo, girar não adianta
+    static constexpr uint32_t SPIN_LIMIT = 8;
+
+    void write(const T& value) {
+        uint32_t words[WORDS] = {};
+        memcpy(words, &value, sizeof(T));
+        uint32_t seq = _seq.load(std::memory_order_relaxed);
+        _seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) _data[i].store(words[i], std::memory_order_relaxed);
+        _seq.store(seq + 2, std::memory_order_release);
+    }
+
+    T read() const {
+        uint32_t words[WORDS];
+        for (uint32_t attempt = 1;; attempt++) {
+            uint32_t before = _seq.load(std::memory_order_acquire);
+            if (!(before & 1)) {
+                for (size_t i = 0; i < WORDS; i++) words[i] = _data[i].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (_seq.load(std::memory_order_relaxed) == before) break;
+            }
+            _retries.fetch_add(1, std::memory_order_relaxed);
+            if (attempt >= SPIN_LIMIT) vTaskDelay(1);
+        }
+        T value;
+        memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+    // Quantas publicações já houve
+    uint32_t version() const { return _seq.load(std::memory_order_acquire) / 2; }
+    // Cópias descartadas por concorrência com o escritor
+    uint32_t retries() const { return _retries.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> _seq{0};
+    std::atomic<uint32_t> _data[WORDS] = {};
+    mutable std::atomic<uint32_t> _retries{0};
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// --- Fila circular de um produtor e um consumidor ---
+// Sem trava: cada lado só escreve no seu índice (head no produtor, tail no
+// consumidor), publicado com release depois de mexer no item. Com a fila
+// cheia push() descarta o item novo e conta a perda; o produtor também guarda
+// a maior ocupação que viu.
+
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "Capacidade deve ser potência de 2");
+
+public:
+    // Só o produtor
+    bool push(const T& item) {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) >= N) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _items[head & (N - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+        uint32_t depth = head + 1 - _tail.load(std::memory_order_relaxed);
+        if (depth > _highWater.load(std::memory_order_relaxed)) _highWater.store(depth, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Só o produtor: push() falharia
+    bool full() const { return _head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_acquire) >= N; }
+
+    // Só o consumidor
+    bool pop(T& item) {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) return false;
+        item = _items[tail & (N - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+    // Maior número de itens na fila logo depois de um push() (no máximo N)
+    uint32_t highWater() const { return _highWater.load(std::memory_order_relaxed); }
+
+private:
+    T _items[N];
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0};
+    std::atomic<uint32_t> _dropped{0};
+    std::atomic<uint32_t> _highWater{0};
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Arduino.h>
+#ifndef NATIVE_SIM
+#include <AsyncTCP.h>
+#endif
+
+// --- Tarefas do firmware: pilha, prioridade e núcleo ---
+// Núcleo 0 fica com a rede (WiFi e lwIP do IDF, AsyncTCP e a tarefa "net",
+// que envia os deltas); núcleo 1 com o controle: o loop() (sensores,
+// agendamentos, persistência) e, acima dele, o supervisor que é dono dos relés.
+// Entre os núcleos só há filas limitadas e caixas de correio:
+//   AsyncTCP -> loop(): controlCommands (SpscQueue) e rgbMailbox
+//   loop() -> net:      stateDeltas (SpscQueue) e o estado no SeqLock
+//   qualquer -> safety: requestPump()/emergencyStop() (atômicos)
+// O loop() e o AsyncTCP são criados pelo framework e pela biblioteca: as
+// linhas deles conferem, em tempo de compilação, a configuração que eles usam
+// (CONFIG_ARDUINO_* do sdkconfig e CONFIG_ASYNC_TCP_* do platformio.ini).
+
+enum class TaskId : uint8_t { Loop, Safety, Network, AsyncTcp, Count };
+
+struct TaskConfig {
+    const char* name;
+    uint32_t stackBytes;
+    UBaseType_t priority;
+    BaseType_t core;
+};
+
+constexpr TaskConfig TASKS[] = {
+    {"loop", 8192, 1, 1},                           // loopTask do Arduino
+    {"safety", 3072, configMAX_PRIORITIES - 5, 1},  // acima de tudo no núcleo 1
+    {"net", 6144, 5, 0},                            // abaixo do AsyncTCP: respostas antes de deltas
+    {"async_tcp", 16384, 10, 0},
+};
+static_assert(sizeof(TASKS) / sizeof(TASKS[0]) == static_cast<size_t>(TaskId::Count), "Uma linha por tarefa");
+
+constexpr const TaskConfig& taskConfig(TaskId task) {
+    return TASKS[static_cast<size_t>(task)];
+}
+
+#ifdef CONFIG_ARDUINO_RUNNING_CORE
+static_assert(CONFIG_ARDUINO_RUNNING_CORE == taskConfig(TaskId::Loop).core, "loop() fora do núcleo da tabela");
+#endif
+#ifdef CONFIG_ARDUINO_LOOP_STACK_SIZE
+static_assert(CONFIG_ARDUINO_LOOP_STACK_SIZE == taskConfig(TaskId::Loop).stackBytes, "Pilha do loop() difere da tabela");
+#endif
+#ifdef CONFIG_ASYNC_TCP_RUNNING_CORE
+static_assert(CONFIG_ASYNC_TCP_RUNNING_CORE == taskConfig(TaskId::AsyncTcp).core,
+              "CONFIG_ASYNC_TCP_RUNNING_CORE (platformio.ini) difere da tabela");
+static_assert(CONFIG_ASYNC_TCP_PRIORITY == taskConfig(TaskId::AsyncTcp).priority,
+              "CONFIG_ASYNC_TCP_PRIORITY (platformio.ini) difere da tabela");
+static_assert(CONFIG_ASYNC_TCP_STACK_SIZE == taskConfig(TaskId::AsyncTcp).stackBytes,
+              "CONFIG_ASYNC_TCP_STACK_SIZE (platformio.ini) difere da tabela");
+#endif
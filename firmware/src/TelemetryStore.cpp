@@ -0,0 +1,336 @@
+#include "TelemetryStore.h"
+#include "Crc32.h"
+
+#include <algorithm>
+
+static const uint16_t BLOCK_MAGIC = 0x4254;   // "TB"
+static const uint8_t FORMAT_VERSION = 1;
+static const size_t CRC_OFFSET = TelemetryStore::BLOCK_SIZE - sizeof(uint32_t);
+
+// Classes de tamanho do delta (instante: delta do delta; valor: delta), em
+// zig-zag: prefixo unário + bits do valor. 0 custa 1 bit.
+struct BitClass {
+    uint8_t prefix;       // bits do prefixo
+    uint8_t prefixValue;
+    uint8_t valueBits;
+};
+static const BitClass BIT_CLASSES[] = {
+    {1, 0b0, 0},
+    {2, 0b10, 5},
+    {3, 0b110, 9},
+    {4, 0b1110, 16},
+    {4, 0b1111, 32},
+};
+static const uint8_t BIT_CLASS_COUNT = sizeof(BIT_CLASSES) / sizeof(BIT_CLASSES[0]);
+
+static uint32_t zigzag(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value) {
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+static const BitClass& classFor(uint32_t zz) {
+    for (uint8_t i = 0; i < BIT_CLASS_COUNT - 1; i++) {
+        if (BIT_CLASSES[i].valueBits == 0 ? zz == 0 : zz < (1UL << BIT_CLASSES[i].valueBits)) return BIT_CLASSES[i];
+    }
+    return BIT_CLASSES[BIT_CLASS_COUNT - 1];
+}
+
+static void writeBits(uint8_t* payload, uint16_t& pos, uint32_t value, uint8_t bits) {
+    for (int8_t i = bits - 1; i >= 0; i--, pos++) {
+        if (value & (1UL << i)) payload[pos >> 3] |= 0x80 >> (pos & 7);
+    }
+}
+
+static uint32_t readBits(const uint8_t* payload, uint16_t& pos, uint8_t bits) {
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < bits; i++, pos++) {
+        value = (value << 1) | ((payload[pos >> 3] >> (7 - (pos & 7))) & 1);
+    }
+    return value;
+}
+
+static void writeClassed(uint8_t* payload, uint16_t& pos, uint32_t zz) {
+    const BitClass& c = classFor(zz);
+    writeBits(payload, pos, c.prefixValue, c.prefix);
+    writeBits(payload, pos, zz, c.valueBits);
+}
+
+static bool readClassed(const uint8_t* payload, uint16_t& pos, uint16_t limit, uint32_t& zz) {
+    uint8_t ones = 0;
+    while (ones < 4) {
+        if (pos >= limit) return false;
+        if (!readBits(payload, pos, 1)) break;
+        ones++;
+    }
+    const BitClass& c = BIT_CLASSES[ones];
+    if (pos + c.valueBits > limit) return false;
+    zz = readBits(payload, pos, c.valueBits);
+    return true;
+}
+
+static TelemetryBlockHeader* headerOf(uint8_t* data) {
+    return reinterpret_cast<TelemetryBlockHeader*>(data);
+}
+
+void TelemetryStore::segmentPath(uint8_t slot, char* path, size_t len) {
+    snprintf(path, len, "/tlm%02u.bin", slot);
+}
+
+bool TelemetryStore::begin(fs::FS& fs) {
+    _fs = &fs;
+    uint32_t newest = 0;
+    size_t newestSize = 0;
+    char path[16];
+    for (uint8_t slot = 0; slot < MAX_SEGMENTS; slot++) {
+        _slotSequence[slot] = 0;
+        segmentPath(slot, path, sizeof(path));
+        if (!fs.exists(path)) continue;
+        File file = fs.open(path, FILE_READ);
+        TelemetryBlockHeader header;
+        size_t size = file ? file.size() : 0;
+        bool valid = file && file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+                     header.magic == BLOCK_MAGIC && header.version == FORMAT_VERSION && header.segment != 0;
+        file.close();
+        if (!valid) {
+            fs.remove(path);
+            continue;
+        }
+        _slotSequence[slot] = header.segment;
+        if (header.segment > newest) {
+            newest = header.segment;
+            newestSize = size;
+            _currentSlot = slot;
+        }
+    }
+    // Continua o segmento mais novo; com final rasgado (queda no meio de uma
+    // escrita) abre outro, para os blocos seguintes ficarem alinhados
+    _currentBlocks = newest != 0 && newestSize % BLOCK_SIZE == 0 ? newestSize / BLOCK_SIZE : SEGMENT_BLOCKS;
+    for (OpenBlock& block : _blocks) headerOf(block.data)->count = 0;
+    return true;
+}
+
+void TelemetryStore::end() {
+    _fs = nullptr;
+    for (OpenBlock& block : _blocks) headerOf(block.data)->count = 0;
+}
+
+void TelemetryStore::add(uint8_t series, uint32_t t, int32_t value) {
+    if (!_fs || series >= MAX_SERIES) return;
+    OpenBlock& block = _blocks[series];
+    TelemetryBlockHeader* header = headerOf(block.data);
+    if (header->count == 0) {
+        start(block, series, t, value);
+        return;
+    }
+    if (t < header->lastTime) return;
+    if (!append(block, t, value)) {
+        seal(block);
+        start(block, series, t, value);
+    }
+}
+
+void TelemetryStore::start(OpenBlock& block, uint8_t series, uint32_t t, int32_t value) {
+    memset(block.data, 0, sizeof(block.data));
+    TelemetryBlockHeader* header = headerOf(block.data);
+    header->magic = BLOCK_MAGIC;
+    header->series = series;
+    header->version = FORMAT_VERSION;
+    header->count = 1;
+    header->firstTime = t;
+    header->lastTime = t;
+    header->firstValue = value;
+    block.bitPos = 0;
+    block.lastDelta = 0;
+    block.lastValue = value;
+    block.openedAt = t;
+}
+
+bool TelemetryStore::append(OpenBlock& block, uint32_t t, int32_t value) {
+    TelemetryBlockHeader* header = headerOf(block.data);
+    // Aritmética modular: a decodificação soma de volta com o mesmo wrap
+    int32_t delta = static_cast<int32_t>(t - header->lastTime);
+    uint32_t timeZz = zigzag(static_cast<int32_t>(static_cast<uint32_t>(delta) - static_cast<uint32_t>(block.lastDelta)));
+    uint32_t valueZz = zigzag(static_cast<int32_t>(static_cast<uint32_t>(value) - static_cast<uint32_t>(block.lastValue)));
+    const BitClass& timeClass = classFor(timeZz);
+    const BitClass& valueClass = classFor(valueZz);
+    uint16_t needed = timeClass.prefix + timeClass.valueBits + valueClass.prefix + valueClass.valueBits;
+    if (block.bitPos + needed > PAYLOAD_BYTES * 8 || header->count == UINT16_MAX) return false;
+
+    uint8_t* payload = block.data + sizeof(TelemetryBlockHeader);
+    writeClassed(payload, block.bitPos, timeZz);
+    writeClassed(payload, block.bitPos, valueZz);
+    header->count++;
+    header->bits = block.bitPos;
+    header->lastTime = t;
+    block.lastDelta = delta;
+    block.lastValue = value;
+    return true;
+}
+
+void TelemetryStore::seal(OpenBlock& block) {
+    TelemetryBlockHeader* header = headerOf(block.data);
+    if (header->count == 0 || !_fs) return;
+    uint16_t count = header->count;
+    if (writeBlock(block.data)) {
+        _blocksWritten++;
+        _samplesWritten += count;
+    }
+    header->count = 0;
+}
+
+void TelemetryStore::poll(uint32_t now) {
+    for (OpenBlock& block : _blocks) {
+        if (headerOf(block.data)->count > 0 && now - block.openedAt >= MAX_BLOCK_AGE_S) seal(block);
+    }
+}
+
+void TelemetryStore::flush() {
+    for (OpenBlock& block : _blocks) seal(block);
+}
+
+bool TelemetryStore::writeBlock(const uint8_t* data) {
+    uint8_t block[BLOCK_SIZE];
+    memcpy(block, data, BLOCK_SIZE);
+    char path[16];
+    // Uma nova tentativa depois de liberar espaço (partição cheia)
+    for (uint8_t attempt = 0; attempt < 2; attempt++) {
+        if (_currentBlocks >= SEGMENT_BLOCKS && !openNextSegment()) return false;
+        headerOf(block)->segment = _slotSequence[_currentSlot];
+        uint32_t crc = crc32Update(0, block, CRC_OFFSET);
+        memcpy(block + CRC_OFFSET, &crc, sizeof(crc));
+
+        segmentPath(_currentSlot, path, sizeof(path));
+        File file = _fs->open(path, FILE_APPEND);
+        size_t written = file ? file.write(block, BLOCK_SIZE) : 0;
+        file.close();
+        if (written == BLOCK_SIZE) {
+            _currentBlocks++;
+            return true;
+        }
+        _writeErrors++;
+        // Final rasgado: os próximos blocos vão para outro segmento
+        _currentBlocks = SEGMENT_BLOCKS;
+        if (!dropOldestSegment()) return false;
+    }
+    return false;
+}
+
+bool TelemetryStore::openNextSegment() {
+    uint32_t newest = 0;
+    for (uint8_t slot = 0; slot < MAX_SEGMENTS; slot++) {
+        if (_slotSequence[slot] > newest) {
+            newest = _slotSequence[slot];
+            _currentSlot = slot;
+        }
+    }
+    uint8_t slot = newest == 0 ? 0 : (_currentSlot + 1) % MAX_SEGMENTS;
+    char path[16];
+    segmentPath(slot, path, sizeof(path));
+    if (_slotSequence[slot] != 0) _segmentsDropped++;
+    if (_fs->exists(path) && !_fs->remove(path)) return false;
+    _slotSequence[slot] = newest + 1;
+    _currentSlot = slot;
+    _currentBlocks = 0;
+    return true;
+}
+
+bool TelemetryStore::dropOldestSegment() {
+    uint8_t oldest = MAX_SEGMENTS;
+    for (uint8_t slot = 0; slot < MAX_SEGMENTS; slot++) {
+        if (slot == _currentSlot || _slotSequence[slot] == 0) continue;
+        if (oldest == MAX_SEGMENTS || _slotSequence[slot] < _slotSequence[oldest]) oldest = slot;
+    }
+    if (oldest == MAX_SEGMENTS) return false;
+    char path[16];
+    segmentPath(oldest, path, sizeof(path));
+    _fs->remove(path);
+    _slotSequence[oldest] = 0;
+    _segmentsDropped++;
+    return true;
+}
+
+// --- Leitura ---
+
+TelemetryReader::TelemetryReader(const TelemetryStore& store, uint32_t from, uint32_t to, uint32_t seriesMask)
+    : _store(store), _from(from), _to(to), _seriesMask(seriesMask) {
+    for (uint8_t slot = 0; slot < TelemetryStore::MAX_SEGMENTS; slot++) {
+        if (store.segmentSequence(slot) != 0) _order[_segments++] = slot;
+    }
+    std::sort(_order, _order + _segments,
+              [&](uint8_t a, uint8_t b) { return store.segmentSequence(a) < store.segmentSequence(b); });
+}
+
+bool TelemetryReader::openNextSegment() {
+    if (!_store.fs()) return false;
+    while (_nextSegment < _segments) {
+        char path[16];
+        TelemetryStore::segmentPath(_order[_nextSegment++], path, sizeof(path));
+        _file = _store.fs()->open(path, FILE_READ);
+        if (_file) return true;
+    }
+    return false;
+}
+
+bool TelemetryReader::loadBlock() {
+    while (true) {
+        if (!_file && !openNextSegment()) return false;
+        // Só blocos inteiros: um final rasgado encerra o arquivo
+        if (_file.read(_block, TelemetryStore::BLOCK_SIZE) != TelemetryStore::BLOCK_SIZE) {
+            _file.close();
+            _file = File();
+            continue;
+        }
+        const TelemetryBlockHeader* header = reinterpret_cast<const TelemetryBlockHeader*>(_block);
+        uint32_t crc;
+        memcpy(&crc, _block + CRC_OFFSET, sizeof(crc));
+        if (header->magic != BLOCK_MAGIC || header->version != FORMAT_VERSION || header->count == 0 ||
+            header->bits > TelemetryStore::PAYLOAD_BYTES * 8 || crc32Update(0, _block, CRC_OFFSET) != crc) {
+            _corruptBlocks++;
+            continue;
+        }
+        if (header->series >= 32 || !(_seriesMask & (1UL << header->series))) continue;
+        if (header->firstTime > _to || header->lastTime < _from) continue;
+
+        _remaining = header->count;
+        _bitPos = 0;
+        _t = header->firstTime;
+        _value = header->firstValue;
+        _delta = 0;
+        _first = true;
+        return true;
+    }
+}
+
+bool TelemetryReader::next(TelemetrySample& sample) {
+    while (true) {
+        if (_remaining == 0 && !loadBlock()) return false;
+        const TelemetryBlockHeader* header = reinterpret_cast<const TelemetryBlockHeader*>(_block);
+        if (!_first) {
+            const uint8_t* payload = _block + sizeof(TelemetryBlockHeader);
+            uint32_t timeZz, valueZz;
+            if (!readClassed(payload, _bitPos, header->bits, timeZz) ||
+                !readClassed(payload, _bitPos, header->bits, valueZz)) {
+                _corruptBlocks++;
+                _remaining = 0;
+                continue;
+            }
+            _delta = static_cast<int32_t>(static_cast<uint32_t>(_delta) + static_cast<uint32_t>(unzigzag(timeZz)));
+            _t += static_cast<uint32_t>(_delta);
+            _value = static_cast<int32_t>(static_cast<uint32_t>(_value) + static_cast<uint32_t>(unzigzag(valueZz)));
+        }
+        _first = false;
+        _remaining--;
+        if (_t > _to) {
+            _remaining = 0;   // o resto do bloco é ainda mais novo
+            continue;
+        }
+        if (_t < _from) continue;
+        sample.series = header->series;
+        sample.t = _t;
+        sample.value = _value;
+        return true;
+    }
+}
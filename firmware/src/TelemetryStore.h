@@ -0,0 +1,130 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+// --- Telemetria persistida na SPIFFS, comprimida ---
+// Cada série (sondas, luminosidade, bombas) enche um bloco de 256 bytes em
+// RAM; só o bloco cheio vai para a flash, numa escrita de uma página, sempre
+// no fim do arquivo. Dentro do bloco, o instante vai como delta do delta
+// (amostras periódicas custam 1 bit) e o valor, inteiro em ponto fixo, como
+// delta em zig-zag com prefixo de tamanho variável (valor repetido = 1 bit).
+// O bloco leva cabeçalho com a primeira amostra e CRC32: cada um é decodificado
+// sozinho e um bloco corrompido perde só as próprias amostras.
+// Os blocos vão para segmentos de SEGMENT_BLOCKS blocos em MAX_SEGMENTS
+// arquivos fixos (/tlm00.bin ...) usados em anel: o segmento mais antigo é
+// apagado quando o anel dá a volta ou quando a partição enche.
+// Instantes em epoch (s): amostras antes do SNTP não são gravadas.
+
+struct TelemetrySample {
+    uint8_t series;
+    uint32_t t;
+    int32_t value;
+};
+
+struct TelemetryBlockHeader {
+    uint16_t magic;
+    uint8_t series;
+    uint8_t version;
+    uint16_t count;       // amostras no bloco (a primeira está no cabeçalho)
+    uint16_t bits;        // bits usados no payload
+    uint32_t segment;     // sequência do segmento: ordena os arquivos
+    uint32_t firstTime;
+    uint32_t lastTime;
+    int32_t firstValue;
+};
+
+static_assert(sizeof(TelemetryBlockHeader) == 24, "TelemetryBlockHeader faz parte do formato em flash");
+
+class TelemetryStore {
+public:
+    static constexpr uint16_t BLOCK_SIZE = 256;   // uma página lógica da SPIFFS
+    static constexpr uint16_t PAYLOAD_BYTES = BLOCK_SIZE - sizeof(TelemetryBlockHeader) - sizeof(uint32_t);
+    static constexpr uint8_t MAX_SERIES = 6;
+    static constexpr uint8_t MAX_SEGMENTS = 32;
+    static constexpr uint16_t SEGMENT_BLOCKS = 64;   // 16 KB por arquivo, 512 KB no total
+    // Bloco aberto há mais que isso vai para a flash mesmo incompleto
+    static constexpr uint32_t MAX_BLOCK_AGE_S = 3600;
+
+    bool begin(fs::FS& fs);
+    // Para de gravar e descarta os blocos em RAM (antes de formatar a SPIFFS)
+    void end();
+
+    // Chamado só pelo loop(); amostras fora de ordem na série são ignoradas
+    void add(uint8_t series, uint32_t t, int32_t value);
+    // Grava blocos abertos há mais de MAX_BLOCK_AGE_S
+    void poll(uint32_t now);
+    // Grava todos os blocos abertos (reinício)
+    void flush();
+
+    static void segmentPath(uint8_t slot, char* path, size_t len);
+    // Sequência do segmento em cada arquivo; 0 = vazio
+    uint32_t segmentSequence(uint8_t slot) const { return _slotSequence[slot]; }
+    fs::FS* fs() const { return _fs; }
+
+    uint32_t blocksWritten() const { return _blocksWritten; }
+    uint32_t samplesWritten() const { return _samplesWritten; }
+    uint32_t segmentsDropped() const { return _segmentsDropped; }
+    uint32_t writeErrors() const { return _writeErrors; }
+
+private:
+    struct OpenBlock {
+        uint8_t data[BLOCK_SIZE];
+        uint16_t bitPos;
+        int32_t lastDelta;     // último delta de tempo
+        int32_t lastValue;
+        uint32_t openedAt;
+    };
+
+    bool append(OpenBlock& block, uint32_t t, int32_t value);
+    void start(OpenBlock& block, uint8_t series, uint32_t t, int32_t value);
+    void seal(OpenBlock& block);
+    bool writeBlock(const uint8_t* data);
+    bool openNextSegment();
+    bool dropOldestSegment();
+
+    fs::FS* _fs = nullptr;
+    OpenBlock _blocks[MAX_SERIES] = {};
+    uint32_t _slotSequence[MAX_SEGMENTS] = {};
+    uint8_t _currentSlot = 0;
+    uint16_t _currentBlocks = SEGMENT_BLOCKS;   // força um segmento novo na primeira escrita
+    uint32_t _blocksWritten = 0;
+    uint32_t _samplesWritten = 0;
+    uint32_t _segmentsDropped = 0;
+    uint32_t _writeErrors = 0;
+};
+
+// Lê os segmentos do mais antigo ao mais novo, um bloco de cada vez (256 bytes
+// de RAM); blocos sem interseção com [from, to] ou fora de `seriesMask` nem
+// são decodificados. Dentro de uma série as amostras saem em ordem; entre
+// séries, na ordem em que os blocos foram gravados.
+class TelemetryReader {
+public:
+    TelemetryReader(const TelemetryStore& store, uint32_t from, uint32_t to, uint32_t seriesMask = 0xFFFFFFFF);
+
+    bool next(TelemetrySample& sample);
+
+    uint32_t corruptBlocks() const { return _corruptBlocks; }
+
+private:
+    bool loadBlock();
+    bool openNextSegment();
+
+    const TelemetryStore& _store;
+    uint32_t _from;
+    uint32_t _to;
+    uint32_t _seriesMask;
+    uint8_t _order[TelemetryStore::MAX_SEGMENTS];
+    uint8_t _segments = 0;
+    uint8_t _nextSegment = 0;
+    File _file;
+
+    uint8_t _block[TelemetryStore::BLOCK_SIZE];
+    uint16_t _remaining = 0;   // amostras ainda por decodificar no bloco
+    uint16_t _bitPos = 0;
+    uint32_t _t = 0;
+    int32_t _delta = 0;
+    int32_t _value = 0;
+    bool _first = false;
+    uint32_t _corruptBlocks = 0;
+};
@@ -0,0 +1,253 @@
+#include "TemperatureSensor.h"
+
+#include <util/OneWire_direct_gpio.h>
+
+// Comandos de função do DS18B20
+static const uint8_t DS18B20_FAMILY = 0x28;
+static const uint8_t DS18B20_MATCH_ROM = 0x55;
+static const uint8_t DS18B20_CONVERT_T = 0x44;
+static const uint8_t DS18B20_READ_SCRATCHPAD = 0xBE;
+
+// Chave da NVS com os endereços ROM, MAX_PROBES x 8 bytes (zeros = vaga livre)
+static const char* NVS_NAMESPACE = "onewire";
+static const char* NVS_ADDRESSES_KEY = "roms";
+
+// A amostra da presença não pode atrasar: a janela do DS18B20 fecha em 240 µs
+static portMUX_TYPE presenceMux = portMUX_INITIALIZER_UNLOCKED;
+
+TemperatureSensorBus::TemperatureSensorBus(OneWire& wire, uint8_t busPin, DallasTemperature& sensors,
+                                           const TemperatureProbeConfig* config, uint8_t count)
+    : _wire(wire), _pin(busPin), _sensors(sensors), _config(config),
+      _count(count > MAX_PROBES ? MAX_PROBES : count) {}
+
+void TemperatureSensorBus::begin(Preferences& prefs) {
+    _prefs = &prefs;
+    _sensors.setWaitForConversion(false);
+
+    DeviceAddress cached[MAX_PROBES] = {};
+    prefs.begin(NVS_NAMESPACE, true);
+    size_t loaded = prefs.getBytes(NVS_ADDRESSES_KEY, cached, sizeof(cached));
+    prefs.end();
+
+    uint8_t known = 0;
+    if (loaded == sizeof(cached)) {
+        for (uint8_t i = 0; i < _count; i++) {
+            if (cached[i][0] != DS18B20_FAMILY || OneWire::crc8(cached[i], 7) != cached[i][7]) continue;
+            memcpy(_slots[i].address, cached[i], sizeof(DeviceAddress));
+            _slots[i].present = true;
+            known++;
+        }
+        Serial.printf("🔄 %d sondas de temperatura carregadas da NVS\n", known);
+    }
+
+    // Só varre o barramento se faltar alguma sonda; com a NVS completa o boot não faz SEARCH ROM
+    if (known < _count) scanBus();
+
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_slots[i].present) applyResolution(i);
+    }
+}
+
+bool TemperatureSensorBus::scanBus() {
+    DeviceAddress found[MAX_PROBES];
+    bool seen[MAX_PROBES] = {false};
+    uint8_t foundCount = 0;
+    DeviceAddress address;
+
+    _wire.reset_search();
+    while (foundCount < MAX_PROBES && _wire.search(address)) {
+        if (address[0] != DS18B20_FAMILY || OneWire::crc8(address, 7) != address[7]) continue;
+        memcpy(found[foundCount++], address, sizeof(DeviceAddress));
+    }
+
+    bool changed = false;
+    // Sondas já cadastradas mantêm a vaga: o papel (entrada, saída...) segue o endereço
+    for (uint8_t f = 0; f < foundCount; f++) {
+        for (uint8_t i = 0; i < _count; i++) {
+            if (_slots[i].present && memcmp(_slots[i].address, found[f], sizeof(DeviceAddress)) == 0) {
+                seen[i] = true;
+                found[f][0] = 0;
+                break;
+            }
+        }
+    }
+    // Sondas novas ocupam vagas livres e, na falta delas, vagas cujas sondas sumiram
+    for (uint8_t f = 0; f < foundCount; f++) {
+        if (found[f][0] == 0) continue;
+        int target = -1;
+        for (uint8_t i = 0; i < _count && target < 0; i++) {
+            if (!_slots[i].present) target = i;
+        }
+        for (uint8_t i = 0; i < _count && target < 0; i++) {
+            if (!seen[i]) target = i;
+        }
+        if (target < 0) {
+            Serial.println("❌ Sonda extra no barramento 1-Wire ignorada (todas as vagas ocupadas)");
+            continue;
+        }
+        memcpy(_slots[target].address, found[f], sizeof(DeviceAddress));
+        _slots[target].present = true;
+        _readings[target] = TemperatureReading();
+        seen[target] = true;
+        changed = true;
+        Serial.printf("🌡️ Nova sonda em '%s'\n", _config[target].name);
+        applyResolution(target);
+    }
+
+    if (changed) saveAddresses();
+    if (foundCount == 0) Serial.println("❌ Nenhum DS18B20 encontrado no barramento 1-Wire");
+    return changed;
+}
+
+void TemperatureSensorBus::saveAddresses() {
+    if (!_prefs) return;
+    DeviceAddress addresses[MAX_PROBES] = {};
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_slots[i].present) memcpy(addresses[i], _slots[i].address, sizeof(DeviceAddress));
+    }
+    _prefs->begin(NVS_NAMESPACE, false);
+    _prefs->putBytes(NVS_ADDRESSES_KEY, addresses, sizeof(addresses));
+    _prefs->end();
+    Serial.println("💾 Endereços das sondas salvos na NVS");
+}
+
+void TemperatureSensorBus::applyResolution(uint8_t probe) {
+    // Só escreve se mudou: a biblioteca copia o scratchpad para a EEPROM do sensor
+    uint8_t resolution = _config[probe].resolution;
+    if (_sensors.getResolution(_slots[probe].address) != resolution) {
+        _sensors.setResolution(_slots[probe].address, resolution);
+    }
+}
+
+bool TemperatureSensorBus::startNextDue(unsigned long now) {
+    for (uint8_t n = 0; n < _count; n++) {
+        uint8_t i = (_nextCandidate + n) % _count;
+        Slot& slot = _slots[i];
+        if (!slot.present) continue;
+        if (slot.lastRequest != 0 && now - slot.lastRequest < _config[i].periodMs) continue;
+        slot.lastRequest = now ? now : 1;
+        _current = i;
+        _nextCandidate = (i + 1) % _count;
+        beginTransaction(DS18B20_CONVERT_T, 0);
+        _lastCompletionPoll = now;
+        _state = State::StartConversion;
+        return true;
+    }
+    return false;
+}
+
+bool TemperatureSensorBus::poll(unsigned long now) {
+    switch (_state) {
+    case State::Idle:
+        if (_rescanRequested.exchange(false, std::memory_order_relaxed)) {
+            scanBus();
+            return false;
+        }
+        startNextDue(now);
+        return false;
+
+    case State::StartConversion:
+        if (!stepTransaction()) return false;
+        if (!_presence) {
+            finishReading(false, 0, now);
+            return true;
+        }
+        _deadline = now + DallasTemperature::millisToWaitForConversion(_config[_current].resolution);
+        _state = State::Converting;
+        return false;
+
+    case State::Converting:
+        if ((long)(now - _deadline) < 0) {
+            if (now - _lastCompletionPoll < COMPLETION_POLL_INTERVAL_MS) return false;
+            _lastCompletionPoll = now;
+            // Um único read slot: o sensor devolve 1 quando terminou a conversão
+            if (!_wire.read_bit()) return false;
+        }
+        beginTransaction(DS18B20_READ_SCRATCHPAD, sizeof(_rx));
+        _state = State::ReadScratchpad;
+        return false;
+
+    case State::ReadScratchpad: {
+        if (!stepTransaction()) return false;
+        float celsius = 0;
+        bool valid = _presence && decodeScratchpad(celsius);
+        finishReading(valid, celsius, now);
+        return true;
+    }
+    }
+    return false;
+}
+
+void TemperatureSensorBus::beginTransaction(uint8_t command, uint8_t readLength) {
+    _tx[0] = DS18B20_MATCH_ROM;
+    memcpy(&_tx[1], _slots[_current].address, sizeof(DeviceAddress));
+    _tx[9] = command;
+    _txLength = sizeof(_tx);
+    _txPos = 0;
+    _rxLength = readLength;
+    _rxPos = 0;
+    _reset = ResetStep::DriveLow;
+}
+
+// Executa um único passo da transação; retorna true quando ela terminou
+bool TemperatureSensorBus::stepTransaction() {
+    switch (_reset) {
+    case ResetStep::DriveLow:
+        digitalWrite(_pin, LOW);
+        pinMode(_pin, OUTPUT);
+        _resetAt = micros();
+        _reset = ResetStep::SamplePresence;
+        return false;
+    case ResetStep::SamplePresence:
+        if (micros() - _resetAt < RESET_LOW_US) return false;
+        // Registradores direto, como a OneWire nas suas seções críticas:
+        // pinMode() passa pelo gpio_config(), que loga e pega travas
+        portENTER_CRITICAL(&presenceMux);
+        DIRECT_MODE_INPUT(PIN_TO_BASEREG(_pin), PIN_TO_BITMASK(_pin));   // o pull-up externo solta a linha
+        delayMicroseconds(PRESENCE_SAMPLE_US);
+        _presence = !DIRECT_READ(PIN_TO_BASEREG(_pin), PIN_TO_BITMASK(_pin));
+        portEXIT_CRITICAL(&presenceMux);
+        _resetAt = micros();
+        _reset = ResetStep::Recovery;
+        return false;
+    case ResetStep::Recovery:
+        if (micros() - _resetAt < RESET_RECOVERY_US) return false;
+        _reset = ResetStep::Done;
+        if (!_presence) return true; // sem pulso de presença não há o que transmitir
+        break;
+    case ResetStep::Done:
+        break;
+    }
+    if (_txPos < _txLength) {
+        _wire.write(_tx[_txPos++]);
+        return _txPos == _txLength && _rxLength == 0;
+    }
+    if (_rxPos < _rxLength) {
+        _rx[_rxPos++] = _wire.read();
+    }
+    return _rxPos >= _rxLength;
+}
+
+bool TemperatureSensorBus::decodeScratchpad(float& celsius) {
+    if (OneWire::crc8(_rx, 8) != _rx[8]) return false;
+    int16_t raw = (int16_t)((_rx[1] << 8) | _rx[0]);
+    // Bits menos significativos são indefinidos abaixo de 12 bits
+    raw &= ~((1 << (12 - _config[_current].resolution)) - 1);
+    celsius = raw / 16.0f;
+    return true;
+}
+
+void TemperatureSensorBus::finishReading(bool valid, float celsius, unsigned long now) {
+    TemperatureReading& reading = _readings[_current];
+    _state = State::Idle;
+    _lastCompleted = _current;
+    if (valid) {
+        reading.celsius = celsius;
+        reading.timestamp = now;
+        reading.errors = 0;
+        reading.valid = true;
+    } else if (reading.errors < 255 && ++reading.errors >= MAX_CONSECUTIVE_ERRORS) {
+        // O endereço continua na vaga: sondas desconectadas voltam sem nova varredura
+        reading.valid = false;
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <Arduino.h>
+#include <OneWire.h>
+#include <DallasTemperature.h>
+#include <Preferences.h>
+#include <atomic>
+
+// --- Barramento 1-Wire com vários DS18B20 ---
+// Os endereços ROM são descobertos no boot (SEARCH ROM) e guardados na NVS;
+// daí em diante cada sonda é endereçada direto por MATCH ROM, com resolução e
+// período de amostragem próprios. A conversão é disparada sem esperar e o
+// scratchpad só é lido numa iteração posterior do loop(), quando o sensor
+// sinaliza fim de conversão ou o prazo da resolução expira. As transações
+// também são fatiadas: cada poll() executa no máximo um passo do reset, um byte
+// escrito ou um byte lido. O reset vai direto no pino, em três passos (linha em
+// 0, soltura com a amostra da presença, recuperação), para que os 480 µs do
+// pulso corram entre duas chamadas; o passo mais longo é um byte (~560 µs).
+// Uma vaga sem sonda fica vazia até o próximo boot ou requestRescan(): a
+// varredura bloqueia o barramento por dezenas de ms.
+
+struct TemperatureProbeConfig {
+    const char* name;
+    uint8_t resolution;       // 9 a 12 bits
+    unsigned long periodMs;   // intervalo entre leituras
+};
+
+// Última leitura de cada sonda; lida pelo broadcast sem tocar no barramento
+struct TemperatureReading {
+    float celsius = DEVICE_DISCONNECTED_C;
+    unsigned long timestamp = 0;  // millis() da última leitura válida
+    uint8_t errors = 0;           // falhas consecutivas
+    bool valid = false;
+};
+
+class TemperatureSensorBus {
+public:
+    static constexpr uint8_t MAX_PROBES = 4;
+
+    // `busPin` é o pino do `wire`: o reset fatiado é feito nele, sem a OneWire
+    TemperatureSensorBus(OneWire& wire, uint8_t busPin, DallasTemperature& sensors,
+                         const TemperatureProbeConfig* config, uint8_t count);
+
+    // Carrega os endereços da NVS (ou varre o barramento) e aplica as resoluções
+    void begin(Preferences& prefs);
+
+    // Avança a máquina de estados; retorna true quando uma leitura foi concluída
+    // (o índice da sonda fica em lastCompletedProbe())
+    bool poll(unsigned long now);
+
+    // Pede uma nova varredura (sonda trocada ou acrescentada). Pode vir de outra
+    // tarefa; roda no próximo poll() sem transação, num passo só
+    void requestRescan() { _rescanRequested.store(true, std::memory_order_relaxed); }
+
+    uint8_t probeCount() const { return _count; }
+    uint8_t lastCompletedProbe() const { return _lastCompleted; }
+    bool isPresent(uint8_t probe) const { return probe < _count && _slots[probe].present; }
+    const char* name(uint8_t probe) const { return _config[probe].name; }
+    const TemperatureReading& reading(uint8_t probe) const { return _readings[probe]; }
+
+private:
+    enum class State : uint8_t { Idle, StartConversion, Converting, ReadScratchpad };
+    enum class ResetStep : uint8_t { DriveLow, SamplePresence, Recovery, Done };
+
+    // Tempos do pulso de reset do 1-Wire (modo padrão)
+    static constexpr unsigned long RESET_LOW_US = 480;        // linha em 0
+    static constexpr unsigned long PRESENCE_SAMPLE_US = 70;   // da soltura até a amostra
+    static constexpr unsigned long RESET_RECOVERY_US = 410;   // resto da janela de presença
+
+    // Intervalo mínimo entre consultas ao bit de fim de conversão
+    static constexpr unsigned long COMPLETION_POLL_INTERVAL_MS = 20;
+    // Falhas seguidas até a leitura da sonda ser marcada como inválida
+    static constexpr uint8_t MAX_CONSECUTIVE_ERRORS = 3;
+
+    struct Slot {
+        DeviceAddress address;
+        bool present;               // endereço conhecido (NVS ou varredura)
+        unsigned long lastRequest;
+    };
+
+    bool scanBus();
+    void saveAddresses();
+    void applyResolution(uint8_t probe);
+    bool startNextDue(unsigned long now);
+
+    void beginTransaction(uint8_t command, uint8_t readLength);
+    bool stepTransaction();
+    bool decodeScratchpad(float& celsius);
+    void finishReading(bool valid, float celsius, unsigned long now);
+
+    OneWire& _wire;
+    uint8_t _pin;
+    DallasTemperature& _sensors;
+    const TemperatureProbeConfig* _config;
+    uint8_t _count;
+    Preferences* _prefs = nullptr;
+
+    Slot _slots[MAX_PROBES] = {};
+    TemperatureReading _readings[MAX_PROBES];
+    uint8_t _current = 0;         // sonda da transação em andamento
+    uint8_t _nextCandidate = 0;   // rodízio entre sondas vencidas ao mesmo tempo
+    uint8_t _lastCompleted = 0;
+    std::atomic<bool> _rescanRequested{false};
+    State _state = State::Idle;
+
+    // Transação em andamento: reset, MATCH ROM + endereço + comando, leitura
+    uint8_t _tx[10] = {0};
+    uint8_t _txLength = 0;
+    uint8_t _txPos = 0;
+    uint8_t _rx[9] = {0};
+    uint8_t _rxLength = 0;
+    uint8_t _rxPos = 0;
+    ResetStep _reset = ResetStep::DriveLow;
+    unsigned long _resetAt = 0;   // micros() do último passo do reset
+    bool _presence = false;
+
+    unsigned long _deadline = 0;
+    unsigned long _lastCompletionPoll = 0;
+};
@@ -0,0 +1,283 @@
+#include "WifiConnection.h"
+
+static const char* CREDS_NAMESPACE = "wifi-creds";
+static const char* CACHE_NAMESPACE = "wifi-cache";
+static const char* CACHE_SSID_KEY = "ssid";
+static const char* CACHE_BSSID_KEY = "bssid";
+static const char* CACHE_CHANNEL_KEY = "channel";
+
+static const char* stateName(WifiConnection::State state) {
+    switch (state) {
+    case WifiConnection::State::AccessPointOnly: return "ap_only";
+    case WifiConnection::State::Connecting: return "connecting";
+    case WifiConnection::State::Connected: return "connected";
+    case WifiConnection::State::Backoff: return "backoff";
+    }
+    return "unknown";
+}
+
+void WifiConnection::begin(const char* apSsid, const char* apPassword, ConnectedCallback onConnected) {
+    _apSsid = apSsid;
+    _apPassword = apPassword;
+    _onConnected = onConnected;
+
+    _prefs.begin(CREDS_NAMESPACE, true);
+    _ssid = _prefs.getString("wifi_ssid", "");
+    _password = _prefs.getString("wifi_pass", "");
+    _prefs.end();
+    _hasCredentials = _ssid.length() > 0;
+
+    // Quem reconecta é a máquina de estados (com backoff), não o driver;
+    // e nada de gravar a configuração do rádio na flash a cada begin()
+    WiFi.persistent(false);
+    WiFi.setAutoReconnect(false);
+    WiFi.onEvent([this](WiFiEvent_t event, WiFiEventInfo_t info) { onEvent(event, info); });
+
+    if (!hasCredentials()) {
+        Serial.println("📝 Nenhuma credencial WiFi salva encontrada.");
+        _state = State::AccessPointOnly;
+        startAccessPoint();
+        return;
+    }
+
+    loadCache();
+    WiFi.mode(WIFI_STA);
+    _outageStart = millis() | 1;   // sem rede desde o boot
+    startAttempt(millis());
+}
+
+// Roda na tarefa de eventos do WiFi: só registra, quem decide é loop()
+void WifiConnection::onEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+    if (event != ARDUINO_EVENT_WIFI_STA_DISCONNECTED) return;
+    uint8_t reason = info.wifi_sta_disconnected.reason;
+    // Eco do nosso próprio disconnect(): chega depois do begin() seguinte e
+    // seria contado como falha da tentativa nova
+    if (reason == WIFI_REASON_ASSOC_LEAVE && _leaving.exchange(false)) return;
+    _lastReason = reason;
+    _eventDisconnected = true;
+}
+
+void WifiConnection::leave() {
+    _leaving = true;
+    WiFi.disconnect();
+}
+
+void WifiConnection::loop(unsigned long now) {
+    if (_state == State::AccessPointOnly) return;
+
+    // O evento só diz que algo aconteceu; o nível (status()) diz como o enlace
+    // está agora. Conexão e queda podem chegar juntas entre duas voltas
+    bool disconnected = _eventDisconnected.exchange(false);
+    bool up = WiFi.status() == WL_CONNECTED;
+
+    switch (_state) {
+    case State::Connecting:
+        if (up) {
+            handleConnected(now);
+        } else if (disconnected) {
+            handleFailure(now, _lastReason);
+        } else if (now - _attemptStart >= CONNECT_TIMEOUT_MS) {
+            leave();
+            handleFailure(now, WIFI_REASON_CONNECTION_FAIL);
+        }
+        break;
+
+    case State::Connected:
+        if (!up) {
+            _disconnects++;
+            _outageStart = now | 1;
+            Serial.printf("📴 WiFi caiu (motivo %u), reconectando...\n", _lastReason.load());
+            _failures = 0;
+            startAttempt(now);   // primeira tentativa imediata, pelo cache
+        } else if (_apActive && now - _connectedAt >= AP_STOP_AFTER_MS) {
+            stopAccessPoint();
+        }
+        break;
+
+    case State::Backoff:
+        if (up) {
+            handleConnected(now);   // a tentativa anterior conectou depois de dada como falha
+        } else if ((long)(now - _retryAt) >= 0) {
+            startAttempt(now);
+        }
+        break;
+
+    case State::AccessPointOnly:
+        break;
+    }
+}
+
+void WifiConnection::setCredentials(const String& ssid, const String& password) {
+    std::lock_guard<std::mutex> guard(_lock);
+    _pendingSsid = ssid;
+    _pendingPassword = password;
+    _pending = true;
+}
+
+void WifiConnection::applyCredentials(unsigned long now) {
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        if (!_pending) return;
+        _pending = false;
+        _ssid = _pendingSsid;
+        _password = _pendingPassword;
+    }
+    _prefs.begin(CREDS_NAMESPACE, false);
+    _prefs.putString("wifi_ssid", _ssid);
+    _prefs.putString("wifi_pass", _password);
+    _prefs.end();
+    _hasCredentials = true;
+    Serial.printf("💾 Credenciais salvas: %s\n", _ssid.c_str());
+
+    // Rede nova: o cache (outro SSID) não serve e a contagem de falhas recomeça.
+    // O AP continua no ar até a estação ficar estável
+    _cacheValid = false;
+    _failures = 0;
+    _lastReason = 0;
+    leave();
+    WiFi.mode(_apActive ? WIFI_AP_STA : WIFI_STA);
+    if (_state == State::Connected) {
+        _disconnects++;
+        _outageStart = now | 1;
+    }
+    startAttempt(now);
+}
+
+void WifiConnection::startAttempt(unsigned long now) {
+    _attempts++;
+    _attemptStart = now;
+    _state = State::Connecting;
+    _eventDisconnected = false;
+
+    // Canal+BSSID conhecidos: associação direta, sem varrer os canais
+    _attemptUsedCache = _cacheValid;
+    if (_attemptUsedCache) {
+        Serial.printf("🔌 Conectando a %s (canal %u, BSSID em cache)\n", _ssid.c_str(), _cachedChannel);
+        WiFi.begin(_ssid.c_str(), _password.c_str(), _cachedChannel, _cachedBssid);
+    } else {
+        Serial.printf("🔌 Conectando à rede WiFi salva: %s\n", _ssid.c_str());
+        WiFi.begin(_ssid.c_str(), _password.c_str());
+    }
+}
+
+void WifiConnection::handleConnected(unsigned long now) {
+    _state = State::Connected;
+    _connectedAt = now;
+    _failures = 0;
+
+    uint32_t elapsed = now - _attemptStart;
+    _lastConnectMs = elapsed;
+    if (_connects++ == 0) _bootConnectMs = now;
+    if (_attemptUsedCache) _fastConnects++;
+    uint32_t outageStart = _outageStart.exchange(0);
+    if (outageStart && _connects > 1) {
+        uint32_t outage = now - outageStart;
+        _lastOutageMs = outage;
+        _totalOutageMs += outage;
+    }
+
+    const uint8_t* bssid = WiFi.BSSID();
+    if (bssid) saveCache(bssid, static_cast<uint8_t>(WiFi.channel()));
+
+    Serial.printf("✅ Conectado à rede WiFi em %lu ms! IP: %s, sinal: %d dBm\n", (unsigned long)elapsed,
+                  WiFi.localIP().toString().c_str(), WiFi.RSSI());
+    if (_onConnected) _onConnected();
+}
+
+void WifiConnection::handleFailure(unsigned long now, uint8_t reason) {
+    // O AP pode ter mudado de canal ou de BSSID: refaz já, com o scan completo
+    if (_attemptUsedCache) {
+        Serial.printf("❌ AP não encontrado no canal em cache (motivo %u), varrendo os canais\n", reason);
+        _cacheValid = false;
+        startAttempt(now);
+        return;
+    }
+
+    _failures++;
+
+    unsigned long delayMs = BACKOFF_MIN_MS << (_failures - 1 < 6 ? _failures - 1 : 6);
+    if (delayMs > BACKOFF_MAX_MS) delayMs = BACKOFF_MAX_MS;
+    delayMs += random(delayMs / 8 + 1);   // espalha as tentativas de vários controladores
+    _retryAt = now + delayMs;
+    _state = State::Backoff;
+
+    Serial.printf("❌ Falha ao conectar (motivo %u), nova tentativa em %lu ms\n", reason, delayMs);
+    if (_failures >= AP_FALLBACK_AFTER_FAILURES && !_apActive) {
+        Serial.println("🔧 Subindo o AP de configuração junto com a estação (AP+STA)...");
+        startAccessPoint();
+    }
+}
+
+void WifiConnection::startAccessPoint() {
+    WiFi.mode(hasCredentials() ? WIFI_AP_STA : WIFI_AP);
+    WiFi.softAP(_apSsid, _apPassword);
+    _apActive = true;
+    Serial.printf("📡 AP Iniciado. SSID: %s\n", _apSsid);
+    Serial.printf("💻 IP: %s\n", WiFi.softAPIP().toString().c_str());
+}
+
+void WifiConnection::stopAccessPoint() {
+    WiFi.softAPdisconnect();
+    WiFi.mode(WIFI_STA);
+    _apActive = false;
+    Serial.println("📡 AP de configuração desligado (estação estável)");
+}
+
+void WifiConnection::loadCache() {
+    _prefs.begin(CACHE_NAMESPACE, true);
+    _cacheValid = _prefs.getString(CACHE_SSID_KEY, "") == _ssid &&
+                  _prefs.getBytes(CACHE_BSSID_KEY, _cachedBssid, sizeof(_cachedBssid)) == sizeof(_cachedBssid);
+    _cachedChannel = _prefs.getUChar(CACHE_CHANNEL_KEY, 0);
+    _prefs.end();
+    if (_cachedChannel == 0) _cacheValid = false;
+}
+
+// Só grava quando o AP mudou: reconexões ao mesmo AP não gastam a NVS
+void WifiConnection::saveCache(const uint8_t* bssid, uint8_t channel) {
+    bool same = _cachedChannel == channel && memcmp(_cachedBssid, bssid, sizeof(_cachedBssid)) == 0;
+    memcpy(_cachedBssid, bssid, sizeof(_cachedBssid));
+    _cachedChannel = channel;
+    _cacheValid = channel != 0;
+    if (same) return;
+
+    _prefs.begin(CACHE_NAMESPACE, false);
+    _prefs.putString(CACHE_SSID_KEY, _ssid);
+    _prefs.putBytes(CACHE_BSSID_KEY, _cachedBssid, sizeof(_cachedBssid));
+    _prefs.putUChar(CACHE_CHANNEL_KEY, _cachedChannel);
+    _prefs.end();
+}
+
+void WifiConnection::toJson(JsonObject out) {
+    State state = _state;
+    out["state"] = stateName(state);
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        out["ssid"] = _ssid;
+    }
+    out["ap_active"] = _apActive.load();
+    if (state == State::Connected) {
+        out["ip"] = WiFi.localIP().toString();
+        out["rssi"] = WiFi.RSSI();
+        out["channel"] = WiFi.channel();
+        const uint8_t* bssid = WiFi.BSSID();
+        if (bssid) {
+            char text[18];
+            snprintf(text, sizeof(text), "%02x:%02x:%02x:%02x:%02x:%02x", bssid[0], bssid[1], bssid[2], bssid[3],
+                     bssid[4], bssid[5]);
+            out["bssid"] = text;
+        }
+    }
+
+    uint32_t now = millis();
+    uint32_t outageStart = _outageStart;
+    out["attempts"] = _attempts.load();
+    out["connects"] = _connects.load();
+    out["fast_connects"] = _fastConnects.load();
+    out["disconnects"] = _disconnects.load();
+    out["last_reason"] = _lastReason.load();
+    out["boot_connect_ms"] = _bootConnectMs.load();
+    out["last_connect_ms"] = _lastConnectMs.load();
+    out["last_outage_ms"] = _lastOutageMs.load();
+    out["total_outage_ms"] = _totalOutageMs.load();
+    out["current_outage_ms"] = outageStart ? now - outageStart : 0;
+}
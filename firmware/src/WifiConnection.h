@@ -0,0 +1,105 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <atomic>
+#include <mutex>
+
+// --- Conexão WiFi em segundo plano ---
+// setup() não espera a rede: begin() dispara a primeira tentativa e retorna.
+// Os eventos do driver (tarefa de eventos do WiFi) só marcam o que aconteceu;
+// a máquina de estados anda em loop(), chamado pela tarefa de rede, e decide
+// pelo WiFi.status() do momento: tentativa -> conectado, ou falha ->
+// espera com backoff exponencial -> nova tentativa. Depois de algumas falhas
+// seguidas o AP de configuração sobe junto (AP+STA), sem reiniciar, e volta a
+// cair quando a rede fica estável de novo. Sem credenciais, só o AP.
+// Canal e BSSID da última conexão ficam na NVS: a tentativa seguinte vai
+// direto ao AP, sem varrer os canais; se ele não estiver mais lá, a próxima
+// volta ao scan completo.
+// Credenciais novas (página de configuração) entram sem reiniciar:
+// setCredentials() guarda, applyCredentials() grava e reconecta, com o AP de
+// configuração ainda no ar até a estação ficar estável.
+
+class WifiConnection {
+public:
+    enum class State : uint8_t { AccessPointOnly, Connecting, Connected, Backoff };
+
+    typedef void (*ConnectedCallback)();
+
+    static constexpr unsigned long CONNECT_TIMEOUT_MS = 15000;  // tentativa sem evento de resposta
+    static constexpr unsigned long BACKOFF_MIN_MS = 1000;
+    static constexpr unsigned long BACKOFF_MAX_MS = 60000;
+    static constexpr uint8_t AP_FALLBACK_AFTER_FAILURES = 3;
+    static constexpr unsigned long AP_STOP_AFTER_MS = 30000;    // STA estável antes de derrubar o AP
+
+    // Lê credenciais e o cache de canal/BSSID da NVS e inicia sem bloquear.
+    // `onConnected` roda na tarefa de rede a cada conexão (ex.: SNTP)
+    void begin(const char* apSsid, const char* apPassword, ConnectedCallback onConnected);
+    void loop(unsigned long now);
+
+    // Handler HTTP: guarda as credenciais para o próximo applyCredentials()
+    void setCredentials(const String& ssid, const String& password);
+    // Tarefa de rede (ação adiada): grava na NVS e reconecta com as novas credenciais
+    void applyCredentials(unsigned long now);
+
+    State state() const { return _state; }
+    bool hasCredentials() const { return _hasCredentials; }
+    bool accessPointActive() const { return _apActive; }
+
+    // Estado e métricas para a API (/api/wifi)
+    void toJson(JsonObject out);
+
+private:
+    void onEvent(WiFiEvent_t event, WiFiEventInfo_t info);
+    void leave();   // WiFi.disconnect() cujo evento de queda não é falha
+    void startAttempt(unsigned long now);
+    void handleConnected(unsigned long now);
+    void handleFailure(unsigned long now, uint8_t reason);
+    void startAccessPoint();
+    void stopAccessPoint();
+    void loadCache();
+    void saveCache(const uint8_t* bssid, uint8_t channel);
+
+    Preferences _prefs;   // instância própria: "wifi-creds" e "wifi-cache"
+    const char* _apSsid = nullptr;
+    const char* _apPassword = nullptr;
+    ConnectedCallback _onConnected = nullptr;
+    std::mutex _lock;     // _ssid (lido pela API) e credenciais pendentes
+    String _ssid;
+    String _password;
+    String _pendingSsid;
+    String _pendingPassword;
+    bool _pending = false;
+    std::atomic<bool> _hasCredentials{false};
+
+    std::atomic<State> _state{State::AccessPointOnly};
+    std::atomic<bool> _apActive{false};
+    unsigned long _attemptStart = 0;
+    unsigned long _retryAt = 0;
+    unsigned long _connectedAt = 0;
+    uint8_t _failures = 0;          // falhas seguidas desde a última conexão
+
+    // Cache de canal/BSSID (só vale para o SSID salvo junto)
+    uint8_t _cachedBssid[6] = {0};
+    uint8_t _cachedChannel = 0;
+    bool _cacheValid = false;
+    bool _attemptUsedCache = false;
+
+    // Marcados pela tarefa de eventos, consumidos em loop() junto com WiFi.status()
+    std::atomic<bool> _eventDisconnected{false};
+    std::atomic<uint8_t> _lastReason{0};
+    std::atomic<bool> _leaving{false};   // disconnect() nosso: o ASSOC_LEAVE que vem dele é ignorado
+
+    // Métricas (lidas pela API na tarefa do AsyncTCP)
+    std::atomic<uint32_t> _attempts{0};
+    std::atomic<uint32_t> _connects{0};
+    std::atomic<uint32_t> _fastConnects{0};
+    std::atomic<uint32_t> _disconnects{0};
+    std::atomic<uint32_t> _bootConnectMs{0};      // boot -> primeiro IP
+    std::atomic<uint32_t> _lastConnectMs{0};      // início da tentativa -> IP
+    std::atomic<uint32_t> _outageStart{0};        // millis() da queda em andamento (0 = sem queda)
+    std::atomic<uint32_t> _lastOutageMs{0};
+    std::atomic<uint32_t> _totalOutageMs{0};
+};
@@ -0,0 +1,129 @@
+#include "WifiScanner.h"
+
+WifiScanner::Reply WifiScanner::request(unsigned long now, uint32_t job, bool refresh, JsonObject out) {
+    std::lock_guard<std::mutex> guard(_lock);
+    bool busy = _requested || _scanning;
+    bool haveResult = _resultJob != 0;
+    bool stale = !haveResult || now - _resultAt >= MAX_AGE_MS;
+
+    if (refresh || stale || job > _resultJob) {
+        if (busy) {
+            _joined++;
+        } else {
+            scheduleLocked(now);
+            busy = true;
+        }
+    }
+
+    if (!haveResult || refresh || job > _resultJob) {
+        out["job"] = _job;
+        out["retry_after_ms"] = RETRY_AFTER_MS;
+        return Reply::Pending;
+    }
+
+    _served++;
+    out["job"] = _resultJob;
+    out["age_ms"] = now - _resultAt;
+    out["scanning"] = busy;
+    JsonArray networks = out["networks"].to<JsonArray>();
+    for (uint8_t i = 0; i < _count; i++) {
+        JsonObject network = networks.add<JsonObject>();
+        network["ssid"] = _networks[i].ssid;
+        network["rssi"] = _networks[i].rssi;
+        network["encryption"] = _networks[i].open ? "open" : "secured";
+    }
+    return Reply::Ready;
+}
+
+void WifiScanner::scheduleLocked(unsigned long now) {
+    _job++;
+    _requested = true;
+    _startAt = now;
+}
+
+void WifiScanner::poll(unsigned long now) {
+    bool start;
+    bool scanning;
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        start = _requested && (long)(now - _startAt) >= 0;
+        scanning = _scanning;
+    }
+
+    if (start) {
+        int16_t result = WiFi.scanNetworks(true);
+        std::lock_guard<std::mutex> guard(_lock);
+        if (result == WIFI_SCAN_FAILED) {
+            _startAt = now + START_RETRY_MS;
+        } else {
+            _requested = false;
+            _scanning = true;
+        }
+        return;
+    }
+
+    if (!scanning) return;
+    int16_t count = WiFi.scanComplete();
+    if (count == WIFI_SCAN_RUNNING) return;
+    if (count < 0) {
+        std::lock_guard<std::mutex> guard(_lock);
+        _scanning = false;
+        _requested = true;
+        _startAt = now + START_RETRY_MS;
+        return;
+    }
+    collect(count, now);
+    WiFi.scanDelete();
+}
+
+// Uma entrada por SSID (o AP mais forte), ordenadas por sinal, sem redes ocultas
+void WifiScanner::collect(int16_t count, unsigned long now) {
+    Network found[MAX_NETWORKS];
+    uint8_t n = 0;
+    for (int16_t i = 0; i < count; i++) {
+        String ssid = WiFi.SSID(i);
+        if (ssid.length() == 0) continue;
+        int8_t rssi = static_cast<int8_t>(WiFi.RSSI(i));
+
+        uint8_t slot = n;
+        for (uint8_t j = 0; j < n; j++) {
+            if (strcmp(found[j].ssid, ssid.c_str()) == 0) {
+                slot = j;
+                break;
+            }
+        }
+        if (slot == n) {
+            if (n < MAX_NETWORKS) {
+                n++;
+            } else {
+                // Lista cheia: substitui a mais fraca, se esta for mais forte
+                slot = 0;
+                for (uint8_t j = 1; j < n; j++) {
+                    if (found[j].rssi < found[slot].rssi) slot = j;
+                }
+                if (found[slot].rssi >= rssi) continue;
+            }
+        } else if (found[slot].rssi >= rssi) {
+            continue;
+        }
+        strncpy(found[slot].ssid, ssid.c_str(), sizeof(found[slot].ssid) - 1);
+        found[slot].ssid[sizeof(found[slot].ssid) - 1] = '\0';
+        found[slot].rssi = rssi;
+        found[slot].open = WiFi.encryptionType(i) == WIFI_AUTH_OPEN;
+    }
+
+    for (uint8_t i = 1; i < n; i++) {
+        Network network = found[i];
+        uint8_t j = i;
+        for (; j > 0 && found[j - 1].rssi < network.rssi; j--) found[j] = found[j - 1];
+        found[j] = network;
+    }
+
+    std::lock_guard<std::mutex> guard(_lock);
+    memcpy(_networks, found, n * sizeof(Network));
+    _count = n;
+    _resultJob = _job;
+    _resultAt = now;
+    _scanning = false;
+    _scans++;
+}
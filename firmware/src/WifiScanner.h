@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <WiFi.h>
+#include <mutex>
+
+// --- Scan de redes WiFi em segundo plano ---
+// O handler HTTP não varre os canais: request() só pede um scan e responde
+// com o último resultado guardado (e a idade dele) ou, se ainda não houver
+// nenhum, com o número do job para o cliente consultar depois. A tarefa de
+// rede chama poll(), que dispara scanNetworks(true) e recolhe o resultado
+// quando pronto.
+// Pedidos simultâneos compartilham o mesmo job: no máximo um scan por vez.
+
+class WifiScanner {
+public:
+    static constexpr uint8_t MAX_NETWORKS = 20;
+    static constexpr unsigned long MAX_AGE_MS = 30000;         // resultado mais velho dispara um scan novo
+    static constexpr unsigned long RETRY_AFTER_MS = 1000;      // sugestão de intervalo de consulta ao cliente
+    static constexpr unsigned long START_RETRY_MS = 1000;      // rádio ocupado (ex.: conectando): tenta de novo
+
+    enum class Reply : uint8_t {
+        Ready,     // `out` tem o resultado (pode estar sendo atualizado em segundo plano)
+        Pending,   // ainda sem resultado para este job: `out` tem job e retry_after_ms
+    };
+
+    // Chamado pelo handler (tarefa do AsyncTCP). `job` = 0 aceita qualquer
+    // resultado guardado; `job` > 0 espera o resultado daquele scan.
+    // `refresh` pede um scan novo mesmo com resultado recente.
+    Reply request(unsigned long now, uint32_t job, bool refresh, JsonObject out);
+
+    // Chamado pela tarefa de rede: inicia o scan pedido e recolhe o resultado
+    void poll(unsigned long now);
+
+    uint32_t scans() const { return _scans; }
+    uint32_t served() const { return _served; }
+    uint32_t joined() const { return _joined; }
+
+private:
+    struct Network {
+        char ssid[33];
+        int8_t rssi;
+        bool open;
+    };
+
+    void collect(int16_t count, unsigned long now);
+    void scheduleLocked(unsigned long now);
+
+    std::mutex _lock;
+    Network _networks[MAX_NETWORKS];
+    uint8_t _count = 0;
+    uint32_t _resultJob = 0;        // job do resultado guardado (0 = nenhum)
+    unsigned long _resultAt = 0;
+    uint32_t _job = 0;              // último job criado
+    bool _requested = false;        // job criado, scan ainda não iniciado
+    bool _scanning = false;
+    unsigned long _startAt = 0;
+
+    uint32_t _scans = 0;            // scans concluídos
+    uint32_t _served = 0;           // respostas com resultado
+    uint32_t _joined = 0;           // pedidos que aproveitaram um job já em andamento
+};
@@ -0,0 +1,119 @@
+#include "WsCommandRouter.h"
+#include "WsProtocol.h"
+
+void WsCommandRouter::begin(ArduinoJson::Allocator* allocator) {
+    _allocator = allocator;
+    _filter.clear();
+    _filter["action"] = true;
+    for (size_t i = 0; i < _count; i++) {
+        for (uint8_t f = 0; f < _commands[i].fieldCount; f++) {
+            _filter[_commands[i].fields[f].name] = true;
+        }
+    }
+}
+
+const WsCommand* WsCommandRouter::find(const char* name) const {
+    const WsCommand* command = _lookup(wsCommandHash(name));
+    // O hash decide; a comparação final só descarta nomes desconhecidos que colidam
+    return command && strcmp(command->name, name) == 0 ? command : nullptr;
+}
+
+const char* WsCommandRouter::validate(const WsCommand& command, JsonObjectConst args, WsCommandError& error) const {
+    for (uint8_t f = 0; f < command.fieldCount; f++) {
+        const WsField& field = command.fields[f];
+        JsonVariantConst value = args[field.name];
+        if (value.isNull()) {
+            if (!field.required) continue;
+            error = WsCommandError::MissingField;
+            return field.name;
+        }
+
+        bool ok = false;
+        switch (field.type) {
+        case WsFieldType::Bool:
+            ok = value.is<bool>();
+            break;
+        case WsFieldType::UInt:
+            ok = value.is<uint32_t>() && value.as<uint32_t>() >= field.min && value.as<uint32_t>() <= field.max;
+            break;
+        case WsFieldType::String:
+            ok = value.is<const char*>();
+            break;
+        }
+        if (!ok) {
+            error = WsCommandError::InvalidField;
+            return field.name;
+        }
+    }
+    return nullptr;
+}
+
+WsCommandResult WsCommandRouter::dispatch(AsyncWebSocketClient* client, const uint8_t* data, size_t len) {
+    WsCommandResult result;
+    JsonDocument doc(_allocator);
+
+    // Uma passada só: "action" e os campos conhecidos; o handler lê os do seu esquema
+    DeserializationError parse = deserializeJson(doc, data, len, DeserializationOption::Filter(_filter));
+    if (parse || !doc.is<JsonObject>()) {
+        result.error = WsCommandError::InvalidJson;
+    } else if (!doc["action"].is<const char*>()) {
+        result.error = WsCommandError::MissingAction;
+    } else if (!(result.command = find(doc["action"].as<const char*>()))) {
+        result.error = WsCommandError::UnknownAction;
+    }
+    if (result.error != WsCommandError::None) {
+        _rejected++;
+        return result;
+    }
+
+    const WsCommand& command = *result.command;
+    JsonObjectConst args = doc.as<JsonObjectConst>();
+    result.field = validate(command, args, result.error);
+    if (!result.field) {
+        result.field = command.handler(client, args);
+        if (result.field) result.error = WsCommandError::InvalidField;
+    }
+    if (result.error != WsCommandError::None) {
+        _rejected++;
+    } else {
+        _dispatched++;
+    }
+    return result;
+}
+
+const char* WsCommandRouter::errorCode(WsCommandError error) {
+    switch (error) {
+    case WsCommandError::None: return "none";
+    case WsCommandError::InvalidJson: return "invalid_json";
+    case WsCommandError::MissingAction: return "missing_action";
+    case WsCommandError::UnknownAction: return "unknown_action";
+    case WsCommandError::MissingField: return "missing_field";
+    case WsCommandError::InvalidField: return "invalid_field";
+    }
+    return "unknown";
+}
+
+void WsCommandRouter::sendError(AsyncWebSocketClient* client, const WsCommandResult& result) {
+    JsonDocument doc(_allocator);
+    doc["action"] = "error";
+    doc["error"] = errorCode(result.error);
+    if (result.command) doc["command"] = result.command->name;
+    if (result.field) doc["field"] = result.field;
+
+    char output[128];
+    size_t len = serializeJson(doc, output, sizeof(output));
+    client->text(output, len);
+}
+
+void WsCommandRouter::sendPackedError(AsyncWebSocketClient* client, const WsCommandResult& result) {
+    JsonDocument doc(_allocator);
+    JsonArray msg = doc.to<JsonArray>();
+    msg.add(WS_MSG_ERROR);
+    msg.add(errorCode(result.error));
+    msg.add(result.command ? result.command->name : nullptr);
+    msg.add(result.field);
+
+    uint8_t output[64];
+    size_t len = serializeMsgPack(doc, output, sizeof(output));
+    client->binary(output, len);
+}
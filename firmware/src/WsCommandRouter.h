@@ -0,0 +1,112 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+
+// --- Despacho dos comandos JSON do WebSocket ---
+// Cada comando é uma linha de tabela: nome, esquema dos campos e handler.
+// O nome vira um hash FNV-1a em tempo de compilação e o comando é escolhido
+// por um switch sobre esse hash (WsCommandLookup, com os rótulos calculados
+// pelo compilador). A mensagem é lida uma única vez, com um
+// DeserializationOption::Filter que é a união de "action" e dos campos de
+// todos os esquemas; o resto do frame é descartado sem alocar. Os campos são
+// validados (presença, tipo e faixa) antes do handler, e qualquer falha volta
+// ao cliente como {"action": "error", ...} em vez de derrubar o controlador.
+// Comando novo = uma linha na tabela e um case no switch.
+
+constexpr uint32_t wsCommandHash(const char* name, uint32_t hash = 2166136261u) {
+    return *name ? wsCommandHash(name + 1, (hash ^ static_cast<uint8_t>(*name)) * 16777619u) : hash;
+}
+
+enum class WsFieldType : uint8_t { Bool, UInt, String };
+
+struct WsField {
+    const char* name;
+    WsFieldType type;
+    bool required;
+    uint32_t min;   // faixa de UInt
+    uint32_t max;
+};
+
+// Retorna nullptr se executou, ou o nome do campo com valor inaceitável
+typedef const char* (*WsCommandHandler)(AsyncWebSocketClient* client, JsonObjectConst args);
+
+struct WsCommand {
+    const char* name;
+    uint32_t hash;
+    const WsField* fields;
+    uint8_t fieldCount;
+    WsCommandHandler handler;
+};
+
+#define WS_COMMAND(name, fields, handler) \
+    WsCommand { name, wsCommandHash(name), fields, sizeof(fields) / sizeof(WsField), handler }
+#define WS_COMMAND_NO_ARGS(name, handler) \
+    WsCommand { name, wsCommandHash(name), nullptr, 0, handler }
+
+// Comando da tabela com este hash, ou nullptr: um switch com case wsCommandHash("nome")
+typedef const WsCommand* (*WsCommandLookup)(uint32_t hash);
+
+// Para static_assert na tabela: dois nomes com o mesmo hash seriam ambíguos
+template <size_t N>
+constexpr bool wsCommandHashesUnique(const WsCommand (&commands)[N], size_t i = 0, size_t j = 1) {
+    return i + 1 >= N   ? true
+           : j >= N     ? wsCommandHashesUnique(commands, i + 1, i + 2)
+           : commands[i].hash == commands[j].hash ? false
+                                                  : wsCommandHashesUnique(commands, i, j + 1);
+}
+
+// Para static_assert: o lookup encontra cada linha da tabela pelo hash dela
+template <size_t N>
+constexpr bool wsCommandLookupMatches(const WsCommand (&commands)[N], WsCommandLookup lookup, size_t i = 0) {
+    return i >= N ? true : lookup(commands[i].hash) == &commands[i] && wsCommandLookupMatches(commands, lookup, i + 1);
+}
+
+enum class WsCommandError : uint8_t {
+    None,
+    InvalidJson,     // frame não é um objeto JSON
+    MissingAction,   // sem "action" (ou não é string)
+    UnknownAction,
+    MissingField,
+    InvalidField,    // tipo ou faixa errados, ou recusado pelo handler
+};
+
+struct WsCommandResult {
+    WsCommandError error = WsCommandError::None;
+    const WsCommand* command = nullptr;
+    const char* field = nullptr;
+};
+
+class WsCommandRouter {
+public:
+    WsCommandRouter(const WsCommand* commands, size_t count, WsCommandLookup lookup)
+        : _commands(commands), _count(count), _lookup(lookup) {}
+
+    // Monta o filtro (união dos esquemas); `allocator` atende os documentos das mensagens
+    void begin(ArduinoJson::Allocator* allocator);
+
+    WsCommandResult dispatch(AsyncWebSocketClient* client, const uint8_t* data, size_t len);
+
+    // Resposta de erro estruturada: {"action":"error","error":código,"command":...,"field":...}
+    void sendError(AsyncWebSocketClient* client, const WsCommandResult& result);
+    // O mesmo erro para clientes MessagePack: [WS_MSG_ERROR, código, comando|nil, campo|nil]
+    void sendPackedError(AsyncWebSocketClient* client, const WsCommandResult& result);
+
+    static const char* errorCode(WsCommandError error);
+
+    uint32_t dispatched() const { return _dispatched; }
+    uint32_t rejected() const { return _rejected; }
+
+private:
+    const WsCommand* find(const char* name) const;
+    const char* validate(const WsCommand& command, JsonObjectConst args, WsCommandError& error) const;
+
+    const WsCommand* _commands;
+    size_t _count;
+    WsCommandLookup _lookup;
+    ArduinoJson::Allocator* _allocator = nullptr;
+    JsonDocument _filter;   // "action" + campos de todos os comandos
+    uint32_t _dispatched = 0;
+    uint32_t _rejected = 0;
+};
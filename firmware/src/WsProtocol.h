@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Arduino.h>
+
+// --- Subprotocolo binário do WebSocket (MessagePack) ---
+// Clientes que pedem WS_MSGPACK_PROTOCOL em Sec-WebSocket-Protocol são
+// atendidos por um segundo AsyncWebSocket no mesmo "/ws" e trocam frames
+// binários; os demais continuam no JSON de texto. Cada mensagem é um array
+// MessagePack: a posição 0 é o tipo e cada campo tem posição fixa, sem chaves
+// textuais nem números formatados como texto.
+//
+//   full_state: [1, seq, [bomba0..3], temperatura, luminosidade,
+//                [[nome, temperatura|nil, presente], ...], [r, g, b, efeito, período_ms]]
+//   delta:      [2, seq, campos, valores...]  (campos = máscara DIRTY_*; um valor
+//                por bit ligado, em ordem crescente: bomba i -> bool,
+//                temperatura, luminosidade, rgb -> [r, g, b, efeito, período_ms],
+//                sonda i -> [nome, temperatura|nil, presente])
+//   error:      [3, código, comando|nil, campo|nil]  (os mesmos do erro JSON,
+//                {"action":"error",...}: comando com o nome JSON equivalente)
+//   resync:     [16]
+//   set_pump:   [17, bomba, estado]
+//   set_rgb:    [18, r, g, b]
+//   set_effect: [19, efeito, período_ms]
+//   emergency_stop:  [20]
+//   clear_emergency: [21]
+//
+// O efeito vai pelo índice de RgbEffectType (0 static, 1 fade, 2 cycle, 3 pulse).
+
+constexpr const char* WS_MSGPACK_PROTOCOL = "qp.msgpack";
+
+enum WsMessageType : uint8_t {
+    // controlador -> cliente
+    WS_MSG_FULL_STATE = 1,
+    WS_MSG_DELTA = 2,
+    WS_MSG_ERROR = 3,
+    // cliente -> controlador
+    WS_MSG_RESYNC = 16,
+    WS_MSG_SET_PUMP = 17,
+    WS_MSG_SET_RGB = 18,
+    WS_MSG_SET_EFFECT = 19,
+    WS_MSG_EMERGENCY_STOP = 20,
+    WS_MSG_CLEAR_EMERGENCY = 21,
+};
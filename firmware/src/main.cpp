@@ -6,11 +6,36 @@
 #include <DallasTemperature.h>
 #include <SPIFFS.h>
 #include <Preferences.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+
+#include "TemperatureSensor.h"
+#include "RgbMailbox.h"
+#include "RgbEffects.h"
+#include "ScheduleStore.h"
+#include "ScheduleEngine.h"
+#include "PumpStateStore.h"
+#include "JsonArena.h"
+#include "WsProtocol.h"
+#include "WsCommandRouter.h"
+#include "WifiConnection.h"
+#include "WifiScanner.h"
+#include "DeferredActions.h"
+#include "Metrics.h"
+#include "SensorHistory.h"
+#include "TelemetryStore.h"
+#include "SafetySupervisor.h"
+#include "ControllerState.h"
+#include "SeqLock.h"
+#include "SpscQueue.h"
+#include "TaskTable.h"
+#include "WebAssets.h" // gerado por scripts/build_web.py
 
 // --- Configuração de Pinos ---
 // Bombas (Relés)
 const int PUMP_PINS[4] = {23, 22, 19, 18}; // Circulação, Filtragem, Borda, Aquecimento
 const char* PUMP_NAMES[4] = {"Circulação", "Filtragem", "Borda", "Aquecimento"};
+const uint8_t EMERGENCY_STOP_PIN = 33; // Botão NA para o GND (pull-up interno)
 
 // LED Integrado (para status)
 const int BUILTIN_LED_PIN = 2;
@@ -19,44 +44,167 @@ const int BUILTIN_LED_PIN = 2;
 const int ONE_WIRE_BUS_PIN = 4;    // DS18B20
 const int LDR_PIN = 34;            // LDR
 
+// Sondas DS18B20 (a ordem define a vaga de cada endereço ROM salvo na NVS)
+const TemperatureProbeConfig TEMPERATURE_PROBES[] = {
+    {"Entrada", 12, 5000},           // Água de entrada (temperatura exibida)
+    {"Saída", 12, 5000},             // Água de saída
+    {"Retorno Aquecedor", 11, 10000},
+    {"Casa de Máquinas", 9, 30000},
+};
+const uint8_t TEMPERATURE_PROBE_COUNT = sizeof(TEMPERATURE_PROBES) / sizeof(TEMPERATURE_PROBES[0]);
+
 // Iluminação RGB (LEDC/PWM)
 const int RGB_PINS[3] = {25, 26, 27}; // R, G, B
 const int RGB_CHANNELS[3] = {0, 1, 2}; // LEDC Channels
 
+// Relógio de parede (agendamentos): fuso POSIX de Brasília, sem horário de verão
+const char* TIMEZONE = "<-03>3";
+const char* NTP_SERVER_1 = "pool.ntp.org";
+const char* NTP_SERVER_2 = "time.google.com";
+const time_t CLOCK_VALID_AFTER = 1577836800; // 2020-01-01: antes disso o SNTP ainda não respondeu
+
 // --- Variáveis de Estado Globais ---
-bool pumpStates[4] = {false, false, false, false};
-float currentTemperature = -127.0;
-int currentLuminosity = 0;
-uint8_t currentColor[3] = {255, 0, 255}; // R, G, B - Roxo padrão
+// Só o loop() escreve em controllerState. O AsyncTCP lê a cópia publicada e
+// pede mudanças pela fila; o loop() aplica os comandos no início de cada volta.
+ControllerState controllerState;
+SeqLock<ControllerState> publishedState;     // loop() -> handlers REST e WebSocket
+SpscQueue<ControlCommand, 32> controlCommands; // handlers WebSocket -> loop()
+SpscQueue<StateDelta, 8> stateDeltas;          // loop() -> tarefa de rede
+
+// --- Sincronização de Estado (WebSocket) ---
+// Cada campo alterado marca um bit; o loop() envia um "delta" só com os campos
+// marcados e um número de sequência. O "full_state" vai apenas na conexão ou
+// quando o cliente detecta um buraco na sequência e pede "resync".
+const uint32_t DIRTY_PUMPS = 0x0F;        // bit i = bomba i
+const uint32_t DIRTY_TEMPERATURE = 1 << 4;
+const uint32_t DIRTY_LUMINOSITY = 1 << 5;
+const uint32_t DIRTY_RGB = 1 << 6;
+const uint32_t DIRTY_PROBES_SHIFT = 8;     // bit 8 + i = sonda i
+uint32_t dirtyState = 0;
 
 // --- Objetos de Hardware/Serviços ---
 AsyncWebServer server(80);
-AsyncWebSocket ws("/ws");
+AsyncWebSocket ws("/ws");       // JSON em texto (clientes legados)
+AsyncWebSocket wsPacked("/ws"); // MessagePack binário (subprotocolo qp.msgpack)
 OneWire oneWire(ONE_WIRE_BUS_PIN);
 DallasTemperature sensors(&oneWire);
+TemperatureSensorBus temperatureSensors(oneWire, ONE_WIRE_BUS_PIN, sensors, TEMPERATURE_PROBES, TEMPERATURE_PROBE_COUNT);
 Preferences preferences;
+RgbMailbox rgbMailbox; // set_rgb do WebSocket -> loop(), só a cor mais recente
+RgbEffectEngine rgbEngine; // Quadros de efeito num esp_timer, LEDC em 12 bits
+ScheduleStore scheduleStore; // Agendamentos em registros binários + diário na SPIFFS
+ScheduleEngine scheduleEngine; // Próximos disparos num min-heap em RAM
+PumpStateStore pumpStateStore; // Estados das bombas na NVS, gravados em segundo plano
+WifiConnection wifiConnection; // Conexão e reconexão WiFi pelo loop(), sem travar o boot
+WifiScanner wifiScanner; // Scan de redes em segundo plano, resultado em cache
+DeferredActionQueue deferredActions; // Reinício e troca de rede só depois da resposta HTTP
+SensorHistory probeHistory[TEMPERATURE_PROBE_COUNT]; // Histórico em RAM por sonda (~8,7 KB cada)
+SensorHistory luminosityHistory;
+TelemetryStore telemetryStore; // Amostras comprimidas na SPIFFS, sobrevivem ao reinício
+SafetySupervisor safetySupervisor; // Única dona dos relés: tempo máximo e parada de emergência
+
+// JSON sem heap: cada tarefa tem sua arena, reaproveitada a cada mensagem
+StaticJsonArena<JSON_POOL_BYTES + 1024> netJsonArena;       // broadcastDelta() (tarefa de rede)
+StaticJsonArena<3 * JSON_POOL_BYTES + 1024> asyncJsonArena; // handlers REST e WebSocket (tarefa do AsyncTCP)
 
 // --- Timers Não-Bloqueantes ---
 unsigned long lastSensorReadTime = 0;
 const long sensorReadInterval = 5000; // 5 segundos
-unsigned long lastBroadcastTime = 0;
-const long broadcastInterval = 2000; // 2 segundos
+unsigned long lastBlinkTime = 0;
+const long blinkInterval = 2000; // 2 segundos
+unsigned long lastRgbFrameTime = 0;
+const long rgbFrameInterval = 16; // ~60 Hz: no máximo uma atualização LEDC por quadro
+unsigned long lastRgbBroadcastTime = 0;
+const long rgbBroadcastInterval = 250; // cor publicada aos clientes no máximo 4x/s
+bool rgbBroadcastPending = false;
+TaskHandle_t loopTaskHandle = nullptr;
+const uint32_t loopIdleMs = 1; // espera máxima entre voltas do loop()
+TaskHandle_t networkTaskHandle = nullptr;
+const uint32_t networkTickMs = 50; // WiFi, scans e limpeza de clientes; deltas acordam a tarefa na hora
+std::atomic<bool> wifiApplyPending{false}; // credenciais novas: aplicadas pela tarefa de rede
+const size_t HISTORY_MAX_POINTS = 240; // pontos por resposta de /api/history
+
+// Séries da telemetria em flash: sondas 0..3 (centésimos de °C), luminosidade (%)
+// e bombas (bit i = bomba i, gravado a cada mudança)
+const uint8_t TELEMETRY_LUMINOSITY = TemperatureSensorBus::MAX_PROBES;
+const uint8_t TELEMETRY_PUMPS = TemperatureSensorBus::MAX_PROBES + 1;
+static_assert(TELEMETRY_PUMPS < TelemetryStore::MAX_SERIES, "Séries da telemetria");
+int lastTelemetryPumps = -1;
 
 // --- Declarações de Funções ---
 void setPumpState(int pumpId, bool state);
 void setRgbColor(uint8_t r, uint8_t g, uint8_t b);
+void setRgbEffect(RgbEffectType effect, uint32_t periodMs);
+void postControlCommand(ControlCommandType type, uint8_t target, uint32_t value);
+void applyControlCommands();
 void onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len);
-void setupWiFi();
-void setupWiFiAP();
-String getMainPage();
-String getConfigPage();
+void onWifiConnected();
+void runDeferredAction(DeferredAction action);
+void sendPage(AsyncWebServerRequest *request, const uint8_t* gz, size_t len, const char* etag);
 void updateSensors();
-void broadcastFullState();
-void parseHexColor(const char* hex, uint8_t& r, uint8_t& g, uint8_t& b);
+uint32_t historyNow();
+void recordTelemetry(uint8_t series, int32_t value);
+void flushTelemetry();
+void handleHistoryRequest(AsyncWebServerRequest *request);
+void markStateDirty(uint32_t fields);
+void addFullState(JsonObject doc, const ControllerState& state);
+void sendFullState(AsyncWebSocket *server, AsyncWebSocketClient *client);
+void publishDelta();
+void broadcastDelta(const StateDelta& delta);
+void networkTask(void* parameter);
+bool requestsMsgPack(AsyncWebServerRequest *request);
+void handlePackedCommand(AsyncWebSocketClient *client, uint8_t *data, size_t len);
+bool packedField(JsonVariantConst value, bool ok, const char* name, WsCommandResult& result);
+const char* cmdResync(AsyncWebSocketClient *client, JsonObjectConst args);
+const char* cmdSetPump(AsyncWebSocketClient *client, JsonObjectConst args);
+const char* cmdSetRgb(AsyncWebSocketClient *client, JsonObjectConst args);
+const char* cmdSetEffect(AsyncWebSocketClient *client, JsonObjectConst args);
+const char* cmdEmergencyStop(AsyncWebSocketClient *client, JsonObjectConst args);
+const char* cmdClearEmergency(AsyncWebSocketClient *client, JsonObjectConst args);
+bool parseHexColor(const char* hex, uint8_t& r, uint8_t& g, uint8_t& b);
 void loadPumpStates();
-void savePumpStates();
-JsonDocument readSchedules();
-bool writeSchedules(const JsonDocument& doc);
+void flushPumpStates();
+
+
+// --- Comandos JSON do WebSocket ---
+// Esquema de cada comando: o router só materializa e valida estes campos
+constexpr WsField SET_PUMP_FIELDS[] = {
+    {"pump_id", WsFieldType::UInt, true, 0, 3},
+    {"state", WsFieldType::Bool, true, 0, 0},
+};
+constexpr WsField SET_RGB_FIELDS[] = {
+    {"color", WsFieldType::String, true, 0, 0}, // "#RRGGBB"
+};
+constexpr WsField SET_EFFECT_FIELDS[] = {
+    {"effect", WsFieldType::String, true, 0, 0},
+    {"period_ms", WsFieldType::UInt, false, 0, 3600000}, // padrão 5000
+};
+
+constexpr WsCommand WS_COMMANDS[] = {
+    WS_COMMAND_NO_ARGS("resync", cmdResync),
+    WS_COMMAND("set_pump", SET_PUMP_FIELDS, cmdSetPump),
+    WS_COMMAND("set_rgb", SET_RGB_FIELDS, cmdSetRgb),
+    WS_COMMAND("set_effect", SET_EFFECT_FIELDS, cmdSetEffect),
+    WS_COMMAND_NO_ARGS("emergency_stop", cmdEmergencyStop),
+    WS_COMMAND_NO_ARGS("clear_emergency", cmdClearEmergency),
+};
+static_assert(wsCommandHashesUnique(WS_COMMANDS), "Dois comandos com o mesmo hash");
+
+// Rótulos calculados em tempo de compilação; o static_assert confere o switch com a tabela
+constexpr const WsCommand* findWsCommand(uint32_t hash) {
+    switch (hash) {
+    case wsCommandHash("resync"): return &WS_COMMANDS[0];
+    case wsCommandHash("set_pump"): return &WS_COMMANDS[1];
+    case wsCommandHash("set_rgb"): return &WS_COMMANDS[2];
+    case wsCommandHash("set_effect"): return &WS_COMMANDS[3];
+    case wsCommandHash("emergency_stop"): return &WS_COMMANDS[4];
+    case wsCommandHash("clear_emergency"): return &WS_COMMANDS[5];
+    default: return nullptr;
+    }
+}
+static_assert(wsCommandLookupMatches(WS_COMMANDS, findWsCommand), "Switch de comandos fora da tabela");
+
+WsCommandRouter wsCommands(WS_COMMANDS, sizeof(WS_COMMANDS) / sizeof(WS_COMMANDS[0]), findWsCommand);
 
 
 void setup() {
@@ -70,36 +218,215 @@ void setup() {
     // Carrega estados das bombas da NVS
     loadPumpStates();
 
-    // Inicializa relés das bombas e aplica estados restaurados
-    for (int i = 0; i < 4; i++) {
-        pinMode(PUMP_PINS[i], OUTPUT);
-        digitalWrite(PUMP_PINS[i], pumpStates[i] ? HIGH : LOW);
-    }
+    // Relés com os estados restaurados, sob a tarefa do supervisor de segurança
+    uint8_t restoredPumps = 0;
+    for (int i = 0; i < 4; i++) restoredPumps |= controllerState.pumps[i] << i;
+    safetySupervisor.begin(PUMP_PINS, EMERGENCY_STOP_PIN, restoredPumps);
 
-    // Inicializa sensores
-    sensors.begin();
+    // Inicializa sensores (endereços das sondas da NVS, conversões sem bloquear o loop)
+    temperatureSensors.begin(preferences);
 
-    // Inicializa iluminação RGB via LEDC
-    for (int i = 0; i < 3; i++) {
-        ledcSetup(RGB_CHANNELS[i], 5000, 8); // Canal, Frequência, Resolução
-        ledcAttachPin(RGB_PINS[i], RGB_CHANNELS[i]);
+    // Sistema de arquivos (agendamentos, telemetria) - montado antes do WiFi, em qualquer modo
+    if (!SPIFFS.begin(true)) {
+        Serial.println("❌ Erro ao montar SPIFFS");
+    } else {
+        scheduleStore.begin(SPIFFS);
+        scheduleEngine.begin(scheduleStore, setPumpState);
+        telemetryStore.begin(SPIFFS);
+        esp_register_shutdown_handler(flushTelemetry);
     }
-    setRgbColor(currentColor[0], currentColor[1], currentColor[2]); // Define cor inicial
-
-    setupWiFi();
 
+    // Inicializa iluminação RGB via LEDC (motor de efeitos)
+    rgbEngine.begin(RGB_PINS, RGB_CHANNELS);
+    setRgbColor(controllerState.color[0], controllerState.color[1], controllerState.color[2]); // Define cor inicial
+
+    // Relés e sensores já estão de pé: a rede conecta em segundo plano
+    wifiConnection.begin("Quinta-dos-Britos-Config", "12345678", onWifiConnected);
+    deferredActions.begin(runDeferredAction);
+    metrics::begin();
+    loopTaskHandle = xTaskGetCurrentTaskHandle(); // setup() roda no loopTask
+    metrics::registerTask(TaskId::Loop, loopTaskHandle);
+
+    // Mesmo "/ws" para os dois formatos: o handler binário vem antes e só
+    // aceita o handshake de quem pediu o subprotocolo MessagePack
+    wsCommands.begin(&asyncJsonArena);
+    wsPacked.setFilter(requestsMsgPack);
+    wsPacked.onEvent(onWebSocketEvent);
+    server.addHandler(&wsPacked);
     ws.onEvent(onWebSocketEvent);
     server.addHandler(&ws);
 
+    // Sem credenciais o "/" é a página de configuração (portal cativo);
+    // com credenciais ela continua em "/config", inclusive pelo AP de fallback
     server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(200, "text/html", getMainPage());
+        if (wifiConnection.hasCredentials()) {
+            sendPage(request, INDEX_HTML_GZ, INDEX_HTML_GZ_LEN, INDEX_HTML_ETAG);
+        } else {
+            sendPage(request, CONFIG_HTML_GZ, CONFIG_HTML_GZ_LEN, CONFIG_HTML_ETAG);
+        }
+    });
+
+    server.on("/config", HTTP_GET, [](AsyncWebServerRequest *request) {
+        sendPage(request, CONFIG_HTML_GZ, CONFIG_HTML_GZ_LEN, CONFIG_HTML_ETAG);
     });
 
+    // --- API de WiFi ---
+
+    // GET /api/wifi - Estado da conexão e métricas (tempo até conectar, quedas)
+    server.on("/api/wifi", HTTP_GET, [](AsyncWebServerRequest *request) {
+        JsonDocument doc(&asyncJsonArena);
+        wifiConnection.toJson(doc.to<JsonObject>());
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // GET /api/scanwifi[?job=N][&refresh=1] - Redes próximas
+    // 200 com o último resultado e a idade dele, ou 202 com o job a consultar
+    server.on("/api/scanwifi", HTTP_GET, [](AsyncWebServerRequest *request) {
+        uint32_t job = request->hasParam("job") ? request->getParam("job")->value().toInt() : 0;
+        bool refresh = request->hasParam("refresh");
+        JsonDocument doc(&asyncJsonArena);
+        WifiScanner::Reply reply = wifiScanner.request(millis(), job, refresh, doc.to<JsonObject>());
+
+        String response;
+        serializeJson(doc, response);
+        request->send(reply == WifiScanner::Reply::Ready ? 200 : 202, "application/json", response);
+    });
+    
+    // POST /api/savewifi - Novas credenciais, aplicadas sem reiniciar
+    server.on("/api/savewifi", HTTP_POST, [](AsyncWebServerRequest *request) {
+        // Campos do formulário vêm no corpo (POST), não na query string
+        if (!request->hasParam("ssid", true) || !request->hasParam("password", true)) {
+            request->send(400, "text/plain", "SSID e senha são obrigatórios");
+            return;
+        }
+        String ssid = request->getParam("ssid", true)->value();
+        String password = request->getParam("password", true)->value();
+        if (ssid.length() == 0 || ssid.length() > 32) {
+            request->send(400, "text/plain", "SSID inválido");
+            return;
+        }
+        if (password.length() > 0 && (password.length() < 8 || password.length() > 63)) {
+            request->send(400, "text/plain", "A senha deve ter de 8 a 63 caracteres");
+            return;
+        }
+
+        wifiConnection.setCredentials(ssid, password);
+        if (!deferredActions.schedule(request, DeferredAction::ApplyWifi)) {
+            request->send(503, "text/plain", "Ocupado, tente novamente");
+            return;
+        }
+        request->send(202, "text/plain", "Credenciais recebidas! Conectando à rede...");
+    });
+
+    // POST /api/restart - Reinicia depois de entregar a resposta
+    server.on("/api/restart", HTTP_POST, [](AsyncWebServerRequest *request) {
+        if (!deferredActions.schedule(request, DeferredAction::Restart, 500)) {
+            request->send(503, "application/json", "{\"error\":\"Busy\"}");
+            return;
+        }
+        request->send(202, "application/json", "{\"status\":\"restarting\"}");
+    });
+
+    // POST /api/factoryreset - Apaga credenciais, estados e agendamentos e reinicia
+    server.on("/api/factoryreset", HTTP_POST, [](AsyncWebServerRequest *request) {
+        if (!deferredActions.schedule(request, DeferredAction::FactoryReset, 500)) {
+            request->send(503, "application/json", "{\"error\":\"Busy\"}");
+            return;
+        }
+        request->send(202, "application/json", "{\"status\":\"resetting\"}");
+    });
+
+    // GET /api/state - Mesmo conteúdo do full_state, da cópia publicada pelo loop()
+    server.on("/api/state", HTTP_GET, [](AsyncWebServerRequest *request) {
+        JsonDocument doc(&asyncJsonArena);
+        addFullState(doc.to<JsonObject>(), publishedState.read());
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // POST /api/sensors/rescan - Procura sondas novas no barramento 1-Wire (no loop())
+    server.on("/api/sensors/rescan", HTTP_POST, [](AsyncWebServerRequest *request) {
+        temperatureSensors.requestRescan();
+        request->send(202, "application/json", "{\"status\":\"scanning\"}");
+    });
+
+    // --- API de Segurança ---
+
+    // POST /api/safety/stop - Parada de emergência (todas as bombas, com trava)
+    server.on("/api/safety/stop", HTTP_POST, [](AsyncWebServerRequest *request) {
+        safetySupervisor.emergencyStop(EmergencySource::Api);
+        request->send(202, "application/json", "{\"status\":\"stopping\"}");
+    });
+
+    // POST /api/safety/clear - Libera a trava (as bombas continuam desligadas)
+    server.on("/api/safety/clear", HTTP_POST, [](AsyncWebServerRequest *request) {
+        safetySupervisor.clearEmergency();
+        request->send(202, "application/json", "{\"status\":\"clearing\"}");
+    });
+
+    // GET /api/safety - Trava de emergência, latência das paradas e tempo ligado de cada bomba
+    server.on("/api/safety", HTTP_GET, [](AsyncWebServerRequest *request) {
+        JsonDocument doc(&asyncJsonArena);
+        safetySupervisor.toJson(doc.to<JsonObject>());
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+#if QP_METRICS
+    // GET /api/metrics - Tempos por seção, heap e filas (texto do Prometheus)
+    server.on("/api/metrics", HTTP_GET, [](AsyncWebServerRequest *request) {
+        String response;
+        response.reserve(4096);
+        metrics::writePrometheus(response);
+        metrics::writeGauge(response, "qp_ws_clients", "Clientes WebSocket (JSON + MessagePack)",
+                            ws.count() + wsPacked.count());
+        metrics::writeCounter(response, "qp_ws_commands_rejected_total", "Comandos WebSocket recusados",
+                              wsCommands.rejected());
+        metrics::writeGauge(response, "qp_json_arena_net_high_water_bytes", "Maior ocupação da arena JSON da tarefa de rede",
+                            netJsonArena.highWater());
+        metrics::writeGauge(response, "qp_json_arena_async_high_water_bytes",
+                            "Maior ocupação da arena JSON do AsyncTCP", asyncJsonArena.highWater());
+        metrics::writeCounter(response, "qp_json_arena_overflows_total", "Blocos JSON que foram para o heap",
+                              netJsonArena.overflows() + asyncJsonArena.overflows());
+        metrics::writeCounter(response, "qp_control_commands_dropped_total", "Comandos descartados com a fila cheia",
+                              controlCommands.dropped());
+        metrics::writeGauge(response, "qp_control_commands_high_water", "Maior ocupação da fila de comandos",
+                            controlCommands.highWater());
+        metrics::writeCounter(response, "qp_state_read_retries_total", "Leituras do estado refeitas durante uma publicação",
+                              publishedState.retries());
+        metrics::writeGauge(response, "qp_emergency_stop_active", "Parada de emergência travada",
+                            safetySupervisor.emergencyActive());
+        metrics::writeCounter(response, "qp_pump_runtime_trips_total", "Bombas desligadas pelo tempo máximo",
+                              safetySupervisor.runtimeTrips());
+        metrics::writeCounter(response, "qp_telemetry_blocks_written_total", "Blocos de telemetria gravados na SPIFFS",
+                              telemetryStore.blocksWritten());
+        metrics::writeCounter(response, "qp_telemetry_samples_written_total", "Amostras de telemetria gravadas",
+                              telemetryStore.samplesWritten());
+        metrics::writeCounter(response, "qp_telemetry_segments_dropped_total", "Segmentos de telemetria descartados",
+                              telemetryStore.segmentsDropped());
+        metrics::writeCounter(response, "qp_telemetry_write_errors_total", "Falhas de escrita da telemetria",
+                              telemetryStore.writeErrors());
+        request->send(200, "text/plain; version=0.0.4", response);
+    });
+#endif
+
+    // GET /api/history?sensor=temperature|luminosity[&probe=N][&from=&to=][&res=raw|1m|15m|1h|auto]
+    // Mínimo, máximo e média por período, da resolução que cobre o intervalo
+    server.on("/api/history", HTTP_GET, handleHistoryRequest);
+
     // --- API de Agendamentos ---
     
     // GET /api/schedules - Listar todos os agendamentos
     server.on("/api/schedules", HTTP_GET, [](AsyncWebServerRequest *request) {
-        JsonDocument doc = readSchedules();
+        JsonDocument doc(&asyncJsonArena);
+        JsonArray schedules = doc.to<JsonArray>();
+        scheduleStore.forEach([&](const ScheduleRecord& record) {
+            scheduleToJson(record, schedules.add<JsonObject>());
+        });
         String response;
         serializeJson(doc, response);
         request->send(200, "application/json", response);
@@ -110,31 +437,29 @@ void setup() {
         // Resposta será enviada no handler do body
     }, NULL, [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
         // Handler do body da requisição
-        JsonDocument requestDoc;
+        JsonDocument requestDoc(&asyncJsonArena);
         DeserializationError error = deserializeJson(requestDoc, data, len);
         
         if (error) {
             request->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
             return;
         }
-        
-        // Gera ID único baseado no timestamp
-        unsigned long scheduleId = millis();
-        requestDoc["id"] = scheduleId;
-        requestDoc["created"] = scheduleId;
-        requestDoc["enabled"] = true; // Padrão habilitado
-        
-        // Lê agendamentos existentes
-        JsonDocument schedulesDoc = readSchedules();
-        JsonArray schedules = schedulesDoc.as<JsonArray>();
-        
-        // Adiciona novo agendamento
-        schedules.add(requestDoc);
-        
-        // Salva de volta
-        if (writeSchedules(schedulesDoc)) {
+
+        ScheduleRecord record;
+        const char* invalid = nullptr;
+        if (!scheduleFromJson(requestDoc, record, invalid)) {
+            request->send(400, "application/json", String("{\"error\":\"") + invalid + "\"}");
+            return;
+        }
+        record.enabled = 1; // Padrão habilitado
+
+        // Grava só uma entrada no diário; o id é sequencial
+        if (scheduleStore.create(record)) {
+            scheduleEngine.onCreated(record);
+            JsonDocument responseDoc(&asyncJsonArena);
+            scheduleToJson(record, responseDoc.to<JsonObject>());
             String response;
-            serializeJson(requestDoc, response);
+            serializeJson(responseDoc, response);
             request->send(201, "application/json", response);
         } else {
             request->send(500, "application/json", "{\"error\":\"Failed to save schedule\"}");
@@ -145,51 +470,132 @@ void setup() {
     server.on("^\\/api\\/schedules\\/(\\d+)$", HTTP_DELETE, [](AsyncWebServerRequest *request) {
         String idParam = request->pathArg(0);
         unsigned long scheduleId = idParam.toInt();
-        
-        JsonDocument schedulesDoc = readSchedules();
-        JsonArray schedules = schedulesDoc.as<JsonArray>();
-        
-        bool found = false;
-        for (size_t i = 0; i < schedules.size(); i++) {
-            if (schedules[i]["id"] == scheduleId) {
-                schedules.remove(i);
-                found = true;
-                break;
-            }
-        }
-        
-        if (found) {
-            if (writeSchedules(schedulesDoc)) {
-                request->send(204); // No Content
-            } else {
-                request->send(500, "application/json", "{\"error\":\"Failed to save changes\"}");
-            }
-        } else {
+
+        if (!scheduleStore.contains(scheduleId)) {
             request->send(404, "application/json", "{\"error\":\"Schedule not found\"}");
+        } else if (scheduleStore.remove(scheduleId)) {
+            scheduleEngine.onRemoved(scheduleId);
+            request->send(204); // No Content
+        } else {
+            request->send(500, "application/json", "{\"error\":\"Failed to save changes\"}");
         }
     });
 
+    // Captive portal - só com o AP de configuração no ar
     server.onNotFound([](AsyncWebServerRequest *request) {
-        request->redirect("http://192.168.4.1/");
+        if (wifiConnection.accessPointActive()) {
+            request->redirect("http://192.168.4.1/");
+        } else {
+            request->send(404, "application/json", "{\"error\":\"Not found\"}");
+        }
     });
 
+    publishedState.write(controllerState); // antes do primeiro cliente
+
+    // Rede no núcleo 0 (TaskTable.h): WiFi, scans e envio dos deltas
+    const TaskConfig& net = taskConfig(TaskId::Network);
+    xTaskCreatePinnedToCore(networkTask, net.name, net.stackBytes, nullptr, net.priority, &networkTaskHandle, net.core);
+    metrics::registerTask(TaskId::Network, networkTaskHandle);
+
     server.begin();
-    Serial.println("✅ Servidor iniciado em http://192.168.4.1");
+    Serial.println("✅ Servidor iniciado");
 }
 
 void loop() {
-    ws.cleanupClients();
-
+    // Cede o núcleo 1 por até um tick; um comando do WebSocket acorda antes
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(loopIdleMs));
+    METRICS_SCOPE(MetricSection::Loop);
     unsigned long currentTime = millis();
 
+    // Bombas e efeitos pedidos pelo WebSocket desde a última volta
+    applyControlCommands();
+
+    // Ações pedidas pela API (reinício, troca de rede) cuja resposta já foi entregue
+    deferredActions.poll(currentTime);
+
     if (currentTime - lastSensorReadTime >= sensorReadInterval) {
         lastSensorReadTime = currentTime;
         updateSensors();
     }
 
-    if (currentTime - lastBroadcastTime >= broadcastInterval) {
-        lastBroadcastTime = currentTime;
-        broadcastFullState();
+    // Avança as leituras das sondas de temperatura (cada uma no seu período)
+    if (temperatureSensors.poll(currentTime)) {
+        uint8_t probe = temperatureSensors.lastCompletedProbe();
+        const TemperatureReading& reading = temperatureSensors.reading(probe);
+        ProbeState& published = controllerState.probes[probe];
+        bool present = temperatureSensors.isPresent(probe);
+        if (reading.valid != published.valid || reading.celsius != published.celsius || present != published.present) {
+            published.celsius = reading.celsius;
+            published.valid = reading.valid;
+            published.present = present;
+            markStateDirty(1UL << (DIRTY_PROBES_SHIFT + probe));
+        }
+        if (reading.errors == 0) {
+            probeHistory[probe].add(historyNow(), reading.celsius);
+            recordTelemetry(probe, lroundf(reading.celsius * 100));
+            if (probe == 0 && reading.celsius != controllerState.temperature) {
+                controllerState.temperature = reading.celsius;
+                markStateDirty(DIRTY_TEMPERATURE);
+            }
+            Serial.printf("🌡️ Temperatura (%s): %.2f°C\n", temperatureSensors.name(probe), reading.celsius);
+        } else {
+            Serial.printf("❌ Erro ao ler sensor de temperatura (%s)!\n", temperatureSensors.name(probe));
+        }
+    }
+
+    // Bombas desligadas pelo supervisor (tempo máximo, emergência) saem do estado publicado
+    uint8_t requestedPumps = safetySupervisor.requestedMask();
+    for (int i = 0; i < 4; i++) {
+        if (controllerState.pumps[i] && !(requestedPumps & (1 << i))) {
+            controllerState.pumps[i] = false;
+            pumpStateStore.markDirty(currentTime);
+            markStateDirty(1UL << i);
+        }
+    }
+
+    // Grava os estados das bombas se a janela de escrita venceu
+    pumpStateStore.poll(currentTime);
+
+    // Agendamentos: só o topo do heap é consultado, nada é lido da SPIFFS
+    time_t now = time(nullptr);
+    if (now > CLOCK_VALID_AFTER) {
+        scheduleEngine.tick(now);
+    }
+
+    // Telemetria: bombas a cada mudança; blocos antigos vão para a flash
+    int pumpMask = 0;
+    for (int i = 0; i < 4; i++) pumpMask |= controllerState.pumps[i] << i;
+    if (pumpMask != lastTelemetryPumps && now > CLOCK_VALID_AFTER) {
+        lastTelemetryPumps = pumpMask;
+        recordTelemetry(TELEMETRY_PUMPS, pumpMask);
+    }
+    telemetryStore.poll(now);
+
+    // Aplica a cor mais recente do seletor, uma vez por quadro
+    if (currentTime - lastRgbFrameTime >= rgbFrameInterval) {
+        lastRgbFrameTime = currentTime;
+        uint8_t r, g, b;
+        if (rgbMailbox.take(r, g, b)) {
+            setRgbColor(r, g, b);
+        }
+    }
+
+    // Publica a cor já assentada, com taxa limitada
+    if (rgbBroadcastPending && currentTime - lastRgbBroadcastTime >= rgbBroadcastInterval) {
+        lastRgbBroadcastTime = currentTime;
+        rgbBroadcastPending = false;
+        Serial.printf("RGB Cor -> R:%d, G:%d, B:%d\n", controllerState.color[0], controllerState.color[1],
+                      controllerState.color[2]);
+        markStateDirty(DIRTY_RGB);
+    }
+
+    // Publica só o que mudou; sem mudanças não há tráfego
+    if (dirtyState) {
+        publishDelta();
+    }
+
+    if (currentTime - lastBlinkTime >= blinkInterval) {
+        lastBlinkTime = currentTime;
         // Pisca o LED para indicar atividade
         digitalWrite(BUILTIN_LED_PIN, !digitalRead(BUILTIN_LED_PIN));
     }
@@ -199,662 +605,637 @@ void loop() {
 
 void setPumpState(int pumpId, bool state) {
     if (pumpId < 0 || pumpId >= 4) return;
-    pumpStates[pumpId] = state;
-    digitalWrite(PUMP_PINS[pumpId], state ? HIGH : LOW);
+    if (controllerState.pumps[pumpId] == state) return;
+    if (!safetySupervisor.requestPump(pumpId, state)) {
+        Serial.printf("🛑 Bomba %d (%s) não ligada: parada de emergência ativa\n", pumpId, PUMP_NAMES[pumpId]);
+        return;
+    }
+    controllerState.pumps[pumpId] = state;
     Serial.printf("Bomba %d (%s) -> %s\n", pumpId, PUMP_NAMES[pumpId], state ? "ON" : "OFF");
-    savePumpStates(); // Salva estados na NVS
-    broadcastFullState();
+    pumpStateStore.markDirty(millis()); // NVS gravada pelo loop(), no fim da janela
+    markStateDirty(1UL << pumpId);
 }
 
+// Entrega a cor ao motor de efeitos; a publicação aos clientes fica a cargo do loop()
 void setRgbColor(uint8_t r, uint8_t g, uint8_t b) {
-    currentColor[0] = r;
-    currentColor[1] = g;
-    currentColor[2] = b;
-    for (int i = 0; i < 3; i++) {
-        ledcWrite(RGB_CHANNELS[i], currentColor[i]);
+    uint8_t* color = controllerState.color;
+    if (color[0] != r || color[1] != g || color[2] != b) {
+        rgbBroadcastPending = true;
+    }
+    color[0] = r;
+    color[1] = g;
+    color[2] = b;
+    if (controllerState.effect == RgbEffectType::Pulse) {
+        rgbEngine.startPulse(r, g, b, controllerState.effectPeriod); // Pulso continua, com a nova cor
+    } else {
+        controllerState.effect = RgbEffectType::Static;
+        rgbEngine.showColor(r, g, b);
     }
-    Serial.printf("RGB Cor -> R:%d, G:%d, B:%d\n", r, g, b);
-    broadcastFullState();
 }
 
-void updateSensors() {
-    // Temperatura
-    sensors.requestTemperatures();
-    float tempC = sensors.getTempCByIndex(0);
-    if (tempC != DEVICE_DISCONNECTED_C) {
-        currentTemperature = tempC;
-        Serial.printf("🌡️ Temperatura: %.2f°C\n", currentTemperature);
-    } else {
-        Serial.println("❌ Erro ao ler sensor de temperatura!");
+// Troca o efeito usando a cor atual; "fade" é uma transição que termina em cor fixa
+void setRgbEffect(RgbEffectType effect, uint32_t periodMs) {
+    const uint8_t* color = controllerState.color;
+    switch (effect) {
+    case RgbEffectType::Static:
+    case RgbEffectType::Fade:
+        rgbEngine.showColor(color[0], color[1], color[2],
+                            effect == RgbEffectType::Fade ? periodMs : 0);
+        effect = RgbEffectType::Static;
+        periodMs = 0;
+        break;
+    case RgbEffectType::Cycle:
+        rgbEngine.startCycle(max(color[0], max(color[1], color[2])), periodMs);
+        break;
+    case RgbEffectType::Pulse:
+        rgbEngine.startPulse(color[0], color[1], color[2], periodMs);
+        break;
+    }
+    controllerState.effect = effect;
+    controllerState.effectPeriod = periodMs;
+    rgbBroadcastPending = true;
+    Serial.printf("RGB Efeito -> %s (%u ms)\n", rgbEffectName(effect), (unsigned)periodMs);
+}
+
+// Chamado pelos handlers do WebSocket (única tarefa produtora da fila)
+void postControlCommand(ControlCommandType type, uint8_t target, uint32_t value) {
+    if (!controlCommands.push(ControlCommand{type, target, value})) {
+        Serial.println("⚠️ Fila de comandos cheia: comando descartado");
+        return;
     }
+    xTaskNotifyGive(loopTaskHandle);
+}
+
+void applyControlCommands() {
+    ControlCommand command;
+    while (controlCommands.pop(command)) {
+        switch (command.type) {
+        case ControlCommandType::SetPump:
+            setPumpState(command.target, command.value != 0);
+            break;
+        case ControlCommandType::SetEffect:
+            setRgbEffect(static_cast<RgbEffectType>(command.target), command.value);
+            break;
+        }
+    }
+}
+
+void updateSensors() {
+    METRICS_SCOPE(MetricSection::UpdateSensors);
+    // Temperatura: agendada por sonda em temperatureSensors.poll()
 
     // Luminosidade
     int rawLDR = analogRead(LDR_PIN);
-    currentLuminosity = map(rawLDR, 0, 4095, 100, 0); // Invertido: mais luz = menor valor
-    Serial.printf("☀️ Luminosidade: %d%%\n", currentLuminosity);
+    int luminosity = map(rawLDR, 0, 4095, 100, 0); // Invertido: mais luz = menor valor
+    if (luminosity != controllerState.luminosity) {
+        controllerState.luminosity = luminosity;
+        markStateDirty(DIRTY_LUMINOSITY);
+    }
+    luminosityHistory.add(historyNow(), luminosity);
+    recordTelemetry(TELEMETRY_LUMINOSITY, luminosity);
+    Serial.printf("☀️ Luminosidade: %d%%\n", luminosity);
+}
+
+// --- Histórico dos Sensores ---
+
+// Segundos desde o boot: monotônico e sem a volta do millis() aos 49 dias
+uint32_t historyNow() {
+    return static_cast<uint32_t>(esp_timer_get_time() / 1000000);
+}
+
+void handleHistoryRequest(AsyncWebServerRequest *request) {
+    String sensor = request->hasParam("sensor") ? request->getParam("sensor")->value() : String("temperature");
+    SensorHistory* history = nullptr;
+    long probe = -1;
+    if (sensor == "luminosity") {
+        history = &luminosityHistory;
+    } else if (sensor == "temperature") {
+        probe = request->hasParam("probe") ? request->getParam("probe")->value().toInt() : 0;
+        if (probe >= 0 && probe < TEMPERATURE_PROBE_COUNT) history = &probeHistory[probe];
+    }
+    if (!history) {
+        request->send(400, "application/json", "{\"error\":\"Invalid sensor\"}");
+        return;
+    }
+
+    bool autoRes = true;
+    HistoryResolution res = HistoryResolution::Raw;
+    if (request->hasParam("res") && request->getParam("res")->value() != "auto") {
+        autoRes = false;
+        if (!SensorHistory::parse(request->getParam("res")->value().c_str(), res)) {
+            request->send(400, "application/json", "{\"error\":\"Invalid res\"}");
+            return;
+        }
+    }
+
+    // Com o relógio acertado a API fala em epoch; antes disso, em segundos desde o boot
+    uint32_t uptime = historyNow();
+    time_t wall = time(nullptr);
+    bool epoch = wall > CLOCK_VALID_AFTER;
+    int64_t offset = epoch ? static_cast<int64_t>(wall) - uptime : 0;
+    int64_t to = request->hasParam("to") ? atoll(request->getParam("to")->value().c_str()) : uptime + offset;
+    int64_t from = request->hasParam("from") ? atoll(request->getParam("from")->value().c_str()) : to - 3600;
+    if (to < from) {
+        request->send(400, "application/json", "{\"error\":\"Invalid range\"}");
+        return;
+    }
+    int64_t fromUp = from - offset < 0 ? 0 : from - offset;
+    int64_t toUp = to - offset;
+    if (toUp > UINT32_MAX) toUp = UINT32_MAX;
+    if (autoRes) res = history->pick(fromUp, toUp < 0 ? 0 : toUp, HISTORY_MAX_POINTS);
+
+    // Resposta montada direto no texto: até HISTORY_MAX_POINTS pontos não cabem na arena JSON
+    String response;
+    response.reserve(160 + HISTORY_MAX_POINTS * 36);
+    char line[160];
+    snprintf(line, sizeof(line),
+             "{\"sensor\":\"%s\",\"probe\":%s,\"res\":\"%s\",\"period_s\":%lu,\"clock\":\"%s\","
+             "\"from\":%lld,\"to\":%lld,\"points\":[",
+             sensor.c_str(), probe < 0 ? "null" : String(probe).c_str(), SensorHistory::name(res), (unsigned long)SensorHistory::period(res),
+             epoch ? "epoch" : "uptime", (long long)from, (long long)to);
+    response += line;
+    bool first = true;
+    bool partial = false;
+    size_t count = 0;
+    if (toUp >= 0) {
+        count = history->query(res, fromUp, toUp, HISTORY_MAX_POINTS, [&](const HistoryPoint& point) {
+            snprintf(line, sizeof(line), "%s[%lld,%.2f,%.2f,%.2f]", first ? "" : ",",
+                     (long long)(point.t + offset), point.min, point.max, point.avg);
+            response += line;
+            first = false;
+            partial = point.partial;
+        });
+    }
+    snprintf(line, sizeof(line), "],\"partial\":%s,\"truncated\":%s}", partial ? "true" : "false",
+             count >= HISTORY_MAX_POINTS ? "true" : "false");
+    response += line;
+    request->send(200, "application/json", response);
+}
+
+// Só com o relógio acertado: instantes em uptime não fariam sentido depois do reinício
+void recordTelemetry(uint8_t series, int32_t value) {
+    time_t now = time(nullptr);
+    if (now > CLOCK_VALID_AFTER) telemetryStore.add(series, now, value);
+}
+
+// Chamado por ESP.restart(): grava os blocos ainda incompletos
+void flushTelemetry() {
+    telemetryStore.flush();
 }
 
 // --- Funções de Rede ---
 
-void broadcastFullState() {
-    JsonDocument doc;
-    doc["action"] = "full_state";
+void markStateDirty(uint32_t fields) {
+    dirtyState |= fields;
+}
+
+void addProbeState(JsonObject probe, uint8_t i, const ProbeState& state) {
+    probe["name"] = temperatureSensors.name(i);
+    if (state.valid) {
+        probe["temperature"] = state.celsius;
+    } else {
+        probe["temperature"] = nullptr;
+    }
+    probe["present"] = state.present;
+}
 
-    JsonArray pump_states = doc.createNestedArray("pumps");
+void addProbeStatePacked(JsonArray probe, uint8_t i, const ProbeState& state) {
+    probe.add(temperatureSensors.name(i));
+    if (state.valid) {
+        probe.add(state.celsius);
+    } else {
+        probe.add(nullptr);
+    }
+    probe.add(state.present);
+}
+
+void addRgbState(JsonObject rgb, const ControllerState& state) {
+    rgb["r"] = state.color[0];
+    rgb["g"] = state.color[1];
+    rgb["b"] = state.color[2];
+    rgb["effect"] = rgbEffectName(state.effect);
+    rgb["period_ms"] = state.effectPeriod;
+}
+
+void addRgbStatePacked(JsonArray rgb, const ControllerState& state) {
+    rgb.add(state.color[0]);
+    rgb.add(state.color[1]);
+    rgb.add(state.color[2]);
+    rgb.add(static_cast<uint8_t>(state.effect));
+    rgb.add(state.effectPeriod);
+}
+
+// full_state no formato binário (layout em WsProtocol.h)
+void sendFullStatePacked(AsyncWebSocketClient *client, const ControllerState& state) {
+    JsonDocument doc(&asyncJsonArena);
+    JsonArray msg = doc.to<JsonArray>();
+    msg.add(WS_MSG_FULL_STATE);
+    msg.add(state.seq);
+
+    JsonArray pump_states = msg.add<JsonArray>();
     for (int i = 0; i < 4; i++) {
-        pump_states.add(pumpStates[i]);
+        pump_states.add(state.pumps[i]);
     }
+    msg.add(state.temperature);
+    msg.add(state.luminosity);
 
-    JsonObject sensors_data = doc.createNestedObject("sensors");
-    sensors_data["temperature"] = currentTemperature;
-    sensors_data["luminosity"] = currentLuminosity;
+    JsonArray probes = msg.add<JsonArray>();
+    for (uint8_t i = 0; i < temperatureSensors.probeCount(); i++) {
+        addProbeStatePacked(probes.add<JsonArray>(), i, state.probes[i]);
+    }
+    addRgbStatePacked(msg.add<JsonArray>(), state);
 
-    JsonObject rgb = doc.createNestedObject("rgb");
-    rgb["r"] = currentColor[0];
-    rgb["g"] = currentColor[1];
-    rgb["b"] = currentColor[2];
+    size_t len = measureMsgPack(doc);
+    AsyncWebSocketMessageBuffer* buffer = wsPacked.makeBuffer(len);
+    if (!buffer) return;
+    serializeMsgPack(doc, buffer->get(), len);
+    client->binary(buffer);
+}
+
+// Corpo do full_state (WebSocket) e do GET /api/state
+void addFullState(JsonObject doc, const ControllerState& state) {
+    doc["seq"] = state.seq;
+
+    JsonArray pump_states = doc["pumps"].to<JsonArray>();
+    for (int i = 0; i < 4; i++) {
+        pump_states.add(state.pumps[i]);
+    }
+
+    JsonObject sensors_data = doc["sensors"].to<JsonObject>();
+    sensors_data["temperature"] = state.temperature;
+    sensors_data["luminosity"] = state.luminosity;
 
-    String output;
-    serializeJson(doc, output);
-    ws.textAll(output);
+    // Tabela de leituras: só memória, nenhum acesso ao barramento 1-Wire aqui
+    JsonArray probes = sensors_data["probes"].to<JsonArray>();
+    for (uint8_t i = 0; i < temperatureSensors.probeCount(); i++) {
+        addProbeState(probes.add<JsonObject>(), i, state.probes[i]);
+    }
+
+    addRgbState(doc["rgb"].to<JsonObject>(), state);
 }
 
-void setupWiFi() {
-    // Tenta carregar credenciais salvas da NVS
-    preferences.begin("wifi-creds", true);
-    String savedSSID = preferences.getString("wifi_ssid", "");
-    String savedPass = preferences.getString("wifi_pass", "");
-    preferences.end();
-    
-    if (savedSSID.length() > 0) {
-        Serial.print("🔌 Conectando à rede WiFi salva: ");
-        Serial.println(savedSSID);
-        
-        WiFi.mode(WIFI_STA);
-        WiFi.begin(savedSSID.c_str(), savedPass.c_str());
-        
-        int attempts = 0;
-        while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-            delay(500);
-            Serial.print(".");
-            attempts++;
-        }
-        
-        if (WiFi.status() == WL_CONNECTED) {
-            Serial.println("\n✅ Conectado à rede WiFi!");
-            Serial.print("📡 IP Address: ");
-            Serial.println(WiFi.localIP());
-            Serial.print("🌐 Gateway: ");
-            Serial.println(WiFi.gatewayIP());
-            Serial.print("📶 Signal Strength: ");
-            Serial.print(WiFi.RSSI());
-            Serial.println(" dBm");
-            return;
+// Snapshot completo para um único cliente (conexão nova ou resync), lido da
+// cópia publicada: o loop() pode estar no meio de uma atualização
+void sendFullState(AsyncWebSocket *server, AsyncWebSocketClient *client) {
+    METRICS_SCOPE(MetricSection::SendFullState);
+    ControllerState state = publishedState.read();
+    if (server == &wsPacked) {
+        sendFullStatePacked(client, state);
+        return;
+    }
+
+    JsonDocument doc(&asyncJsonArena); // chamado pelos eventos do WebSocket
+    doc["action"] = "full_state";
+    addFullState(doc.as<JsonObject>(), state);
+
+    // Direto no buffer da mensagem, sem String intermediária
+    size_t len = measureJson(doc);
+    AsyncWebSocketMessageBuffer* buffer = ws.makeBuffer(len);
+    if (!buffer) return;
+    serializeJson(doc, reinterpret_cast<char*>(buffer->get()), len + 1);
+    client->text(buffer);
+}
+
+// Delta binário: a máscara de campos vai junto e cada bit ligado traz um valor
+void broadcastDeltaPacked(uint32_t fields, const ControllerState& state) {
+    uint32_t probeMask = ((1UL << temperatureSensors.probeCount()) - 1) << DIRTY_PROBES_SHIFT;
+    fields &= DIRTY_PUMPS | DIRTY_TEMPERATURE | DIRTY_LUMINOSITY | DIRTY_RGB | probeMask;
+
+    JsonDocument doc(&netJsonArena);
+    JsonArray msg = doc.to<JsonArray>();
+    msg.add(WS_MSG_DELTA);
+    msg.add(state.seq);
+    msg.add(fields);
+    for (uint8_t bit = 0; bit < 32; bit++) {
+        uint32_t field = 1UL << bit;
+        if (!(fields & field)) continue;
+        if (field & DIRTY_PUMPS) {
+            msg.add(state.pumps[bit]);
+        } else if (field == DIRTY_TEMPERATURE) {
+            msg.add(state.temperature);
+        } else if (field == DIRTY_LUMINOSITY) {
+            msg.add(state.luminosity);
+        } else if (field == DIRTY_RGB) {
+            addRgbStatePacked(msg.add<JsonArray>(), state);
         } else {
-            Serial.println("\n❌ Falha ao conectar à rede WiFi salva.");
+            uint8_t probe = bit - DIRTY_PROBES_SHIFT;
+            addProbeStatePacked(msg.add<JsonArray>(), probe, state.probes[probe]);
         }
-    } else {
-        Serial.println("📝 Nenhuma credencial WiFi salva encontrada.");
     }
-    
-    // Se chegou aqui, falhou ou não tem credenciais - entra em modo AP
-    Serial.println("🔧 Iniciando modo AP para configuração...");
-    setupWiFiAP();
+
+    size_t len = measureMsgPack(doc);
+    AsyncWebSocketMessageBuffer* buffer = wsPacked.makeBuffer(len);
+    if (!buffer) return;
+    serializeMsgPack(doc, buffer->get(), len);
+    wsPacked.binaryAll(buffer);
 }
 
-void setupWiFiAP() {
-    const char* ssid = "Quinta-dos-Britos-Config";
-    WiFi.softAP(ssid, "12345678");
-    Serial.printf("📡 AP Iniciado. SSID: %s\n", ssid);
-    Serial.printf("💻 IP: %s\n", WiFi.softAPIP().toString().c_str());
-    
-    // Inicializa SPIFFS para servir arquivos
-    if (!SPIFFS.begin(true)) {
-        Serial.println("❌ Erro ao montar SPIFFS");
-        return;
+// Delta com os campos marcados desde o último envio. Bombas e sondas vão como
+// objetos indexados ({"2": true}) para carregar só os itens alterados.
+void broadcastDeltaJson(uint32_t fields, const ControllerState& state) {
+    JsonDocument doc(&netJsonArena);
+    doc["action"] = "delta";
+    doc["seq"] = state.seq;
+
+    if (fields & DIRTY_PUMPS) {
+        JsonObject pump_states = doc["pumps"].to<JsonObject>();
+        for (int i = 0; i < 4; i++) {
+            if (fields & (1UL << i)) pump_states[String(i)] = state.pumps[i];
+        }
     }
-    
-    // Portal cativo simples - redireciona todas as requisições
-    
-    // Rota principal - página de configuração
-    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(200, "text/html", getConfigPage());
-    });
-    
-    // API para escanear redes WiFi
-    server.on("/api/scanwifi", HTTP_GET, [](AsyncWebServerRequest *request) {
-        int n = WiFi.scanNetworks();
-        JsonDocument doc;
-        JsonArray networks = doc.to<JsonArray>();
-        
-        for (int i = 0; i < n; i++) {
-            JsonObject network = networks.add<JsonObject>();
-            network["ssid"] = WiFi.SSID(i);
-            network["rssi"] = WiFi.RSSI(i);
-            network["encryption"] = (WiFi.encryptionType(i) == WIFI_AUTH_OPEN) ? "open" : "secured";
+
+    uint32_t probeFields = fields >> DIRTY_PROBES_SHIFT;
+    if (fields & (DIRTY_TEMPERATURE | DIRTY_LUMINOSITY) || probeFields) {
+        JsonObject sensors_data = doc["sensors"].to<JsonObject>();
+        if (fields & DIRTY_TEMPERATURE) sensors_data["temperature"] = state.temperature;
+        if (fields & DIRTY_LUMINOSITY) sensors_data["luminosity"] = state.luminosity;
+        if (probeFields) {
+            JsonObject probes = sensors_data["probes"].to<JsonObject>();
+            for (uint8_t i = 0; i < temperatureSensors.probeCount(); i++) {
+                if (probeFields & (1UL << i)) addProbeState(probes[String(i)].to<JsonObject>(), i, state.probes[i]);
+            }
         }
-        
-        String response;
-        serializeJson(doc, response);
-        request->send(200, "application/json", response);
-    });
-    
-    // API para salvar credenciais WiFi
-    server.on("/api/savewifi", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (request->hasParam("ssid") && request->hasParam("password")) {
-            String ssid = request->getParam("ssid")->value();
-            String password = request->getParam("password")->value();
-            
-            // Salva credenciais na NVS
-            preferences.begin("wifi-creds", false);
-            preferences.putString("wifi_ssid", ssid);
-            preferences.putString("wifi_pass", password);
+    }
+
+    if (fields & DIRTY_RGB) {
+        addRgbState(doc["rgb"].to<JsonObject>(), state);
+    }
+
+    // Serializado uma vez num buffer que todos os clientes compartilham: cada
+    // fila guarda só uma referência e a memória volta ao heap no último envio
+    size_t len = measureJson(doc);
+    AsyncWebSocketMessageBuffer* buffer = ws.makeBuffer(len);
+    if (!buffer) return;
+    serializeJson(doc, reinterpret_cast<char*>(buffer->get()), len + 1);
+    ws.textAll(buffer);
+}
+
+// loop(): publica o estado com um seq novo e entrega os campos alterados à
+// tarefa de rede. Com a fila cheia (rede atrasada) os campos continuam
+// marcados e saem juntos no próximo delta, sem pular seq.
+void publishDelta() {
+    if (stateDeltas.full()) return;
+    controllerState.seq++;
+    publishedState.write(controllerState);
+    stateDeltas.push(StateDelta{dirtyState, controllerState});
+    dirtyState = 0;
+    xTaskNotifyGive(networkTaskHandle);
+}
+
+// Tarefa de rede: cada formato só é serializado se houver cliente conectado
+// nele; sem clientes, quem conectar depois recebe o full_state. Um full_state
+// lido do SeqLock pode sair antes de deltas já contidos nele (seq menor ou
+// igual), que o cliente descarta.
+void broadcastDelta(const StateDelta& delta) {
+    METRICS_SCOPE(MetricSection::BroadcastDelta);
+    if (ws.count() > 0) broadcastDeltaJson(delta.fields, delta.state);
+    if (wsPacked.count() > 0) broadcastDeltaPacked(delta.fields, delta.state);
+}
+
+// Núcleo 0: conexão WiFi, scans, limpeza dos clientes e envio dos deltas. Só
+// lê o estado que o loop() publicou; nada aqui espera sensores ou relés.
+void networkTask(void* parameter) {
+    uint32_t lastSample = micros();
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(networkTickMs));
+        uint32_t started = micros();
+        unsigned long now = millis();
+
+        ws.cleanupClients();
+        wsPacked.cleanupClients();
+
+        // Tentativas, backoff e AP de fallback da conexão WiFi
+        if (wifiApplyPending.exchange(false, std::memory_order_acq_rel)) {
+            wifiConnection.applyCredentials(now);
+        }
+        wifiConnection.loop(now);
+        wifiScanner.poll(now);
+
+        StateDelta delta;
+        while (stateDeltas.pop(delta)) {
+            broadcastDelta(delta);
+        }
+
+        metrics::addTaskBusy(TaskId::Network, micros() - started);
+        if (started - lastSample >= 1000000) {
+            metrics::sampleTasks(started);
+            lastSample = started;
+        }
+    }
+}
+
+// Chamado pelo wifiConnection.loop() a cada (re)conexão
+void onWifiConnected() {
+    configTzTime(TIMEZONE, NTP_SERVER_1, NTP_SERVER_2); // SNTP em segundo plano
+}
+
+// Namespaces da NVS apagados pelo reset de fábrica
+const char* FACTORY_RESET_NAMESPACES[] = {"wifi-creds", "wifi-cache", "pump-states", "onewire"};
+
+// Executada pelo deferredActions.poll() no loop(), com a resposta já entregue
+void runDeferredAction(DeferredAction action) {
+    switch (action) {
+    case DeferredAction::Restart:
+        Serial.println("🔄 Reiniciando...");
+        ESP.restart();
+        break;
+
+    case DeferredAction::ApplyWifi:
+        wifiApplyPending.store(true, std::memory_order_release); // a conexão WiFi é da tarefa de rede
+        xTaskNotifyGive(networkTaskHandle);
+        break;
+
+    case DeferredAction::FactoryReset:
+        Serial.println("🧹 Reset de fábrica: apagando NVS e SPIFFS...");
+        for (int i = 0; i < 4; i++) setPumpState(i, false);
+        pumpStateStore.flush(); // nada pendente para o handler de shutdown regravar
+        telemetryStore.end();
+        for (const char* name : FACTORY_RESET_NAMESPACES) {
+            preferences.begin(name, false);
+            preferences.clear();
             preferences.end();
-            
-            Serial.printf("💾 Credenciais salvas: %s\n", ssid.c_str());
-            request->send(200, "text/plain", "Credenciais salvas! Reiniciando...");
-            
-            delay(1000);
-            ESP.restart();
-        } else {
-            request->send(400, "text/plain", "SSID e senha são obrigatórios");
         }
-    });
-    
-    // Captive portal - redireciona tudo para a página de configuração
-    server.onNotFound([](AsyncWebServerRequest *request) {
-        request->redirect("http://192.168.4.1/");
-    });
-    
-    server.begin();
-    Serial.println("🌐 Servidor de configuração iniciado");
+        SPIFFS.format();
+        ESP.restart();
+        break;
+    }
 }
 
 void onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
+    METRICS_SCOPE(MetricSection::WsEvent);
     if (type == WS_EVT_CONNECT) {
         Serial.printf("Cliente #%u conectado.\n", client->id());
-        broadcastFullState(); // Envia estado atual ao novo cliente
+        sendFullState(server, client); // Envia estado atual só ao novo cliente
     } else if (type == WS_EVT_DISCONNECT) {
         Serial.printf("Cliente #%u desconectado.\n", client->id());
+    } else if (type == WS_EVT_DATA && server == &wsPacked) {
+        handlePackedCommand(client, data, len);
     } else if (type == WS_EVT_DATA) {
-        JsonDocument doc;
-        if (deserializeJson(doc, data, len) == DeserializationError::Ok) {
-            const char* action = doc["action"];
-            if (strcmp(action, "set_pump") == 0) {
-                setPumpState(doc["pump_id"], doc["state"]);
-            } else if (strcmp(action, "set_rgb") == 0) {
-                const char* hexColor = doc["color"]; // ex: "#RRGGBB"
-                uint8_t r, g, b;
-                parseHexColor(hexColor, r, g, b);
-                setRgbColor(r, g, b);
-            }
+        WsCommandResult result = wsCommands.dispatch(client, data, len);
+        if (result.error != WsCommandError::None) {
+            wsCommands.sendError(client, result);
         }
     }
 }
 
-// --- Funções Utilitárias ---
-void parseHexColor(const char* hex, uint8_t& r, uint8_t& g, uint8_t& b) {
-    if (hex && hex[0] == '#') {
-        long color = strtol(&hex[1], NULL, 16);
-        r = (color >> 16) & 0xFF;
-        g = (color >> 8) & 0xFF;
-        b = color & 0xFF;
-    }
+const char* cmdResync(AsyncWebSocketClient *client, JsonObjectConst args) {
+    sendFullState(&ws, client); // Cliente perdeu um delta
+    return nullptr;
 }
 
-void savePumpStates() {
-    preferences.begin("pump-states", false);
-    preferences.putBytes("states", pumpStates, sizeof(pumpStates));
-    preferences.end();
-    Serial.println("💾 Estados das bombas salvos na NVS");
+const char* cmdSetPump(AsyncWebSocketClient *client, JsonObjectConst args) {
+    if (args["state"] && safetySupervisor.emergencyActive()) return "state"; // parada de emergência ativa
+    postControlCommand(ControlCommandType::SetPump, args["pump_id"], args["state"].as<bool>());
+    return nullptr;
 }
 
-void loadPumpStates() {
-    preferences.begin("pump-states", true);
-    if (preferences.isKey("states")) {
-        preferences.getBytes("states", pumpStates, sizeof(pumpStates));
-        Serial.println("🔄 Estados das bombas carregados da NVS");
-        for (int i = 0; i < 4; i++) {
-            Serial.printf("   Bomba %d (%s): %s\n", i, PUMP_NAMES[i], pumpStates[i] ? "ON" : "OFF");
-        }
-    } else {
-        Serial.println("📝 Nenhum estado salvo encontrado, usando padrões");
-        // Estados padrão já estão definidos na inicialização
-        for (int i = 0; i < 4; i++) {
-            pumpStates[i] = false;
-        }
-    }
-    preferences.end();
+const char* cmdEmergencyStop(AsyncWebSocketClient *client, JsonObjectConst args) {
+    safetySupervisor.emergencyStop(EmergencySource::Command);
+    return nullptr;
 }
 
-// --- Funções de Agendamento ---
+const char* cmdClearEmergency(AsyncWebSocketClient *client, JsonObjectConst args) {
+    safetySupervisor.clearEmergency();
+    return nullptr;
+}
 
-JsonDocument readSchedules() {
-    JsonDocument doc;
-    File file = SPIFFS.open("/schedules.json", "r");
-    
-    if (!file) {
-        Serial.println("📄 Arquivo de agendamentos não encontrado, criando array vazio");
-        doc.to<JsonArray>(); // Cria um array vazio
-        return doc;
-    }
-    
-    DeserializationError error = deserializeJson(doc, file);
-    file.close();
-    
-    if (error) {
-        Serial.printf("❌ Erro ao ler agendamentos: %s\n", error.c_str());
-        doc.to<JsonArray>(); // Retorna array vazio em caso de erro
-        return doc;
-    }
-    
-    Serial.printf("📄 %d agendamentos carregados\n", doc.size());
-    return doc;
+const char* cmdSetRgb(AsyncWebSocketClient *client, JsonObjectConst args) {
+    uint8_t r, g, b;
+    if (!parseHexColor(args["color"], r, g, b)) return "color";
+    rgbMailbox.post(r, g, b); // Aplicada no próximo quadro do loop()
+    return nullptr;
 }
 
-bool writeSchedules(const JsonDocument& doc) {
-    File file = SPIFFS.open("/schedules.json", "w");
-    
-    if (!file) {
-        Serial.println("❌ Erro ao abrir arquivo de agendamentos para escrita");
-        return false;
+const char* cmdSetEffect(AsyncWebSocketClient *client, JsonObjectConst args) {
+    RgbEffectType effect;
+    if (!parseRgbEffectName(args["effect"], effect)) return "effect";
+    postControlCommand(ControlCommandType::SetEffect, static_cast<uint8_t>(effect), args["period_ms"] | 5000);
+    return nullptr;
+}
+
+// Comandos binários: o tipo na posição 0 escolhe o comando, sem comparar strings.
+// Frames malformados e argumentos fora da faixa voltam como o mesmo erro
+// estruturado do JSON (códigos, comando e campo), em MessagePack.
+void handlePackedCommand(AsyncWebSocketClient *client, uint8_t *data, size_t len) {
+    JsonDocument doc(&asyncJsonArena);
+    WsCommandResult result;
+    if (deserializeMsgPack(doc, data, len) != DeserializationError::Ok || !doc.is<JsonArrayConst>()) {
+        result.error = WsCommandError::InvalidJson;
+        wsCommands.sendPackedError(client, result);
+        return;
     }
-    
-    size_t bytesWritten = serializeJson(doc, file);
-    file.close();
-    
-    if (bytesWritten == 0) {
-        Serial.println("❌ Erro ao salvar agendamentos");
-        return false;
+    JsonArrayConst msg = doc.as<JsonArrayConst>();
+    if (!msg[0].is<uint8_t>()) {
+        result.error = WsCommandError::MissingAction;
+        wsCommands.sendPackedError(client, result);
+        return;
     }
-    
-    Serial.printf("💾 %d agendamentos salvos (%d bytes)\n", doc.size(), bytesWritten);
-    return true;
-}
-
-String getConfigPage() {
-    return String(R"(
-<!DOCTYPE html>
-<html lang="pt-BR">
-<head>
-    <meta charset="UTF-8">
-    <meta name="viewport" content="width=device-width, initial-scale=1.0">
-    <title>Configuração WiFi - Quinta dos Britos</title>
-    <style>
-        * { margin: 0; padding: 0; box-sizing: border-box; }
-        body { 
-            font-family: -apple-system, BlinkMacSystemFont, 'Segoe UI', Roboto, sans-serif;
-            background: linear-gradient(135deg, #667eea 0%, #764ba2 100%);
-            min-height: 100vh;
-            display: flex;
-            align-items: center;
-            justify-content: center;
-            padding: 20px;
-        }
-        .container {
-            background: white;
-            border-radius: 20px;
-            box-shadow: 0 20px 40px rgba(0,0,0,0.1);
-            padding: 40px;
-            max-width: 500px;
-            width: 100%;
-        }
-        .header {
-            text-align: center;
-            margin-bottom: 30px;
-        }
-        .header h1 {
-            color: #333;
-            font-size: 28px;
-            margin-bottom: 10px;
-        }
-        .header p {
-            color: #666;
-            font-size: 16px;
-        }
-        .form-group {
-            margin-bottom: 20px;
-        }
-        label {
-            display: block;
-            margin-bottom: 8px;
-            color: #333;
-            font-weight: 500;
-        }
-        select, input {
-            width: 100%;
-            padding: 12px 16px;
-            border: 2px solid #e1e5e9;
-            border-radius: 10px;
-            font-size: 16px;
-            transition: border-color 0.3s;
-        }
-        select:focus, input:focus {
-            outline: none;
-            border-color: #667eea;
-        }
-        .btn {
-            background: linear-gradient(135deg, #667eea 0%, #764ba2 100%);
-            color: white;
-            border: none;
-            padding: 12px 24px;
-            border-radius: 10px;
-            font-size: 16px;
-            font-weight: 500;
-            cursor: pointer;
-            transition: transform 0.2s;
-            width: 100%;
-        }
-        .btn:hover {
-            transform: translateY(-2px);
-        }
-        .btn:disabled {
-            opacity: 0.6;
-            cursor: not-allowed;
-            transform: none;
-        }
-        .status {
-            margin-top: 20px;
-            padding: 12px;
-            border-radius: 10px;
-            text-align: center;
-            font-weight: 500;
-        }
-        .status.success {
-            background: #d4edda;
-            color: #155724;
-            border: 1px solid #c3e6cb;
-        }
-        .status.error {
-            background: #f8d7da;
-            color: #721c24;
-            border: 1px solid #f5c6cb;
-        }
-        .status.info {
-            background: #d1ecf1;
-            color: #0c5460;
-            border: 1px solid #bee5eb;
-        }
-        .scan-btn {
-            background: #28a745;
-            margin-bottom: 20px;
-        }
-        .loading {
-            display: none;
-            text-align: center;
-            margin: 20px 0;
-        }
-        .spinner {
-            border: 3px solid #f3f3f3;
-            border-top: 3px solid #667eea;
-            border-radius: 50%;
-            width: 30px;
-            height: 30px;
-            animation: spin 1s linear infinite;
-            margin: 0 auto 10px;
-        }
-        @keyframes spin {
-            0% { transform: rotate(0deg); }
-            100% { transform: rotate(360deg); }
-        }
-    </style>
-</head>
-<body>
-    <div class="container">
-        <div class="header">
-            <h1>🏛️ Quinta dos Britos</h1>
-            <p>Configuração da Rede WiFi</p>
-        </div>
-        
-        <form id="wifiForm">
-            <div class="form-group">
-                <label for="ssid">Rede WiFi:</label>
-                <select id="ssid" name="ssid" required>
-                    <option value="">Clique em 'Escanear' para ver redes disponíveis</option>
-                </select>
-            </div>
-            
-            <div class="form-group">
-                <label for="password">Senha:</label>
-                <input type="password" id="password" name="password" placeholder="Digite a senha da rede">
-            </div>
-            
-            <button type="button" id="scanBtn" class="btn scan-btn">🔍 Escanear Redes</button>
-            <button type="submit" id="saveBtn" class="btn" disabled>💾 Salvar e Conectar</button>
-        </form>
-        
-        <div id="status"></div>
-        <div id="loading" class="loading">
-            <div class="spinner"></div>
-            <p>Configurando...</p>
-        </div>
-    </div>
-
-    <script>
-        const ssidSelect = document.getElementById('ssid');
-        const passwordInput = document.getElementById('password');
-        const scanBtn = document.getElementById('scanBtn');
-        const saveBtn = document.getElementById('saveBtn');
-        const form = document.getElementById('wifiForm');
-        const status = document.getElementById('status');
-        const loading = document.getElementById('loading');
-
-        function showStatus(message, type) {
-            status.innerHTML = message;
-            status.className = 'status ' + type;
-        }
-
-        function showLoading(show) {
-            loading.style.display = show ? 'block' : 'none';
-            scanBtn.disabled = show;
-            saveBtn.disabled = show;
-        }
 
-        async function scanNetworks() {
-            showLoading(true);
-            showStatus('Escanando redes WiFi...', 'info');
-            
-            try {
-                const response = await fetch('/api/scanwifi');
-                const networks = await response.json();
-                
-                ssidSelect.innerHTML = '<option value="">Selecione uma rede</option>';
-                
-                networks.forEach(network => {
-                    const option = document.createElement('option');
-                    option.value = network.ssid;
-                    option.textContent = `${network.ssid} (${network.rssi} dBm) ${network.encryption === 'open' ? '🔓' : '🔒'}`;
-                    ssidSelect.appendChild(option);
-                });
-                
-                showStatus(`${networks.length} redes encontradas`, 'success');
-                saveBtn.disabled = false;
-            } catch (error) {
-                showStatus('Erro ao escanear redes: ' + error.message, 'error');
-            } finally {
-                showLoading(false);
-            }
+    switch (msg[0].as<uint8_t>()) {
+    case WS_MSG_RESYNC:
+        sendFullState(&wsPacked, client); // Cliente perdeu um delta
+        break;
+    case WS_MSG_SET_PUMP:
+        result.command = findWsCommand(wsCommandHash("set_pump"));
+        if (packedField(msg[1], msg[1].is<uint8_t>() && msg[1].as<uint8_t>() < 4, "pump_id", result) &&
+            packedField(msg[2], msg[2].is<bool>() && !(msg[2].as<bool>() && safetySupervisor.emergencyActive()), "state", result)) {
+            postControlCommand(ControlCommandType::SetPump, msg[1], msg[2].as<bool>());
         }
-
-        async function saveWiFi(event) {
-            event.preventDefault();
-            
-            const ssid = ssidSelect.value;
-            const password = passwordInput.value;
-            
-            if (!ssid) {
-                showStatus('Por favor, selecione uma rede WiFi', 'error');
-                return;
-            }
-            
-            showLoading(true);
-            showStatus('Salvando configuração...', 'info');
-            
-            try {
-                const formData = new FormData();
-                formData.append('ssid', ssid);
-                formData.append('password', password);
-                
-                const response = await fetch('/api/savewifi', {
-                    method: 'POST',
-                    body: formData
-                });
-                
-                if (response.ok) {
-                    showStatus('✅ Configuração salva! O dispositivo está reiniciando...', 'success');
-                    setTimeout(() => {
-                        showStatus('🔄 Reiniciando... Aguarde alguns segundos e tente conectar à sua rede WiFi.', 'info');
-                    }, 2000);
-                } else {
-                    const error = await response.text();
-                    showStatus('Erro: ' + error, 'error');
-                }
-            } catch (error) {
-                showStatus('Erro ao salvar: ' + error.message, 'error');
-            } finally {
-                showLoading(false);
-            }
-        }
-
-        scanBtn.addEventListener('click', scanNetworks);
-        form.addEventListener('submit', saveWiFi);
-        
-        // Escanear automaticamente ao carregar a página
-        window.addEventListener('load', scanNetworks);
-    </script>
-</body>
-</html>
-)");
-}
-
-// --- Interface HTML ---
-String getMainPage() {
-    return String(R"(
-<!DOCTYPE html>
-<html lang="pt-BR" class="dark">
-<head>
-    <meta charset="UTF-8">
-    <meta name="viewport" content="width=device-width, initial-scale=1.0">
-    <title>Quinta dos Britos - Piscina</title>
-    <script src="https://cdn.tailwindcss.com"></script>
-    <style>
-        :root { --main-hue: 231; }
-        body { 
-            background-color: hsl(var(--main-hue), 15%, 15%);
-            background-image: radial-gradient(circle at 1px 1px, hsl(var(--main-hue), 15%, 20%) 1px, transparent 0);
-            background-size: 20px 20px;
-            transition: --main-hue 0.5s ease;
+        break;
+    case WS_MSG_EMERGENCY_STOP:
+        safetySupervisor.emergencyStop(EmergencySource::Command);
+        break;
+    case WS_MSG_CLEAR_EMERGENCY:
+        safetySupervisor.clearEmergency();
+        break;
+    case WS_MSG_SET_RGB:
+        result.command = findWsCommand(wsCommandHash("set_rgb"));
+        if (packedField(msg[1], msg[1].is<uint8_t>(), "color", result) &&
+            packedField(msg[2], msg[2].is<uint8_t>(), "color", result) &&
+            packedField(msg[3], msg[3].is<uint8_t>(), "color", result)) {
+            rgbMailbox.post(msg[1], msg[2], msg[3]); // Aplicada no próximo quadro do loop()
         }
-        .pump-card.pump-active {
-            box-shadow: 0 0 20px 5px hsla(var(--main-hue), 90%, 60%, 0.5);
-            border-color: hsl(var(--main-hue), 90%, 60%);
+        break;
+    case WS_MSG_SET_EFFECT:
+        result.command = findWsCommand(wsCommandHash("set_effect"));
+        if (packedField(msg[1], msg[1].is<uint8_t>() && msg[1].as<uint8_t>() <= static_cast<uint8_t>(RgbEffectType::Pulse), "effect", result) &&
+            (msg[2].isNull() || packedField(msg[2], msg[2].is<uint32_t>() && msg[2].as<uint32_t>() <= 3600000, "period_ms", result))) {
+            postControlCommand(ControlCommandType::SetEffect, msg[1], msg[2] | 5000);
         }
-    </style>
-</head>
-<body class="text-gray-200 font-sans">
-    <div class="container mx-auto p-4 max-w-2xl">
-        <header class="text-center py-6">
-            <h1 class="text-4xl md:text-5xl font-bold tracking-tight">🏛️ Quinta dos Britos</h1>
-            <p class="text-xl text-gray-400 mt-2">Sistema de Automação da Piscina</p>
-        </header>
-        <main>
-            <section class="grid grid-cols-2 gap-4 mb-6 text-center">
-                <div class="bg-gray-800/50 backdrop-blur-sm p-4 rounded-lg">
-                    <h3 class="font-semibold text-lg">🌡️ Temperatura</h3>
-                    <p class="text-3xl font-mono" id="temp-display">--.- °C</p>
-                </div>
-                <div class="bg-gray-800/50 backdrop-blur-sm p-4 rounded-lg">
-                    <h3 class="font-semibold text-lg">☀️ Luminosidade</h3>
-                    <p class="text-3xl font-mono" id="lumi-display">-- %</p>
-                </div>
-            </section>
-            <section class="grid grid-cols-2 md:grid-cols-4 gap-4 mb-6">
-    )") +
-    [&]() {
-        String cards = "";
-        for (int i = 0; i < 4; ++i) {
-            cards += R"(<div id="card)" + String(i) + R"(" class="pump-card bg-gray-800/50 backdrop-blur-sm p-4 rounded-lg text-center border-2 border-transparent transition-all duration-300">
-                    <h3 class="font-bold text-lg mb-2">)" + PUMP_NAMES[i] + R"(</h3>
-                    <input type="checkbox" id="pump)" + String(i) + R"(" class="toggle-checkbox hidden">
-                    <label for="pump)" + String(i) + R"(" class="cursor-pointer inline-block w-14 h-8 bg-gray-600 rounded-full p-1 transition-colors duration-300">
-                        <span class="inline-block w-6 h-6 bg-white rounded-full shadow-md transform transition-transform duration-300"></span>
-                    </label>
-                </div>)";
-        }
-        return cards;
-    }() +
-    String(R"(
-            </section>
-            <section class="bg-gray-800/50 backdrop-blur-sm p-4 rounded-lg">
-                <h3 class="font-semibold text-lg mb-2 text-center">🎨 Iluminação RGB</h3>
-                <div class="flex justify-center items-center">
-                    <input type="color" id="colorPicker" value="#FF00FF" class="w-24 h-12 p-1 bg-gray-700 rounded-md cursor-pointer">
-                </div>
-            </section>
-            <footer class="text-center mt-6">
-                <p id="connectionStatus" class="font-mono text-sm text-red-500">🔴 Desconectado</p>
-            </footer>
-        </main>
-    </div>
-    <script>
-        const ws = new WebSocket(`ws://${window.location.host}/ws`);
-
-        function hexToHsl(hex) {
-            const result = /^#?([a-f\d]{2})([a-f\d]{2})([a-f\d]{2})$/i.exec(hex);
-            let r = parseInt(result[1], 16) / 255, g = parseInt(result[2], 16) / 255, b = parseInt(result[3], 16) / 255;
-            const max = Math.max(r, g, b), min = Math.min(r, g, b);
-            let h, s, l = (max + min) / 2;
-            if (max === min) { h = s = 0; }
-            else {
-                const d = max - min;
-                s = l > 0.5 ? d / (2 - max - min) : d / (max + min);
-                switch (max) {
-                    case r: h = (g - b) / d + (g < b ? 6 : 0); break;
-                    case g: h = (b - r) / d + 2; break;
-                    case b: h = (r - g) / d + 4; break;
-                }
-                h /= 6;
-            }
-            return { h: Math.round(h * 360), s: Math.round(s * 100), l: Math.round(l * 100) };
-        }
-
-        ws.onopen = () => document.getElementById('connectionStatus').textContent = '🟢 Conectado';
-        ws.onclose = () => document.getElementById('connectionStatus').textContent = '🔴 Desconectado';
+        break;
+    default:
+        result.error = WsCommandError::UnknownAction;
+        break;
+    }
+    if (result.error != WsCommandError::None) {
+        wsCommands.sendPackedError(client, result);
+    }
+}
 
-        ws.onmessage = (event) => {
-            const state = JSON.parse(event.data);
-            if (state.action !== 'full_state') return;
+// Argumento posicional de um comando binário; ausente ou inaceitável vira missing_field/invalid_field
+bool packedField(JsonVariantConst value, bool ok, const char* name, WsCommandResult& result) {
+    if (value.isNull()) {
+        result.error = WsCommandError::MissingField;
+    } else if (!ok) {
+        result.error = WsCommandError::InvalidField;
+    } else {
+        return true;
+    }
+    result.field = name;
+    return false;
+}
 
-            state.pumps.forEach((isOn, i) => {
-                document.getElementById(`pump${i}`).checked = isOn;
-                document.getElementById(`card${i}`).classList.toggle('pump-active', isOn);
-            });
+// Filtro do handshake: o cliente pediu o subprotocolo MessagePack
+bool requestsMsgPack(AsyncWebServerRequest *request) {
+    const AsyncWebHeader* protocol = request->getHeader("Sec-WebSocket-Protocol");
+    return protocol && strstr(protocol->value().c_str(), WS_MSGPACK_PROTOCOL) != nullptr;
+}
 
-            document.getElementById('temp-display').textContent = `${state.sensors.temperature.toFixed(1)} °C`;
-            document.getElementById('lumi-display').textContent = `${state.sensors.luminosity} %`;
-            
-            const hexColor = `#${state.rgb.r.toString(16).padStart(2, '0')}${state.rgb.g.toString(16).padStart(2, '0')}${state.rgb.b.toString(16).padStart(2, '0')}`;
-            document.getElementById('colorPicker').value = hexColor;
+// --- Funções Utilitárias ---
+bool parseHexColor(const char* hex, uint8_t& r, uint8_t& g, uint8_t& b) {
+    if (hex && hex[0] == '#' && strlen(hex) == 7 && strspn(&hex[1], "0123456789abcdefABCDEF") == 6) {
+        long color = strtol(&hex[1], NULL, 16);
+        r = (color >> 16) & 0xFF;
+        g = (color >> 8) & 0xFF;
+        b = color & 0xFF;
+        return true;
+    }
+    return false;
+}
 
-            const hsl = hexToHsl(hexColor);
-            document.documentElement.style.setProperty('--main-hue', hsl.h);
-        };
+// Chamado por ESP.restart(): um estado ainda na janela não se perde no reinício
+void flushPumpStates() {
+    pumpStateStore.flush();
+}
 
-        for(let i=0; i<4; i++) {
-            document.getElementById(`pump${i}`).addEventListener('change', (e) => {
-                ws.send(JSON.stringify({ action: 'set_pump', pump_id: i, state: e.target.checked }));
-            });
+void loadPumpStates() {
+    if (pumpStateStore.begin(controllerState.pumps)) {
+        Serial.println("🔄 Estados das bombas carregados da NVS");
+        for (int i = 0; i < 4; i++) {
+            Serial.printf("   Bomba %d (%s): %s\n", i, PUMP_NAMES[i], controllerState.pumps[i] ? "ON" : "OFF");
         }
+    } else {
+        Serial.println("📝 Nenhum estado salvo encontrado, usando padrões");
+    }
+    esp_register_shutdown_handler(flushPumpStates);
+}
 
-        document.getElementById('colorPicker').addEventListener('input', (e) => {
-            ws.send(JSON.stringify({ action: 'set_rgb', color: e.target.value }));
-        });
-
-        const style = document.createElement('style');
-        style.innerHTML = `.toggle-checkbox:checked + label span { transform: translateX(1.5rem); } .toggle-checkbox:checked + label { background-color: hsl(var(--main-hue), 80%, 60%); }`;
-        document.head.appendChild(style);
-    </script>
-</body>
-</html>
-    )");
+// Páginas pré-comprimidas na flash (web/ -> src/WebAssets.h): nenhuma String
+// no heap por requisição. A URL é fixa, então o navegador revalida a cada
+// acesso e um ETag igual responde 304 sem corpo.
+void sendPage(AsyncWebServerRequest *request, const uint8_t* gz, size_t len, const char* etag) {
+    const AsyncWebHeader* ifNoneMatch = request->getHeader("If-None-Match");
+    if (ifNoneMatch && ifNoneMatch->value() == etag) {
+        AsyncWebServerResponse *response = request->beginResponse(304);
+        response->addHeader("ETag", etag);
+        response->addHeader("Cache-Control", "no-cache");
+        request->send(response);
+        return;
+    }
+    AsyncWebServerResponse *response = request->beginResponse_P(200, "text/html", gz, len);
+    response->addHeader("Content-Encoding", "gzip");
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
 }
+
@@ -0,0 +1,138 @@
+// Fila justa de eventos da AsyncTCP (lib/AsyncTCP/src/AsyncTCPFairQueue.h),
+// com o mesmo laço de despacho da tarefa async
+#include <Arduino.h>
+#include <AsyncTCPFairQueue.h>
+#include <NativeSim.h>
+#include <unity.h>
+
+struct Client {
+    int id;
+};
+
+enum EventType : uint8_t { EVENT_RECV, EVENT_POLL, EVENT_ERROR };
+
+struct Event {
+    Event* next;
+    Client* client;
+    EventType event;
+};
+
+static const size_t SLOTS = 4;
+typedef FairEventQueue<Event, SLOTS> Queue;
+
+// Janela de 1 s, orçamento de 250 ms, reset depois de 2 janelas seguidas
+static const Queue::Config CONFIG = {1000000, 250000, 3, 2};
+
+void setUp() {}
+void tearDown() {}
+
+static Event* event(Client* client, EventType type) {
+    return new Event{nullptr, client, type};
+}
+
+static void push(Queue& queue, Event* e) {
+    if (!queue.push(e, e->event == EVENT_POLL)) delete e;
+}
+
+// Como _get_async_event(): o erro é o último evento da conexão e libera o slot
+static Event* popEvent(Queue& queue) {
+    Event* e = queue.pop();
+    if (e && e->event == EVENT_ERROR) {
+        Event* stale = queue.remove_client(e->client);
+        while (stale) {
+            Event* next = stale->next;
+            delete stale;
+            stale = next;
+        }
+    }
+    return e;
+}
+
+void test_errored_client_is_never_reported_for_reset() {
+    static Queue queue(CONFIG);
+    Client* hog = new Client{1};
+    Client other = {2};
+    uint32_t now = 0;
+
+    // Primeira janela estourando o orçamento: throttled, a uma janela do reset
+    push(queue, event(hog, EVENT_RECV));
+    delete popEvent(queue);
+    TEST_ASSERT_NULL(queue.complete(300000, now));   // abre a janela
+    now += 1000000;
+    push(queue, event(&other, EVENT_RECV));
+    delete popEvent(queue);
+    TEST_ASSERT_NULL(queue.complete(10, now));
+    TEST_ASSERT_FALSE(queue.accepts_poll(hog));
+
+    // Segunda janela: mais 300 ms, e a conexão cai. O callback de erro apaga o cliente
+    push(queue, event(hog, EVENT_RECV));
+    delete popEvent(queue);
+    TEST_ASSERT_NULL(queue.complete(300000, now + 10));
+    push(queue, event(hog, EVENT_ERROR));
+    Event* error = popEvent(queue);
+    TEST_ASSERT_EQUAL(EVENT_ERROR, error->event);
+    delete error;
+    Client* freed = hog;
+    delete hog;
+    TEST_ASSERT_NULL(queue.complete(50, now + 20));
+
+    // O fim da janela é fechado por outra conexão: o cliente apagado não pode voltar
+    for (int window = 0; window < 3; window++) {
+        now += 1000000;
+        push(queue, event(&other, EVENT_RECV));
+        delete popEvent(queue);
+        TEST_ASSERT_TRUE(queue.complete(10, now) != freed);
+    }
+    TEST_ASSERT_EQUAL(0, queue.size());
+    TEST_ASSERT_EQUAL_UINT32(0, queue.stats().hog_resets);
+
+    // Um cliente novo no mesmo endereço começa sem throttle
+    TEST_ASSERT_TRUE(queue.accepts_poll(freed));
+}
+
+void test_shared_queue_coalesces_polls_per_client() {
+    static Queue queue(CONFIG);
+    Client busy[SLOTS] = {{1}, {2}, {3}, {4}};
+    Client a = {5};
+    Client b = {6};
+
+    // Todos os slots com eventos pendentes: as próximas conexões caem na fila compartilhada
+    for (Client& client : busy) push(queue, event(&client, EVENT_RECV));
+    TEST_ASSERT_TRUE(queue.push(event(&a, EVENT_POLL), true));
+    TEST_ASSERT_TRUE(queue.push(event(&b, EVENT_POLL), true));
+    TEST_ASSERT_EQUAL_UINT32(2, queue.stats().shared_fallbacks);
+    TEST_ASSERT_EQUAL_UINT32(0, queue.stats().polls_coalesced);
+
+    // Um segundo poll da mesma conexão é coalescido, o da outra não é afetado
+    TEST_ASSERT_FALSE(queue.accepts_poll(&a));
+    Event* repeat = event(&a, EVENT_POLL);
+    TEST_ASSERT_FALSE(queue.push(repeat, true));
+    delete repeat;
+    TEST_ASSERT_EQUAL_UINT32(1, queue.stats().polls_coalesced);
+
+    // Eventos que chegam depois seguem a conexão na fila compartilhada, atrás do poll
+    push(queue, event(&a, EVENT_RECV));
+    TEST_ASSERT_EQUAL(SLOTS + 3, queue.size());
+
+    // Despacha tudo: cada conexão recebe o seu poll, e o de 'a' antes do recv
+    int polls[2] = {0, 0};
+    bool aPolled = false;
+    while (Event* e = popEvent(queue)) {
+        if (e->client == &a && e->event == EVENT_POLL) aPolled = true;
+        if (e->client == &a && e->event == EVENT_RECV) TEST_ASSERT_TRUE(aPolled);
+        if (e->event == EVENT_POLL) polls[e->client == &a ? 0 : 1]++;
+        delete e;
+        queue.complete(10, 0);
+    }
+    TEST_ASSERT_EQUAL(1, polls[0]);
+    TEST_ASSERT_EQUAL(1, polls[1]);
+    TEST_ASSERT_TRUE(queue.accepts_poll(&a));
+    TEST_ASSERT_TRUE(queue.accepts_poll(&b));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_errored_client_is_never_reported_for_reset);
+    RUN_TEST(test_shared_queue_coalesces_polls_per_client);
+    return sim::end(UNITY_END());
+}
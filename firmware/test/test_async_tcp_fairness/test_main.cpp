@@ -0,0 +1,180 @@
+// Latência de cauda da fila de eventos da AsyncTCP com um consumidor lento:
+// simulação de eventos discretos da tarefa async com três dashboards rápidos e
+// uma conexão lenta (rajadas de eventos, callbacks de 30 ms), comparando a fila
+// justa (AsyncTCPFairQueue.h) com uma FIFO única
+#include <Arduino.h>
+#include <AsyncTCPFairQueue.h>
+#include <NativeSim.h>
+#include <unity.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <queue>
+#include <vector>
+
+struct Client {
+    int id;
+};
+
+enum EventType : uint8_t { EVENT_RECV, EVENT_SENT, EVENT_POLL };
+
+struct Event {
+    Event* next;
+    Client* client;
+    EventType event;
+    double queuedMs;
+};
+
+struct Arrival {
+    double ms;
+    int client;
+    EventType event;
+    bool operator>(const Arrival& other) const { return ms > other.ms; }
+};
+
+static const int FAST_CLIENTS = 3;
+static const int SLOW = FAST_CLIENTS;
+static const double FAST_CALLBACK_MS = 0.5;
+static const double SLOW_CALLBACK_MS = 30;
+static const double RUN_MS = 60000;
+
+typedef FairEventQueue<Event, 16> FairQueue;
+
+// Janela de 1 s, orçamento de 250 ms, 3 rodadas puladas, sem reset
+static const FairQueue::Config CONFIG = {1000000, 250000, 3, 0};
+
+static Client clients[FAST_CLIENTS + 1] = {{0}, {1}, {2}, {3}};
+
+// Referência: uma FIFO para todas as conexões (polls coalescidos só se já houver um da mesma conexão na fila)
+class FifoQueue {
+public:
+    bool push(Event* e, bool poll) {
+        if (poll) {
+            for (Event* queued = _events.begin(); queued; queued = queued->next) {
+                if (queued->client == e->client && queued->event == EVENT_POLL) return false;
+            }
+        }
+        _events.push_back(e);
+        return true;
+    }
+    Event* pop() { return _events.pop_front(); }
+    void complete(uint32_t, uint32_t) {}
+
+private:
+    SimpleIntrusiveList<Event> _events;
+};
+
+class FairAdapter {
+public:
+    explicit FairAdapter(FairQueue& queue) : _queue(queue) {}
+    bool push(Event* e, bool poll) { return _queue.push(e, poll); }
+    Event* pop() { return _queue.pop(); }
+    void complete(uint32_t busyUs, uint32_t nowUs) { _queue.complete(busyUs, nowUs); }
+
+private:
+    FairQueue& _queue;
+};
+
+struct Latency {
+    double p50;
+    double p99;
+    double max;
+    size_t slowServed;
+};
+
+static double percentile(std::vector<double>& values, double p) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+}
+
+// Dashboards: um recv a cada 100 ms e um poll a cada 500 ms. Conexão lenta: rajada de 25 "sent" por segundo
+// (um WS_EVT_DATA grande sendo drenado) e um poll a cada 500 ms
+template <typename Q>
+static Latency simulate(Q& queue) {
+    std::priority_queue<Arrival, std::vector<Arrival>, std::greater<Arrival>> arrivals;
+    for (int c = 0; c < FAST_CLIENTS; c++) {
+        for (double ms = c * 7; ms < RUN_MS; ms += 100) arrivals.push({ms, c, EVENT_RECV});
+        for (double ms = c * 13; ms < RUN_MS; ms += 500) arrivals.push({ms, c, EVENT_POLL});
+    }
+    for (double ms = 0; ms < RUN_MS; ms += 1000) {
+        for (int k = 0; k < 25; k++) arrivals.push({ms + k * 0.2, SLOW, EVENT_SENT});
+    }
+    for (double ms = 0; ms < RUN_MS; ms += 500) arrivals.push({ms, SLOW, EVENT_POLL});
+
+    std::vector<double> fast;
+    size_t slowServed = 0;
+    double now = 0;
+    for (;;) {
+        while (!arrivals.empty() && arrivals.top().ms <= now) {
+            Arrival a = arrivals.top();
+            arrivals.pop();
+            Event* e = new Event{nullptr, &clients[a.client], a.event, a.ms};
+            if (!queue.push(e, a.event == EVENT_POLL)) delete e;
+        }
+        Event* e = queue.pop();
+        if (!e) {
+            if (arrivals.empty()) break;
+            now = arrivals.top().ms;
+            continue;
+        }
+        bool slow = e->client->id == SLOW;
+        if (slow) {
+            slowServed++;
+        } else {
+            fast.push_back(now - e->queuedMs);
+        }
+        double cost = slow ? SLOW_CALLBACK_MS : FAST_CALLBACK_MS;
+        now += cost;
+        queue.complete((uint32_t)(cost * 1000), (uint32_t)(now * 1000));
+        delete e;
+    }
+    Latency latency;
+    latency.p50 = percentile(fast, 0.5);
+    latency.p99 = percentile(fast, 0.99);
+    latency.max = percentile(fast, 1);
+    latency.slowServed = slowServed;
+    return latency;
+}
+
+static void report(const char* name, const Latency& latency) {
+    char line[128];
+    snprintf(line, sizeof(line), "%s: rápidos p50 %.1f ms, p99 %.1f ms, máx %.1f ms; eventos lentos servidos %u", name,
+             latency.p50, latency.p99, latency.max, (unsigned)latency.slowServed);
+    TEST_MESSAGE(line);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_fast_clients_tail_latency_is_bounded() {
+    FifoQueue fifo;
+    Latency baseline = simulate(fifo);
+    report("fifo", baseline);
+
+    static FairQueue fair(CONFIG);
+    FairAdapter adapter(fair);
+    Latency latency = simulate(adapter);
+    report("justa", latency);
+
+    // Na FIFO os dashboards esperam a rajada inteira da conexão lenta
+    TEST_ASSERT_GREATER_THAN(10 * SLOW_CALLBACK_MS, baseline.max);
+    // Na fila justa, um callback lento por rodada: p99 de até dois, e o pior caso (recv e poll do mesmo
+    // dashboard na fila atrás de um callback lento) de até três
+    TEST_ASSERT_LESS_OR_EQUAL(2 * SLOW_CALLBACK_MS, latency.p99);
+    TEST_ASSERT_LESS_OR_EQUAL(3 * SLOW_CALLBACK_MS, latency.max);
+    TEST_ASSERT_LESS_THAN(baseline.p99, latency.p99);
+
+    // A conexão lenta estoura o orçamento e é throttled, mas continua sendo servida
+    FairEventQueueStats stats = fair.stats();
+    TEST_ASSERT_GREATER_THAN(0, stats.hog_throttles);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.hog_resets);
+    TEST_ASSERT_GREATER_THAN(0, latency.slowServed);
+    TEST_ASSERT_EQUAL(0, fair.size());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_fast_clients_tail_latency_is_bounded);
+    return sim::end(UNITY_END());
+}
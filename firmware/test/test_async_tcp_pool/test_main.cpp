@@ -0,0 +1,159 @@
+// Pool de pacotes de evento da AsyncTCP (lib/AsyncTCP/src/AsyncTCPSlabPool.h):
+// uma thread no papel do lwIP aloca, outra no da tarefa async libera
+#include <Arduino.h>
+#include <AsyncTCPSlabPool.h>
+#include <NativeSim.h>
+#include <unity.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Mesmo tamanho do lwip_tcp_event_packet_t (maior membro: o evento de DNS)
+struct Packet {
+    Packet* next;
+    int event;
+    void* client;
+    union {
+        struct {
+            void* pcb;
+            void* pb;
+            int8_t err;
+        } recv;
+        struct {
+            const char* name;
+            uint8_t addr[20];
+        } dns;
+    };
+};
+
+static const size_t POOL_SIZE = 68;   // CONFIG_ASYNC_TCP_QUEUE_SIZE (64) + 4
+typedef SimpleSlabPool<sizeof(Packet), alignof(Packet), POOL_SIZE> PacketPool;
+
+void setUp() {}
+void tearDown() {}
+
+void test_pool_hands_out_each_slot_once() {
+    static PacketPool pool;
+    std::vector<void*> slots;
+    for (size_t i = 0; i < POOL_SIZE; i++) {
+        void* slot = pool.allocate();
+        TEST_ASSERT_NOT_NULL(slot);
+        TEST_ASSERT_TRUE(pool.owns(slot));
+        for (void* other : slots) TEST_ASSERT_TRUE(other != slot);
+        slots.push_back(slot);
+    }
+    TEST_ASSERT_NULL(pool.allocate());
+
+    Packet* heap = new Packet();
+    TEST_ASSERT_FALSE(pool.owns(heap));
+    delete heap;
+
+    SimpleSlabPoolStats stats = pool.stats();
+    TEST_ASSERT_EQUAL(POOL_SIZE, stats.in_use);
+    TEST_ASSERT_EQUAL(POOL_SIZE, stats.high_watermark);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.exhausted);
+    for (void* slot : slots) pool.release(slot);
+    TEST_ASSERT_EQUAL(0, pool.stats().in_use);
+    TEST_ASSERT_NOT_NULL(pool.allocate());
+}
+
+struct StormResult {
+    double nsPerEvent;
+    uint64_t heapPackets;
+};
+
+// Produtor e consumidor ligados por um anel de `backlog` posições; o consumidor
+// aloca uma String de vez em quando, como os handlers
+template <bool UsePool>
+static StormResult storm(PacketPool& pool, long events, size_t backlog) {
+    std::vector<std::atomic<Packet*>> ring(backlog);
+    for (auto& slot : ring) slot = nullptr;
+    std::atomic<size_t> head{0}, tail{0};
+    std::atomic<uint64_t> heapPackets{0};
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread lwip([&] {
+        for (long i = 0; i < events; i++) {
+            void* memory = UsePool ? pool.allocate() : nullptr;
+            Packet* packet;
+            if (memory) {
+                packet = new (memory) Packet();
+            } else {
+                packet = new Packet();
+                heapPackets++;
+            }
+            packet->event = i & 7;
+            while (head - tail >= backlog) std::this_thread::yield();
+            ring[head % backlog] = packet;
+            head++;
+        }
+    });
+    std::thread async([&] {
+        std::string body;
+        for (long done = 0; done < events;) {
+            if (tail == head) {
+                std::this_thread::yield();
+                continue;
+            }
+            Packet* packet = ring[tail % backlog];
+            tail++;
+            if ((done & 15) == 0) body = std::string(64 + done % 200, 'x');
+            if (pool.owns(packet)) {
+                pool.release(packet);
+            } else {
+                delete packet;
+            }
+            done++;
+        }
+    });
+    lwip.join();
+    async.join();
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / events;
+    return {ns, heapPackets.load()};
+}
+
+void test_event_storm_within_queue_size_never_touches_heap() {
+    static PacketPool pool;
+    const long EVENTS = 500000;
+    StormResult heap = storm<false>(pool, EVENTS, 64);
+    StormResult slab = storm<true>(pool, EVENTS, 64);
+
+    char line[128];
+    snprintf(line, sizeof(line), "%ld eventos, fila de 64: new/delete %.1f ns/evento, pool %.1f ns/evento", EVENTS,
+             heap.nsPerEvent, slab.nsPerEvent);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL_UINT64(EVENTS, heap.heapPackets);
+    // Backlog dentro da fila: o pool atende tudo
+    TEST_ASSERT_EQUAL_UINT64(0, slab.heapPackets);
+    SimpleSlabPoolStats stats = pool.stats();
+    TEST_ASSERT_EQUAL(0, stats.in_use);
+    TEST_ASSERT_LESS_OR_EQUAL(POOL_SIZE, stats.high_watermark);
+    TEST_ASSERT_EQUAL_UINT32(EVENTS, stats.allocations);
+}
+
+void test_deep_backlog_falls_back_to_heap() {
+    static PacketPool pool;
+    const long EVENTS = 200000;
+    StormResult slab = storm<true>(pool, EVENTS, 256);
+
+    SimpleSlabPoolStats stats = pool.stats();
+    char line[128];
+    snprintf(line, sizeof(line), "fila de 256: %.1f ns/evento, %llu pacotes no heap", slab.nsPerEvent,
+             (unsigned long long)slab.heapPackets);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL_UINT64(stats.exhausted, slab.heapPackets);
+    TEST_ASSERT_EQUAL_UINT64(EVENTS, stats.allocations + slab.heapPackets);
+    TEST_ASSERT_EQUAL(0, stats.in_use);
+    TEST_ASSERT_EQUAL(POOL_SIZE, stats.high_watermark);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_pool_hands_out_each_slot_once);
+    RUN_TEST(test_event_storm_within_queue_size_never_touches_heap);
+    RUN_TEST(test_deep_backlog_falls_back_to_heap);
+    return sim::end(UNITY_END());
+}
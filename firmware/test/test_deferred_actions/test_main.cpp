@@ -0,0 +1,164 @@
+// Ações adiadas para depois da resposta HTTP (src/DeferredActions.h):
+// schedule() no handler, release() pelo onDisconnect do servidor simulado e
+// poll() do loop(), incluindo o fallback de RELEASE_TIMEOUT_MS
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <NativeSim.h>
+#include <unity.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "DeferredActions.h"
+
+static DeferredActionQueue* queue = nullptr;
+static std::vector<DeferredAction> ran;
+static size_t ranInsideHandler = 0;
+
+static void runAction(DeferredAction action) {
+    ran.push_back(action);
+}
+
+static AsyncWebServer server(8080);
+
+// Como /api/restart: agenda, faz um poll() ainda dentro do handler e responde
+static void scheduleAndRespond(AsyncWebServerRequest* request, DeferredAction action, unsigned long delayMs) {
+    TEST_ASSERT_TRUE(queue->schedule(request, action, delayMs));
+    queue->poll(millis() + DeferredActionQueue::RELEASE_TIMEOUT_MS - 1);
+    ranInsideHandler += ran.size();
+    request->send(200, "application/json", "{\"status\":\"ok\"}");
+}
+
+void setUp() {
+    queue = new DeferredActionQueue();
+    queue->begin(runAction);
+    ran.clear();
+    ranInsideHandler = 0;
+}
+void tearDown() {
+    delete queue;
+    queue = nullptr;
+}
+
+void test_action_runs_only_after_the_response() {
+    sim::HttpResponse response = sim::http(HTTP_POST, "/restart");
+    TEST_ASSERT_EQUAL(200, response.code);
+    TEST_ASSERT_EQUAL(0, ranInsideHandler);   // a resposta ainda não tinha saído
+
+    queue->poll(millis());
+    TEST_ASSERT_EQUAL(1, ran.size());
+    TEST_ASSERT_EQUAL(DeferredAction::Restart, ran[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, queue->executed());
+    TEST_ASSERT_EQUAL_UINT32(0, queue->timedOut());
+
+    // Executada uma vez só
+    queue->poll(millis() + 60000);
+    TEST_ASSERT_EQUAL(1, ran.size());
+}
+
+void test_delay_counts_from_the_release() {
+    sim::http(HTTP_POST, "/wifi");
+    unsigned long releasedAt = millis();
+    queue->poll(releasedAt);
+    TEST_ASSERT_EQUAL(0, ran.size());
+    queue->poll(releasedAt + 250);
+    TEST_ASSERT_EQUAL(1, ran.size());
+    TEST_ASSERT_EQUAL(DeferredAction::ApplyWifi, ran[0]);
+}
+
+void test_repeated_request_is_not_duplicated() {
+    sim::http(HTTP_POST, "/restart");
+    sim::http(HTTP_POST, "/restart");
+    sim::http(HTTP_POST, "/wifi");
+    unsigned long now = millis() + 1000;
+    for (int i = 0; i < 5; i++) queue->poll(now);
+    TEST_ASSERT_EQUAL(2, ran.size());
+    TEST_ASSERT_EQUAL(DeferredAction::Restart, ran[0]);
+    TEST_ASSERT_EQUAL(DeferredAction::ApplyWifi, ran[1]);
+}
+
+void test_missing_disconnect_falls_back_to_timeout() {
+    // Requisição cujo onDisconnect nunca vem (cliente sumiu antes do fim da resposta)
+    AsyncWebServerRequest request;
+    unsigned long scheduledAt = millis();
+    TEST_ASSERT_TRUE(queue->schedule(&request, DeferredAction::FactoryReset));
+
+    queue->poll(scheduledAt + DeferredActionQueue::RELEASE_TIMEOUT_MS - 10);
+    TEST_ASSERT_EQUAL(0, ran.size());
+    queue->poll(scheduledAt + DeferredActionQueue::RELEASE_TIMEOUT_MS + 10);
+    TEST_ASSERT_EQUAL(1, ran.size());
+    TEST_ASSERT_EQUAL(DeferredAction::FactoryReset, ran[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, queue->timedOut());
+
+    // Com atraso, o prazo soma os dois
+    AsyncWebServerRequest delayed;
+    scheduledAt = millis();
+    TEST_ASSERT_TRUE(queue->schedule(&delayed, DeferredAction::Restart, 1000));
+    queue->poll(scheduledAt + DeferredActionQueue::RELEASE_TIMEOUT_MS + 500);
+    TEST_ASSERT_EQUAL(1, ran.size());
+    queue->poll(scheduledAt + DeferredActionQueue::RELEASE_TIMEOUT_MS + 1010);
+    TEST_ASSERT_EQUAL(2, ran.size());
+    TEST_ASSERT_EQUAL_UINT32(2, queue->timedOut());
+}
+
+void test_late_disconnect_after_timeout_is_harmless() {
+    AsyncWebServerRequest request;
+    unsigned long scheduledAt = millis();
+    queue->schedule(&request, DeferredAction::Restart);
+    queue->poll(scheduledAt + DeferredActionQueue::RELEASE_TIMEOUT_MS + 10);
+    TEST_ASSERT_EQUAL(1, ran.size());
+
+    // A mesma ação agendada de novo não é liberada pelo onDisconnect da requisição antiga
+    AsyncWebServerRequest again;
+    scheduledAt = millis();
+    queue->schedule(&again, DeferredAction::Restart);
+    sim::http(HTTP_POST, "/wifi");   // outra requisição completa no meio
+    queue->poll(millis() + 300);
+    TEST_ASSERT_EQUAL(2, ran.size());
+    TEST_ASSERT_EQUAL(DeferredAction::ApplyWifi, ran[1]);
+    queue->poll(scheduledAt + DeferredActionQueue::RELEASE_TIMEOUT_MS - 10);
+    TEST_ASSERT_EQUAL(2, ran.size());
+}
+
+// O loop() lê `now` antes de o AsyncTCP carimbar: a entrada é "do futuro" para
+// esse poll() e não pode contar como vencida nem pular o atraso
+void test_stamp_after_the_loop_read_is_not_expired() {
+    unsigned long now = millis();
+    delay(5);
+    AsyncWebServerRequest request;
+    TEST_ASSERT_TRUE(queue->schedule(&request, DeferredAction::FactoryReset));
+    sim::http(HTTP_POST, "/wifi");   // liberada na hora, com 250 ms de atraso
+    queue->poll(now);
+    TEST_ASSERT_EQUAL(0, ran.size());
+    TEST_ASSERT_EQUAL_UINT32(0, queue->timedOut());
+
+    queue->poll(millis() + 250);
+    TEST_ASSERT_EQUAL(1, ran.size());
+    TEST_ASSERT_EQUAL(DeferredAction::ApplyWifi, ran[0]);
+    queue->poll(millis() + DeferredActionQueue::RELEASE_TIMEOUT_MS);
+    TEST_ASSERT_EQUAL(2, ran.size());
+    TEST_ASSERT_EQUAL(DeferredAction::FactoryReset, ran[1]);
+    TEST_ASSERT_EQUAL_UINT32(1, queue->timedOut());
+}
+
+int main(int argc, char** argv) {
+    char root[] = "/tmp/qp-test-XXXXXX";
+    sim::config().root = mkdtemp(root);
+    sim::begin(argc, argv);
+    server.on("/restart", HTTP_POST, [](AsyncWebServerRequest* request) {
+        scheduleAndRespond(request, DeferredAction::Restart, 0);
+    });
+    server.on("/wifi", HTTP_POST, [](AsyncWebServerRequest* request) {
+        scheduleAndRespond(request, DeferredAction::ApplyWifi, 250);
+    });
+    server.begin();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_action_runs_only_after_the_response);
+    RUN_TEST(test_delay_counts_from_the_release);
+    RUN_TEST(test_repeated_request_is_not_duplicated);
+    RUN_TEST(test_missing_disconnect_falls_back_to_timeout);
+    RUN_TEST(test_late_disconnect_after_timeout_is_harmless);
+    RUN_TEST(test_stamp_after_the_loop_read_is_not_expired);
+    return sim::end(UNITY_END());
+}
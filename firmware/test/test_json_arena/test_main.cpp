@@ -0,0 +1,122 @@
+// Caminhos quentes do JSON sem heap (src/JsonArena.h): sendFullState() e
+// broadcastDelta() montam e serializam o documento na arena da tarefa; os
+// únicos blocos do heap são o buffer e o payload da mensagem, que são da
+// biblioteca do WebSocket
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <NativeSim.h>
+#include <unity.h>
+
+#include <cstdlib>
+
+#include "ControllerState.h"
+#include "JsonArena.h"
+
+// Conta malloc/realloc só na thread que está medindo (as tarefas simuladas seguem rodando)
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+
+static thread_local bool counting = false;
+static long heapAllocations = 0;
+
+extern "C" void* malloc(size_t size) {
+    if (counting) heapAllocations++;
+    return __libc_malloc(size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size) {
+    if (counting) heapAllocations++;
+    return __libc_realloc(ptr, size);
+}
+
+void setup();
+void loop();
+void sendFullState(AsyncWebSocket* server, AsyncWebSocketClient* client);
+void broadcastDelta(const StateDelta& delta);
+
+extern AsyncWebSocket ws;
+extern StaticJsonArena<JSON_POOL_BYTES + 1024> netJsonArena;
+extern StaticJsonArena<3 * JSON_POOL_BYTES + 1024> asyncJsonArena;
+
+static const int MESSAGES = 1000;
+static const uint32_t ALL_FIELDS = 0x0F | (1 << 4) | (1 << 5) | (1 << 6) | (0x0F << 8);
+
+static uint32_t clients[4];
+
+// Alocações do heap durante fn(), descontadas as da camada WS (buffer e payload da mensagem)
+template <typename Fn>
+static long allocationsOutsideWs(Fn fn) {
+    long before = heapAllocations;
+    uint64_t wsBlocksBefore = sim::stats().wsHeapBlocks.load();
+    counting = true;
+    fn();
+    counting = false;
+    return (heapAllocations - before) - (long)(sim::stats().wsHeapBlocks.load() - wsBlocksBefore);
+}
+
+static void drain() {
+    for (uint32_t id : clients) sim::wsReceive(id);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_full_state_does_not_touch_the_heap() {
+    long allocations = 0;
+    for (int i = 0; i < MESSAGES; i++) {
+        AsyncWebSocketClient* client = ws.client(clients[i % 4]);
+        TEST_ASSERT_NOT_NULL(client);
+        allocations += allocationsOutsideWs([&] { sendFullState(&ws, client); });
+        drain();
+    }
+    char line[96];
+    snprintf(line, sizeof(line), "%d full_state: %ld alocações fora da camada WS, arena %u/%u bytes", MESSAGES,
+             allocations, (unsigned)asyncJsonArena.highWater(), (unsigned)asyncJsonArena.capacity());
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL(0, allocations);
+    TEST_ASSERT_EQUAL_UINT32(0, asyncJsonArena.overflows());
+}
+
+void test_delta_broadcast_does_not_touch_the_heap() {
+    StateDelta delta;
+    delta.fields = ALL_FIELDS;
+    long allocations = 0;
+    for (int i = 0; i < MESSAGES; i++) {
+        delta.state.seq++;
+        delta.state.pumps[i % 4] = !delta.state.pumps[i % 4];
+        delta.state.temperature = 20 + (i % 100) / 10.0f;
+        delta.state.luminosity = i % 101;
+        for (ProbeState& probe : delta.state.probes) {
+            probe.present = true;
+            probe.valid = true;
+            probe.celsius = delta.state.temperature;
+        }
+        allocations += allocationsOutsideWs([&] { broadcastDelta(delta); });
+        drain();
+    }
+    char line[96];
+    snprintf(line, sizeof(line), "%d deltas: %ld alocações fora da camada WS, arena %u/%u bytes", MESSAGES,
+             allocations, (unsigned)netJsonArena.highWater(), (unsigned)netJsonArena.capacity());
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL(0, allocations);
+    TEST_ASSERT_EQUAL_UINT32(0, netJsonArena.overflows());
+}
+
+int main(int argc, char** argv) {
+    char root[] = "/tmp/qp-test-XXXXXX";
+    sim::config().root = mkdtemp(root);
+    sim::begin(argc, argv);
+    for (int i = 0; i < 4; i++) sim::addTemperatureProbe(24.0f + i);
+    setup();
+    for (uint32_t& client : clients) client = sim::wsConnect("/ws");
+    for (int i = 0; i < 50; i++) {
+        loop();
+        delay(1);
+    }
+    drain();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_full_state_does_not_touch_the_heap);
+    RUN_TEST(test_delta_broadcast_does_not_touch_the_heap);
+    return sim::end(UNITY_END());
+}
@@ -0,0 +1,105 @@
+// Camada de simulação (lib/NativeHal): o que os outros testes assumem dela
+#include <Arduino.h>
+#include <NativeSim.h>
+#include <Preferences.h>
+#include <SPIFFS.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <unity.h>
+
+#include <atomic>
+#include <cstdlib>
+
+void setUp() {}
+void tearDown() {}
+
+static std::atomic<int> interrupts{0};
+
+static void onFalling(void* arg) {
+    static_cast<std::atomic<int>*>(arg)->fetch_add(1);
+}
+
+void test_pins_and_interrupts() {
+    pinMode(26, OUTPUT);
+    digitalWrite(26, HIGH);
+    TEST_ASSERT_EQUAL(HIGH, sim::pinLevel(26));
+
+    pinMode(33, INPUT_PULLUP);
+    TEST_ASSERT_EQUAL(HIGH, digitalRead(33));
+    attachInterruptArg(33, onFalling, &interrupts, FALLING);
+    sim::setDigitalInput(33, LOW);
+    sim::setDigitalInput(33, HIGH);   // borda de subida: não dispara
+    sim::setDigitalInput(33, LOW);
+    TEST_ASSERT_EQUAL(2, interrupts.load());
+    TEST_ASSERT_EQUAL(LOW, digitalRead(33));
+}
+
+void test_nvs_survives_reopen() {
+    Preferences prefs;
+    TEST_ASSERT_TRUE(prefs.begin("teste"));
+    prefs.putUInt("valor", 0xC0FFEE);
+    prefs.end();
+    uint64_t commits = sim::stats().nvsCommits.load();
+    TEST_ASSERT_GREATER_THAN(0, commits);
+
+    TEST_ASSERT_TRUE(prefs.begin("teste", true));
+    TEST_ASSERT_EQUAL_UINT32(0xC0FFEE, prefs.getUInt("valor"));
+    TEST_ASSERT_EQUAL_UINT32(7, prefs.getUInt("ausente", 7));
+    prefs.end();
+}
+
+void test_spiffs_round_trip() {
+    TEST_ASSERT_TRUE(SPIFFS.begin(true));
+    File out = SPIFFS.open("/teste.bin", FILE_WRITE);
+    const uint8_t data[] = {1, 2, 3, 4, 5};
+    TEST_ASSERT_EQUAL(sizeof(data), out.write(data, sizeof(data)));
+    out.close();
+
+    File in = SPIFFS.open("/teste.bin", FILE_READ);
+    uint8_t back[sizeof(data)] = {};
+    TEST_ASSERT_EQUAL(sizeof(data), in.read(back, sizeof(back)));
+    in.close();
+    TEST_ASSERT_EQUAL_MEMORY(data, back, sizeof(data));
+    TEST_ASSERT_TRUE(SPIFFS.remove("/teste.bin"));
+    TEST_ASSERT_FALSE(SPIFFS.exists("/teste.bin"));
+}
+
+void test_clocks_are_monotonic() {
+    int64_t start = esp_timer_get_time();
+    unsigned long startMillis = millis();
+    delay(20);
+    TEST_ASSERT_GREATER_OR_EQUAL(20000, esp_timer_get_time() - start);
+    TEST_ASSERT_GREATER_OR_EQUAL(20, millis() - startMillis);
+}
+
+static TaskHandle_t waiter = nullptr;
+static std::atomic<uint32_t> received{0};
+
+static void waitNotification(void*) {
+    received = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    for (;;) vTaskDelay(1000);
+}
+
+void test_task_notification_wakes_task() {
+    xTaskCreatePinnedToCore(waitNotification, "espera", 4096, nullptr, 5, &waiter, 1);
+    TEST_ASSERT_NOT_NULL(waiter);
+    xTaskNotifyGive(waiter);
+    for (int i = 0; i < 200 && received == 0; i++) delay(1);
+    TEST_ASSERT_EQUAL_UINT32(1, received.load());
+    // Pilha pintada: a tarefa usou pouco, quase tudo continua intacto
+    TEST_ASSERT_GREATER_THAN(4096, uxTaskGetStackHighWaterMark(waiter));
+}
+
+int main(int argc, char** argv) {
+    char root[] = "/tmp/qp-test-XXXXXX";
+    sim::config().root = mkdtemp(root);
+    sim::begin(argc, argv);
+    UNITY_BEGIN();
+    RUN_TEST(test_pins_and_interrupts);
+    RUN_TEST(test_nvs_survives_reopen);
+    RUN_TEST(test_spiffs_round_trip);
+    RUN_TEST(test_clocks_are_monotonic);
+    RUN_TEST(test_task_notification_wakes_task);
+    return sim::end(UNITY_END());
+}
@@ -0,0 +1,108 @@
+// Persistência write-behind das bombas (src/PumpStateStore.h): a NVS
+// simulada conta os commits
+#include <Arduino.h>
+#include <NativeSim.h>
+#include <Preferences.h>
+#include <unity.h>
+
+#include <cstdlib>
+
+#include "PumpStateStore.h"
+
+static bool states[PumpStateStore::PUMP_COUNT];
+
+void setUp() {
+    Preferences prefs;
+    prefs.begin("pump-states");
+    prefs.clear();
+    prefs.end();
+}
+void tearDown() {}
+
+static uint64_t nvsCommits() {
+    return sim::stats().nvsCommits.load();
+}
+
+void test_toggle_storm_collapses_into_one_write() {
+    PumpStateStore store;
+    store.begin(states);
+    uint64_t before = nvsCommits();
+
+    // 1000 set_pump em 4 s (dentro de uma janela de 5 s), um poll() por iteração do loop()
+    for (unsigned long i = 0; i < 1000; i++) {
+        unsigned long now = 1000 + i * 4;
+        states[i % 4] = (i / 4) % 2 == 1;   // termina com todas ligadas
+        store.markDirty(now);
+        store.poll(now);
+    }
+    TEST_ASSERT_EQUAL_UINT64(0, nvsCommits() - before);
+    TEST_ASSERT_TRUE(store.pending());
+
+    store.poll(1000 + PumpStateStore::DEFAULT_WINDOW_MS);
+    char line[64];
+    snprintf(line, sizeof(line), "1000 mudanças -> %llu commit na NVS", (unsigned long long)(nvsCommits() - before));
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL_UINT64(1, nvsCommits() - before);
+    TEST_ASSERT_EQUAL_UINT32(1000, store.changes());
+    TEST_ASSERT_EQUAL_UINT32(1, store.commits());
+    TEST_ASSERT_FALSE(store.pending());
+
+    // O que ficou na NVS é o estado vivo
+    bool restored[PumpStateStore::PUMP_COUNT];
+    PumpStateStore reopened;
+    TEST_ASSERT_TRUE(reopened.begin(restored));
+    TEST_ASSERT_EQUAL_MEMORY(states, restored, sizeof(states));
+}
+
+void test_toggle_back_within_window_skips_write() {
+    PumpStateStore store;
+    store.begin(states);
+    uint64_t before = nvsCommits();
+
+    states[2] = !states[2];
+    store.markDirty(100);
+    states[2] = !states[2];
+    store.markDirty(200);
+    store.poll(100 + PumpStateStore::DEFAULT_WINDOW_MS);
+
+    TEST_ASSERT_EQUAL_UINT64(0, nvsCommits() - before);
+    TEST_ASSERT_EQUAL_UINT32(1, store.skipped());
+    TEST_ASSERT_FALSE(store.pending());
+}
+
+void test_each_window_writes_at_most_once() {
+    PumpStateStore store;
+    store.begin(states);
+    uint64_t before = nvsCommits();
+
+    // 60 s alternando a bomba 0 a cada 100 ms: uma gravação por janela de 5 s
+    for (unsigned long now = 0; now < 60000; now += 100) {
+        states[0] = (now / 100) % 2 == 0;
+        store.markDirty(now);
+        store.poll(now);
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(60000 / PumpStateStore::DEFAULT_WINDOW_MS, nvsCommits() - before);
+}
+
+void test_flush_writes_immediately() {
+    PumpStateStore store;
+    store.begin(states);
+    states[3] = !states[3];
+    store.markDirty(10);
+    uint64_t before = nvsCommits();
+    store.flush();   // reinício: não espera a janela
+    TEST_ASSERT_EQUAL_UINT64(1, nvsCommits() - before);
+    TEST_ASSERT_FALSE(store.pending());
+}
+
+int main(int argc, char** argv) {
+    char root[] = "/tmp/qp-test-XXXXXX";
+    sim::config().root = mkdtemp(root);
+    sim::begin(argc, argv);
+    UNITY_BEGIN();
+    RUN_TEST(test_toggle_storm_collapses_into_one_write);
+    RUN_TEST(test_toggle_back_within_window_skips_write);
+    RUN_TEST(test_each_window_writes_at_most_once);
+    RUN_TEST(test_flush_writes_immediately);
+    return sim::end(UNITY_END());
+}
@@ -0,0 +1,155 @@
+// Motor de efeitos RGB (src/RgbEffects.h): tabelas constexpr contra a conta em
+// ponto flutuante, saída bit a bit estável e custo do núcleo de interpolação
+#include <Arduino.h>
+#include <NativeSim.h>
+#include <unity.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+#include "RgbEffects.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_gamma_table_matches_float_reference() {
+    for (int i = 0; i < 256; i++) {
+        uint16_t expected = static_cast<uint16_t>(std::pow(i / 255.0, rgbfx::GAMMA) * rgbfx::DUTY_MAX + 0.5);
+        TEST_ASSERT_EQUAL_UINT16(expected, rgbfx::GAMMA_TABLE.duty[i]);
+    }
+}
+
+void test_wave_table_matches_float_reference() {
+    int ties = 0;
+    for (int i = 0; i < 256; i++) {
+        double exact = (1 - std::cos(i * 2 * M_PI / 256)) / 2 * 255;
+        uint8_t expected = static_cast<uint8_t>(exact + 0.5);
+        // Em i = 64 e 192 o valor exato é 127,5: std::cos(pi/2) sai 6e-17 e
+        // arredonda para baixo, a série constexpr chega no 0 e arredonda para cima
+        if (std::fabs(exact - std::floor(exact) - 0.5) < 1e-9) {
+            TEST_ASSERT_EQUAL_UINT8(std::floor(exact) + 1, rgbfx::WAVE_TABLE.level[i]);
+            ties++;
+            continue;
+        }
+        TEST_ASSERT_EQUAL_UINT8(expected, rgbfx::WAVE_TABLE.level[i]);
+    }
+    TEST_ASSERT_EQUAL(2, ties);
+}
+
+void test_hue_wheel_keeps_full_saturation() {
+    for (int h = 0; h < 256; h++) {
+        const uint8_t* c = rgbfx::HUE_WHEEL.rgb[h];
+        // S = V = 1: um canal no máximo, um apagado
+        TEST_ASSERT_EQUAL_UINT8(255, std::max(c[0], std::max(c[1], c[2])));
+        TEST_ASSERT_EQUAL_UINT8(0, std::min(c[0], std::min(c[1], c[2])));
+    }
+}
+
+static uint32_t fnv(uint32_t hash, uint16_t value) {
+    hash ^= value & 0xFF;
+    hash *= 16777619u;
+    hash ^= value >> 8;
+    hash *= 16777619u;
+    return hash;
+}
+
+static RgbEffect effect(RgbEffectType type, uint8_t r, uint8_t g, uint8_t b, uint32_t durationMs) {
+    RgbEffect fx;
+    fx.type = type;
+    fx.color[0] = r;
+    fx.color[1] = g;
+    fx.color[2] = b;
+    fx.durationMs = durationMs;
+    return fx;
+}
+
+// 1000 quadros a 100 Hz de cada efeito. Os hashes são os do ESP32: qualquer
+// mudança no núcleo que altere um único duty aparece aqui
+void test_render_sequences_are_bit_exact() {
+    RgbEffect fade = effect(RgbEffectType::Fade, 10, 200, 0, 2000);
+    fade.from[0] = 4095;
+    const struct {
+        RgbEffect fx;
+        uint32_t hash;
+    } cases[] = {
+        {effect(RgbEffectType::Static, 255, 0, 255, 0), 0x93fd52e5},
+        {fade, 0x06e7d1db},
+        {effect(RgbEffectType::Cycle, 255, 255, 255, 10000), 0x01f21bbf},
+        {effect(RgbEffectType::Pulse, 255, 64, 0, 3000), 0x2f7cd695},
+    };
+    for (const auto& c : cases) {
+        uint32_t hash = 2166136261u;
+        uint16_t duty[3];
+        for (uint32_t t = 0; t < 10000; t += 10) {
+            RgbEffectEngine::render(c.fx, t, duty);
+            for (uint16_t d : duty) hash = fnv(hash, d);
+        }
+        TEST_ASSERT_EQUAL_UINT32(c.hash, hash);
+    }
+}
+
+void test_low_brightness_fade_is_smooth() {
+    RgbEffect low = effect(RgbEffectType::Fade, 32, 0, 0, 2000);
+    uint16_t previous = 0;
+    int steps = 0;
+    for (uint32_t t = 0; t <= 2000; t += 10) {
+        uint16_t duty[3];
+        RgbEffectEngine::render(low, t, duty);
+        TEST_ASSERT_GREATER_OR_EQUAL(previous, duty[0]);
+        if (duty[0] != previous) steps++;
+        previous = duty[0];
+    }
+    TEST_ASSERT_EQUAL_UINT16(rgbfx::GAMMA_TABLE.duty[32], previous);
+    // Em 8 bits com gama seriam uns 3 degraus
+    TEST_ASSERT_GREATER_THAN(30, steps);
+}
+
+void test_render_kernel_cost() {
+    RgbEffect fx[2] = {effect(RgbEffectType::Cycle, 255, 255, 255, 10000),
+                       effect(RgbEffectType::Pulse, 255, 64, 0, 3000)};
+    const uint32_t FRAMES = 2000000;
+    volatile uint32_t sink = 0;
+    uint16_t duty[3];
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < FRAMES; n++) {
+        RgbEffectEngine::render(fx[n & 1], n * 10, duty);
+        sink += duty[0];
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double nsPerFrame = seconds * 1e9 / FRAMES;
+    char line[64];
+    snprintf(line, sizeof(line), "render(): %.1f ns por quadro", nsPerFrame);
+    TEST_MESSAGE(line);
+    // O timer pede 100 quadros/s; mesmo sem otimização sobra muito
+    TEST_ASSERT_LESS_THAN(2000, nsPerFrame);
+}
+
+void test_timer_runs_at_100_hz() {
+    RgbEffectEngine engine;
+    const int pins[3] = {25, 26, 27};
+    const int channels[3] = {0, 1, 2};
+    engine.begin(pins, channels);
+    engine.startCycle(255, 1000);
+    uint32_t before = engine.frames();
+    delay(2000);
+    uint32_t frames = engine.frames() - before;
+    TEST_ASSERT_GREATER_OR_EQUAL(180, frames);
+    TEST_ASSERT_LESS_OR_EQUAL(210, frames);
+    TEST_ASSERT_EQUAL_UINT8(rgbfx::DUTY_BITS, sim::pinDutyResolution(25));
+}
+
+int main(int argc, char** argv) {
+    char root[] = "/tmp/qp-test-XXXXXX";
+    sim::config().root = mkdtemp(root);
+    sim::begin(argc, argv);
+    UNITY_BEGIN();
+    RUN_TEST(test_gamma_table_matches_float_reference);
+    RUN_TEST(test_wave_table_matches_float_reference);
+    RUN_TEST(test_hue_wheel_keeps_full_saturation);
+    RUN_TEST(test_render_sequences_are_bit_exact);
+    RUN_TEST(test_low_brightness_fade_is_smooth);
+    RUN_TEST(test_render_kernel_cost);
+    RUN_TEST(test_timer_runs_at_100_hz);
+    return sim::end(UNITY_END());
+}
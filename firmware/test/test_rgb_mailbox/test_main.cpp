@@ -0,0 +1,159 @@
+// Caixa de correio do set_rgb (src/RgbMailbox.h): uma thread postando sem
+// parar enquanto o loop() consome, e o que fica esperando (cor, fila de
+// comandos, fila de saída de cada cliente WebSocket) durante a enxurrada
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+#include <NativeSim.h>
+#include <unity.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+
+#include "ControllerState.h"
+#include "RgbMailbox.h"
+#include "SpscQueue.h"
+
+void setup();
+void loop();
+extern RgbMailbox rgbMailbox;
+extern SpscQueue<ControlCommand, 32> controlCommands;
+
+void setUp() {}
+void tearDown() {}
+
+// Cor n: r e g trazem o contador, b confere os dois (detecta cor rasgada)
+static void colorFor(uint32_t n, uint8_t& r, uint8_t& g, uint8_t& b) {
+    r = (n >> 8) & 0xFF;
+    g = n & 0xFF;
+    b = r ^ g ^ 0x5A;
+}
+
+void test_latest_color_wins_and_is_never_torn() {
+    static const uint32_t POSTS = 0xFFFF;   // o contador cabe em r e g
+    RgbMailbox mailbox;
+    std::atomic<bool> done{false};
+    std::thread producer([&] {
+        for (uint32_t n = 1; n <= POSTS; n++) {
+            uint8_t r, g, b;
+            colorFor(n, r, g, b);
+            mailbox.post(r, g, b);
+        }
+        done = true;
+    });
+
+    uint32_t taken = 0;
+    uint32_t last = 0;   // contador da última cor retirada
+    bool finished = false;
+    while (!finished) {
+        finished = done.load();   // depois de done, um último take() vê a última cor
+        uint8_t r, g, b;
+        if (!mailbox.take(r, g, b)) continue;
+        TEST_ASSERT_EQUAL_UINT8(r ^ g ^ 0x5A, b);
+        uint32_t n = ((uint32_t)r << 8) | g;
+        TEST_ASSERT_GREATER_THAN(last, n);   // nunca volta para uma cor mais velha
+        last = n;
+        taken++;
+    }
+    producer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(POSTS, last);
+    TEST_ASSERT_EQUAL_UINT32(POSTS, mailbox.posted());
+    TEST_ASSERT_EQUAL_UINT32(POSTS, taken + mailbox.overwritten());
+    uint8_t r, g, b;
+    TEST_ASSERT_FALSE(mailbox.take(r, g, b));
+}
+
+// Fila de saída por cliente, lida a cada volta: no máximo o que uma volta do
+// loop() manda (delta de estado e cor)
+static const size_t OUTBOX_BOUND = 2;
+
+void test_flood_costs_one_ledc_update_per_frame() {
+    setup();
+    uint32_t clients[3];
+    for (uint32_t& client : clients) {
+        client = sim::wsConnect("/ws");
+        sim::wsReceive(client);
+    }
+
+    uint64_t ledcBefore = sim::stats().ledcWrites.load();
+    uint64_t wsDroppedBefore = sim::stats().wsMessagesDropped.load();
+    size_t messages = 0;
+    bool sawPending = false;   // cor esperando o loop() na caixa entre as voltas
+    std::atomic<bool> done{false};
+    // 10 mil quadros em ~1 s, de outra thread como a tarefa do AsyncTCP
+    std::thread flooder([&] {
+        char frame[64];
+        for (uint32_t i = 0; i < 10000; i++) {
+            snprintf(frame, sizeof(frame), "{\"action\":\"set_rgb\",\"color\":\"#%06X\"}", (i * 2654435u) & 0xFFFFFF);
+            sim::wsSend(clients[0], frame);
+            if (i % 10 == 0) delayMicroseconds(1000);
+        }
+        sim::wsSend(clients[0], "{\"action\":\"set_rgb\",\"color\":\"#123456\"}");
+        done = true;
+    });
+
+    unsigned long start = millis();
+    unsigned long floodEnd = 0;
+    while (!floodEnd || millis() - floodEnd < 1000) {
+        if (done && !floodEnd) floodEnd = millis();
+        sawPending |= rgbMailbox.pending();
+        loop();
+        delayMicroseconds(1000);
+        for (uint32_t client : clients) messages += sim::wsReceive(client).size();
+    }
+    flooder.join();
+
+    double seconds = (millis() - start) / 1000.0;
+    uint64_t ledcWrites = sim::stats().ledcWrites.load() - ledcBefore;
+    size_t outboxPeak[3];
+    for (int i = 0; i < 3; i++) outboxPeak[i] = sim::wsOutboxPeak(clients[i]);
+    char line[160];
+    snprintf(line, sizeof(line), "10001 set_rgb: %llu escritas LEDC, %zu mensagens WS em %.1f s", (unsigned long long)ledcWrites,
+             messages, seconds);
+    TEST_MESSAGE(line);
+    uint32_t taken = rgbMailbox.posted() - rgbMailbox.overwritten();
+    snprintf(line, sizeof(line), "pico de espera: fila de saída %zu/%zu/%zu, fila de comandos %u; %u cores retiradas da caixa",
+             outboxPeak[0], outboxPeak[1], outboxPeak[2], (unsigned)controlCommands.highWater(), (unsigned)taken);
+    TEST_MESSAGE(line);
+    // Um quadro a cada 16 ms, três canais; cada set_rgb aplicado direto daria 30 mil
+    TEST_ASSERT_LESS_THAN(3 * (seconds * 1000 / 16 + 2), ledcWrites);
+    // Cor publicada no máximo 4x/s para cada um dos três clientes
+    TEST_ASSERT_LESS_THAN(3 * (seconds * 4 + 2), messages);
+
+    // O que espera não cresce com a enxurrada: a caixa guarda uma cor, retirada
+    // no máximo uma vez por quadro; o set_rgb não passa pela fila de comandos;
+    // cada cliente, lido a cada volta, fica longe de WS_MAX_QUEUED_MESSAGES
+    TEST_ASSERT_EQUAL_UINT32(10001, rgbMailbox.posted());
+    TEST_ASSERT_TRUE(sawPending);
+    TEST_ASSERT_FALSE(rgbMailbox.pending());
+    TEST_ASSERT_LESS_THAN(seconds * 1000 / 16 + 2, taken);
+    TEST_ASSERT_EQUAL_UINT32(0, controlCommands.highWater());
+    TEST_ASSERT_EQUAL_UINT32(0, controlCommands.dropped());
+    for (size_t peak : outboxPeak) {
+        TEST_ASSERT_GREATER_THAN(0, peak);
+        TEST_ASSERT_LESS_OR_EQUAL(OUTBOX_BOUND, peak);
+    }
+    TEST_ASSERT_EQUAL_UINT64(wsDroppedBefore, sim::stats().wsMessagesDropped.load());
+    sim::HttpResponse metricsText = sim::http(HTTP_GET, "/api/metrics");
+    TEST_ASSERT_NOT_EQUAL(std::string::npos, metricsText.body.find("# TYPE qp_control_commands_dropped_total counter\n"
+                                                                   "qp_control_commands_dropped_total 0\n"));
+
+    sim::HttpResponse state = sim::http(HTTP_GET, "/api/state");
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, state.body));
+    TEST_ASSERT_EQUAL(0x12, doc["rgb"]["r"].as<int>());
+    TEST_ASSERT_EQUAL(0x34, doc["rgb"]["g"].as<int>());
+    TEST_ASSERT_EQUAL(0x56, doc["rgb"]["b"].as<int>());
+}
+
+int main(int argc, char** argv) {
+    char root[] = "/tmp/qp-test-XXXXXX";
+    sim::config().root = mkdtemp(root);
+    sim::begin(argc, argv);
+    UNITY_BEGIN();
+    RUN_TEST(test_latest_color_wins_and_is_never_torn);
+    RUN_TEST(test_flood_costs_one_ledc_update_per_frame);
+    return sim::end(UNITY_END());
+}
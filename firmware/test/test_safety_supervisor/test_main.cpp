@@ -0,0 +1,159 @@
+// Parada de emergência (src/SafetySupervisor.h) com o firmware inteiro no
+// simulador e a CPU saturada: loop() sem folga (sensores lentos), a rede
+// martelando HTTP e WebSocket e uma thread ocupada por núcleo. Pelo botão
+// (interrupção), por emergencyStop() e pelo comando emergency_stop, a
+// latência até o último relé desligado fica abaixo de 100 ms
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <NativeSim.h>
+#include <unity.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "SafetySupervisor.h"
+
+void setup();
+void loop();
+extern SafetySupervisor safetySupervisor;
+
+// Cópias de main.cpp (constantes de escopo de arquivo lá)
+static const int PUMP_PINS[4] = {23, 22, 19, 18};
+static const uint8_t EMERGENCY_STOP_PIN = 33;
+
+static const uint32_t STOP_BOUND_MICROS = 100000;   // PRD: parada em menos de 100 ms
+static const int TRIALS = 40;                        // por caminho
+
+enum class Trigger { Button, Call, Command };
+
+static std::atomic<bool> running{true};
+static std::vector<std::thread> load;
+static uint32_t wsClient;
+
+static bool relaysAll(int level) {
+    for (int pin : PUMP_PINS) {
+        if (sim::pinLevel(pin) != level) return false;
+    }
+    return true;
+}
+
+static bool waitFor(bool (*done)(), unsigned long timeoutMs) {
+    unsigned long start = millis();
+    while (!done()) {
+        if (millis() - start > timeoutMs) return false;
+        delayMicroseconds(200);
+    }
+    return true;
+}
+
+static void startLoad() {
+    // loop() sem pausa: as sondas simuladas levam o tempo de conversão do DS18B20
+    load.emplace_back([] {
+        while (running) loop();
+    });
+    // Rede: leituras HTTP e comandos WebSocket que não mexem nas bombas
+    load.emplace_back([] {
+        while (running) {
+            sim::http(HTTP_GET, "/api/history?res=1m");
+            sim::http(HTTP_GET, "/api/metrics");
+            sim::http(HTTP_GET, "/api/safety");
+        }
+    });
+    load.emplace_back([] {
+        uint32_t client = sim::wsConnect("/ws");
+        while (running) {
+            sim::wsSend(client, "{\"action\":\"resync\"}");
+            sim::wsReceive(client);
+        }
+        sim::wsDisconnect(client);
+    });
+    unsigned cores = std::max(2u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < cores; i++) {
+        load.emplace_back([] {
+            volatile uint64_t spin = 0;
+            while (running) spin = spin + 1;
+        });
+    }
+}
+
+// Solta a trava, liga as quatro bombas e dispara a parada por `trigger`;
+// devolve a latência medida pelo supervisor
+static uint32_t stopOnce(Trigger trigger) {
+    sim::setDigitalInput(EMERGENCY_STOP_PIN, HIGH);
+    safetySupervisor.clearEmergency();
+    TEST_ASSERT_TRUE(waitFor([] { return !safetySupervisor.emergencyActive(); }, 1000));
+    for (uint8_t pump = 0; pump < SafetySupervisor::PUMP_COUNT; pump++) {
+        TEST_ASSERT_TRUE(safetySupervisor.requestPump(pump, true));
+    }
+    TEST_ASSERT_TRUE(waitFor([] { return relaysAll(HIGH); }, 1000));
+    delayMicroseconds(1000 + rand() % 20000);   // fase aleatória em relação ao TICK_MS
+
+    uint32_t stops = safetySupervisor.stops();
+    switch (trigger) {
+    case Trigger::Button: sim::setDigitalInput(EMERGENCY_STOP_PIN, LOW); break;
+    case Trigger::Call: safetySupervisor.emergencyStop(EmergencySource::Api); break;
+    case Trigger::Command: sim::wsSend(wsClient, "{\"action\":\"emergency_stop\"}"); break;
+    }
+    unsigned long start = millis();
+    while (safetySupervisor.stops() == stops) {
+        TEST_ASSERT_TRUE_MESSAGE(millis() - start < 1000, "parada não aconteceu em 1 s");
+        delayMicroseconds(100);
+    }
+    TEST_ASSERT_TRUE(relaysAll(LOW));
+    TEST_ASSERT_TRUE(safetySupervisor.emergencyActive());
+    TEST_ASSERT_EQUAL_UINT8(0, safetySupervisor.appliedMask());
+    // Com a trava ativa nenhum pedido liga bomba
+    TEST_ASSERT_FALSE(safetySupervisor.requestPump(0, true));
+    return safetySupervisor.lastStopLatencyMicros();
+}
+
+static void runTrials(Trigger trigger, const char* name) {
+    std::vector<uint32_t> latencies;
+    for (int i = 0; i < TRIALS; i++) {
+        uint32_t latency = stopOnce(trigger);
+        TEST_ASSERT_LESS_THAN_UINT32(STOP_BOUND_MICROS, latency);
+        latencies.push_back(latency);
+    }
+    std::sort(latencies.begin(), latencies.end());
+    char line[128];
+    snprintf(line, sizeof(line), "%s: %d paradas, p50 %.3f ms, p99 %.3f ms, máx %.3f ms", name, TRIALS,
+             latencies[TRIALS / 2] / 1000.0, latencies[TRIALS * 99 / 100] / 1000.0, latencies.back() / 1000.0);
+    TEST_MESSAGE(line);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_button_interrupt_stops_within_bound() {
+    runTrials(Trigger::Button, "botão (ISR)");
+}
+
+void test_emergency_stop_call_stops_within_bound() {
+    runTrials(Trigger::Call, "emergencyStop()");
+}
+
+void test_ws_command_stops_within_bound() {
+    runTrials(Trigger::Command, "comando emergency_stop");
+    TEST_ASSERT_LESS_THAN_UINT32(STOP_BOUND_MICROS, safetySupervisor.maxStopLatencyMicros());
+    TEST_ASSERT_EQUAL_UINT32(3 * TRIALS, safetySupervisor.stops());
+}
+
+int main(int argc, char** argv) {
+    char root[] = "/tmp/qp-test-XXXXXX";
+    sim::config().root = mkdtemp(root);
+    sim::begin(argc, argv);
+    for (int i = 0; i < 4; i++) sim::addTemperatureProbe(26.0f + i);
+    setup();
+    wsClient = sim::wsConnect("/ws");
+    startLoad();
+    UNITY_BEGIN();
+    RUN_TEST(test_button_interrupt_stops_within_bound);
+    RUN_TEST(test_emergency_stop_call_stops_within_bound);
+    RUN_TEST(test_ws_command_stops_within_bound);
+    running = false;
+    for (std::thread& thread : load) thread.join();
+    return sim::end(UNITY_END());
+}
@@ -0,0 +1,152 @@
+// Motor de agendamentos (src/ScheduleEngine.h): disparos pelo min-heap e
+// saltos do relógio de parede no meio de uma janela
+#include <Arduino.h>
+#include <NativeSim.h>
+#include <SPIFFS.h>
+#include <unity.h>
+
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+#include "ScheduleEngine.h"
+
+struct PumpAction {
+    int pumpId;
+    bool on;
+};
+
+static std::vector<PumpAction> actions;
+static ScheduleStore store;
+static ScheduleEngine* engine = nullptr;   // novo a cada teste: sem janelas herdadas
+
+static void recordAction(int pumpId, bool on) {
+    actions.push_back({pumpId, on});
+}
+
+// 2024-03-04 (segunda-feira) hh:mm:ss, em UTC
+static time_t at(int day, int hour, int minute, int second = 0) {
+    return 1709510400 + day * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+// Um agendamento diário às 08:00, 30 min, bomba 1
+void setUp() {
+    SPIFFS.remove("/sched.dat");
+    SPIFFS.remove("/sched.log");
+    TEST_ASSERT_TRUE(store.begin(SPIFFS));
+    ScheduleRecord record = {};
+    snprintf(record.name, sizeof(record.name), "Filtro");
+    record.pumpId = 1;
+    record.hour = 8;
+    record.minute = 0;
+    record.duration = 30;
+    record.days = 0x7F;
+    record.enabled = 1;
+    TEST_ASSERT_TRUE(store.create(record));
+    engine = new ScheduleEngine();
+    engine->begin(store, recordAction);
+    actions.clear();
+}
+void tearDown() {
+    delete engine;
+    engine = nullptr;
+}
+
+// O loop() chama tick() a cada poucos segundos; aqui, a cada 30 s até `until`
+static time_t wallClock = 0;
+
+static void runUntil(time_t until) {
+    for (; wallClock < until; wallClock += 30) engine->tick(wallClock);
+    wallClock = until;
+    engine->tick(wallClock);
+}
+
+// Ajuste do relógio (SNTP, manual) seguido de um tick
+static void jumpTo(time_t when) {
+    wallClock = when;
+    engine->tick(wallClock);
+}
+
+static void expectActions(std::initializer_list<PumpAction> expected) {
+    TEST_ASSERT_EQUAL(expected.size(), actions.size());
+    size_t i = 0;
+    for (const PumpAction& action : expected) {
+        TEST_ASSERT_EQUAL(action.pumpId, actions[i].pumpId);
+        TEST_ASSERT_EQUAL(action.on, actions[i].on);
+        i++;
+    }
+    actions.clear();
+}
+
+void test_window_starts_and_stops_every_day() {
+    jumpTo(at(0, 7, 59));
+    expectActions({});
+    runUntil(at(0, 8, 0));
+    expectActions({{1, true}});
+    runUntil(at(0, 8, 29, 59));
+    expectActions({});
+    runUntil(at(0, 8, 30));
+    expectActions({{1, false}});
+    TEST_ASSERT_EQUAL(at(1, 8, 0), engine->nextEventTime());
+    runUntil(at(1, 8, 0));
+    expectActions({{1, true}});
+}
+
+void test_boot_inside_window_turns_pump_on() {
+    jumpTo(at(0, 8, 10));
+    expectActions({{1, true}});
+    runUntil(at(0, 8, 30));
+    expectActions({{1, false}});
+}
+
+void test_backward_jump_out_of_window_keeps_schedule() {
+    jumpTo(at(0, 8, 0));
+    expectActions({{1, true}});
+    // SNTP corrige o relógio duas horas para trás
+    jumpTo(at(0, 6, 10));
+    expectActions({{1, false}});
+    runUntil(at(0, 8, 0));
+    expectActions({{1, true}});
+    runUntil(at(0, 8, 30));
+    expectActions({{1, false}});
+}
+
+void test_forward_jump_out_of_window_keeps_schedule() {
+    jumpTo(at(0, 8, 0));
+    expectActions({{1, true}});
+    jumpTo(at(0, 11, 5));
+    expectActions({{1, false}});
+    runUntil(at(1, 7, 59));
+    expectActions({});
+    runUntil(at(1, 8, 0));
+    expectActions({{1, true}});
+}
+
+void test_jump_inside_window_keeps_pump_on() {
+    jumpTo(at(0, 8, 0));
+    expectActions({{1, true}});
+    runUntil(at(0, 8, 20));
+    // Cinco minutos para trás: ainda dentro da janela, nada muda
+    jumpTo(at(0, 8, 15));
+    expectActions({});
+    runUntil(at(0, 8, 30));
+    expectActions({{1, false}});
+    runUntil(at(1, 8, 0));
+    expectActions({{1, true}});
+}
+
+int main(int argc, char** argv) {
+    char root[] = "/tmp/qp-test-XXXXXX";
+    sim::config().root = mkdtemp(root);
+    sim::begin(argc, argv);
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    SPIFFS.begin(true);
+    UNITY_BEGIN();
+    RUN_TEST(test_window_starts_and_stops_every_day);
+    RUN_TEST(test_boot_inside_window_turns_pump_on);
+    RUN_TEST(test_backward_jump_out_of_window_keeps_schedule);
+    RUN_TEST(test_forward_jump_out_of_window_keeps_schedule);
+    RUN_TEST(test_jump_inside_window_keeps_pump_on);
+    return sim::end(UNITY_END());
+}
@@ -0,0 +1,148 @@
+// Agendamentos em registros binários com diário (src/ScheduleStore.h) sobre o
+// SPIFFS simulado, que conta os bytes gravados na flash
+#include <Arduino.h>
+#include <NativeSim.h>
+#include <SPIFFS.h>
+#include <unity.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+#include "ScheduleStore.h"
+
+static void wipe() {
+    SPIFFS.remove("/sched.dat");
+    SPIFFS.remove("/sched.log");
+    SPIFFS.remove("/sched.tmp");
+}
+
+void setUp() {
+    wipe();
+}
+void tearDown() {}
+
+static ScheduleRecord record(int i) {
+    ScheduleRecord r = {};
+    snprintf(r.name, sizeof(r.name), "Bomba %d", i);
+    r.pumpId = i % 4;
+    r.hour = i % 24;
+    r.minute = i % 60;
+    r.duration = 30;
+    r.days = 0x7F;
+    r.enabled = 1;
+    return r;
+}
+
+// Cria e remove 20 agendamentos por cima de `existing`; médias por operação
+static void measure(size_t existing, double& createMicros, double& createBytes, double& removeMicros,
+                    double& removeBytes) {
+    wipe();
+    ScheduleStore store;
+    TEST_ASSERT_TRUE(store.begin(SPIFFS));
+    for (size_t i = 0; i < existing; i++) {
+        ScheduleRecord r = record(i);
+        TEST_ASSERT_TRUE(store.create(r));
+    }
+
+    const int K = 20;
+    std::vector<uint32_t> ids;
+    uint64_t flash = sim::stats().flashBytesWritten.load();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < K; i++) {
+        ScheduleRecord r = record(i);
+        TEST_ASSERT_TRUE(store.create(r));
+        ids.push_back(r.id);
+    }
+    auto middle = std::chrono::steady_clock::now();
+    uint64_t flashMiddle = sim::stats().flashBytesWritten.load();
+    for (uint32_t id : ids) TEST_ASSERT_TRUE(store.remove(id));
+    auto end = std::chrono::steady_clock::now();
+
+    createMicros = std::chrono::duration<double, std::micro>(middle - start).count() / K;
+    removeMicros = std::chrono::duration<double, std::micro>(end - middle).count() / K;
+    createBytes = double(flashMiddle - flash) / K;
+    removeBytes = double(sim::stats().flashBytesWritten.load() - flashMiddle) / K;
+    TEST_ASSERT_EQUAL(existing, store.count());
+}
+
+void test_cost_does_not_grow_with_schedule_count() {
+    for (size_t existing : {10, 100, 1000}) {
+        double createMicros, createBytes, removeMicros, removeBytes;
+        measure(existing, createMicros, createBytes, removeMicros, removeBytes);
+        char line[128];
+        snprintf(line, sizeof(line), "N=%zu: criar %.0f us / %.0f B, remover %.0f us / %.0f B", existing,
+                 createMicros, createBytes, removeMicros, removeBytes);
+        TEST_MESSAGE(line);
+        // Reescrever tudo a cada operação custava ~108 B por agendamento
+        // existente (108 KB com N=1000); o diário grava uma entrada, e a
+        // compactação ocasional fica amortizada
+        TEST_ASSERT_LESS_THAN(1024, createBytes);
+        TEST_ASSERT_LESS_THAN(1024, removeBytes);
+    }
+}
+
+void test_reopen_restores_every_record() {
+    std::vector<ScheduleRecord> kept;
+    {
+        ScheduleStore store;
+        TEST_ASSERT_TRUE(store.begin(SPIFFS));
+        for (int i = 0; i < 150; i++) {
+            ScheduleRecord r = record(i);
+            TEST_ASSERT_TRUE(store.create(r));
+            if (i % 3 == 0) {
+                TEST_ASSERT_TRUE(store.remove(r.id));
+            } else {
+                kept.push_back(r);
+            }
+        }
+    }
+
+    ScheduleStore reopened;
+    TEST_ASSERT_TRUE(reopened.begin(SPIFFS));
+    TEST_ASSERT_EQUAL(kept.size(), reopened.count());
+    for (const ScheduleRecord& expected : kept) {
+        ScheduleRecord r;
+        TEST_ASSERT_TRUE(reopened.get(expected.id, r));
+        TEST_ASSERT_EQUAL_MEMORY(&expected, &r, sizeof(r));
+    }
+    // Ids continuam depois do maior já usado
+    ScheduleRecord next = record(999);
+    TEST_ASSERT_TRUE(reopened.create(next));
+    TEST_ASSERT_GREATER_THAN(kept.back().id, next.id);
+}
+
+void test_torn_journal_entry_is_dropped() {
+    {
+        ScheduleStore store;
+        TEST_ASSERT_TRUE(store.begin(SPIFFS));
+        for (int i = 0; i < 5; i++) {
+            ScheduleRecord r = record(i);
+            TEST_ASSERT_TRUE(store.create(r));
+        }
+    }
+    // Queda de energia no meio de uma entrada
+    File log = SPIFFS.open("/sched.log", FILE_APPEND);
+    const uint8_t partial[7] = {1, 2, 3, 4, 5, 6, 7};
+    log.write(partial, sizeof(partial));
+    log.close();
+
+    ScheduleStore reopened;
+    TEST_ASSERT_TRUE(reopened.begin(SPIFFS));
+    TEST_ASSERT_EQUAL(5, reopened.count());
+    ScheduleStore again;
+    TEST_ASSERT_TRUE(again.begin(SPIFFS));
+    TEST_ASSERT_EQUAL(5, again.count());
+}
+
+int main(int argc, char** argv) {
+    char root[] = "/tmp/qp-test-XXXXXX";
+    sim::config().root = mkdtemp(root);
+    sim::begin(argc, argv);
+    SPIFFS.begin(true);
+    UNITY_BEGIN();
+    RUN_TEST(test_cost_does_not_grow_with_schedule_count);
+    RUN_TEST(test_reopen_restores_every_record);
+    RUN_TEST(test_torn_journal_entry_is_dropped);
+    return sim::end(UNITY_END());
+}
@@ -0,0 +1,241 @@
+// Histórico dos sensores em várias resoluções (src/SensorHistory.h): 30 dias
+// simulados de amostras a cada 5 s, conferidos contra uma referência calculada
+// por força bruta, e os limites das respostas de /api/history
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+#include <NativeSim.h>
+#include <unity.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "SensorHistory.h"
+
+void setup();
+uint32_t historyNow();
+
+extern SensorHistory luminosityHistory;
+
+static const size_t HISTORY_MAX_POINTS = 240;   // o mesmo de src/main.cpp
+
+static const uint32_t DAY = 86400;
+static const uint32_t DAYS = 30;
+static const uint32_t STEP_S = 5;
+static const uint32_t GAP_START = 10 * DAY;   // 2 h sem amostras (sensor desconectado)
+static const uint32_t GAP_END = 10 * DAY + 7200;
+
+struct Sample {
+    uint32_t t;
+    int16_t value;   // centésimos, como o anel guarda
+};
+
+struct Period {
+    int16_t min;
+    int16_t max;
+    int32_t sum;
+    int count;
+};
+
+static std::vector<Sample> samples;
+
+// Mesma série para os dois testes: ciclo diário, ruído e o buraco de 2 h
+static void simulate(SensorHistory& history, uint32_t start) {
+    samples.clear();
+    srand(1);
+    for (uint32_t t = start; t < start + DAYS * DAY; t += STEP_S) {
+        uint32_t elapsed = t - start;
+        if (elapsed > GAP_START && elapsed < GAP_END) continue;
+        float value = 26.0f + 3.0f * sinf(elapsed * 2 * M_PI / DAY) + (rand() % 100) / 100.0f;
+        history.add(t, value);
+        samples.push_back({t, static_cast<int16_t>(lroundf(value * 100))});
+    }
+}
+
+static std::map<uint32_t, Period> reference(uint32_t period) {
+    std::map<uint32_t, Period> periods;
+    for (const Sample& s : samples) {
+        uint32_t start = s.t - s.t % period;
+        auto it = periods.find(start);
+        if (it == periods.end()) {
+            periods[start] = {s.value, s.value, s.value, 1};
+        } else {
+            Period& p = it->second;
+            p.min = std::min(p.min, s.value);
+            p.max = std::max(p.max, s.value);
+            p.sum += s.value;
+            p.count++;
+        }
+    }
+    return periods;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_thirty_days_fill_every_ring_exactly() {
+    static SensorHistory history;
+    simulate(history, 3);
+    TEST_ASSERT_EQUAL_UINT32(samples.size(), history.samples());
+
+    // Bruto: as últimas RAW_CAPACITY amostras, intactas
+    std::vector<HistoryPoint> raw;
+    history.query(HistoryResolution::Raw, 0, UINT32_MAX, 100000, [&](const HistoryPoint& p) { raw.push_back(p); });
+    TEST_ASSERT_EQUAL(SensorHistory::RAW_CAPACITY, raw.size());
+    for (size_t i = 0; i < raw.size(); i++) {
+        const Sample& s = samples[samples.size() - raw.size() + i];
+        TEST_ASSERT_EQUAL_UINT32(s.t, raw[i].t);
+        TEST_ASSERT_EQUAL(s.value, lroundf(raw[i].avg * 100));
+    }
+
+    for (uint8_t tier = 0; tier < SensorHistory::TIER_COUNT; tier++) {
+        uint32_t period = SensorHistory::TIER_PERIOD_S[tier];
+        std::map<uint32_t, Period> periods = reference(period);
+        uint32_t newestOpen = periods.rbegin()->first;
+        uint32_t ring = SensorHistory::TIER_CAPACITY[tier] * period;
+        uint32_t oldestKept = newestOpen > ring ? newestOpen - ring : 0;
+
+        std::vector<HistoryPoint> points;
+        history.query(static_cast<HistoryResolution>(tier + 1), 0, UINT32_MAX, 100000,
+                      [&](const HistoryPoint& p) { points.push_back(p); });
+
+        // O anel fecha TIER_CAPACITY períodos antes do aberto; dentro dele, só os que tiveram amostras
+        size_t expected = 0;
+        for (const auto& entry : periods) {
+            if (entry.first >= oldestKept) expected++;
+        }
+        char line[96];
+        snprintf(line, sizeof(line), "%lus: %u pontos (anel de %u + aberto)", (unsigned long)period,
+                 (unsigned)points.size(), (unsigned)SensorHistory::TIER_CAPACITY[tier]);
+        TEST_MESSAGE(line);
+        TEST_ASSERT_EQUAL(expected, points.size());
+        TEST_ASSERT_EQUAL_UINT32(periods.lower_bound(oldestKept)->first, points.front().t);
+        TEST_ASSERT_EQUAL_UINT32(newestOpen, points.back().t);
+        TEST_ASSERT_TRUE(points.back().partial);
+
+        for (size_t i = 0; i < points.size(); i++) {
+            const HistoryPoint& p = points[i];
+            TEST_ASSERT_EQUAL_UINT32(0, p.t % period);
+            if (i > 0) TEST_ASSERT_GREATER_THAN(points[i - 1].t, p.t);
+            TEST_ASSERT_EQUAL(i + 1 == points.size(), p.partial);
+            const Period& r = periods.at(p.t);
+            TEST_ASSERT_EQUAL(r.min, lroundf(p.min * 100));
+            TEST_ASSERT_EQUAL(r.max, lroundf(p.max * 100));
+            TEST_ASSERT_EQUAL(r.sum / r.count, lroundf(p.avg * 100));
+        }
+    }
+
+    // O buraco de 2 h aparece como períodos ausentes no nível de 15 min (o de 1 min já o descartou)
+    std::vector<HistoryPoint> gap;
+    history.query(HistoryResolution::QuarterHour, GAP_START + 900, GAP_END - 900, 100,
+                  [&](const HistoryPoint& p) { gap.push_back(p); });
+    TEST_ASSERT_EQUAL(0, gap.size());
+}
+
+struct HistoryReply {
+    int code;
+    std::string res;
+    bool truncated;
+    std::vector<uint32_t> times;
+};
+
+static HistoryReply history(const std::string& query) {
+    sim::HttpResponse response = sim::http(HTTP_GET, "/api/history?sensor=luminosity" + query);
+    HistoryReply reply = {response.code, "", false, {}};
+    if (response.code != 200) return reply;
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, response.body));
+    reply.res = doc["res"].as<const char*>();
+    reply.truncated = doc["truncated"];
+    for (JsonArrayConst point : doc["points"].as<JsonArrayConst>()) {
+        TEST_ASSERT_EQUAL(4, point.size());
+        TEST_ASSERT_TRUE(point[1].as<float>() <= point[3].as<float>() && point[3].as<float>() <= point[2].as<float>());
+        reply.times.push_back(point[0].as<uint32_t>());
+    }
+    return reply;
+}
+
+// Todos os pontos tocam [from, to], em ordem, e nunca passam de HISTORY_MAX_POINTS
+static void expectBounded(const HistoryReply& reply, uint32_t from, uint32_t to) {
+    TEST_ASSERT_EQUAL(200, reply.code);
+    TEST_ASSERT_LESS_OR_EQUAL(HISTORY_MAX_POINTS, reply.times.size());
+    HistoryResolution res;
+    TEST_ASSERT_TRUE(SensorHistory::parse(reply.res.c_str(), res));
+    uint32_t period = SensorHistory::period(res);
+    for (size_t i = 0; i < reply.times.size(); i++) {
+        // 1 s de folga: o deslocamento uptime -> epoch é recalculado a cada requisição
+        TEST_ASSERT_GREATER_OR_EQUAL(from - period, reply.times[i] + 1);
+        TEST_ASSERT_LESS_OR_EQUAL(to + 1, reply.times[i]);
+        if (i > 0) TEST_ASSERT_GREATER_THAN(reply.times[i - 1], reply.times[i]);
+    }
+    TEST_ASSERT_EQUAL(reply.times.size() >= HISTORY_MAX_POINTS, reply.truncated);
+}
+
+void test_history_api_output_is_bounded() {
+    // Amostras a partir do uptime atual; a API fala em epoch (o relógio do host já é válido)
+    uint32_t start = historyNow() + 1;
+    simulate(luminosityHistory, start);
+    uint32_t end = start + DAYS * DAY;
+    uint32_t offset = time(nullptr) - historyNow();
+    char query[96];
+
+    // Resoluções fixas sobre os 30 dias: sempre os HISTORY_MAX_POINTS mais recentes
+    const char* resolutions[] = {"raw", "1m", "15m", "1h"};
+    for (const char* res : resolutions) {
+        snprintf(query, sizeof(query), "&res=%s&from=%lu&to=%lu", res, (unsigned long)(offset + start),
+                 (unsigned long)(offset + end));
+        HistoryReply reply = history(query);
+        expectBounded(reply, offset + start, offset + end);
+        TEST_ASSERT_EQUAL_STRING(res, reply.res.c_str());
+        size_t expected = strcmp(res, "raw") == 0 ? SensorHistory::RAW_CAPACITY : HISTORY_MAX_POINTS;
+        TEST_ASSERT_EQUAL(expected, reply.times.size());
+        // Os mais recentes: o último ponto é a última amostra ou o período aberto
+        HistoryResolution parsed;
+        SensorHistory::parse(res, parsed);
+        TEST_ASSERT_GREATER_OR_EQUAL(offset + end - SensorHistory::period(parsed) - STEP_S - 1, reply.times.back());
+    }
+
+    // auto: a resolução mais fina que cobre o intervalo em até HISTORY_MAX_POINTS pontos
+    struct Case {
+        uint32_t span;
+        const char* res;
+    };
+    const Case cases[] = {{600, "raw"}, {3600, "1m"}, {2 * DAY, "15m"}, {DAYS * DAY, "1h"}};
+    for (const Case& c : cases) {
+        snprintf(query, sizeof(query), "&res=auto&from=%lu&to=%lu", (unsigned long)(offset + end - c.span),
+                 (unsigned long)(offset + end));
+        HistoryReply reply = history(query);
+        char line[96];
+        snprintf(line, sizeof(line), "auto, %lu s: res %s, %u pontos", (unsigned long)c.span, reply.res.c_str(),
+                 (unsigned)reply.times.size());
+        TEST_MESSAGE(line);
+        expectBounded(reply, offset + end - c.span, offset + end);
+        TEST_ASSERT_EQUAL_STRING(c.res, reply.res.c_str());
+        TEST_ASSERT_GREATER_THAN(0, reply.times.size());
+    }
+
+    // Intervalo anterior a tudo que foi guardado: vazio, não um erro
+    snprintf(query, sizeof(query), "&res=1m&from=%lu&to=%lu", (unsigned long)(offset + start),
+             (unsigned long)(offset + start + 3600));
+    HistoryReply old = history(query);
+    expectBounded(old, offset + start, offset + start + 3600);
+    TEST_ASSERT_EQUAL(0, old.times.size());
+
+    snprintf(query, sizeof(query), "&from=%lu&to=%lu", (unsigned long)(offset + end), (unsigned long)(offset + start));
+    TEST_ASSERT_EQUAL(400, history(query).code);
+    TEST_ASSERT_EQUAL(400, history("&res=5m").code);
+}
+
+int main(int argc, char** argv) {
+    char root[] = "/tmp/qp-test-XXXXXX";
+    sim::config().root = mkdtemp(root);
+    sim::begin(argc, argv);
+    setup();
+    UNITY_BEGIN();
+    RUN_TEST(test_thirty_days_fill_every_ring_exactly);
+    RUN_TEST(test_history_api_output_is_bounded);
+    return sim::end(UNITY_END());
+}
@@ -0,0 +1,201 @@
+// Estado compartilhado sem trava (src/SeqLock.h, src/SpscQueue.h): um escritor
+// publica ControllerState enquanto vários leitores copiam, e nenhuma cópia
+// mistura duas versões; a fila de um produtor entrega em ordem, inteira, e
+// conta exatamente o que descartou
+#include <Arduino.h>
+#include <NativeSim.h>
+#include <unity.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "ControllerState.h"
+#include "SeqLock.h"
+#include "SpscQueue.h"
+
+static const int READERS = 4;
+// Por tempo, não por contagem: num núcleo só a preempção precisa cair no
+// meio de várias escritas
+static const unsigned long WRITE_MS = 1000;
+
+// Todos os campos derivam de `k`: uma cópia rasgada não bate consigo mesma
+static ControllerState stateFor(uint32_t k) {
+    ControllerState state;
+    state.seq = k;
+    for (int i = 0; i < 4; i++) state.pumps[i] = (k >> i) & 1;
+    state.temperature = k * 0.25f;
+    state.luminosity = k % 101;
+    state.color[0] = k;
+    state.color[1] = k >> 8;
+    state.color[2] = k >> 16;
+    state.effect = static_cast<RgbEffectType>(k % 4);
+    state.effectPeriod = ~k;
+    for (ProbeState& probe : state.probes) {
+        probe.celsius = k * 0.5f;
+        probe.valid = k & 1;
+        probe.present = k & 2;
+    }
+    return state;
+}
+
+static bool consistent(const ControllerState& state) {
+    ControllerState expected = stateFor(state.seq);
+    for (int i = 0; i < 4; i++) {
+        if (state.pumps[i] != expected.pumps[i]) return false;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (state.color[i] != expected.color[i]) return false;
+    }
+    for (size_t i = 0; i < TemperatureSensorBus::MAX_PROBES; i++) {
+        const ProbeState& probe = state.probes[i];
+        if (probe.celsius != expected.probes[i].celsius || probe.valid != expected.probes[i].valid ||
+            probe.present != expected.probes[i].present) {
+            return false;
+        }
+    }
+    return state.temperature == expected.temperature && state.luminosity == expected.luminosity &&
+           state.effect == expected.effect && state.effectPeriod == expected.effectPeriod;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_seqlock_snapshots_are_never_torn() {
+    SeqLock<ControllerState> published;
+    published.write(stateFor(0));
+    std::atomic<bool> writing{true};
+    std::atomic<uint64_t> reads{0}, torn{0}, backwards{0}, newest{0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; r++) {
+        readers.emplace_back([&] {
+            uint32_t last = 0;
+            uint64_t count = 0;
+            // Pelo menos uma leitura depois do fim da escrita
+            for (bool more = true; more;) {
+                more = writing.load(std::memory_order_acquire);
+                ControllerState state = published.read();
+                count++;
+                if (!consistent(state)) torn++;
+                if (state.seq < last) backwards++;
+                last = state.seq;
+            }
+            reads += count;
+            if (last > newest) newest = last;
+        });
+    }
+    uint32_t versions = 0;
+    std::thread writer([&] {
+        unsigned long start = millis();
+        while (millis() - start < WRITE_MS) published.write(stateFor(++versions));
+        writing.store(false, std::memory_order_release);
+    });
+    writer.join();
+    for (std::thread& reader : readers) reader.join();
+
+    char line[128];
+    snprintf(line, sizeof(line), "%u versões, %d leitores, %llu leituras, %u cópias refeitas", versions, READERS,
+             (unsigned long long)reads.load(), published.retries());
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL_UINT64(0, torn.load());
+    TEST_ASSERT_EQUAL_UINT64(0, backwards.load());
+    TEST_ASSERT_GREATER_THAN_UINT32(0, published.retries());
+    TEST_ASSERT_EQUAL_UINT32(versions, published.version() - 1);   // + a publicação inicial
+    TEST_ASSERT_EQUAL_UINT32(versions, newest.load());
+    TEST_ASSERT_EQUAL_UINT32(versions, published.read().seq);
+}
+
+// Deltas para a rede: o produtor não espera; o que não coube é descartado e
+// contado, e o consumidor vê o resto em ordem e inteiro
+void test_spsc_queue_drops_are_counted_exactly() {
+    static SpscQueue<StateDelta, 16> queue;
+    const uint32_t SENT = 300000;
+    std::atomic<bool> producing{true};
+    uint32_t rejected = 0;
+
+    std::vector<uint32_t> received;
+    uint64_t tornItems = 0;
+    std::thread consumer([&] {
+        StateDelta delta;
+        for (bool more = true; more;) {
+            more = producing.load(std::memory_order_acquire);
+            while (queue.pop(delta)) {
+                if (delta.fields != delta.state.seq || !consistent(delta.state)) tornItems++;
+                received.push_back(delta.state.seq);
+            }
+            if (more) std::this_thread::yield();
+        }
+    });
+    for (uint32_t k = 1; k <= SENT; k++) {
+        StateDelta delta;
+        delta.fields = k;
+        delta.state = stateFor(k);
+        if (!queue.push(delta)) rejected++;
+        // Rajadas maiores que a fila; num núcleo só, o consumidor roda entre elas
+        if (k % 64 == 0) std::this_thread::yield();
+    }
+    producing.store(false, std::memory_order_release);
+    consumer.join();
+
+    char line[96];
+    snprintf(line, sizeof(line), "%u enviados, %zu entregues, %u descartados", SENT, received.size(), queue.dropped());
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL_UINT64(0, tornItems);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, queue.dropped());
+    TEST_ASSERT_EQUAL_UINT32(16, queue.highWater());   // houve descarte: a fila chegou a encher
+    TEST_ASSERT_GREATER_THAN_UINT32(0, received.size());
+    TEST_ASSERT_EQUAL_UINT32(rejected, queue.dropped());
+    TEST_ASSERT_EQUAL_UINT32(SENT, received.size() + queue.dropped());
+    for (size_t i = 1; i < received.size(); i++) {
+        if (received[i] <= received[i - 1]) TEST_FAIL_MESSAGE("delta fora de ordem");
+    }
+}
+
+// Comandos para o loop(): quem produz tenta de novo com a fila cheia, então
+// nada se perde e a ordem é exatamente a de envio
+void test_spsc_queue_retried_commands_arrive_in_order() {
+    static SpscQueue<ControlCommand, 32> queue;
+    const uint32_t SENT = 1000000;
+    uint32_t full = 0;
+    std::thread producer([&] {
+        for (uint32_t i = 0; i < SENT; i++) {
+            ControlCommand command = {i & 1 ? ControlCommandType::SetPump : ControlCommandType::SetEffect,
+                                      static_cast<uint8_t>(i), i};
+            while (!queue.push(command)) {
+                full++;
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint32_t expected = 0;
+    uint32_t wrong = 0;
+    ControlCommand command;
+    while (expected < SENT) {
+        if (!queue.pop(command)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (command.value != expected || command.target != static_cast<uint8_t>(expected) ||
+            command.type != (expected & 1 ? ControlCommandType::SetPump : ControlCommandType::SetEffect)) {
+            wrong++;
+        }
+        expected++;
+    }
+    producer.join();
+    TEST_ASSERT_EQUAL_UINT32(0, wrong);
+    TEST_ASSERT_FALSE(queue.pop(command));
+    TEST_ASSERT_EQUAL_UINT32(full, queue.dropped());
+}
+
+int main(int argc, char** argv) {
+    char root[] = "/tmp/qp-test-XXXXXX";
+    sim::config().root = mkdtemp(root);
+    sim::begin(argc, argv);
+    UNITY_BEGIN();
+    RUN_TEST(test_seqlock_snapshots_are_never_torn);
+    RUN_TEST(test_spsc_queue_drops_are_counted_exactly);
+    RUN_TEST(test_spsc_queue_retried_commands_arrive_in_order);
+    return sim::end(UNITY_END());
+}
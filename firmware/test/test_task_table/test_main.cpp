@@ -0,0 +1,173 @@
+// Tabela de tarefas (src/TaskTable.h) e o que /api/metrics exporta por tarefa:
+// a rede no núcleo 0, o controle no núcleo 1, a fração de núcleo de cada
+// janela e a menor sobra de pilha medida na pilha pintada da tarefa
+#include <Arduino.h>
+#include <NativeSim.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <unity.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <string>
+
+#include "Metrics.h"
+#include "TaskTable.h"
+
+void setUp() {}
+void tearDown() {}
+
+// Valor da linha `name{labels}` do texto do Prometheus; -1 se ela não existe
+static double metricValue(const String& text, const std::string& series) {
+    std::string body = text.c_str();
+    std::string key = "\n" + series + " ";
+    size_t at = body.find(key);
+    if (at == std::string::npos) return -1;
+    return strtod(body.c_str() + at + key.size(), nullptr);
+}
+
+void test_table_partitions_cores() {
+    TEST_ASSERT_EQUAL_STRING("loop", taskConfig(TaskId::Loop).name);
+    TEST_ASSERT_EQUAL_STRING("safety", taskConfig(TaskId::Safety).name);
+    TEST_ASSERT_EQUAL_STRING("net", taskConfig(TaskId::Network).name);
+    TEST_ASSERT_EQUAL_STRING("async_tcp", taskConfig(TaskId::AsyncTcp).name);
+
+    // Controle e segurança no núcleo 1, rede no 0
+    TEST_ASSERT_EQUAL(1, taskConfig(TaskId::Loop).core);
+    TEST_ASSERT_EQUAL(1, taskConfig(TaskId::Safety).core);
+    TEST_ASSERT_EQUAL(0, taskConfig(TaskId::Network).core);
+    TEST_ASSERT_EQUAL(0, taskConfig(TaskId::AsyncTcp).core);
+
+    // O supervisor preempta tudo; o AsyncTCP responde antes de a rede mandar deltas
+    for (size_t i = 0; i < static_cast<size_t>(TaskId::Count); i++) {
+        if (i == static_cast<size_t>(TaskId::Safety)) continue;
+        TEST_ASSERT_GREATER_THAN(TASKS[i].priority, taskConfig(TaskId::Safety).priority);
+    }
+    TEST_ASSERT_LESS_THAN(configMAX_PRIORITIES, taskConfig(TaskId::Safety).priority);
+    TEST_ASSERT_GREATER_THAN(taskConfig(TaskId::Network).priority, taskConfig(TaskId::AsyncTcp).priority);
+    TEST_ASSERT_GREATER_THAN(taskConfig(TaskId::Loop).priority, taskConfig(TaskId::Network).priority);
+
+    for (const TaskConfig& task : TASKS) TEST_ASSERT_GREATER_OR_EQUAL(2048, task.stackBytes);
+}
+
+void test_cpu_ratio_per_window() {
+    String text;
+    metrics::sampleTasks(1000000);   // abre a janela em t = 1 s
+    metrics::addTaskBusy(TaskId::Network, 250000);
+    metrics::addTaskBusy(TaskId::Safety, 10000);
+    metrics::sampleTasks(2000000);
+    metrics::writePrometheus(text);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.25f, metricValue(text, "qp_task_cpu_ratio{task=\"net\",core=\"0\"}"));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.01f, metricValue(text, "qp_task_cpu_ratio{task=\"safety\",core=\"1\"}"));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.0f, metricValue(text, "qp_task_cpu_ratio{task=\"async_tcp\",core=\"0\"}"));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.25f, metricValue(text, "qp_task_busy_seconds_total{task=\"net\"}"));
+
+    // Janela seguinte: o acumulado cresce, a fração só conta o novo.
+    // Mais trabalho que tempo (relógios de fontes diferentes) satura em 1
+    metrics::addTaskBusy(TaskId::Network, 50000);
+    metrics::addTaskBusy(TaskId::Safety, 600000);
+    metrics::sampleTasks(2500000);
+    text = "";
+    metrics::writePrometheus(text);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.1f, metricValue(text, "qp_task_cpu_ratio{task=\"net\",core=\"0\"}"));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 1.0f, metricValue(text, "qp_task_cpu_ratio{task=\"safety\",core=\"1\"}"));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.3f, metricValue(text, "qp_task_busy_seconds_total{task=\"net\"}"));
+
+    // A seção Loop já conta como trabalho da tarefa "loop"
+    metrics::recordMicros(MetricSection::Loop, 1500);
+    text = "";
+    metrics::writePrometheus(text);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0015f, metricValue(text, "qp_task_busy_seconds_total{task=\"loop\"}"));
+
+    for (const TaskConfig& task : TASKS) {
+        std::string series = std::string("qp_task_stack_bytes{task=\"") + task.name + "\"}";
+        TEST_ASSERT_EQUAL_INT32(task.stackBytes, (long)metricValue(text, series));
+    }
+}
+
+void test_counter_and_gauge_types() {
+    String text;
+    metrics::writeCounter(text, "qp_test_dropped_total", "Descartes", 4000000000ULL);
+    metrics::writeGauge(text, "qp_test_depth", "Profundidade", 3);
+    TEST_ASSERT_EQUAL_STRING("# HELP qp_test_dropped_total Descartes\n"
+                             "# TYPE qp_test_dropped_total counter\n"
+                             "qp_test_dropped_total 4000000000\n"
+                             "# HELP qp_test_depth Profundidade\n"
+                             "# TYPE qp_test_depth gauge\n"
+                             "qp_test_depth 3\n",
+                             text.c_str());
+}
+
+// Bem abaixo dos 6 KiB da tabela para "net": vale também no ESP32
+static const size_t STACK_USED = 2048;
+// A espera na notificação já desceu abaixo de useStack() antes de
+// touchStack() (~700 bytes no host com -O0): a queda medida é menor que STACK_USED
+static const long STACK_SLACK = 1024;
+static TaskHandle_t worker = nullptr;
+static std::atomic<bool> parked{false};
+static std::atomic<bool> touched{false};
+
+static volatile uint8_t stackSink;
+
+static void __attribute__((noinline)) touchStack() {
+    volatile uint8_t scratch[STACK_USED];
+    for (size_t i = 0; i < STACK_USED; i++) scratch[i] = static_cast<uint8_t>(i);
+    uint8_t sum = 0;
+    for (size_t i = 0; i < STACK_USED; i++) sum += scratch[i];
+    stackSink = sum;
+}
+
+static void useStack(void*) {
+    // Uma espera que expira percorre o mesmo caminho da próxima: depois de
+    // `parked`, nada desce mais fundo que isso até a notificação
+    ulTaskNotifyTake(pdTRUE, 1);
+    parked = true;
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10000));
+    touchStack();
+    touched = true;
+    for (;;) vTaskDelay(1000);
+}
+
+static long stackFreeMin(const char* task) {
+    String text;
+    metrics::writePrometheus(text);
+    return (long)metricValue(text, std::string("qp_task_stack_free_min_bytes{task=\"") + task + "\"}");
+}
+
+void test_stack_high_water_mark() {
+    const TaskConfig& config = taskConfig(TaskId::Network);
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreatePinnedToCore(useStack, config.name, config.stackBytes, nullptr,
+                                                      config.priority, &worker, config.core));
+    metrics::registerTask(TaskId::Network, worker);
+    for (int i = 0; i < 2000 && !parked; i++) delay(1);
+    TEST_ASSERT_TRUE(parked.load());
+
+    long before = stackFreeMin("net");
+    TEST_ASSERT_GREATER_THAN((long)STACK_USED, before);
+    // Só tarefas registradas exportam a sobra de pilha
+    TEST_ASSERT_EQUAL(-1, stackFreeMin("safety"));
+
+    xTaskNotifyGive(worker);
+    for (int i = 0; i < 2000 && !touched; i++) delay(1);
+    TEST_ASSERT_TRUE(touched.load());
+
+    long after = stackFreeMin("net");
+    TEST_ASSERT_GREATER_OR_EQUAL(0, after);
+    TEST_ASSERT_LESS_OR_EQUAL(before - ((long)STACK_USED - STACK_SLACK), after);
+    // Mínimo desde o boot: a pilha já voltou, a sobra não
+    delay(5);
+    TEST_ASSERT_EQUAL(after, stackFreeMin("net"));
+}
+
+int main(int argc, char** argv) {
+    char root[] = "/tmp/qp-test-XXXXXX";
+    sim::config().root = mkdtemp(root);
+    sim::begin(argc, argv);
+    UNITY_BEGIN();
+    RUN_TEST(test_table_partitions_cores);
+    RUN_TEST(test_cpu_ratio_per_window);
+    RUN_TEST(test_counter_and_gauge_types);
+    RUN_TEST(test_stack_high_water_mark);
+    return sim::end(UNITY_END());
+}
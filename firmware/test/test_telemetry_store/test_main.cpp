@@ -0,0 +1,297 @@
+// Telemetria comprimida (src/TelemetryStore.h) na SPIFFS simulada: o que o
+// TelemetryReader devolve é bit a bit o que entrou, em todas as classes de
+// tamanho do delta do delta e do delta do valor, e uma semana sintética da
+// piscina mede compressão e bytes gravados por dia
+#include <Arduino.h>
+#include <NativeSim.h>
+#include <SPIFFS.h>
+#include <unity.h>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "TelemetryStore.h"
+
+static const uint32_t T0 = 1718000000;   // 2024-06-10, depois do SNTP
+
+static std::vector<TelemetrySample> readAll(const TelemetryStore& store, uint32_t& corrupt) {
+    std::vector<TelemetrySample> out;
+    TelemetryReader reader(store, 0, UINT32_MAX);
+    TelemetrySample sample;
+    while (reader.next(sample)) out.push_back(sample);
+    corrupt = reader.corruptBlocks();
+    return out;
+}
+
+// Compara série a série: entre séries a ordem é a dos blocos gravados
+static void assertSameSamples(const std::vector<TelemetrySample>& expected, const std::vector<TelemetrySample>& actual) {
+    TEST_ASSERT_EQUAL_size_t(expected.size(), actual.size());
+    for (uint8_t series = 0; series < TelemetryStore::MAX_SERIES; series++) {
+        std::vector<const TelemetrySample*> in, out;
+        for (const TelemetrySample& s : expected) if (s.series == series) in.push_back(&s);
+        for (const TelemetrySample& s : actual) if (s.series == series) out.push_back(&s);
+        TEST_ASSERT_EQUAL_size_t(in.size(), out.size());
+        for (size_t i = 0; i < in.size(); i++) {
+            if (in[i]->t != out[i]->t || in[i]->value != out[i]->value) {
+                char line[128];
+                snprintf(line, sizeof(line), "série %u, amostra %zu: esperado (%u, %d), lido (%u, %d)", series, i,
+                         in[i]->t, in[i]->value, out[i]->t, out[i]->value);
+                TEST_FAIL_MESSAGE(line);
+            }
+        }
+    }
+}
+
+// `age` = false: sem poll(), os blocos só fecham cheios
+static void addAll(TelemetryStore& store, const std::vector<TelemetrySample>& samples, bool age = true) {
+    for (const TelemetrySample& s : samples) {
+        store.add(s.series, s.t, s.value);
+        if (age) store.poll(s.t);
+    }
+    store.flush();
+}
+
+void setUp() {
+    SPIFFS.format();
+}
+
+void tearDown() {}
+
+// Deltas escolhidos para cair em cada classe (0, 5, 9, 16 e 32 bits) e nas
+// bordas entre elas, com o instante e o valor dando a volta em 32 bits
+void test_round_trip_covers_every_bit_class() {
+    static const int64_t EDGES[] = {0,     1,     -1,     15,     -16,     16,       255,       -256,    256,
+                                    32767, -32768, 32768, -32769, INT_MAX, INT_MIN,  INT_MAX,   INT_MIN};
+    std::vector<TelemetrySample> samples;
+    uint32_t t = T0;
+    int32_t value = 0;
+    uint32_t delta = 5;
+    for (int64_t timeEdge : EDGES) {
+        for (int64_t valueEdge : EDGES) {
+            // Delta do delta negativo só enquanto o instante não recua
+            int64_t nextDelta = (int64_t)delta + (timeEdge >= 0 ? timeEdge : std::max<int64_t>(timeEdge, -(int64_t)delta));
+            delta = (uint32_t)std::min<int64_t>(nextDelta, UINT32_MAX - (uint64_t)t);
+            t += delta;
+            value = (int32_t)((uint32_t)value + (uint32_t)valueEdge);
+            samples.push_back({0, t, value});
+        }
+    }
+    // Instantes repetidos e valores nos extremos
+    samples.push_back({0, t, INT32_MAX});
+    samples.push_back({0, t, INT32_MIN});
+    samples.push_back({0, t, 0});
+    // Série com o mesmo valor a cada 5 s: 2 bits por amostra
+    for (uint32_t i = 0; i < 5000; i++) samples.push_back({1, T0 + i * 5, 2750});
+
+    TelemetryStore store;
+    TEST_ASSERT_TRUE(store.begin(SPIFFS));
+    addAll(store, samples);
+    TEST_ASSERT_EQUAL_UINT32(samples.size(), store.samplesWritten());
+    TEST_ASSERT_EQUAL_UINT32(0, store.writeErrors());
+
+    uint32_t corrupt;
+    std::vector<TelemetrySample> back = readAll(store, corrupt);
+    TEST_ASSERT_EQUAL_UINT32(0, corrupt);
+    assertSameSamples(samples, back);
+
+    // 5000 amostras periódicas e repetidas: cada hora (MAX_BLOCK_AGE_S) cabe
+    // num bloco só, com folga
+    uint32_t constantBlocks = 0;
+    for (uint8_t slot = 0; slot < TelemetryStore::MAX_SEGMENTS; slot++) {
+        if (store.segmentSequence(slot) == 0) continue;
+        char path[16];
+        TelemetryStore::segmentPath(slot, path, sizeof(path));
+        File file = SPIFFS.open(path, FILE_READ);
+        TelemetryBlockHeader header;
+        while (file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header)) {
+            if (header.series == 1) constantBlocks++;
+            file.seek(file.position() + TelemetryStore::BLOCK_SIZE - sizeof(header));
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32((5000 * 5 + TelemetryStore::MAX_BLOCK_AGE_S - 1) / TelemetryStore::MAX_BLOCK_AGE_S, constantBlocks);
+}
+
+// Passeio aleatório em 6 séries intercaladas, deltas de todos os tamanhos,
+// reaberto no meio (reinício) e relido também por janela de tempo e série
+void test_random_walk_round_trip_is_bit_exact() {
+    std::mt19937 rng(1234);
+    std::vector<TelemetrySample> samples;
+    uint32_t t = T0;
+    int32_t value[TelemetryStore::MAX_SERIES] = {};
+    for (uint32_t i = 0; i < 100000; i++) {
+        uint8_t series = rng() % TelemetryStore::MAX_SERIES;
+        uint32_t pick = rng() % 100;
+        uint32_t step = pick < 70 ? 5 : pick < 90 ? rng() % 40 : pick < 99 ? rng() % 5000 : rng() % 200000;
+        int32_t jump = pick < 40 ? 0 : pick < 80 ? (int32_t)(rng() % 31) - 15 : pick < 95 ? (int32_t)(rng() % 60001) - 30000 : (int32_t)rng();
+        t += step;
+        value[series] = (int32_t)((uint32_t)value[series] + (uint32_t)jump);
+        samples.push_back({series, t, value[series]});
+    }
+
+    size_t half = samples.size() / 2;
+    {
+        TelemetryStore store;
+        TEST_ASSERT_TRUE(store.begin(SPIFFS));
+        addAll(store, std::vector<TelemetrySample>(samples.begin(), samples.begin() + half), false);
+    }
+    TelemetryStore store;
+    TEST_ASSERT_TRUE(store.begin(SPIFFS));
+    addAll(store, std::vector<TelemetrySample>(samples.begin() + half, samples.end()), false);
+    TEST_ASSERT_EQUAL_UINT32(0, store.writeErrors());
+    TEST_ASSERT_EQUAL_UINT32(0, store.segmentsDropped());
+
+    uint32_t corrupt;
+    assertSameSamples(samples, readAll(store, corrupt));
+    TEST_ASSERT_EQUAL_UINT32(0, corrupt);
+
+    // Janela de tempo e máscara de série: exatamente o subconjunto
+    uint32_t from = T0 + 200000, to = T0 + 400000;
+    std::vector<TelemetrySample> expected, actual;
+    for (const TelemetrySample& s : samples) {
+        if ((s.series == 2 || s.series == 5) && s.t >= from && s.t <= to) expected.push_back(s);
+    }
+    TelemetryReader reader(store, from, to, (1UL << 2) | (1UL << 5));
+    TelemetrySample sample;
+    while (reader.next(sample)) actual.push_back(sample);
+    TEST_ASSERT_GREATER_THAN(0, expected.size());
+    assertSameSamples(expected, actual);
+}
+
+// Um byte trocado num bloco perde só as amostras daquele bloco
+void test_corrupt_block_loses_only_its_samples() {
+    std::vector<TelemetrySample> samples;
+    for (uint32_t i = 0; i < 20000; i++) samples.push_back({0, T0 + i * 5, (int32_t)(2700 + (i / 7) % 40)});
+    TelemetryStore store;
+    TEST_ASSERT_TRUE(store.begin(SPIFFS));
+    addAll(store, samples);
+    TEST_ASSERT_GREATER_THAN_UINT32(3, store.blocksWritten());
+
+    char path[16];
+    TelemetryStore::segmentPath(0, path, sizeof(path));
+    File file = SPIFFS.open(path, FILE_READ);
+    std::vector<uint8_t> bytes(file.size());
+    file.read(bytes.data(), bytes.size());
+    file.close();
+    const size_t victim = 2;
+    TelemetryBlockHeader header;
+    memcpy(&header, &bytes[victim * TelemetryStore::BLOCK_SIZE], sizeof(header));
+    bytes[victim * TelemetryStore::BLOCK_SIZE + 100] ^= 0x10;
+    file = SPIFFS.open(path, FILE_WRITE);
+    file.write(bytes.data(), bytes.size());
+    file.close();
+
+    std::vector<TelemetrySample> expected;
+    for (const TelemetrySample& s : samples) {
+        if (s.t < header.firstTime || s.t > header.lastTime) expected.push_back(s);
+    }
+    TEST_ASSERT_EQUAL_size_t(samples.size() - header.count, expected.size());
+    uint32_t corrupt;
+    assertSameSamples(expected, readAll(store, corrupt));
+    TEST_ASSERT_EQUAL_UINT32(1, corrupt);
+}
+
+// Uma semana da piscina: sondas a cada 5/10/30 s com a quantização do
+// DS18B20, luminosidade a cada 5 s com nuvens e bombas algumas vezes por dia
+static std::vector<TelemetrySample> poolWeek(uint32_t days) {
+    std::mt19937 rng(42);
+    std::normal_distribution<float> noise(0, 1);
+    struct Probe {
+        uint32_t periodMs;
+        float step;
+        float offset;
+    };
+    static const Probe PROBES[] = {{5000, .0625f, 0}, {5000, .0625f, -.4f}, {10000, .125f, 3.f}, {30000, .5f, -2.f}};
+    std::vector<TelemetrySample> out;
+    uint64_t next[5] = {};
+    float drift[4] = {};
+    float cloud = 0;
+    uint32_t pumpNext = 3600;
+    int32_t pumps = 0;
+    for (uint64_t ms = 0; ms < days * 86400000ULL; ms += 1000) {
+        uint32_t t = T0 + ms / 1000;
+        float day = (ms / 1000 % 86400) / 86400.0f;
+        for (uint8_t p = 0; p < 4; p++) {
+            if (ms < next[p]) continue;
+            next[p] += PROBES[p].periodMs + rng() % 40;   // jitter do loop
+            drift[p] = drift[p] * 0.999f + noise(rng) * 0.01f;
+            float c = 27.0f + PROBES[p].offset + 1.5f * sinf((day - 0.35f) * 2 * M_PI) + drift[p] + noise(rng) * 0.03f;
+            c = roundf(c / PROBES[p].step) * PROBES[p].step;
+            out.push_back({p, t, (int32_t)lroundf(c * 100)});
+        }
+        if (ms >= next[4]) {
+            next[4] += 5000 + rng() % 40;
+            cloud = cloud * 0.98f + noise(rng) * 0.6f;
+            float sun = std::max(0.0f, sinf((day - 0.25f) * 2 * M_PI));
+            out.push_back({4, t, (int32_t)std::min(100.0f, std::max(0.0f, 100 * sun + cloud * sun * 10 + noise(rng)))});
+        }
+        if (ms / 1000 >= pumpNext) {
+            pumps ^= 1 << (rng() % 4);
+            out.push_back({5, t, pumps});
+            pumpNext += 4 * 3600 + rng() % 3600;
+        }
+    }
+    return out;
+}
+
+void test_pool_week_compression() {
+    const uint32_t DAYS = 7;
+    std::vector<TelemetrySample> samples = poolWeek(DAYS);
+    size_t jsonBytes = 0;
+    for (const TelemetrySample& s : samples) {
+        char record[64];
+        jsonBytes += snprintf(record, sizeof(record), "{\"s\":%u,\"t\":%u,\"v\":%d}\n", s.series, s.t, s.value);
+    }
+
+    TelemetryStore store;
+    TEST_ASSERT_TRUE(store.begin(SPIFFS));
+    uint64_t flashBefore = sim::stats().flashBytesWritten;
+    auto started = std::chrono::steady_clock::now();
+    addAll(store, samples);
+    double addNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count() / samples.size();
+    uint64_t flashBytes = sim::stats().flashBytesWritten - flashBefore;
+
+    started = std::chrono::steady_clock::now();
+    uint32_t corrupt;
+    std::vector<TelemetrySample> back = readAll(store, corrupt);
+    double readMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    assertSameSamples(samples, back);
+    TEST_ASSERT_EQUAL_UINT32(0, corrupt);
+    TEST_ASSERT_EQUAL_UINT32(0, store.segmentsDropped());
+    TEST_ASSERT_EQUAL_UINT64(store.blocksWritten() * TelemetryStore::BLOCK_SIZE, flashBytes);
+
+    double bitsPerSample = flashBytes * 8.0 / samples.size();
+    double binaryRatio = samples.size() * 9.0 / flashBytes;   // série + uint32 t + int32 v
+    double jsonRatio = (double)jsonBytes / flashBytes;
+    char line[160];
+    snprintf(line, sizeof(line), "semana: %zu amostras, %u blocos, %.1f KB/dia, %.1f gravações de página/dia",
+             samples.size(), store.blocksWritten(), flashBytes / 1024.0 / DAYS, store.blocksWritten() / (double)DAYS);
+    TEST_MESSAGE(line);
+    snprintf(line, sizeof(line), "%.2f bits/amostra; %.1fx menor que registros de 9 B, %.1fx menor que JSON (%zu B)",
+             bitsPerSample, binaryRatio, jsonRatio, jsonBytes);
+    TEST_MESSAGE(line);
+    snprintf(line, sizeof(line), "add() %.0f ns/amostra, leitura da semana %.1f ms", addNs, readMs);
+    TEST_MESSAGE(line);
+
+    // A semana inteira cabe no anel de 512 KB e custa menos de 1 byte por amostra
+    TEST_ASSERT_TRUE(bitsPerSample < 8.0);
+    TEST_ASSERT_TRUE(jsonRatio > 25.0);
+    TEST_ASSERT_LESS_THAN_UINT32(TelemetryStore::MAX_SEGMENTS * TelemetryStore::SEGMENT_BLOCKS, store.blocksWritten());
+}
+
+int main(int argc, char** argv) {
+    char root[] = "/tmp/qp-test-XXXXXX";
+    sim::config().root = mkdtemp(root);
+    sim::begin(argc, argv);
+    SPIFFS.begin(true);
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_covers_every_bit_class);
+    RUN_TEST(test_random_walk_round_trip_is_bit_exact);
+    RUN_TEST(test_corrupt_block_loses_only_its_samples);
+    RUN_TEST(test_pool_week_compression);
+    return sim::end(UNITY_END());
+}
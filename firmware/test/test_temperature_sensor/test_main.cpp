@@ -0,0 +1,227 @@
+// Barramento 1-Wire não bloqueante (src/TemperatureSensor.h) sobre os DS18B20
+// simulados, com o tempo de conversão e de barramento do hardware real: nenhum
+// passo de poll() nem volta do loop() passa de 1 ms, contra os ~750 ms da
+// leitura bloqueante (requestTemperatures()) que o firmware fazia antes
+#include <Arduino.h>
+#include <NativeSim.h>
+#include <unity.h>
+
+#include <cstdlib>
+
+#include "Metrics.h"
+#include "TemperatureSensor.h"
+
+void setup();
+void loop();
+extern TemperatureSensorBus temperatureSensors;
+
+static const TemperatureProbeConfig PROBES[] = {
+    {"entrada", 12, 1000},
+    {"saida", 12, 1000},
+    {"aquecedor", 10, 500},
+    {"caixa", 9, 500},
+};
+static const float TEMPERATURES[] = {24.0f, 27.5f, 31.25f, 40.5f};
+
+static const unsigned long SLICE_BOUND_MICROS = 1000;
+
+// Barramento próprio do teste; o oneWire de main.cpp fica no pino 4
+static const uint8_t BUS_PIN = 5;
+static OneWire wire(BUS_PIN);
+static DallasTemperature dallas(&wire);
+static Preferences prefs;
+static uint64_t searchBeginMicros = 0;   // begin() com a NVS vazia
+
+void setUp() {}
+void tearDown() {}
+
+struct PollStats {
+    unsigned long worstMicros = 0;       // em sim::threadMicros()
+    unsigned long wallWorstMicros = 0;   // no relógio de parede, com as pausas do host
+    unsigned long long totalMicros = 0;
+    unsigned long polls = 0;
+};
+
+// Roda o barramento como o loop(): um poll() por iteração, 1 ms entre elas.
+// O passo é medido em sim::threadMicros(): a máquina virtual dos testes chega
+// a parar uma thread por dezenas de ms, o que não é custo do barramento
+static PollStats run(TemperatureSensorBus& bus, unsigned long durationMs) {
+    PollStats stats;
+    unsigned long start = millis();
+    while (millis() - start < durationMs) {
+        unsigned long wall = micros();
+        uint64_t t0 = sim::threadMicros();
+        bus.poll(millis());
+        unsigned long dt = sim::threadMicros() - t0;
+        wall = micros() - wall;
+        if (dt > stats.worstMicros) stats.worstMicros = dt;
+        if (wall > stats.wallWorstMicros) stats.wallWorstMicros = wall;
+        stats.totalMicros += dt;
+        stats.polls++;
+        delayMicroseconds(1000);
+    }
+    return stats;
+}
+
+void test_reads_every_probe_without_blocking() {
+    TemperatureSensorBus bus(wire, BUS_PIN, dallas, PROBES, 4);
+    uint64_t before = sim::stats().oneWireBusMicros.load();
+    bus.begin(prefs);
+    searchBeginMicros = sim::stats().oneWireBusMicros.load() - before;
+    TEST_ASSERT_EQUAL(4, bus.probeCount());
+
+    PollStats stats = run(bus, 2500);
+    for (uint8_t i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(bus.isPresent(i));
+        TEST_ASSERT_TRUE(bus.reading(i).valid);
+    }
+    // O papel segue o endereço: cada sonda na ordem em que foi achada
+    float seen[4];
+    for (uint8_t i = 0; i < 4; i++) seen[i] = bus.reading(i).celsius;
+    for (float expected : TEMPERATURES) {
+        bool found = false;
+        for (float value : seen) found |= value == expected;
+        TEST_ASSERT_TRUE_MESSAGE(found, "temperatura de uma sonda não apareceu");
+    }
+
+    char line[128];
+    snprintf(line, sizeof(line), "poll(): pior %lu us (%lu us no relógio de parede), média %.1f us em %lu chamadas",
+             stats.worstMicros, stats.wallWorstMicros, (double)stats.totalMicros / stats.polls, stats.polls);
+    TEST_MESSAGE(line);
+    // Uma leitura bloqueante de 12 bits para o loop() por 750 ms; fatiado, o
+    // pior passo é um byte no barramento (~560 µs)
+    TEST_ASSERT_LESS_THAN(SLICE_BOUND_MICROS, stats.worstMicros);
+}
+
+void test_cached_addresses_skip_bus_search() {
+    TemperatureSensorBus bus(wire, BUS_PIN, dallas, PROBES, 4);
+    uint64_t before = sim::stats().oneWireBusMicros.load();
+    bus.begin(prefs);
+    uint64_t busMicros = sim::stats().oneWireBusMicros.load() - before;
+
+    char line[96];
+    snprintf(line, sizeof(line), "begin(): %llu us de barramento com a NVS completa, %llu us com a varredura",
+             (unsigned long long)busMicros, (unsigned long long)searchBeginMicros);
+    TEST_MESSAGE(line);
+    for (uint8_t i = 0; i < 4; i++) TEST_ASSERT_TRUE(bus.isPresent(i));
+    // Sem SEARCH ROM sobra só a conferência das resoluções
+    TEST_ASSERT_GREATER_THAN(0, searchBeginMicros);
+    TEST_ASSERT_LESS_THAN(searchBeginMicros / 2, busMicros);
+}
+
+void test_disconnected_probe_becomes_invalid() {
+    TemperatureSensorBus bus(wire, BUS_PIN, dallas, PROBES, 4);
+    bus.begin(prefs);
+    // As conversões são uma de cada vez: 750 + 750 + 188 + 94 ms por volta
+    run(bus, 2500);
+
+    // Acha a sonda do aquecedor (10 bits, 500 ms) pela temperatura
+    uint8_t heater = 0xFF;
+    for (uint8_t i = 0; i < 4; i++) {
+        if (bus.reading(i).valid && bus.reading(i).celsius == TEMPERATURES[2]) heater = i;
+    }
+    TEST_ASSERT_NOT_EQUAL(0xFF, heater);
+    for (sim::TemperatureProbe& probe : sim::probes()) {
+        if (probe.temperatureC == TEMPERATURES[2]) probe.connected = false;
+    }
+
+    run(bus, 6000);
+    TEST_ASSERT_FALSE(bus.reading(heater).valid);
+    TEST_ASSERT_GREATER_OR_EQUAL(3, bus.reading(heater).errors);
+    for (uint8_t i = 0; i < 4; i++) {
+        if (i != heater) TEST_ASSERT_TRUE(bus.reading(i).valid);
+    }
+}
+
+// Menos sondas no barramento que vagas (o caso comum): a vaga vazia não volta a
+// varrer o barramento sozinha. Passado um minuto, nenhum passo chega a 1 ms
+void test_missing_probe_does_not_rescan_the_bus() {
+    for (sim::TemperatureProbe& probe : sim::probes()) probe.connected = true;
+    sim::probes()[2].connected = false;
+    sim::probes()[3].connected = false;
+    prefs.begin("onewire", false);
+    prefs.clear();
+    prefs.end();
+
+    TemperatureSensorBus bus(wire, BUS_PIN, dallas, PROBES, 4);
+    bus.begin(prefs);
+    uint8_t present = 0;
+    for (uint8_t i = 0; i < 4; i++) present += bus.isPresent(i);
+    TEST_ASSERT_EQUAL(2, present);
+
+    PollStats stats = run(bus, 61000);
+    char line[128];
+    snprintf(line, sizeof(line), "61 s com 2 de 4 vagas: poll() pior %lu us em %lu chamadas", stats.worstMicros,
+             stats.polls);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_LESS_THAN(SLICE_BOUND_MICROS, stats.worstMicros);
+
+    // A sonda religada só entra com um pedido explícito (POST /api/sensors/rescan)
+    sim::probes()[2].connected = true;
+    run(bus, 100);
+    present = 0;
+    for (uint8_t i = 0; i < 4; i++) present += bus.isPresent(i);
+    TEST_ASSERT_EQUAL(2, present);
+    bus.requestRescan();
+    run(bus, 1000);
+    present = 0;
+    for (uint8_t i = 0; i < 4; i++) present += bus.isPresent(i);
+    TEST_ASSERT_EQUAL(3, present);
+}
+
+// O caminho antigo de updateSensors(): uma volta do loop() parada na conversão
+void test_loop_versus_blocking_read() {
+    DallasTemperature legacy(&wire);
+    legacy.begin();
+    legacy.setWaitForConversion(true);
+    unsigned long blockingWorst = 0;   // relógio de parede: a espera é por millis()
+    for (int i = 0; i < 3; i++) {
+        unsigned long t0 = micros();
+        legacy.requestTemperatures();
+        float celsius = legacy.getTempCByIndex(0);
+        unsigned long dt = micros() - t0;
+        if (dt > blockingWorst) blockingWorst = dt;
+        TEST_ASSERT_TRUE(celsius != DEVICE_DISCONNECTED_C);
+    }
+
+    // O firmware inteiro: loop() com as quatro sondas lidas pelo barramento
+    // fatiado. A sonda do aquecedor volta (o teste anterior a desligou)
+    for (sim::TemperatureProbe& probe : sim::probes()) probe.connected = true;
+    setup();
+    unsigned long loopWorst = 0, loops = 0;
+    unsigned long start = millis();
+    while (millis() - start < 3000) {
+        uint64_t t0 = sim::threadMicros();
+        loop();
+        unsigned long dt = sim::threadMicros() - t0;
+        if (dt > loopWorst) loopWorst = dt;
+        loops++;
+    }
+    // O histograma do firmware mede no relógio de parede
+    const LatencyHistogram& wall = metrics::histogram(MetricSection::Loop);
+
+    char line[160];
+    snprintf(line, sizeof(line),
+             "volta do loop(): bloqueante pior %lu us | fatiado pior %lu us em %lu voltas (parede: pior %lu us, p99 %lu us)",
+             blockingWorst, loopWorst, loops, (unsigned long)wall.maxMicros(), (unsigned long)wall.quantileMicros(0.99f));
+    TEST_MESSAGE(line);
+    TEST_ASSERT_GREATER_OR_EQUAL(DallasTemperature::millisToWaitForConversion(12) * 1000UL, blockingWorst);
+    TEST_ASSERT_GREATER_THAN(1000, loops);
+    TEST_ASSERT_LESS_THAN(SLICE_BOUND_MICROS, loopWorst);
+    // As leituras chegaram pelo loop(): uma volta pelas sondas leva ~1,8 s
+    for (uint8_t i = 0; i < 4; i++) TEST_ASSERT_TRUE(temperatureSensors.reading(i).valid);
+}
+
+int main(int argc, char** argv) {
+    char root[] = "/tmp/qp-test-XXXXXX";
+    sim::config().root = mkdtemp(root);
+    for (size_t i = 0; i < 4; i++) sim::addTemperatureProbe(TEMPERATURES[i], PROBES[i].resolution);
+    sim::begin(argc, argv);
+    UNITY_BEGIN();
+    RUN_TEST(test_reads_every_probe_without_blocking);
+    RUN_TEST(test_cached_addresses_skip_bus_search);
+    RUN_TEST(test_disconnected_probe_becomes_invalid);
+    RUN_TEST(test_missing_probe_does_not_rescan_the_bus);
+    RUN_TEST(test_loop_versus_blocking_read);
+    return sim::end(UNITY_END());
+}
@@ -0,0 +1,125 @@
+// Máquina de estados da conexão WiFi (src/WifiConnection.h) sobre o rádio
+// simulado: eventos que chegam juntos entre duas voltas do loop(), o eco do
+// nosso próprio disconnect() e a conexão que chega atrasada durante o backoff
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <NativeSim.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <unity.h>
+
+#include "WifiConnection.h"
+
+static const unsigned long CONNECT_MS = 100;
+static const unsigned long FAIL_MS = 200;
+
+static sim::AccessPoint& accessPoint() {
+    return sim::accessPoints().front();
+}
+
+// O WiFi não desregistra handlers: cada teste usa uma instância nova, que
+// fica viva até o fim do processo (os eventos seguintes ainda chegam nela)
+static WifiConnection* startConnection() {
+    WifiConnection* wifi = new WifiConnection();
+    wifi->begin("Quinta-dos-Britos-Config", "12345678", nullptr);
+    return wifi;
+}
+
+static bool loopUntil(WifiConnection& wifi, WifiConnection::State state, unsigned long timeoutMs) {
+    unsigned long start = millis();
+    while (millis() - start < timeoutMs) {
+        wifi.loop(millis());
+        if (wifi.state() == state) return true;
+        delay(5);
+    }
+    return false;
+}
+
+static uint32_t metric(WifiConnection& wifi, const char* key) {
+    JsonDocument doc;
+    wifi.toJson(doc.to<JsonObject>());
+    return doc[key].as<uint32_t>();
+}
+
+void setUp() {
+    // Derruba o enlace do teste anterior e deixa os eventos dele irem embora
+    WiFi.disconnect();
+    delay(20);
+
+    sim::accessPoints().clear();
+    sim::AccessPoint ap;
+    ap.ssid = "Quinta";
+    ap.password = "segredo";
+    sim::accessPoints().push_back(ap);
+
+    Preferences prefs;
+    prefs.begin("wifi-creds");
+    prefs.putString("wifi_ssid", "Quinta");
+    prefs.putString("wifi_pass", "segredo");
+    prefs.end();
+    prefs.begin("wifi-cache");
+    prefs.clear();
+    prefs.end();
+}
+void tearDown() {}
+
+void test_drop_pending_with_the_connect_is_not_lost() {
+    WifiConnection& wifi = *startConnection();
+
+    // Conecta e cai antes do loop() rodar: GOT_IP e DISCONNECTED pendentes juntos
+    delay(CONNECT_MS + 50);
+    accessPoint().reachable = false;
+    delay(FAIL_MS + 50);
+    wifi.loop(millis());
+    TEST_ASSERT_EQUAL(WifiConnection::State::Backoff, wifi.state());
+
+    // O AP volta: a próxima tentativa reconecta
+    accessPoint().reachable = true;
+    TEST_ASSERT_TRUE(loopUntil(wifi, WifiConnection::State::Connected, 3000));
+    TEST_ASSERT_EQUAL_UINT32(1, metric(wifi, "connects"));
+}
+
+void test_own_disconnect_is_not_a_failure() {
+    WifiConnection& wifi = *startConnection();
+    TEST_ASSERT_TRUE(loopUntil(wifi, WifiConnection::State::Connected, 1000));
+
+    // Credenciais novas com a estação no ar: o ASSOC_LEAVE do disconnect()
+    // chega durante a tentativa nova e não pode contar como falha dela
+    wifi.setCredentials("Quinta", "segredo");
+    wifi.applyCredentials(millis());
+    unsigned long start = millis();
+    while (wifi.state() != WifiConnection::State::Connected && millis() - start < 1000) {
+        wifi.loop(millis());
+        TEST_ASSERT_NOT_EQUAL(WifiConnection::State::Backoff, wifi.state());
+        delay(5);
+    }
+    TEST_ASSERT_EQUAL(WifiConnection::State::Connected, wifi.state());
+    TEST_ASSERT_EQUAL_UINT32(2, metric(wifi, "attempts"));
+    TEST_ASSERT_EQUAL_UINT32(2, metric(wifi, "connects"));
+    TEST_ASSERT_EQUAL_UINT32(0, metric(wifi, "last_reason"));
+}
+
+void test_late_connect_during_backoff_is_taken() {
+    accessPoint().reachable = false;
+    WifiConnection& wifi = *startConnection();
+    TEST_ASSERT_TRUE(loopUntil(wifi, WifiConnection::State::Backoff, FAIL_MS + 500));
+
+    // O driver ainda associa depois da falha avisada: vale a conexão, sem
+    // esperar o fim do backoff (>= BACKOFF_MIN_MS) nem abrir outra tentativa
+    accessPoint().reachable = true;
+    TEST_ASSERT_TRUE(loopUntil(wifi, WifiConnection::State::Connected, WifiConnection::BACKOFF_MIN_MS / 2));
+    TEST_ASSERT_EQUAL_UINT32(1, metric(wifi, "attempts"));
+}
+
+int main(int argc, char** argv) {
+    char root[] = "/tmp/qp-test-XXXXXX";
+    sim::config().root = mkdtemp(root);
+    sim::config().wifiConnectMillis = CONNECT_MS;
+    sim::config().wifiFailMillis = FAIL_MS;
+    sim::begin(argc, argv);
+    UNITY_BEGIN();
+    RUN_TEST(test_drop_pending_with_the_connect_is_not_lost);
+    RUN_TEST(test_own_disconnect_is_not_a_failure);
+    RUN_TEST(test_late_connect_during_backoff_is_taken);
+    return sim::end(UNITY_END());
+}
@@ -0,0 +1,175 @@
+// Scan de WiFi em segundo plano (src/WifiScanner.h) sobre o rádio simulado:
+// pedidos simultâneos dividem o job, e a ordem entre pedido, poll() da tarefa
+// de rede e resposta segue o número do job
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <NativeSim.h>
+#include <WiFi.h>
+#include <unity.h>
+
+#include <cstdlib>
+
+#include "WifiScanner.h"
+
+static const unsigned long SCAN_MS = 100;
+
+static void addAccessPoint(const char* ssid, int32_t rssi, const char* password = "segredo") {
+    sim::AccessPoint ap;
+    ap.ssid = ssid;
+    ap.rssi = rssi;
+    ap.password = password;
+    sim::accessPoints().push_back(ap);
+}
+
+static WifiScanner::Reply request(WifiScanner& scanner, uint32_t job, bool refresh, JsonDocument& doc) {
+    doc.clear();
+    return scanner.request(millis(), job, refresh, doc.to<JsonObject>());
+}
+
+// Roda a tarefa de rede até o scan em andamento terminar; `skew` adianta o relógio do scanner
+static void pollUntilScanned(WifiScanner& scanner, uint32_t scans, unsigned long skew = 0) {
+    unsigned long start = millis();
+    while (scanner.scans() < scans && millis() - start < 10 * SCAN_MS) {
+        scanner.poll(millis() + skew);
+        delay(5);
+    }
+    TEST_ASSERT_EQUAL_UINT32(scans, scanner.scans());
+}
+
+void setUp() {
+    sim::accessPoints().clear();
+    addAccessPoint("Quinta", -70);
+    addAccessPoint("Quinta", -48);            // mesmo SSID, AP mais forte
+    addAccessPoint("Vizinho", -81);
+    addAccessPoint("Convidados", -60, "");   // aberta
+    addAccessPoint("", -30);                  // oculta
+}
+void tearDown() {}
+
+void test_concurrent_requests_share_one_job() {
+    WifiScanner scanner;
+    JsonDocument a;
+    JsonDocument b;
+
+    // Duas páginas pedem antes do primeiro poll(): um job só
+    TEST_ASSERT_EQUAL(WifiScanner::Reply::Pending, request(scanner, 0, false, a));
+    TEST_ASSERT_EQUAL(WifiScanner::Reply::Pending, request(scanner, 0, false, b));
+    TEST_ASSERT_EQUAL_UINT32(1, a["job"].as<uint32_t>());
+    TEST_ASSERT_EQUAL_UINT32(1, b["job"].as<uint32_t>());
+    TEST_ASSERT_EQUAL_UINT32(WifiScanner::RETRY_AFTER_MS, a["retry_after_ms"].as<uint32_t>());
+    TEST_ASSERT_EQUAL_UINT32(1, scanner.joined());
+
+    // Com o scan já rodando, mais um pedido (mesmo com refresh) entra no mesmo job
+    scanner.poll(millis());
+    TEST_ASSERT_EQUAL(WifiScanner::Reply::Pending, request(scanner, 0, true, a));
+    TEST_ASSERT_EQUAL_UINT32(1, a["job"].as<uint32_t>());
+    TEST_ASSERT_EQUAL_UINT32(2, scanner.joined());
+
+    pollUntilScanned(scanner, 1);
+
+    // Todos recebem o mesmo resultado: um por SSID (o AP mais forte), por sinal, sem ocultas
+    TEST_ASSERT_EQUAL(WifiScanner::Reply::Ready, request(scanner, 1, false, a));
+    TEST_ASSERT_EQUAL(WifiScanner::Reply::Ready, request(scanner, 0, false, b));
+    TEST_ASSERT_EQUAL_UINT32(1, a["job"].as<uint32_t>());
+    TEST_ASSERT_EQUAL_UINT32(1, b["job"].as<uint32_t>());
+    TEST_ASSERT_FALSE(a["scanning"].as<bool>());
+    JsonArray networks = a["networks"];
+    TEST_ASSERT_EQUAL(3, networks.size());
+    TEST_ASSERT_EQUAL_STRING("Quinta", networks[0]["ssid"]);
+    TEST_ASSERT_EQUAL(-48, networks[0]["rssi"].as<int>());
+    TEST_ASSERT_EQUAL_STRING("secured", networks[0]["encryption"]);
+    TEST_ASSERT_EQUAL_STRING("Convidados", networks[1]["ssid"]);
+    TEST_ASSERT_EQUAL_STRING("open", networks[1]["encryption"]);
+    TEST_ASSERT_EQUAL_STRING("Vizinho", networks[2]["ssid"]);
+    TEST_ASSERT_EQUAL_UINT32(1, scanner.scans());
+    TEST_ASSERT_EQUAL_UINT32(2, scanner.served());
+}
+
+void test_job_orders_polls_and_responses() {
+    WifiScanner scanner;
+    JsonDocument doc;
+    request(scanner, 0, false, doc);
+    pollUntilScanned(scanner, 1);
+
+    // refresh: job 2 criado; quem espera o job 2 fica pendente, quem aceita qualquer um recebe o 1
+    // marcado como em atualização
+    TEST_ASSERT_EQUAL(WifiScanner::Reply::Pending, request(scanner, 0, true, doc));
+    TEST_ASSERT_EQUAL_UINT32(2, doc["job"].as<uint32_t>());
+    TEST_ASSERT_EQUAL(WifiScanner::Reply::Pending, request(scanner, 2, false, doc));
+    TEST_ASSERT_EQUAL(WifiScanner::Reply::Ready, request(scanner, 0, false, doc));
+    TEST_ASSERT_EQUAL_UINT32(1, doc["job"].as<uint32_t>());
+    TEST_ASSERT_TRUE(doc["scanning"].as<bool>());
+
+    // Uma rede nova aparece durante o job 2: só o resultado dele a traz
+    addAccessPoint("Nova", -40);
+    pollUntilScanned(scanner, 2);
+    TEST_ASSERT_EQUAL(WifiScanner::Reply::Ready, request(scanner, 2, false, doc));
+    TEST_ASSERT_EQUAL_UINT32(2, doc["job"].as<uint32_t>());
+    TEST_ASSERT_EQUAL_STRING("Nova", doc["networks"][0]["ssid"]);
+    TEST_ASSERT_FALSE(doc["scanning"].as<bool>());
+
+    // Um job que ainda não existe cria o próximo em vez de responder com um velho
+    TEST_ASSERT_EQUAL(WifiScanner::Reply::Pending, request(scanner, 5, false, doc));
+    TEST_ASSERT_EQUAL_UINT32(3, doc["job"].as<uint32_t>());
+    pollUntilScanned(scanner, 3);
+    TEST_ASSERT_EQUAL(WifiScanner::Reply::Ready, request(scanner, 3, false, doc));
+    TEST_ASSERT_EQUAL_UINT32(3, doc["job"].as<uint32_t>());
+    TEST_ASSERT_EQUAL_UINT32(1, scanner.joined());   // o pedido pelo job 2 esperou o refresh
+}
+
+void test_stale_result_is_served_while_rescanning() {
+    WifiScanner scanner;
+    JsonDocument doc;
+    unsigned long now = millis();
+    scanner.request(now, 0, false, doc.to<JsonObject>());
+    pollUntilScanned(scanner, 1);
+
+    // Resultado velho: responde com ele (e a idade) e agenda um scan novo
+    now = millis() + WifiScanner::MAX_AGE_MS;
+    doc.clear();
+    TEST_ASSERT_EQUAL(WifiScanner::Reply::Ready, scanner.request(now, 0, false, doc.to<JsonObject>()));
+    TEST_ASSERT_EQUAL_UINT32(1, doc["job"].as<uint32_t>());
+    TEST_ASSERT_GREATER_OR_EQUAL(WifiScanner::MAX_AGE_MS, doc["age_ms"].as<unsigned long>());
+    TEST_ASSERT_TRUE(doc["scanning"].as<bool>());
+
+    // O scan novo só começa quando a tarefa de rede roda
+    TEST_ASSERT_EQUAL_UINT32(1, scanner.scans());
+    pollUntilScanned(scanner, 2, WifiScanner::MAX_AGE_MS);
+    doc.clear();
+    TEST_ASSERT_EQUAL(WifiScanner::Reply::Ready,
+                      scanner.request(millis() + WifiScanner::MAX_AGE_MS, 0, false, doc.to<JsonObject>()));
+    TEST_ASSERT_EQUAL_UINT32(2, doc["job"].as<uint32_t>());
+}
+
+void test_result_keeps_the_strongest_networks() {
+    sim::accessPoints().clear();
+    char ssid[16];
+    for (int i = 0; i < 3 * WifiScanner::MAX_NETWORKS; i++) {
+        snprintf(ssid, sizeof(ssid), "rede-%02d", i);
+        addAccessPoint(ssid, -90 + i);
+    }
+    WifiScanner scanner;
+    JsonDocument doc;
+    request(scanner, 0, false, doc);
+    pollUntilScanned(scanner, 1);
+    TEST_ASSERT_EQUAL(WifiScanner::Reply::Ready, request(scanner, 1, false, doc));
+    JsonArray networks = doc["networks"];
+    TEST_ASSERT_EQUAL(WifiScanner::MAX_NETWORKS, networks.size());
+    TEST_ASSERT_EQUAL(-90 + 3 * WifiScanner::MAX_NETWORKS - 1, networks[0]["rssi"].as<int>());
+    for (size_t i = 1; i < networks.size(); i++) {
+        TEST_ASSERT_LESS_THAN(networks[i - 1]["rssi"].as<int>(), networks[i]["rssi"].as<int>());
+    }
+}
+
+int main(int argc, char** argv) {
+    char root[] = "/tmp/qp-test-XXXXXX";
+    sim::config().root = mkdtemp(root);
+    sim::config().wifiScanMillis = SCAN_MS;
+    sim::begin(argc, argv);
+    UNITY_BEGIN();
+    RUN_TEST(test_concurrent_requests_share_one_job);
+    RUN_TEST(test_job_orders_polls_and_responses);
+    RUN_TEST(test_stale_result_is_served_while_rescanning);
+    RUN_TEST(test_result_keeps_the_strongest_networks);
+    return sim::end(UNITY_END());
+}
@@ -0,0 +1,165 @@
+// Broadcast dos deltas de estado com um único buffer compartilhado
+// (broadcastDelta() em src/main.cpp): alocações e heap retido pelas filas dos
+// clientes com 1 e 8 dashboards, contra textAll() copiando por cliente
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <NativeSim.h>
+#include <unity.h>
+
+#include <malloc.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+static std::atomic<bool> tracking{false};
+static std::atomic<long> liveBytes{0};
+static std::atomic<long> allocations{0};
+
+void* operator new(size_t size) {
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    if (tracking) {
+        liveBytes += malloc_usable_size(p);
+        allocations++;
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    if (tracking) liveBytes -= malloc_usable_size(p);
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+void setup();
+void loop();
+
+extern AsyncWebSocket ws;
+
+static const int TOGGLES = 200;
+static const int DRAIN_EVERY = 10;   // ACK atrasado: as filas só esvaziam a cada 10 broadcasts
+
+struct Usage {
+    long allocations;
+    long queuedBytes;   // pico do heap retido pelas filas entre drenagens
+    uint64_t frames;
+    uint64_t bytes;     // payload mais cabeçalho de cada frame
+};
+
+static std::vector<uint32_t> clients;
+
+static void drain() {
+    for (uint32_t id : clients) sim::wsReceive(id);
+}
+
+static void connect(size_t count) {
+    while (clients.size() < count) clients.push_back(sim::wsConnect("/ws"));
+    for (int i = 0; i < 50; i++) {
+        loop();
+        delay(1);
+    }
+    drain();
+}
+
+// 200 set_pump alternando as bombas; cada um vira um delta para todos os clientes
+static Usage toggleStorm() {
+    Usage usage = {0, 0, 0, 0};
+    uint64_t framesBefore = sim::stats().wsMessagesSent.load();
+    uint64_t bytesBefore = sim::stats().wsBytesSent.load();
+    liveBytes = 0;
+    allocations = 0;
+    tracking = true;
+    for (int k = 0; k < TOGGLES; k++) {
+        char command[96];
+        snprintf(command, sizeof(command), "{\"action\":\"set_pump\",\"pump_id\":%d,\"state\":%s}", k % 4,
+                 (k / 4) % 2 ? "false" : "true");
+        sim::wsSend(clients[0], command);
+        loop();
+        delay(1);
+        if (k % DRAIN_EVERY == DRAIN_EVERY - 1) {
+            if (liveBytes > usage.queuedBytes) usage.queuedBytes = liveBytes;
+            tracking = false;
+            drain();
+            tracking = true;
+        }
+    }
+    tracking = false;
+    usage.allocations = allocations;
+    usage.frames = sim::stats().wsMessagesSent.load() - framesBefore;
+    usage.bytes = sim::stats().wsBytesSent.load() - bytesBefore;
+    return usage;
+}
+
+// O caminho antigo: o mesmo volume de deltas com textAll(String), uma cópia por cliente
+static Usage copyStorm(size_t payloadBytes) {
+    Usage usage = {0, 0, 0, 0};
+    uint64_t framesBefore = sim::stats().wsMessagesSent.load();
+    std::string payload(payloadBytes, 'x');
+    liveBytes = 0;
+    allocations = 0;
+    tracking = true;
+    for (int k = 0; k < TOGGLES; k++) {
+        ws.textAll(payload.c_str(), payload.size());
+        if (k % DRAIN_EVERY == DRAIN_EVERY - 1) {
+            if (liveBytes > usage.queuedBytes) usage.queuedBytes = liveBytes;
+            tracking = false;
+            drain();
+            tracking = true;
+        }
+    }
+    tracking = false;
+    usage.allocations = allocations;
+    usage.frames = sim::stats().wsMessagesSent.load() - framesBefore;
+    return usage;
+}
+
+static void report(const char* name, const Usage& usage) {
+    char line[128];
+    snprintf(line, sizeof(line), "%s: %ld alocações, %.1f KB retidos nas filas, %llu frames", name, usage.allocations,
+             usage.queuedBytes / 1024.0, (unsigned long long)usage.frames);
+    TEST_MESSAGE(line);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_delta_payload_is_shared_by_all_clients() {
+    setup();
+    connect(1);
+    Usage one = toggleStorm();
+    report("1 cliente", one);
+
+    connect(8);
+    Usage eight = toggleStorm();
+    report("8 clientes", eight);
+
+    TEST_ASSERT_GREATER_OR_EQUAL(TOGGLES, one.frames);
+    TEST_ASSERT_EQUAL_UINT64(8 * one.frames, eight.frames);
+    // Um payload por delta, qualquer que seja o número de clientes: os 7 clientes a mais custam só as entradas
+    // nas filas, não cópias do delta
+    TEST_ASSERT_LESS_THAN(one.allocations + (long)one.frames, eight.allocations);
+    TEST_ASSERT_LESS_THAN(3 * one.queuedBytes, eight.queuedBytes);
+
+    size_t deltaBytes = eight.bytes / eight.frames - 2;
+    Usage copies = copyStorm(deltaBytes);
+    report("8 clientes, cópia por cliente", copies);
+    TEST_ASSERT_EQUAL_UINT64(8 * TOGGLES, copies.frames);
+    TEST_ASSERT_GREATER_OR_EQUAL(8 * TOGGLES, copies.allocations);
+    TEST_ASSERT_LESS_THAN(copies.queuedBytes, eight.queuedBytes);
+}
+
+int main(int argc, char** argv) {
+    char root[] = "/tmp/qp-test-XXXXXX";
+    sim::config().root = mkdtemp(root);
+    sim::begin(argc, argv);
+    UNITY_BEGIN();
+    RUN_TEST(test_delta_payload_is_shared_by_all_clients);
+    return sim::end(UNITY_END());
+}
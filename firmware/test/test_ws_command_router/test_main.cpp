@@ -0,0 +1,231 @@
+// Roteador dos comandos JSON do WebSocket (src/WsCommandRouter.h) sob frames
+// malformados: dispatch() chamado direto, com uma tabela de esquemas igual à
+// do firmware e handlers que só contam as chamadas
+#include <Arduino.h>
+#include <NativeSim.h>
+#include <unity.h>
+
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "JsonArena.h"
+#include "WsCommandRouter.h"
+
+static int handled = 0;
+static bool refuseNext = false;
+
+static const char* countCall(AsyncWebSocketClient*, JsonObjectConst args) {
+    handled++;
+    if (refuseNext) {
+        refuseNext = false;
+        return "state";
+    }
+    return nullptr;
+}
+
+constexpr WsField PUMP_FIELDS[] = {
+    {"pump_id", WsFieldType::UInt, true, 0, 3},
+    {"state", WsFieldType::Bool, true, 0, 0},
+};
+constexpr WsField RGB_FIELDS[] = {
+    {"color", WsFieldType::String, true, 0, 0},
+};
+constexpr WsField EFFECT_FIELDS[] = {
+    {"effect", WsFieldType::String, true, 0, 0},
+    {"period_ms", WsFieldType::UInt, false, 0, 3600000},
+};
+
+constexpr WsCommand COMMANDS[] = {
+    WS_COMMAND_NO_ARGS("resync", countCall),
+    WS_COMMAND("set_pump", PUMP_FIELDS, countCall),
+    WS_COMMAND("set_rgb", RGB_FIELDS, countCall),
+    WS_COMMAND("set_effect", EFFECT_FIELDS, countCall),
+};
+
+constexpr const WsCommand* findCommand(uint32_t hash) {
+    switch (hash) {
+    case wsCommandHash("resync"): return &COMMANDS[0];
+    case wsCommandHash("set_pump"): return &COMMANDS[1];
+    case wsCommandHash("set_rgb"): return &COMMANDS[2];
+    case wsCommandHash("set_effect"): return &COMMANDS[3];
+    default: return nullptr;
+    }
+}
+static_assert(wsCommandLookupMatches(COMMANDS, findCommand), "Switch de comandos fora da tabela");
+
+static StaticJsonArena<3 * JSON_POOL_BYTES + 1024> arena;
+static WsCommandRouter router(COMMANDS, sizeof(COMMANDS) / sizeof(COMMANDS[0]), findCommand);
+
+static WsCommandResult dispatch(const std::string& frame) {
+    int before = handled;
+    WsCommandResult result = router.dispatch(nullptr, reinterpret_cast<const uint8_t*>(frame.data()), frame.size());
+    // O handler só roda com todos os campos válidos, e a arena volta ao início depois de cada mensagem
+    if (result.error == WsCommandError::None || result.error == WsCommandError::InvalidField) {
+        TEST_ASSERT_TRUE(handled - before <= 1);
+    } else {
+        TEST_ASSERT_EQUAL(before, handled);
+    }
+    TEST_ASSERT_EQUAL(0, arena.used());
+    return result;
+}
+
+static void expectError(WsCommandError error, const char* field, const std::string& frame) {
+    WsCommandResult result = dispatch(frame);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(WsCommandRouter::errorCode(error), WsCommandRouter::errorCode(result.error),
+                                     frame.substr(0, 80).c_str());
+    if (field) {
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(field, result.field, frame.c_str());
+    }
+}
+
+static const std::vector<std::string> VALID = {
+    "{\"action\":\"resync\"}",
+    "{\"action\":\"set_pump\",\"pump_id\":2,\"state\":true}",
+    "{\"action\":\"set_rgb\",\"color\":\"#10ff20\"}",
+    "{\"action\":\"set_effect\",\"effect\":\"pulse\",\"period_ms\":3000}",
+    "{\"action\":\"set_effect\",\"effect\":\"cycle\"}",
+};
+
+void setUp() {}
+void tearDown() {}
+
+void test_valid_commands_are_dispatched() {
+    for (const std::string& frame : VALID) {
+        int before = handled;
+        TEST_ASSERT_EQUAL(WsCommandError::None, dispatch(frame).error);
+        TEST_ASSERT_EQUAL(before + 1, handled);
+    }
+    // Campos de outros comandos e extras não atrapalham
+    TEST_ASSERT_EQUAL(WsCommandError::None,
+                      dispatch("{\"color\":\"#000000\",\"action\":\"set_pump\",\"state\":false,\"pump_id\":0,"
+                               "\"extra\":{\"a\":[1,2,3]}}")
+                          .error);
+}
+
+void test_null_or_non_string_action() {
+    expectError(WsCommandError::MissingAction, nullptr, "{}");
+    expectError(WsCommandError::MissingAction, nullptr, "{\"pump_id\":1}");
+    expectError(WsCommandError::MissingAction, nullptr, "{\"action\":null}");
+    expectError(WsCommandError::MissingAction, nullptr, "{\"action\":7}");
+    expectError(WsCommandError::MissingAction, nullptr, "{\"action\":true}");
+    expectError(WsCommandError::MissingAction, nullptr, "{\"action\":[\"set_pump\"]}");
+    expectError(WsCommandError::MissingAction, nullptr, "{\"action\":{\"name\":\"set_pump\"}}");
+    expectError(WsCommandError::UnknownAction, nullptr, "{\"action\":\"\"}");
+    expectError(WsCommandError::UnknownAction, nullptr, "{\"action\":\"set_pumps\"}");
+    expectError(WsCommandError::UnknownAction, nullptr, "{\"action\":\"SET_PUMP\"}");
+}
+
+void test_not_an_object() {
+    const char* frames[] = {"", "null", "[]", "42", "\"set_pump\"", "{\"action\":\"set_pump\"",
+                            "{\"action\":\"set_pump\",\"pump_id\":1,\"state\":true", "\xff\xfe", "[{\"action\":\"resync\"}]"};
+    for (const char* frame : frames) expectError(WsCommandError::InvalidJson, nullptr, frame);
+}
+
+void test_wrong_argument_types() {
+    expectError(WsCommandError::MissingField, "pump_id", "{\"action\":\"set_pump\"}");
+    expectError(WsCommandError::MissingField, "state", "{\"action\":\"set_pump\",\"pump_id\":1}");
+    expectError(WsCommandError::MissingField, "pump_id", "{\"action\":\"set_pump\",\"pump_id\":null,\"state\":true}");
+    expectError(WsCommandError::InvalidField, "pump_id", "{\"action\":\"set_pump\",\"pump_id\":\"1\",\"state\":true}");
+    expectError(WsCommandError::InvalidField, "pump_id", "{\"action\":\"set_pump\",\"pump_id\":-1,\"state\":true}");
+    expectError(WsCommandError::InvalidField, "pump_id", "{\"action\":\"set_pump\",\"pump_id\":4,\"state\":true}");
+    expectError(WsCommandError::InvalidField, "pump_id", "{\"action\":\"set_pump\",\"pump_id\":1.5,\"state\":true}");
+    expectError(WsCommandError::InvalidField, "pump_id", "{\"action\":\"set_pump\",\"pump_id\":1e99,\"state\":true}");
+    expectError(WsCommandError::InvalidField, "pump_id", "{\"action\":\"set_pump\",\"pump_id\":[1],\"state\":true}");
+    expectError(WsCommandError::InvalidField, "state", "{\"action\":\"set_pump\",\"pump_id\":1,\"state\":1}");
+    expectError(WsCommandError::InvalidField, "state", "{\"action\":\"set_pump\",\"pump_id\":1,\"state\":\"true\"}");
+    expectError(WsCommandError::InvalidField, "color", "{\"action\":\"set_rgb\",\"color\":123}");
+    expectError(WsCommandError::InvalidField, "color", "{\"action\":\"set_rgb\",\"color\":{}}");
+    expectError(WsCommandError::InvalidField, "effect", "{\"action\":\"set_effect\",\"effect\":false}");
+    expectError(WsCommandError::InvalidField, "period_ms", "{\"action\":\"set_effect\",\"effect\":\"pulse\",\"period_ms\":-5}");
+    expectError(WsCommandError::InvalidField, "period_ms",
+                "{\"action\":\"set_effect\",\"effect\":\"pulse\",\"period_ms\":3600001}");
+
+    // Recusa do handler (ex.: parada de emergência) também volta como invalid_field
+    refuseNext = true;
+    expectError(WsCommandError::InvalidField, "state", "{\"action\":\"set_pump\",\"pump_id\":1,\"state\":true}");
+}
+
+void test_oversized_input() {
+    // Aninhamento profundo: recusado pelo limite do parser, sem estourar a pilha
+    expectError(WsCommandError::InvalidJson, nullptr, std::string(5000, '['));
+    expectError(WsCommandError::InvalidJson, nullptr,
+                "{\"action\":\"resync\",\"x\":" + std::string(200, '[') + std::string(200, ']') + "}");
+
+    // 64 KB num campo ignorado: o filtro descarta sem guardar
+    std::string padding(64 * 1024, 'x');
+    TEST_ASSERT_EQUAL(WsCommandError::None,
+                      dispatch("{\"action\":\"set_pump\",\"junk\":\"" + padding + "\",\"pump_id\":3,\"state\":false}").error);
+
+    // 16 KB dentro de um campo do esquema: não cabe na arena, vai para o heap e chega inteiro ao handler
+    // (que recusaria a cor; aqui só conta a chamada)
+    std::string longValue(16 * 1024, 'f');
+    int before = handled;
+    TEST_ASSERT_EQUAL(WsCommandError::None,
+                      dispatch("{\"action\":\"set_rgb\",\"color\":\"#" + longValue + "\"}").error);
+    TEST_ASSERT_EQUAL(before + 1, handled);
+    expectError(WsCommandError::UnknownAction, nullptr, "{\"action\":\"" + longValue + "\"}");
+
+    // Strings além do limite do ArduinoJson: recusadas pelo parser
+    WsCommandResult result = dispatch("{\"action\":\"set_rgb\",\"color\":\"#" + padding + padding + "\"}");
+    TEST_ASSERT_NOT_EQUAL(WsCommandError::None, result.error);
+
+    // Milhares de chaves desconhecidas
+    std::string many = "{\"action\":\"resync\"";
+    for (int i = 0; i < 5000; i++) many += ",\"k" + std::to_string(i) + "\":" + std::to_string(i);
+    TEST_ASSERT_EQUAL(WsCommandError::None, dispatch(many + "}").error);
+}
+
+void test_random_mutations() {
+    static const char ALPHABET[] = "{}[]\":,0123456789truefalsnul#abcdef-.eE \\\xff";
+    std::mt19937 rng(1234);
+    uint32_t dispatchedBefore = router.dispatched();
+    uint32_t rejectedBefore = router.rejected();
+    const int MUTATIONS = 100000;
+    const int RANDOM_FRAMES = 20000;
+
+    for (int i = 0; i < MUTATIONS; i++) {
+        std::string frame = VALID[rng() % VALID.size()];
+        for (int m = 1 + rng() % 4; m > 0 && !frame.empty(); m--) {
+            size_t at = rng() % frame.size();
+            char c = ALPHABET[rng() % (sizeof(ALPHABET) - 1)];
+            switch (rng() % 4) {
+            case 0: frame[at] = c; break;
+            case 1: frame.erase(at, 1 + rng() % 4); break;
+            case 2: frame.insert(at, 1, c); break;
+            case 3: frame.resize(at); break;
+            }
+        }
+        dispatch(frame);
+    }
+    for (int i = 0; i < RANDOM_FRAMES; i++) {
+        std::string frame(rng() % 64, '\0');
+        for (char& c : frame) c = static_cast<char>(rng());
+        dispatch(frame);
+    }
+
+    uint32_t dispatched = router.dispatched() - dispatchedBefore;
+    uint32_t rejected = router.rejected() - rejectedBefore;
+    char line[96];
+    snprintf(line, sizeof(line), "%d frames: %u executados, %u recusados, arena %u/%u bytes", MUTATIONS + RANDOM_FRAMES,
+             (unsigned)dispatched, (unsigned)rejected, (unsigned)arena.highWater(), (unsigned)arena.capacity());
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL_UINT32(MUTATIONS + RANDOM_FRAMES, dispatched + rejected);
+    TEST_ASSERT_GREATER_THAN(0, dispatched);
+}
+
+int main(int argc, char** argv) {
+    char root[] = "/tmp/qp-test-XXXXXX";
+    sim::config().root = mkdtemp(root);
+    sim::begin(argc, argv);
+    router.begin(&arena);
+    UNITY_BEGIN();
+    RUN_TEST(test_valid_commands_are_dispatched);
+    RUN_TEST(test_null_or_non_string_action);
+    RUN_TEST(test_not_an_object);
+    RUN_TEST(test_wrong_argument_types);
+    RUN_TEST(test_oversized_input);
+    RUN_TEST(test_random_mutations);
+    return sim::end(UNITY_END());
+}
@@ -0,0 +1,203 @@
+// Subprotocolo MessagePack do WebSocket (src/WsProtocol.h) contra o JSON de
+// texto: tamanho e tempo de codificação do full_state e dos deltas, e um
+// comando binário chegando aos dois formatos
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+#include <NativeSim.h>
+#include <unity.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+#include "ControllerState.h"
+#include "WsProtocol.h"
+
+void setup();
+void loop();
+void broadcastDeltaJson(uint32_t fields, const ControllerState& state);
+void broadcastDeltaPacked(uint32_t fields, const ControllerState& state);
+
+static const int ITERATIONS = 20000;
+
+static uint32_t jsonClient;
+static uint32_t packedClient;
+
+typedef std::chrono::steady_clock Clock;
+
+static double microsPerCall(Clock::time_point start, int calls) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / calls;
+}
+
+static ControllerState sampleState() {
+    ControllerState state;
+    state.seq = 1234;
+    state.pumps[0] = true;
+    state.pumps[2] = true;
+    state.temperature = 27.31f;
+    state.luminosity = 64;
+    for (uint8_t i = 0; i < 4; i++) {
+        state.probes[i].present = true;
+        state.probes[i].valid = true;
+        state.probes[i].celsius = 24.5f + i;
+    }
+    return state;
+}
+
+void setUp() {
+    sim::wsReceive(jsonClient);
+    sim::wsReceive(packedClient);
+}
+void tearDown() {}
+
+void test_full_state_is_smaller_in_msgpack() {
+    // Reconectados: o primeiro frame de cada um é o full_state
+    uint32_t json = sim::wsConnect("/ws");
+    uint32_t packed = sim::wsConnect("/ws", {{"Sec-WebSocket-Protocol", WS_MSGPACK_PROTOCOL}});
+    loop();
+    std::vector<std::string> jsonFrames = sim::wsReceive(json);
+    std::vector<std::string> packedFrames = sim::wsReceive(packed);
+    TEST_ASSERT_FALSE(jsonFrames.empty());
+    TEST_ASSERT_FALSE(packedFrames.empty());
+
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeMsgPack(doc, packedFrames.front()));
+    TEST_ASSERT_EQUAL(WS_MSG_FULL_STATE, doc[0].as<int>());
+    TEST_ASSERT_EQUAL(4, doc[2].size());
+    TEST_ASSERT_EQUAL(4, doc[5].size());
+
+    char line[96];
+    snprintf(line, sizeof(line), "full_state: json %u B, msgpack %u B", (unsigned)jsonFrames.front().size(),
+             (unsigned)packedFrames.front().size());
+    TEST_MESSAGE(line);
+    TEST_ASSERT_LESS_THAN(jsonFrames.front().size() / 3, packedFrames.front().size());
+    sim::wsDisconnect(json);
+    sim::wsDisconnect(packed);
+}
+
+void test_delta_encoding_size_and_time() {
+    struct Case {
+        const char* name;
+        uint32_t fields;
+    };
+    const Case cases[] = {{"1 bomba", 0x01}, {"temp+lum", 0x30}, {"rgb", 0x40}, {"tudo", 0xF7F}};
+    ControllerState state = sampleState();
+    double jsonTotal = 0;
+    double packedTotal = 0;
+
+    for (const Case& c : cases) {
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < ITERATIONS; i++) {
+            broadcastDeltaJson(c.fields, state);
+            if (i % 16 == 15) sim::wsReceive(jsonClient);
+        }
+        double jsonMicros = microsPerCall(start, ITERATIONS);
+        sim::wsReceive(jsonClient);
+        broadcastDeltaJson(c.fields, state);
+        size_t jsonBytes = sim::wsReceive(jsonClient).back().size();
+
+        start = Clock::now();
+        for (int i = 0; i < ITERATIONS; i++) {
+            broadcastDeltaPacked(c.fields, state);
+            if (i % 16 == 15) sim::wsReceive(packedClient);
+        }
+        double packedMicros = microsPerCall(start, ITERATIONS);
+        sim::wsReceive(packedClient);
+        broadcastDeltaPacked(c.fields, state);
+        std::string frame = sim::wsReceive(packedClient).back();
+
+        char line[128];
+        snprintf(line, sizeof(line), "delta %-8s json %.2f us %3u B | msgpack %.2f us %3u B", c.name, jsonMicros,
+                 (unsigned)jsonBytes, packedMicros, (unsigned)frame.size());
+        TEST_MESSAGE(line);
+
+        // [2, seq, campos, valores...]: um valor por bit ligado
+        JsonDocument doc;
+        TEST_ASSERT_FALSE(deserializeMsgPack(doc, frame));
+        TEST_ASSERT_EQUAL(WS_MSG_DELTA, doc[0].as<int>());
+        TEST_ASSERT_EQUAL_UINT32(state.seq, doc[1].as<uint32_t>());
+        TEST_ASSERT_EQUAL_UINT32(c.fields, doc[2].as<uint32_t>());
+        TEST_ASSERT_EQUAL(3 + __builtin_popcount(c.fields), doc.size());
+
+        TEST_ASSERT_LESS_THAN(jsonBytes / 3, frame.size());
+        jsonTotal += jsonMicros;
+        packedTotal += packedMicros;
+    }
+    // Sem chaves nem números em texto, a codificação binária sai mais barata no conjunto
+    TEST_ASSERT_TRUE_MESSAGE(packedTotal < jsonTotal, "msgpack mais lento que json");
+}
+
+void test_packed_command_reaches_both_formats() {
+    // set_pump [17, 3, true]
+    sim::wsSend(packedClient, std::string("\x93\x11\x03\xc3", 4), true);
+    for (int i = 0; i < 20; i++) {
+        loop();
+        delay(1);
+    }
+
+    std::vector<std::string> packed = sim::wsReceive(packedClient);
+    TEST_ASSERT_FALSE(packed.empty());
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeMsgPack(doc, packed.back()));
+    TEST_ASSERT_EQUAL(WS_MSG_DELTA, doc[0].as<int>());
+    TEST_ASSERT_EQUAL_UINT32(0x08, doc[2].as<uint32_t>() & 0x0F);
+    TEST_ASSERT_TRUE(doc[3].as<bool>());
+
+    std::vector<std::string> json = sim::wsReceive(jsonClient);
+    TEST_ASSERT_FALSE(json.empty());
+    TEST_ASSERT_FALSE(deserializeJson(doc, json.back()));
+    TEST_ASSERT_EQUAL_STRING("delta", doc["action"]);
+    TEST_ASSERT_TRUE(doc["pumps"]["3"].as<bool>());
+}
+
+// Mesmo erro estruturado do JSON: [3, código, comando|nil, campo|nil]
+static void expectPackedError(const std::string& frame, const char* code, const char* command, const char* field) {
+    sim::wsSend(packedClient, frame, true);
+    std::vector<std::string> replies = sim::wsReceive(packedClient);
+    TEST_ASSERT_EQUAL(1, replies.size());
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeMsgPack(doc, replies.back()));
+    TEST_ASSERT_EQUAL(WS_MSG_ERROR, doc[0].as<int>());
+    TEST_ASSERT_EQUAL_STRING(code, doc[1].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING(command, doc[2].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING(field, doc[3].as<const char*>());
+}
+
+void test_malformed_packed_command_gets_structured_error() {
+    expectPackedError(std::string("\xc1", 1), "invalid_json", nullptr, nullptr);
+    expectPackedError(std::string("\x81\xa1\x61\x01", 4), "invalid_json", nullptr, nullptr);   // mapa, não array
+    expectPackedError(std::string("\x91\xc0", 2), "missing_action", nullptr, nullptr);
+    expectPackedError(std::string("\x91\x63", 2), "unknown_action", nullptr, nullptr);
+    expectPackedError(std::string("\x93\x11\x07\xc3", 4), "invalid_field", "set_pump", "pump_id");
+    expectPackedError(std::string("\x93\x11\xff\xc3", 4), "invalid_field", "set_pump", "pump_id");   // -1
+    expectPackedError(std::string("\x92\x11\x01", 3), "missing_field", "set_pump", "state");
+    expectPackedError(std::string("\x93\x11\x01\x01", 4), "invalid_field", "set_pump", "state");
+    expectPackedError(std::string("\x94\x12\x01\xa1\x61\x01", 6), "invalid_field", "set_rgb", "color");
+    expectPackedError(std::string("\x93\x13\x09\x01", 4), "invalid_field", "set_effect", "effect");
+
+    // Nada foi aplicado: nenhum delta saiu para o cliente JSON
+    loop();
+    TEST_ASSERT_EQUAL(0, sim::wsReceive(jsonClient).size());
+}
+
+int main(int argc, char** argv) {
+    char root[] = "/tmp/qp-test-XXXXXX";
+    sim::config().root = mkdtemp(root);
+    sim::begin(argc, argv);
+    for (int i = 0; i < 4; i++) sim::addTemperatureProbe(24.0f + i);
+    setup();
+    jsonClient = sim::wsConnect("/ws");
+    packedClient = sim::wsConnect("/ws", {{"Sec-WebSocket-Protocol", WS_MSGPACK_PROTOCOL}});
+    for (int i = 0; i < 50; i++) {
+        loop();
+        delay(1);
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_full_state_is_smaller_in_msgpack);
+    RUN_TEST(test_delta_encoding_size_and_time);
+    RUN_TEST(test_packed_command_reaches_both_formats);
+    RUN_TEST(test_malformed_packed_command_gets_structured_error);
+    return sim::end(UNITY_END());
+}